@@ -0,0 +1,35 @@
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <recti/dme.hpp>
+#include <recti/recti.hpp>
+#include <vector>
+
+using namespace recti;
+
+static auto make_sinks(int n) -> std::vector<point<double>>
+{
+    std::srand(11);
+    auto sinks = std::vector<point<double>> {};
+    for (auto i = 0; i != n; ++i)
+    {
+        sinks.emplace_back(std::rand() % 1000000, std::rand() % 1000000);
+    }
+    return sinks;
+}
+
+static void BM_dme_zero_skew(benchmark::State& state)
+{
+    const auto sinks = make_sinks(int(state.range(0)));
+    for (auto _ : state)
+    {
+        const auto tree =
+            dme_zero_skew<double>(sinks, unsigned(state.range(1)));
+        benchmark::DoNotOptimize(tree.length);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_dme_zero_skew)
+    ->Args({1 << 17, 1})
+    ->Args({1 << 17, 0})
+    ->Args({1 << 20, 0})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <recti/grid_index.hpp>
+#include <recti/recti.hpp>
+#include <vector>
+
+using namespace recti;
+
+static auto make_cells(int n) -> std::vector<rectangle<int>>
+{
+    std::srand(5);
+    auto cells = std::vector<rectangle<int>> {};
+    for (auto i = 0; i != n; ++i)
+    {
+        auto x = std::rand() % 100000;
+        auto y = std::rand() % 100000;
+        cells.emplace_back(interval<int> {x, x + 20 + std::rand() % 80},
+            interval<int> {y, y + 100});
+    }
+    return cells;
+}
+
+static auto make_windows(int n) -> std::vector<rectangle<int>>
+{
+    auto windows = std::vector<rectangle<int>> {};
+    for (auto i = 0; i != n; ++i)
+    {
+        auto x = std::rand() % 100000;
+        auto y = std::rand() % 100000;
+        windows.emplace_back(
+            interval<int> {x, x + 500}, interval<int> {y, y + 500});
+    }
+    return windows;
+}
+
+static const auto extent =
+    rectangle<int> {interval<int> {0, 100100}, interval<int> {0, 100100}};
+
+static void BM_grid_build(benchmark::State& state)
+{
+    const auto cells = make_cells(int(state.range(0)));
+    auto G = grid_index<int> {extent, 200};
+    for (auto _ : state)
+    {
+        G.build(cells, unsigned(state.range(1)));
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_grid_build)->Args({1 << 20, 1})->Args({1 << 20, 0});
+
+static void BM_grid_query(benchmark::State& state)
+{
+    const auto cells = make_cells(int(state.range(0)));
+    const auto windows = make_windows(1024);
+    auto G = grid_index<int> {extent, 200};
+    G.build(cells);
+    for (auto _ : state)
+    {
+        auto count = std::size_t(0);
+        for (auto&& w : windows)
+        {
+            G.query(w, [&count](std::size_t) { ++count; });
+        }
+        benchmark::DoNotOptimize(count);
+    }
+}
+BENCHMARK(BM_grid_query)->Arg(1 << 16)->Arg(1 << 20);
+
+static void BM_brute_query(benchmark::State& state)
+{
+    const auto cells = make_cells(int(state.range(0)));
+    const auto windows = make_windows(1024);
+    for (auto _ : state)
+    {
+        auto count = std::size_t(0);
+        for (auto&& w : windows)
+        {
+            for (auto&& r : cells)
+            {
+                count += r.overlaps(w) ? 1 : 0;
+            }
+        }
+        benchmark::DoNotOptimize(count);
+    }
+}
+BENCHMARK(BM_brute_query)->Arg(1 << 16)->Arg(1 << 20);
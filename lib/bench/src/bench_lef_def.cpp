@@ -0,0 +1,91 @@
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <recti/lef_def.hpp>
+#include <recti/recti.hpp>
+#include <string>
+
+using namespace recti;
+
+static const char* const lef_text = R"(UNITS
+  DATABASE MICRONS 1000 ;
+END UNITS
+MACRO INV
+  CLASS CORE ;
+  SIZE 0.8 BY 2.0 ;
+  PIN A
+    PORT
+      LAYER metal1 ;
+        RECT 0.1 0.5 0.3 0.7 ;
+    END
+  END A
+  PIN Y
+    PORT
+      LAYER metal1 ;
+        RECT 0.5 1.0 0.7 1.6 ;
+    END
+  END Y
+END INV
+END LIBRARY
+)";
+
+/**
+ * @brief a placed design with n components and n nets of 2 - 5 pins
+ */
+static auto make_def(int n, bool with_nets) -> std::string
+{
+    static const char* const orients[] = {"N", "FS", "S", "FN"};
+    std::srand(5);
+    auto s = std::string {};
+    s += "VERSION 5.8 ;\nDESIGN top ;\nUNITS DISTANCE MICRONS 2000 ;\n";
+    s += "DIEAREA ( 0 0 ) ( 4000000 4000000 ) ;\n";
+    s += "COMPONENTS " + std::to_string(n) + " ;\n";
+    for (auto i = 0; i != n; ++i)
+    {
+        s += "- u" + std::to_string(i) + " INV + PLACED ( " +
+            std::to_string(std::rand() % 4000000) + ' ' +
+            std::to_string(std::rand() % 4000000) + " ) " +
+            orients[std::rand() % 4] + " ;\n";
+    }
+    s += "END COMPONENTS\nNETS " + std::to_string(n) + " ;\n";
+    for (auto i = 0; with_nets && i != n; ++i)
+    {
+        s += "- n" + std::to_string(i);
+        for (auto k = 2 + std::rand() % 4; k != 0; --k)
+        {
+            s += " ( u" + std::to_string(std::rand() % n) +
+                (k == 1 ? " Y )" : " A )");
+        }
+        s += " + USE SIGNAL ;\n";
+    }
+    s += "END NETS\nEND DESIGN\n";
+    return s;
+}
+
+/**
+ * @brief args: components, threads, whether nets are listed
+ */
+static void BM_parse_def(benchmark::State& state)
+{
+    const auto text = make_def(int(state.range(0)), state.range(2) != 0);
+    auto lib = lef_library<int> {};
+    if (parse_lef<int>(lef_text, lib) != lef_def_status::ok)
+    {
+        state.SkipWithError("LEF parse failed");
+        return;
+    }
+    for (auto _ : state)
+    {
+        auto d = def_design<int> {};
+        const auto st =
+            parse_def<int>(text, d, &lib, unsigned(state.range(1)));
+        benchmark::DoNotOptimize(st);
+        benchmark::DoNotOptimize(d.nets.num_pins());
+    }
+    state.SetBytesProcessed(
+        state.iterations() * std::int64_t(text.size()));
+}
+BENCHMARK(BM_parse_def)
+    ->Args({1 << 20, 1, 0})
+    ->Args({1 << 20, 1, 1})
+    ->Args({1 << 20, 0, 1})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,119 @@
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdlib>
+#include <recti/recti.hpp>
+#include <recti/rstar_tree.hpp>
+#include <utility>
+#include <vector>
+
+using namespace recti;
+
+static auto make_placement(int n) -> std::vector<rectangle<int>>
+{
+    std::srand(7);
+    auto cells = std::vector<rectangle<int>> {};
+    for (auto i = 0; i != n; ++i)
+    {
+        auto x = std::rand() % 100000;
+        auto y = std::rand() % 1000 * 100; // on rows
+        cells.emplace_back(interval<int> {x, x + 20 + std::rand() % 80},
+            interval<int> {y, y + 100});
+    }
+    return cells;
+}
+
+/**
+ * @brief One step of a placer: a quarter of the cells move, most by a few
+ * units, one in fifty to a random spot
+ */
+static auto move_batch(std::vector<rectangle<int>>& cells)
+    -> std::vector<std::pair<std::uint32_t, rectangle<int>>>
+{
+    auto moves = std::vector<std::pair<std::uint32_t, rectangle<int>>> {};
+    for (auto id = 0U; id != cells.size(); ++id)
+    {
+        if (std::rand() % 4 != 0)
+        {
+            continue;
+        }
+        const auto& r = cells[id];
+        auto dx = std::rand() % 21 - 10;
+        auto dy = 0;
+        if (std::rand() % 50 == 0)
+        {
+            dx = std::rand() % 100000 - r.x().lower();
+            dy = std::rand() % 1000 * 100 - r.y().lower();
+        }
+        cells[id] = rectangle<int> {
+            interval<int> {r.x().lower() + dx, r.x().upper() + dx},
+            interval<int> {r.y().lower() + dy, r.y().upper() + dy}};
+        moves.emplace_back(id, cells[id]);
+    }
+    return moves;
+}
+
+static void BM_rstar_insert(benchmark::State& state)
+{
+    const auto cells = make_placement(int(state.range(0)));
+    for (auto _ : state)
+    {
+        auto tree = rstar_tree<int> {};
+        for (auto&& r : cells)
+        {
+            tree.insert(r);
+        }
+        benchmark::DoNotOptimize(tree.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_rstar_insert)->Arg(1 << 16)->Arg(1 << 20);
+
+static void BM_rstar_move_stream(benchmark::State& state)
+{
+    auto cells = make_placement(int(state.range(0)));
+    auto tree = rstar_tree<int> {};
+    for (auto&& r : cells)
+    {
+        tree.insert(r);
+    }
+    auto moved = std::int64_t(0);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        const auto moves = move_batch(cells);
+        state.ResumeTiming();
+        benchmark::DoNotOptimize(tree.move_all(moves));
+        moved += std::int64_t(moves.size());
+    }
+    state.SetItemsProcessed(moved);
+}
+BENCHMARK(BM_rstar_move_stream)->Arg(1 << 16)->Arg(1 << 20);
+
+static void BM_rstar_query(benchmark::State& state)
+{
+    const auto cells = make_placement(int(state.range(0)));
+    auto tree = rstar_tree<int> {};
+    for (auto&& r : cells)
+    {
+        tree.insert(r);
+    }
+    auto windows = std::vector<rectangle<int>> {};
+    for (auto i = 0; i != 1024; ++i)
+    {
+        auto x = std::rand() % 100000;
+        auto y = std::rand() % 100000;
+        windows.emplace_back(
+            interval<int> {x, x + 500}, interval<int> {y, y + 500});
+    }
+    for (auto _ : state)
+    {
+        auto count = std::size_t(0);
+        for (auto&& w : windows)
+        {
+            tree.query(w, [&count](std::uint32_t) { ++count; });
+        }
+        benchmark::DoNotOptimize(count);
+    }
+    state.SetItemsProcessed(state.iterations() * 1024);
+}
+BENCHMARK(BM_rstar_query)->Arg(1 << 16)->Arg(1 << 20);
@@ -0,0 +1,496 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Grid index that readers query while a writer keeps editing it
+ *
+ * The index is a sequence of immutable versions. A version is a table of
+ * pointers to immutable tiles (the bins of a uniform grid), each holding
+ * the ids and rectangles of the shapes that meet it. The writer stages
+ * edits (insert, remove, move) with stable ids, like incremental_drc, and
+ * commit() copies only the tiles touched by the batch, shares all others
+ * with the previous version and publishes the new version with one
+ * atomic store. Readers never take a lock and never see a half-applied
+ * batch; the writer never waits for readers.
+ *
+ * Old versions and the tiles they no longer share are reclaimed by
+ * epochs: every reader thread owns a slot (cache-line sized) in which it
+ * announces the global epoch while it holds a version. A version retired
+ * at epoch e is freed by a later commit (or reclaim()) once no slot
+ * announces an epoch below e. A stalled reader thus delays reclamation,
+ * never the writer.
+ *
+ * There must be at most one writer thread, and each reader slot must be
+ * used by one thread at a time.
+ *
+ * @tparam T
+ */
+template <typename T>
+class concurrent_index
+{
+  private:
+    struct tile
+    {
+        std::vector<std::uint32_t> ids;
+        std::vector<rectangle<T>> rects;
+    };
+
+    struct version
+    {
+        std::vector<const tile*> tiles;
+        std::size_t size;
+        std::uint64_t number;
+    };
+
+    struct retired
+    {
+        std::uint64_t epoch;
+        const version* root;
+        std::vector<const tile*> tiles; // replaced by the next version
+    };
+
+    struct alignas(64) reader_slot
+    {
+        std::atomic<std::uint64_t> epoch {0}; // 0 = not reading
+    };
+
+    point<T> _origin;
+    T _pitch;
+    std::size_t _nx;
+    std::size_t _ny;
+    tile _empty_tile;
+    std::atomic<const version*> _current;
+    std::atomic<std::uint64_t> _epoch {1};
+    std::unique_ptr<reader_slot[]> _slots;
+    std::size_t _num_slots;
+    std::vector<retired> _retired;
+
+    // writer state: staged geometry and what the current version holds
+    std::vector<rectangle<T>> _shapes;
+    std::vector<bool> _alive;
+    std::vector<rectangle<T>> _published;
+    std::vector<bool> _published_alive;
+    std::vector<bool> _dirty_flag;
+    std::vector<std::uint32_t> _dirty;
+    std::size_t _num_alive {0};
+
+  public:
+    /**
+     * @brief A consistent read-only view of one committed version
+     *
+     * Holding a reader keeps its version alive; release it (by letting it
+     * go out of scope) promptly so that old versions can be reclaimed.
+     */
+    class reader
+    {
+        friend class concurrent_index;
+
+        const concurrent_index* _index;
+        reader_slot* _slot;
+        const version* _version;
+
+        reader(const concurrent_index* index, reader_slot* slot)
+            : _index {index}
+            , _slot {slot}
+        {
+            assert(slot->epoch.load(std::memory_order_relaxed) == 0);
+            // announce before loading, so that a writer that retires the
+            // loaded version afterwards sees the announcement
+            slot->epoch.store(index->_epoch.load());
+            this->_version = index->_current.load();
+        }
+
+      public:
+        reader(const reader&) = delete;
+        auto operator=(const reader&) -> reader& = delete;
+
+        reader(reader&& other) noexcept
+            : _index {other._index}
+            , _slot {std::exchange(other._slot, nullptr)}
+            , _version {other._version}
+        {
+        }
+
+        auto operator=(reader&&) -> reader& = delete;
+
+        ~reader()
+        {
+            if (this->_slot != nullptr)
+            {
+                this->_slot->epoch.store(0, std::memory_order_release);
+            }
+        }
+
+        /**
+         * @brief number of shapes in this version
+         *
+         * @return std::size_t
+         */
+        [[nodiscard]] auto size() const noexcept -> std::size_t
+        {
+            return this->_version->size;
+        }
+
+        /**
+         * @brief number of commits that led to this version
+         *
+         * @return std::uint64_t
+         */
+        [[nodiscard]] auto number() const noexcept -> std::uint64_t
+        {
+            return this->_version->number;
+        }
+
+        /**
+         * @brief Call fn(id, rect) once for every shape overlapping the
+         * window
+         *
+         * A shape listed in several tiles is reported only from the first
+         * tile, in row-major order, that both it and the window meet, so
+         * queries keep no scratch state.
+         *
+         * @tparam Fn
+         * @param window closed query window
+         * @param fn callable(std::uint32_t, const rectangle<T>&)
+         */
+        template <typename Fn>
+        void query(const rectangle<T>& window, Fn&& fn) const
+        {
+            const auto& idx = *this->_index;
+            const auto x0 = idx._bin_x(window.x().lower());
+            const auto x1 = idx._bin_x(window.x().upper());
+            const auto y0 = idx._bin_y(window.y().lower());
+            const auto y1 = idx._bin_y(window.y().upper());
+            for (auto iy = y0; iy <= y1; ++iy)
+            {
+                for (auto ix = x0; ix <= x1; ++ix)
+                {
+                    const auto* t = this->_version->tiles[iy * idx._nx + ix];
+                    for (auto k = std::size_t(0); k != t->ids.size(); ++k)
+                    {
+                        const auto& r = t->rects[k];
+                        if (!r.overlaps(window))
+                        {
+                            continue;
+                        }
+                        const auto fx =
+                            std::max(x0, idx._bin_x(r.x().lower()));
+                        const auto fy =
+                            std::max(y0, idx._bin_y(r.y().lower()));
+                        if (fx == ix && fy == iy)
+                        {
+                            fn(t->ids[k], r);
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    /**
+     * @brief Construct an empty index
+     *
+     * @param extent region covered by the tiles (shapes may lie outside)
+     * @param pitch tile size
+     * @param max_readers number of reader slots
+     */
+    concurrent_index(
+        const rectangle<T>& extent, const T& pitch, std::size_t max_readers)
+        : _origin {extent.lower()}
+        , _pitch {pitch}
+        , _nx {std::size_t(extent.x().len() / pitch) + 1}
+        , _ny {std::size_t(extent.y().len() / pitch) + 1}
+        , _current {nullptr}
+        , _slots {new reader_slot[std::max<std::size_t>(max_readers, 1)]}
+        , _num_slots {std::max<std::size_t>(max_readers, 1)}
+    {
+        assert(T(0) < pitch);
+        this->_current.store(new version {
+            std::vector<const tile*>(this->_nx * this->_ny, &_empty_tile), 0,
+            0});
+    }
+
+    concurrent_index(const concurrent_index&) = delete;
+    auto operator=(const concurrent_index&) -> concurrent_index& = delete;
+
+    /**
+     * @brief Destroy the index; no reader may be alive
+     *
+     */
+    ~concurrent_index()
+    {
+        for (auto&& r : this->_retired)
+        {
+            this->_free(r);
+        }
+        const auto* v = this->_current.load();
+        for (const auto* t : v->tiles)
+        {
+            if (t != &this->_empty_tile)
+            {
+                delete t;
+            }
+        }
+        delete v;
+    }
+
+    /**
+     * @brief Take a snapshot of the latest committed version
+     *
+     * @param slot reader slot of the calling thread, < max_readers
+     * @return reader
+     */
+    [[nodiscard]] auto read(std::size_t slot) const -> reader
+    {
+        assert(slot < this->_num_slots);
+        return reader {this, &this->_slots[slot]};
+    }
+
+    /**
+     * @brief number of shape ids handed out (including removed ones)
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return this->_shapes.size();
+    }
+
+    /**
+     * @brief stage the insertion of a shape (writer only)
+     *
+     * @param r
+     * @return std::uint32_t its id
+     */
+    auto insert(const rectangle<T>& r) -> std::uint32_t
+    {
+        assert(this->_shapes.size() < std::size_t(UINT32_MAX));
+        const auto id = std::uint32_t(this->_shapes.size());
+        this->_shapes.push_back(r);
+        this->_alive.push_back(true);
+        this->_published.push_back(r);
+        this->_published_alive.push_back(false);
+        this->_dirty_flag.push_back(false);
+        this->_touch(id);
+        return id;
+    }
+
+    /**
+     * @brief stage the removal of a shape (writer only)
+     *
+     * @param id
+     */
+    void remove(std::uint32_t id)
+    {
+        assert(this->_alive[id]);
+        this->_alive[id] = false;
+        this->_touch(id);
+    }
+
+    /**
+     * @brief stage moving (or resizing) a shape (writer only)
+     *
+     * @param id
+     * @param r new geometry
+     */
+    void move(std::uint32_t id, const rectangle<T>& r)
+    {
+        assert(this->_alive[id]);
+        this->_shapes[id] = r;
+        this->_touch(id);
+    }
+
+    /**
+     * @brief Publish the staged edits as a new version (writer only)
+     *
+     * The tiles touched by the batch are rebuilt in parallel; the tile
+     * table itself is copied, so a commit also costs O(number of tiles).
+     *
+     * @param num_threads (0 = hardware concurrency)
+     */
+    void commit(unsigned num_threads = 0)
+    {
+        const auto* old = this->_current.load(std::memory_order_relaxed);
+        // (tile, id) pairs to drop and to add
+        auto drop = std::vector<std::pair<std::size_t, std::uint32_t>> {};
+        auto add = std::vector<std::pair<std::size_t, std::uint32_t>> {};
+        for (auto id : this->_dirty)
+        {
+            if (this->_published_alive[id])
+            {
+                this->_for_tiles(this->_published[id],
+                    [&](std::size_t b) { drop.emplace_back(b, id); });
+            }
+            if (this->_alive[id])
+            {
+                this->_for_tiles(this->_shapes[id],
+                    [&](std::size_t b) { add.emplace_back(b, id); });
+            }
+        }
+        std::sort(add.begin(), add.end());
+        auto touched = std::vector<std::size_t> {};
+        for (auto&& d : drop)
+        {
+            touched.push_back(d.first);
+        }
+        for (auto&& a : add)
+        {
+            touched.push_back(a.first);
+        }
+        std::sort(touched.begin(), touched.end());
+        touched.erase(
+            std::unique(touched.begin(), touched.end()), touched.end());
+
+        auto fresh = std::vector<const tile*>(touched.size());
+        parallel_for(
+            touched.size(),
+            [&](std::size_t k)
+            {
+                const auto b = touched[k];
+                const auto* src = old->tiles[b];
+                auto t = tile {};
+                for (auto i = std::size_t(0); i != src->ids.size(); ++i)
+                {
+                    if (!this->_dirty_flag[src->ids[i]])
+                    {
+                        t.ids.push_back(src->ids[i]);
+                        t.rects.push_back(src->rects[i]);
+                    }
+                }
+                auto it = std::lower_bound(add.begin(), add.end(),
+                    std::pair<std::size_t, std::uint32_t> {b, 0});
+                for (; it != add.end() && it->first == b; ++it)
+                {
+                    t.ids.push_back(it->second);
+                    t.rects.push_back(this->_shapes[it->second]);
+                }
+                fresh[k] = t.ids.empty() ? &this->_empty_tile
+                                         : new tile {std::move(t)};
+            },
+            num_threads);
+
+        for (auto id : this->_dirty)
+        {
+            this->_num_alive -= this->_published_alive[id] ? 1 : 0;
+            this->_num_alive += this->_alive[id] ? 1 : 0;
+            this->_published[id] = this->_shapes[id];
+            this->_published_alive[id] = this->_alive[id];
+            this->_dirty_flag[id] = false;
+        }
+        this->_dirty.clear();
+
+        auto* next =
+            new version {old->tiles, this->_num_alive, old->number + 1};
+        auto gone = retired {0, old, {}};
+        for (auto k = std::size_t(0); k != touched.size(); ++k)
+        {
+            auto& slot = next->tiles[touched[k]];
+            if (slot != &this->_empty_tile)
+            {
+                gone.tiles.push_back(slot);
+            }
+            slot = fresh[k];
+        }
+        this->_current.store(next);
+        // readers announcing this epoch or later loaded `next`
+        gone.epoch = this->_epoch.fetch_add(1) + 1;
+        this->_retired.push_back(std::move(gone));
+        this->reclaim();
+    }
+
+    /**
+     * @brief Free the retired versions no reader can still hold
+     *
+     * @return std::size_t number of versions still waiting
+     */
+    auto reclaim() -> std::size_t
+    {
+        auto oldest = UINT64_MAX;
+        for (auto i = std::size_t(0); i != this->_num_slots; ++i)
+        {
+            const auto e = this->_slots[i].epoch.load();
+            if (e != 0)
+            {
+                oldest = std::min(oldest, e);
+            }
+        }
+        const auto last = std::partition(this->_retired.begin(),
+            this->_retired.end(),
+            [oldest](const retired& r) { return oldest < r.epoch; });
+        std::for_each(last, this->_retired.end(),
+            [this](retired& r) { this->_free(r); });
+        this->_retired.erase(last, this->_retired.end());
+        return this->_retired.size();
+    }
+
+  private:
+    void _free(retired& r)
+    {
+        for (const auto* t : r.tiles)
+        {
+            delete t;
+        }
+        delete r.root;
+    }
+
+    void _touch(std::uint32_t id)
+    {
+        if (!this->_dirty_flag[id])
+        {
+            this->_dirty_flag[id] = true;
+            this->_dirty.push_back(id);
+        }
+    }
+
+    [[nodiscard]] auto _bin_x(const T& x) const -> std::size_t
+    {
+        if (x < this->_origin.x())
+        {
+            return 0;
+        }
+        auto i = std::size_t((x - this->_origin.x()) / this->_pitch);
+        return std::min(i, this->_nx - 1);
+    }
+
+    [[nodiscard]] auto _bin_y(const T& y) const -> std::size_t
+    {
+        if (y < this->_origin.y())
+        {
+            return 0;
+        }
+        auto i = std::size_t((y - this->_origin.y()) / this->_pitch);
+        return std::min(i, this->_ny - 1);
+    }
+
+    /**
+     * @brief call fn(tile) for every tile a rectangle meets
+     */
+    template <typename Fn>
+    void _for_tiles(const rectangle<T>& r, Fn&& fn) const
+    {
+        const auto x0 = this->_bin_x(r.x().lower());
+        const auto x1 = this->_bin_x(r.x().upper());
+        const auto y0 = this->_bin_y(r.y().lower());
+        const auto y1 = this->_bin_y(r.y().upper());
+        for (auto iy = y0; iy <= y1; ++iy)
+        {
+            for (auto ix = x0; ix <= x1; ++ix)
+            {
+                fn(iy * this->_nx + ix);
+            }
+        }
+    }
+};
+
+} // namespace recti
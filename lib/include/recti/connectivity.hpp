@@ -0,0 +1,250 @@
+#pragma once
+
+#include "disjoint_set.hpp"
+#include "grid_index.hpp"
+#include "parallel.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <gsl/span>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Connected component id per shape and the number of components
+ *
+ */
+struct component_labels
+{
+    std::vector<std::uint32_t> component;
+    std::size_t num_components {0};
+};
+
+/**
+ * @brief A via: a rectangle connecting shapes on two layers
+ *
+ * @tparam T
+ */
+template <typename T>
+struct layer_via
+{
+    rectangle<T> shape;
+    std::uint32_t lower_layer;
+    std::uint32_t upper_layer;
+};
+
+namespace detail
+{
+
+/**
+ * @brief Union every touching pair among the shapes of one layer
+ *
+ * The shapes are binned with make_grid_index() and only pairs sharing a
+ * bin are tested. A pair is united only in the bin holding the lower-left
+ * corner of its intersection, so long shapes such as power rails cost
+ * O(bins spanned x shapes per bin) rather than a scan of the whole layer.
+ * Bins are split into ranges of equal estimated pair work, one per
+ * thread.
+ *
+ * @tparam T
+ * @param group the shapes of the layer
+ * @param members index of each group shape into `ids`
+ */
+template <typename T>
+inline void unite_binned(gsl::span<const rectangle<T>> group,
+    gsl::span<const std::uint32_t> members, gsl::span<const std::uint32_t> ids,
+    concurrent_disjoint_set& ds, unsigned num_threads)
+{
+    if (group.size() < 2)
+    {
+        return;
+    }
+    const auto gi = make_grid_index<T>(group, num_threads);
+
+    const auto [nx, ny] = gi.dims();
+    const auto nb = nx * ny;
+    auto work = std::vector<std::size_t>(nb + 1, 0); // strictly increasing
+    for (auto b = std::size_t(0); b != nb; ++b)
+    {
+        const auto k = gi.bin(b % nx, b / nx).size();
+        work[b + 1] = work[b] + k * (k - (k != 0)) / 2 + 1;
+    }
+    const auto pieces = num_chunks(nb, num_threads);
+    parallel_for(
+        pieces,
+        [&](std::size_t t)
+        {
+            auto first_bin = [&](std::size_t p)
+            {
+                const auto target = work[nb] * p / pieces;
+                return std::size_t(
+                    std::lower_bound(work.begin(), work.end(), target) -
+                    work.begin());
+            };
+            const auto last = t + 1 == pieces ? nb : first_bin(t + 1);
+            for (auto b = first_bin(t); b < last; ++b)
+            {
+                const auto cell = std::make_pair(b % nx, b / nx);
+                const auto items = gi.bin(cell.first, cell.second);
+                for (auto u = std::size_t(0); u != items.size(); ++u)
+                {
+                    const auto& a = group[items[u]];
+                    for (auto v = u + 1; v != items.size(); ++v)
+                    {
+                        const auto& c = group[items[v]];
+                        if (!a.overlaps(c))
+                        {
+                            continue;
+                        }
+                        const auto corner =
+                            point<T> {std::max(a.x().lower(), c.x().lower()),
+                                std::max(a.y().lower(), c.y().lower())};
+                        if (gi.locate(corner) == cell)
+                        {
+                            ds.unite(ids[members[items[u]]],
+                                ids[members[items[v]]]);
+                        }
+                    }
+                }
+            }
+        },
+        num_threads);
+}
+
+/**
+ * @brief Union every pair of touching or overlapping shapes of a layer
+ *
+ * `order` lists the items grouped by key; items with different keys never
+ * connect. Each group is handled by unite_binned().
+ *
+ * @tparam T
+ */
+template <typename T>
+inline void unite_touching(gsl::span<const rectangle<T>> shapes,
+    gsl::span<const std::uint32_t> keys, gsl::span<const std::uint32_t> ids,
+    gsl::span<const std::uint32_t> order, concurrent_disjoint_set& ds,
+    unsigned num_threads)
+{
+    auto group = std::vector<rectangle<T>> {};
+    for (auto g0 = std::size_t(0); g0 != order.size();)
+    {
+        auto g1 = g0 + 1;
+        while (g1 != order.size() && keys[order[g1]] == keys[order[g0]])
+        {
+            ++g1;
+        }
+        group.clear();
+        for (auto k = g0; k != g1; ++k)
+        {
+            group.push_back(shapes[order[k]]);
+        }
+        unite_binned<T>(group, order.subspan(g0, g1 - g0), ids, ds,
+            num_threads);
+        g0 = g1;
+    }
+}
+
+/**
+ * @brief dense component ids, numbered by their smallest member
+ */
+inline auto label_components(concurrent_disjoint_set& ds, unsigned num_threads)
+    -> component_labels
+{
+    const auto n = ds.size();
+    auto res = component_labels {};
+    res.component.resize(n);
+    parallel_for(
+        n,
+        [&](std::size_t i) { res.component[i] = ds.find(std::uint32_t(i)); },
+        num_threads);
+    // the root of a set is its smallest member, so it is labelled first
+    for (auto i = 0U; i != n; ++i)
+    {
+        const auto r = res.component[i];
+        res.component[i] = r == i ? std::uint32_t(res.num_components++)
+                                  : res.component[r];
+    }
+    return res;
+}
+
+} // namespace detail
+
+/**
+ * @brief Connected components of touching or overlapping rectangles
+ *
+ * Rectangles are closed, so shapes that merely share an edge or a corner
+ * are connected. Candidate pairs come from a uniform bin grid and are
+ * merged concurrently in a lock-free union-find. Components are numbered
+ * by their smallest member, so the labels do not depend on `num_threads`.
+ *
+ * @tparam T
+ * @param rects
+ * @param num_threads (0 = hardware concurrency)
+ * @return component_labels one id per rectangle
+ */
+template <typename T>
+inline auto connected_components(
+    gsl::span<const rectangle<T>> rects, unsigned num_threads = 0)
+    -> component_labels
+{
+    assert(rects.size() <= std::size_t(UINT32_MAX));
+    auto order = std::vector<std::uint32_t>(rects.size());
+    std::iota(order.begin(), order.end(), 0U);
+    const auto keys = std::vector<std::uint32_t>(rects.size(), 0);
+    auto ids = std::vector<std::uint32_t>(rects.size());
+    std::iota(ids.begin(), ids.end(), 0U);
+    auto ds = concurrent_disjoint_set {rects.size()};
+    detail::unite_touching<T>(rects, keys, ids, order, ds, num_threads);
+    return detail::label_components(ds, num_threads);
+}
+
+/**
+ * @brief Connected components of shapes on several layers joined by vias
+ *
+ * Shapes connect when they touch on the same layer. A via connects every
+ * shape it touches on its lower and on its upper layer. The result has
+ * one id per shape followed by one id per via.
+ *
+ * @tparam T
+ * @param rects
+ * @param layers layer of each rectangle
+ * @param vias
+ * @param num_threads (0 = hardware concurrency)
+ * @return component_labels size rects.size() + vias.size()
+ */
+template <typename T>
+inline auto connected_components(gsl::span<const rectangle<T>> rects,
+    gsl::span<const std::uint32_t> layers, gsl::span<const layer_via<T>> vias,
+    unsigned num_threads = 0) -> component_labels
+{
+    assert(rects.size() == layers.size());
+    assert(rects.size() + 2 * vias.size() <= std::size_t(UINT32_MAX));
+    // a via takes part in the binning of both of its layers
+    auto shapes = std::vector<rectangle<T>>(rects.begin(), rects.end());
+    auto keys = std::vector<std::uint32_t>(layers.begin(), layers.end());
+    auto ids = std::vector<std::uint32_t>(rects.size());
+    std::iota(ids.begin(), ids.end(), 0U);
+    for (auto v = 0U; v != vias.size(); ++v)
+    {
+        const auto id = std::uint32_t(rects.size() + v);
+        shapes.push_back(vias[v].shape);
+        keys.push_back(vias[v].lower_layer);
+        ids.push_back(id);
+        shapes.push_back(vias[v].shape);
+        keys.push_back(vias[v].upper_layer);
+        ids.push_back(id);
+    }
+    auto order = std::vector<std::uint32_t>(shapes.size());
+    std::iota(order.begin(), order.end(), 0U);
+    std::stable_sort(order.begin(), order.end(),
+        [&](auto a, auto b) { return keys[a] < keys[b]; });
+    auto ds = concurrent_disjoint_set {rects.size() + vias.size()};
+    detail::unite_touching<T>(shapes, keys, ids, order, ds, num_threads);
+    return detail::label_components(ds, num_threads);
+}
+
+} // namespace recti
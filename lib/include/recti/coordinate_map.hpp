@@ -0,0 +1,420 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <gsl/span>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Sorted distinct coordinates and their dense 32-bit ranks
+ *
+ * Maps each of the stored values to its rank in [0, size()) and back, so
+ * that kernels can index arrays, Fenwick trees or bit vectors by rank and
+ * compare 32-bit integers instead of T (which may be int64_t or a
+ * Fraction). Only `<` and `==` are required of T; no hashing. Lookups are
+ * binary searches over one contiguous array and are safe to run
+ * concurrently. At most 2^32 - 1 distinct values are supported.
+ *
+ * @tparam T
+ */
+template <typename T>
+class coordinate_map
+{
+  private:
+    std::vector<T> _values; // distinct, sorted
+
+  public:
+    /**
+     * @brief Construct an empty map
+     */
+    coordinate_map() = default;
+
+    /**
+     * @brief Sort and deduplicate the given values
+     *
+     * @param values any order, with repeats
+     * @param num_threads (0 = hardware concurrency)
+     */
+    explicit coordinate_map(std::vector<T> values, unsigned num_threads = 0)
+        : _values {std::move(values)}
+    {
+        parallel_sort(this->_values.begin(), this->_values.end(), num_threads);
+        this->_values.erase(
+            std::unique(this->_values.begin(), this->_values.end()),
+            this->_values.end());
+        this->_values.shrink_to_fit();
+        assert(this->_values.size() < std::size_t(UINT32_MAX));
+    }
+
+    /**
+     * @brief number of distinct values
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return this->_values.size();
+    }
+
+    /**
+     * @brief whether the map holds no values
+     */
+    [[nodiscard]] auto empty() const noexcept -> bool
+    {
+        return this->_values.empty();
+    }
+
+    /**
+     * @brief the distinct values, ascending (index = rank)
+     */
+    [[nodiscard]] auto values() const noexcept -> gsl::span<const T>
+    {
+        return this->_values;
+    }
+
+    /**
+     * @brief Value of a rank (the inverse mapping)
+     *
+     * @param r rank in [0, size())
+     * @return const T&
+     */
+    [[nodiscard]] auto value(std::uint32_t r) const -> const T&
+    {
+        assert(r < this->_values.size());
+        return this->_values[r];
+    }
+
+    /**
+     * @brief whether v is one of the stored values
+     */
+    [[nodiscard]] auto contains(const T& v) const -> bool
+    {
+        return std::binary_search(
+            this->_values.begin(), this->_values.end(), v);
+    }
+
+    /**
+     * @brief Rank of a stored value
+     *
+     * @param v must be one of the stored values
+     * @return std::uint32_t
+     */
+    [[nodiscard]] auto rank(const T& v) const -> std::uint32_t
+    {
+        const auto r = this->lower_rank(v);
+        assert(r < this->_values.size() && this->_values[r] == v);
+        return r;
+    }
+
+    /**
+     * @brief number of stored values below v (first rank >= v)
+     */
+    [[nodiscard]] auto lower_rank(const T& v) const -> std::uint32_t
+    {
+        return std::uint32_t(
+            std::lower_bound(this->_values.begin(), this->_values.end(), v) -
+            this->_values.begin());
+    }
+
+    /**
+     * @brief number of stored values not above v (first rank > v)
+     */
+    [[nodiscard]] auto upper_rank(const T& v) const -> std::uint32_t
+    {
+        return std::uint32_t(
+            std::upper_bound(this->_values.begin(), this->_values.end(), v) -
+            this->_values.begin());
+    }
+
+    /**
+     * @brief Ranks [first, last) of the stored values inside a closed range
+     *
+     * The range may hold values that are not stored; first == last when no
+     * stored value lies inside.
+     *
+     * @param r
+     * @return std::pair<std::uint32_t, std::uint32_t>
+     */
+    [[nodiscard]] auto rank_range(const interval<T>& r) const
+        -> std::pair<std::uint32_t, std::uint32_t>
+    {
+        const auto a = this->lower_rank(r.lower());
+        return {a, std::max(a, this->upper_rank(r.upper()))};
+    }
+
+    /**
+     * @brief Ranks of many stored values, in parallel
+     *
+     * @param vs each must be one of the stored values
+     * @param num_threads (0 = hardware concurrency)
+     * @return std::vector<std::uint32_t>
+     */
+    [[nodiscard]] auto ranks(gsl::span<const T> vs,
+        unsigned num_threads = 0) const -> std::vector<std::uint32_t>
+    {
+        auto res = std::vector<std::uint32_t>(vs.size());
+        parallel_for(
+            vs.size(), [&](std::size_t i) { res[i] = this->rank(vs[i]); },
+            num_threads);
+        return res;
+    }
+};
+
+/**
+ * @brief Append the x and y coordinates of points
+ */
+template <typename T>
+inline void collect_coordinates(gsl::span<const point<T>> pts,
+    std::vector<T>& xs, std::vector<T>& ys)
+{
+    for (auto&& p : pts)
+    {
+        xs.push_back(p.x());
+        ys.push_back(p.y());
+    }
+}
+
+/**
+ * @brief Append the end points of intervals
+ */
+template <typename T>
+inline void collect_coordinates(
+    gsl::span<const interval<T>> ivs, std::vector<T>& vs)
+{
+    for (auto&& iv : ivs)
+    {
+        vs.push_back(iv.lower());
+        vs.push_back(iv.upper());
+    }
+}
+
+/**
+ * @brief Append the x and y bounds of rectangles
+ */
+template <typename T>
+inline void collect_coordinates(gsl::span<const rectangle<T>> rects,
+    std::vector<T>& xs, std::vector<T>& ys)
+{
+    for (auto&& r : rects)
+    {
+        xs.push_back(r.x().lower());
+        xs.push_back(r.x().upper());
+        ys.push_back(r.y().lower());
+        ys.push_back(r.y().upper());
+    }
+}
+
+/**
+ * @brief Append the x range and y of horizontal segments
+ */
+template <typename T>
+inline void collect_coordinates(gsl::span<const hsegment<T>> segs,
+    std::vector<T>& xs, std::vector<T>& ys)
+{
+    for (auto&& s : segs)
+    {
+        xs.push_back(s.x().lower());
+        xs.push_back(s.x().upper());
+        ys.push_back(s.y());
+    }
+}
+
+/**
+ * @brief Append the x and y range of vertical segments
+ */
+template <typename T>
+inline void collect_coordinates(gsl::span<const vsegment<T>> segs,
+    std::vector<T>& xs, std::vector<T>& ys)
+{
+    for (auto&& s : segs)
+    {
+        xs.push_back(s.x());
+        ys.push_back(s.y().lower());
+        ys.push_back(s.y().upper());
+    }
+}
+
+/**
+ * @brief Independent x and y coordinate maps of a set of shapes
+ *
+ * Collect the coordinates of everything that has to share one rank space
+ * with collect_coordinates(), build once, then hand the same rank_space
+ * to every kernel rather than letting each one sort its own copy:
+ *
+ *     auto xs = std::vector<T> {}, ys = std::vector<T> {};
+ *     collect_coordinates<T>(pins, xs, ys);
+ *     collect_coordinates<T>(blockages, xs, ys);
+ *     const auto rs = rank_space<T> {std::move(xs), std::move(ys)};
+ *     const auto rpins = rs.to_ranks(pins);
+ *
+ * Ranks preserve order and equality, so any predicate built from
+ * comparisons (overlap, containment, sweep order) gives the same answer
+ * in rank space; distances and areas do not carry over.
+ *
+ * @tparam T
+ */
+template <typename T>
+class rank_space
+{
+  private:
+    coordinate_map<T> _x;
+    coordinate_map<T> _y;
+
+  public:
+    /**
+     * @brief Construct an empty rank space
+     */
+    rank_space() = default;
+
+    /**
+     * @brief Build both maps
+     *
+     * @param xs x coordinates, any order, with repeats
+     * @param ys y coordinates, any order, with repeats
+     * @param num_threads (0 = hardware concurrency)
+     */
+    rank_space(std::vector<T> xs, std::vector<T> ys, unsigned num_threads = 0)
+        : _x {std::move(xs), num_threads}
+        , _y {std::move(ys), num_threads}
+    {
+    }
+
+    /**
+     * @brief the x coordinate map
+     */
+    [[nodiscard]] auto x() const noexcept -> const coordinate_map<T>&
+    {
+        return this->_x;
+    }
+
+    /**
+     * @brief the y coordinate map
+     */
+    [[nodiscard]] auto y() const noexcept -> const coordinate_map<T>&
+    {
+        return this->_y;
+    }
+
+    /**
+     * @brief point in rank space (coordinates must be stored)
+     */
+    [[nodiscard]] auto to_rank(const point<T>& p) const
+        -> point<std::uint32_t>
+    {
+        return {this->_x.rank(p.x()), this->_y.rank(p.y())};
+    }
+
+    /**
+     * @brief rectangle in rank space (bounds must be stored)
+     */
+    [[nodiscard]] auto to_rank(const rectangle<T>& r) const
+        -> rectangle<std::uint32_t>
+    {
+        return {interval<std::uint32_t> {this->_x.rank(r.x().lower()),
+                    this->_x.rank(r.x().upper())},
+            interval<std::uint32_t> {
+                this->_y.rank(r.y().lower()), this->_y.rank(r.y().upper())}};
+    }
+
+    /**
+     * @brief horizontal segment in rank space (coordinates must be stored)
+     */
+    [[nodiscard]] auto to_rank(const hsegment<T>& s) const
+        -> hsegment<std::uint32_t>
+    {
+        return {interval<std::uint32_t> {this->_x.rank(s.x().lower()),
+                    this->_x.rank(s.x().upper())},
+            this->_y.rank(s.y())};
+    }
+
+    /**
+     * @brief vertical segment in rank space (coordinates must be stored)
+     */
+    [[nodiscard]] auto to_rank(const vsegment<T>& s) const
+        -> vsegment<std::uint32_t>
+    {
+        return {this->_x.rank(s.x()),
+            interval<std::uint32_t> {
+                this->_y.rank(s.y().lower()), this->_y.rank(s.y().upper())}};
+    }
+
+    /**
+     * @brief Convert many shapes to rank space, in parallel
+     *
+     * @tparam Shapes vector or span of point, rectangle, hsegment or
+     *         vsegment of T
+     * @param shapes
+     * @param num_threads (0 = hardware concurrency)
+     * @return the converted shapes, in input order
+     */
+    template <typename Shapes>
+    [[nodiscard]] auto to_ranks(const Shapes& shapes,
+        unsigned num_threads = 0) const
+    {
+        using R = decltype(this->to_rank(shapes[0]));
+        if (shapes.empty())
+        {
+            return std::vector<R> {};
+        }
+        // the rank shapes have no default constructor: seed with the
+        // first one, then overwrite in parallel
+        auto res = std::vector<R>(shapes.size(), this->to_rank(shapes[0]));
+        parallel_for(
+            shapes.size(),
+            [&](std::size_t i) { res[i] = this->to_rank(shapes[i]); },
+            num_threads);
+        return res;
+    }
+
+    /**
+     * @brief the inverse mapping of a point
+     */
+    [[nodiscard]] auto to_value(const point<std::uint32_t>& p) const
+        -> point<T>
+    {
+        return {this->_x.value(p.x()), this->_y.value(p.y())};
+    }
+
+    /**
+     * @brief the inverse mapping of a rectangle
+     */
+    [[nodiscard]] auto to_value(const rectangle<std::uint32_t>& r) const
+        -> rectangle<T>
+    {
+        return {interval<T> {this->_x.value(r.x().lower()),
+                    this->_x.value(r.x().upper())},
+            interval<T> {
+                this->_y.value(r.y().lower()), this->_y.value(r.y().upper())}};
+    }
+
+    /**
+     * @brief Closed window in rank space
+     *
+     * The bounds need not be stored: the result covers exactly the ranks
+     * whose values lie inside the window.
+     *
+     * @param w
+     * @param[out] res the window in rank space, when not empty
+     * @return false if no stored x or no stored y lies inside the window
+     */
+    [[nodiscard]] auto window(
+        const rectangle<T>& w, rectangle<std::uint32_t>& res) const -> bool
+    {
+        const auto [a, b] = this->_x.rank_range(w.x());
+        const auto [c, d] = this->_y.rank_range(w.y());
+        if (a == b || c == d)
+        {
+            return false;
+        }
+        res = rectangle<std::uint32_t> {interval<std::uint32_t> {a, b - 1},
+            interval<std::uint32_t> {c, d - 1}};
+        return true;
+    }
+};
+
+} // namespace recti
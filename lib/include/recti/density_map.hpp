@@ -0,0 +1,398 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <gsl/span>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Placement density-bin map with a summed-area table
+ *
+ * The extent is cut into nx * ny bins of a fixed pitch (the last row and
+ * column may reach past the extent). Every rectangle contributes its exact
+ * overlap area to each bin it touches; parts outside the bins are dropped.
+ * A summed-area table over the bins answers the occupied area of any block
+ * of bins in O(1).
+ *
+ * add() and remove() update the bin areas immediately and the table lazily:
+ * the next query rebuilds it from the lowest modified bin row upward.
+ * Queries may therefore rebuild the table, so they must not run
+ * concurrently with each other while modifications are pending.
+ *
+ * @tparam T
+ */
+template <typename T>
+class density_map
+{
+  private:
+    point<T> _origin;
+    T _pitch_x;
+    T _pitch_y;
+    std::size_t _nx;
+    std::size_t _ny;
+    std::vector<T> _bins;        // nx * ny, row-major
+    mutable std::vector<T> _sat; // (nx + 1) * (ny + 1), zero first row/column
+    mutable std::size_t _dirty_row;
+
+  public:
+    /**
+     * @brief Construct a new density map object
+     *
+     * @param extent
+     * @param pitch_x bin width
+     * @param pitch_y bin height
+     */
+    density_map(const rectangle<T>& extent, const T& pitch_x, const T& pitch_y)
+        : _origin {extent.lower()}
+        , _pitch_x {pitch_x}
+        , _pitch_y {pitch_y}
+        , _nx {_num_bins(extent.x().len(), pitch_x)}
+        , _ny {_num_bins(extent.y().len(), pitch_y)}
+        , _bins(_nx * _ny, T(0))
+        , _sat((_nx + 1) * (_ny + 1), T(0))
+        , _dirty_row {_ny}
+    {
+    }
+
+    /**
+     * @brief (Re)build the map from a set of rectangles
+     *
+     * Bin rows are split into bands, one per thread, so no two threads
+     * write the same bin. The rectangles are first bucketed by the bands
+     * they touch, in CSR form with two counting passes as in grid_index,
+     * so each band thread reads only its own bucket: O(n + bins) work in
+     * total rather than O(threads * n). Within a bin, areas are summed in
+     * rectangle order whatever the thread count. The summed-area table is
+     * then built with a parallel pass over rows followed by one over
+     * columns.
+     *
+     * @param rects
+     * @param num_threads (0 = hardware concurrency)
+     */
+    void build(gsl::span<const rectangle<T>> rects, unsigned num_threads = 0)
+    {
+        std::fill(this->_bins.begin(), this->_bins.end(), T(0));
+        const auto n = rects.size();
+        assert(n <= std::size_t(UINT32_MAX));
+        const auto nb = std::size_t(num_chunks(this->_ny, num_threads));
+        const auto band = (this->_ny + nb - 1) / nb;
+        const auto nt = num_chunks(n, num_threads);
+        auto cursor = std::vector<std::vector<std::size_t>>(
+            nt, std::vector<std::size_t>(nb, 0));
+        auto for_each_band = [&](std::size_t id, auto&& visit)
+        {
+            const auto [iy0, iy1] = this->_rows(rects[id]);
+            for (auto b = iy0 / band; iy0 <= iy1 && b <= iy1 / band; ++b)
+            {
+                visit(b);
+            }
+        };
+
+        // pass 1: count
+        parallel_chunks(
+            n,
+            [&](unsigned tid, std::size_t first, std::size_t last)
+            {
+                auto& cnt = cursor[tid];
+                for (auto id = first; id != last; ++id)
+                {
+                    for_each_band(id, [&cnt](std::size_t b) { ++cnt[b]; });
+                }
+            },
+            nt);
+
+        auto start = std::vector<std::size_t>(nb + 1, 0);
+        auto total = std::size_t(0);
+        for (auto b = std::size_t(0); b != nb; ++b)
+        {
+            start[b] = total;
+            for (auto&& cnt : cursor)
+            {
+                const auto c = cnt[b];
+                cnt[b] = total;
+                total += c;
+            }
+        }
+        start[nb] = total;
+        auto items = std::vector<std::uint32_t>(total);
+
+        // pass 2: fill
+        parallel_chunks(
+            n,
+            [&](unsigned tid, std::size_t first, std::size_t last)
+            {
+                auto& pos = cursor[tid];
+                for (auto id = first; id != last; ++id)
+                {
+                    for_each_band(id,
+                        [&](std::size_t b)
+                        { items[pos[b]++] = std::uint32_t(id); });
+                }
+            },
+            nt);
+
+        // one band per thread, over its own bucket only
+        parallel_for(
+            nb,
+            [&](std::size_t b)
+            {
+                const auto row0 = std::min(this->_ny, b * band);
+                const auto row1 = std::min(this->_ny, row0 + band);
+                for (auto k = start[b]; k != start[b + 1]; ++k)
+                {
+                    this->_accumulate(rects[items[k]], row0, row1, true);
+                }
+            },
+            unsigned(nb));
+        this->_dirty_row = 0;
+        this->_rebuild(num_threads);
+    }
+
+    /**
+     * @brief add the area of a rectangle
+     *
+     * @param r
+     */
+    void add(const rectangle<T>& r)
+    {
+        this->_accumulate(r, 0, this->_ny, true);
+    }
+
+    /**
+     * @brief remove the area of a previously added rectangle
+     *
+     * @param r
+     */
+    void remove(const rectangle<T>& r)
+    {
+        this->_accumulate(r, 0, this->_ny, false);
+    }
+
+    /**
+     * @brief number of bins in x and y
+     *
+     * @return std::pair<std::size_t, std::size_t>
+     */
+    [[nodiscard]] auto dims() const noexcept
+        -> std::pair<std::size_t, std::size_t>
+    {
+        return {this->_nx, this->_ny};
+    }
+
+    /**
+     * @brief occupied area of bin (ix, iy)
+     *
+     * @param ix
+     * @param iy
+     * @return T
+     */
+    [[nodiscard]] auto bin_area(std::size_t ix, std::size_t iy) const -> T
+    {
+        return this->_bins[iy * this->_nx + ix];
+    }
+
+    /**
+     * @brief the region covered by bin (ix, iy)
+     *
+     * @param ix
+     * @param iy
+     * @return rectangle<T>
+     */
+    [[nodiscard]] auto bin_rect(std::size_t ix, std::size_t iy) const
+        -> rectangle<T>
+    {
+        const auto x = this->_origin.x() + T(ix) * this->_pitch_x;
+        const auto y = this->_origin.y() + T(iy) * this->_pitch_y;
+        return {interval<T> {x, x + this->_pitch_x},
+            interval<T> {y, y + this->_pitch_y}};
+    }
+
+    /**
+     * @brief occupied area of bins [ix0, ix1] x [iy0, iy1] in O(1)
+     *
+     * @param ix0
+     * @param iy0
+     * @param ix1 (inclusive)
+     * @param iy1 (inclusive)
+     * @return T
+     */
+    [[nodiscard]] auto area(std::size_t ix0, std::size_t iy0, std::size_t ix1,
+        std::size_t iy1) const -> T
+    {
+        assert(ix0 <= ix1 && ix1 < this->_nx && iy0 <= iy1 && iy1 < this->_ny);
+        if (this->_dirty_row != this->_ny)
+        {
+            this->_rebuild(1);
+        }
+        const auto w = this->_nx + 1;
+        return this->_sat[(iy1 + 1) * w + ix1 + 1] -
+            this->_sat[iy0 * w + ix1 + 1] - this->_sat[(iy1 + 1) * w + ix0] +
+            this->_sat[iy0 * w + ix0];
+    }
+
+    /**
+     * @brief occupied area of all bins overlapping a window
+     *
+     * The result is exact when the window is aligned to bin boundaries.
+     *
+     * @param window
+     * @return T
+     */
+    [[nodiscard]] auto area(const rectangle<T>& window) const -> T
+    {
+        const auto ix0 = this->_index(
+            window.x().lower() - this->_origin.x(), this->_pitch_x, this->_nx);
+        const auto ix1 = this->_last_index(
+            window.x().upper() - this->_origin.x(), this->_pitch_x, this->_nx);
+        const auto iy0 = this->_index(
+            window.y().lower() - this->_origin.y(), this->_pitch_y, this->_ny);
+        const auto iy1 = this->_last_index(
+            window.y().upper() - this->_origin.y(), this->_pitch_y, this->_ny);
+        return this->area(ix0, iy0, std::max(ix0, ix1), std::max(iy0, iy1));
+    }
+
+  private:
+    static auto _num_bins(const T& len, const T& pitch) -> std::size_t
+    {
+        assert(T(0) < pitch);
+        auto n = std::size_t(len / pitch);
+        if (T(n) * pitch < len)
+        {
+            ++n;
+        }
+        return std::max(n, std::size_t(1));
+    }
+
+    // bin containing offset d (clamped)
+    static auto _index(const T& d, const T& pitch, std::size_t n)
+        -> std::size_t
+    {
+        if (d < T(0))
+        {
+            return 0;
+        }
+        return std::min(std::size_t(d / pitch), n - 1);
+    }
+
+    // last bin whose interior lies below offset d (clamped)
+    static auto _last_index(const T& d, const T& pitch, std::size_t n)
+        -> std::size_t
+    {
+        auto i = _index(d, pitch, n);
+        if (i != 0 && !(T(i) * pitch < d))
+        {
+            --i; // d is on the lower boundary of bin i
+        }
+        return i;
+    }
+
+    /**
+     * @brief rows [first, last] that r may overlap (none if last < first)
+     */
+    auto _rows(const rectangle<T>& r) const
+        -> std::pair<std::size_t, std::size_t>
+    {
+        return {_index(r.y().lower() - this->_origin.y(), this->_pitch_y,
+                    this->_ny),
+            _last_index(r.y().upper() - this->_origin.y(), this->_pitch_y,
+                this->_ny)};
+    }
+
+    /**
+     * @brief Add (or subtract) the bin overlaps of r within rows [row0, row1)
+     */
+    void _accumulate(
+        const rectangle<T>& r, std::size_t row0, std::size_t row1, bool add)
+    {
+        const auto rx0 = r.x().lower() - this->_origin.x();
+        const auto rx1 = r.x().upper() - this->_origin.x();
+        const auto ry0 = r.y().lower() - this->_origin.y();
+        const auto ry1 = r.y().upper() - this->_origin.y();
+        const auto iy0 = std::max(row0, _index(ry0, this->_pitch_y, this->_ny));
+        const auto iy1 = _last_index(ry1, this->_pitch_y, this->_ny);
+        const auto ix0 = _index(rx0, this->_pitch_x, this->_nx);
+        const auto ix1 = _last_index(rx1, this->_pitch_x, this->_nx);
+        for (auto iy = iy0; iy < row1 && iy <= iy1; ++iy)
+        {
+            const auto b0 = T(iy) * this->_pitch_y;
+            const auto h =
+                std::min(ry1, b0 + this->_pitch_y) - std::max(ry0, b0);
+            if (!(T(0) < h))
+            {
+                continue;
+            }
+            for (auto ix = ix0; ix <= ix1; ++ix)
+            {
+                const auto a0 = T(ix) * this->_pitch_x;
+                const auto w =
+                    std::min(rx1, a0 + this->_pitch_x) - std::max(rx0, a0);
+                if (!(T(0) < w))
+                {
+                    continue;
+                }
+                auto& bin = this->_bins[iy * this->_nx + ix];
+                if (add)
+                {
+                    bin += w * h;
+                }
+                else
+                {
+                    bin -= w * h;
+                }
+            }
+        }
+        if (row0 == 0 && row1 == this->_ny)
+        {
+            this->_dirty_row = std::min(this->_dirty_row, iy0);
+        }
+    }
+
+    /**
+     * @brief Rebuild the summed-area table from row _dirty_row upward
+     *
+     * @param num_threads
+     */
+    void _rebuild(unsigned num_threads) const
+    {
+        const auto w = this->_nx + 1;
+        const auto first = this->_dirty_row;
+        // row prefix sums
+        parallel_for(
+            this->_ny - first,
+            [&](std::size_t k)
+            {
+                const auto iy = first + k;
+                auto* row = &this->_sat[(iy + 1) * w];
+                const auto* bins = &this->_bins[iy * this->_nx];
+                auto sum = T(0);
+                for (auto ix = 0U; ix != this->_nx; ++ix)
+                {
+                    sum += bins[ix];
+                    row[ix + 1] = sum;
+                }
+            },
+            num_threads);
+        // column prefix sums
+        parallel_for(
+            this->_nx,
+            [&](std::size_t ix)
+            {
+                for (auto iy = first; iy != this->_ny; ++iy)
+                {
+                    this->_sat[(iy + 1) * w + ix + 1] +=
+                        this->_sat[iy * w + ix + 1];
+                }
+            },
+            num_threads);
+        this->_dirty_row = this->_ny;
+    }
+};
+
+} // namespace recti
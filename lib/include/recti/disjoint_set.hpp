@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Disjoint-set forest (union-find) over dense indices
+ *
+ * Union by size with path halving.
+ */
+class disjoint_set
+{
+  private:
+    std::vector<std::uint32_t> _parent;
+    std::vector<std::uint32_t> _size;
+
+  public:
+    /**
+     * @brief Construct a new disjoint set object with n singletons
+     *
+     * @param n
+     */
+    explicit disjoint_set(std::size_t n)
+        : _parent(n)
+        , _size(n, 1)
+    {
+        std::iota(this->_parent.begin(), this->_parent.end(), 0U);
+    }
+
+    /**
+     * @brief representative of the set containing a
+     *
+     * @param a
+     * @return std::uint32_t
+     */
+    auto find(std::uint32_t a) -> std::uint32_t
+    {
+        while (this->_parent[a] != a)
+        {
+            this->_parent[a] = this->_parent[this->_parent[a]];
+            a = this->_parent[a];
+        }
+        return a;
+    }
+
+    /**
+     * @brief merge the sets containing a and b
+     *
+     * @param a
+     * @param b
+     * @return true if they were disjoint
+     * @return false
+     */
+    auto unite(std::uint32_t a, std::uint32_t b) -> bool
+    {
+        a = this->find(a);
+        b = this->find(b);
+        if (a == b)
+        {
+            return false;
+        }
+        if (this->_size[a] < this->_size[b])
+        {
+            std::swap(a, b);
+        }
+        this->_parent[b] = a;
+        this->_size[a] += this->_size[b];
+        return true;
+    }
+};
+
+/**
+ * @brief Lock-free disjoint-set forest for concurrent unions
+ *
+ * Roots are linked by index (the larger root points to the smaller one)
+ * with a compare-and-swap, and find() halves paths with a CAS that may
+ * fail harmlessly. The representative of a set is therefore always
+ * its smallest member, independently of the order of the unions, so the
+ * final partition and representatives are deterministic.
+ */
+class concurrent_disjoint_set
+{
+  private:
+    std::size_t _n;
+    std::unique_ptr<std::atomic<std::uint32_t>[]> _parent;
+
+  public:
+    /**
+     * @brief Construct a new concurrent disjoint set object with n singletons
+     *
+     * @param n
+     */
+    explicit concurrent_disjoint_set(std::size_t n)
+        : _n {n}
+        , _parent {new std::atomic<std::uint32_t>[n]}
+    {
+        for (auto i = 0U; i != n; ++i)
+        {
+            this->_parent[i].store(
+                std::uint32_t(i), std::memory_order_relaxed);
+        }
+    }
+
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return this->_n;
+    }
+
+    /**
+     * @brief representative (smallest member) of the set containing a
+     *
+     * Exact once no union is in flight.
+     *
+     * @param a
+     * @return std::uint32_t
+     */
+    auto find(std::uint32_t a) -> std::uint32_t
+    {
+        for (;;)
+        {
+            auto p = this->_parent[a].load(std::memory_order_acquire);
+            if (p == a)
+            {
+                return a;
+            }
+            const auto gp = this->_parent[p].load(std::memory_order_acquire);
+            if (gp != p)
+            {
+                this->_parent[a].compare_exchange_weak(
+                    p, gp, std::memory_order_acq_rel);
+            }
+            a = gp;
+        }
+    }
+
+    /**
+     * @brief merge the sets containing a and b; safe to call concurrently
+     *
+     * @param a
+     * @param b
+     * @return true if this call linked two sets
+     * @return false
+     */
+    auto unite(std::uint32_t a, std::uint32_t b) -> bool
+    {
+        for (;;)
+        {
+            a = this->find(a);
+            b = this->find(b);
+            if (a == b)
+            {
+                return false;
+            }
+            if (a < b)
+            {
+                std::swap(a, b);
+            }
+            // a is the larger root: link it below b unless it moved meanwhile
+            auto expected = a;
+            if (this->_parent[a].compare_exchange_strong(
+                    expected, b, std::memory_order_acq_rel))
+            {
+                return true;
+            }
+        }
+    }
+};
+
+} // namespace recti
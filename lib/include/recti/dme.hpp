@@ -0,0 +1,347 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "recti.hpp"
+#include "trr.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <gsl/span>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Zero-skew clock tree
+ *
+ * Nodes are numbered with the sinks first (0 .. n - 1, the input order)
+ * followed by the n - 1 merge nodes. Node i hangs below parents[i] by a
+ * wire of electrical length wires[i]; this is at least the L1 distance
+ * between the two positions, and any excess is snaking. Under the linear
+ * (path length) delay model every sink is exactly `delay` away from the
+ * root.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct zero_skew_tree
+{
+    static constexpr auto none = std::uint32_t(-1);
+
+    std::vector<point<T>> positions;
+    std::vector<std::uint32_t> parents;
+    std::vector<T> wires;
+    std::uint32_t root {none};
+    T delay {0};
+    T length {0};
+};
+
+namespace detail
+{
+
+/**
+ * @brief Deferred-merge embedding over a means-and-medians topology
+ *
+ * The topology recursively halves the sinks at the median of the wider
+ * bounding-box side. A range [first, last) of the sorted sink order is
+ * always split at first + (last - first) / 2, so its merge node can be
+ * numbered n + split - 1 before the range is even partitioned; disjoint
+ * subtrees can therefore be built, merged and embedded on separate
+ * threads without any coordination.
+ *
+ * @tparam T
+ */
+template <typename T>
+class dme_engine
+{
+  private:
+    gsl::span<const point<T>> _sinks;
+    std::vector<std::uint32_t> _order; // sink indices, partitioned
+    std::vector<trr<T>> _ms;           // merging segments
+    std::vector<T> _delay;             // node to any sink below it
+    std::vector<point<T>> _pos;        // rotated positions
+    zero_skew_tree<T>& _tree;
+
+  public:
+    dme_engine(gsl::span<const point<T>> sinks, zero_skew_tree<T>& tree)
+        : _sinks {sinks}
+        , _order(sinks.size())
+        , _ms(2 * sinks.size() - 1, trr<T> {sinks[0]})
+        , _delay(2 * sinks.size() - 1, T(0))
+        , _pos(2 * sinks.size() - 1, sinks[0])
+        , _tree {tree}
+    {
+        std::iota(this->_order.begin(), this->_order.end(), 0U);
+        for (auto i = 0U; i != sinks.size(); ++i)
+        {
+            this->_ms[i] = trr<T> {sinks[i]};
+        }
+        tree.parents.assign(2 * sinks.size() - 1, zero_skew_tree<T>::none);
+        tree.wires.assign(2 * sinks.size() - 1, T(0));
+    }
+
+    void run(unsigned num_threads)
+    {
+        const auto n = this->_sinks.size();
+        // split the top of the topology serially until there are enough
+        // independent subtrees to keep every thread busy
+        auto top = std::vector<std::pair<std::size_t, std::size_t>> {};
+        auto tasks = std::vector<std::pair<std::size_t, std::size_t>> {};
+        auto pending = std::vector<std::pair<std::size_t, std::size_t>> {
+            {std::size_t(0), n}};
+        const auto want = 4 * std::size_t(num_workers(num_threads));
+        while (!pending.empty())
+        {
+            const auto [first, last] = pending.back();
+            pending.pop_back();
+            if (last - first < 2 || tasks.size() + pending.size() >= want)
+            {
+                tasks.emplace_back(first, last);
+                continue;
+            }
+            const auto mid = this->_split(first, last);
+            top.emplace_back(first, last);
+            pending.emplace_back(mid, last);
+            pending.emplace_back(first, mid);
+        }
+
+        parallel_for(
+            tasks.size(),
+            [&](std::size_t k)
+            { this->_build(tasks[k].first, tasks[k].second); },
+            num_threads);
+        for (auto it = top.rbegin(); it != top.rend(); ++it)
+        {
+            const auto [first, last] = *it;
+            const auto mid = first + (last - first) / 2;
+            this->_merge(this->_id(first, last), this->_id(first, mid),
+                this->_id(mid, last));
+        }
+
+        // embed: the root as close as possible to the middle of the sinks,
+        // then every node as close as possible to its placed parent
+        const auto root = this->_id(0, n);
+        auto box = this->_ms[0].rotated();
+        for (auto i = 1U; i != n; ++i)
+        {
+            const auto& r = this->_ms[i].rotated();
+            box = rectangle<T> {
+                interval<T> {std::min(box.x().lower(), r.x().lower()),
+                    std::max(box.x().upper(), r.x().upper())},
+                interval<T> {std::min(box.y().lower(), r.y().lower()),
+                    std::max(box.y().upper(), r.y().upper())}};
+        }
+        this->_pos[root] = this->_ms[root].nearest_rotated(
+            point<T> {(box.x().lower() + box.x().upper()) / 2,
+                (box.y().lower() + box.y().upper()) / 2});
+        for (auto&& [first, last] : top)
+        {
+            const auto mid = first + (last - first) / 2;
+            const auto p = this->_id(first, last);
+            this->_place(this->_id(first, mid), p);
+            this->_place(this->_id(mid, last), p);
+        }
+        parallel_for(
+            tasks.size(),
+            [&](std::size_t k)
+            { this->_embed(tasks[k].first, tasks[k].second); },
+            num_threads);
+
+        auto& tree = this->_tree;
+        tree.root = root;
+        tree.delay = this->_delay[root];
+        tree.positions.assign(this->_sinks.begin(), this->_sinks.end());
+        for (auto i = n; i != this->_pos.size(); ++i)
+        {
+            tree.positions.push_back(unrotate45(this->_pos[i]));
+        }
+        for (auto&& w : tree.wires)
+        {
+            tree.length += w;
+        }
+    }
+
+  private:
+    /**
+     * @brief node of the subtree over _order[first, last)
+     */
+    [[nodiscard]] auto _id(std::size_t first, std::size_t last) const
+        -> std::uint32_t
+    {
+        return last - first == 1
+            ? this->_order[first]
+            : std::uint32_t(this->_sinks.size() + first + (last - first) / 2 -
+                  1);
+    }
+
+    /**
+     * @brief partition _order[first, last) at its median, return the split
+     */
+    auto _split(std::size_t first, std::size_t last) -> std::size_t
+    {
+        const auto& s = this->_sinks;
+        auto xl = s[this->_order[first]].x();
+        auto xh = xl;
+        auto yl = s[this->_order[first]].y();
+        auto yh = yl;
+        for (auto i = first + 1; i != last; ++i)
+        {
+            const auto& p = s[this->_order[i]];
+            xl = std::min(xl, p.x());
+            xh = std::max(xh, p.x());
+            yl = std::min(yl, p.y());
+            yh = std::max(yh, p.y());
+        }
+        const auto by_x = !(xh - xl < yh - yl);
+        const auto mid = first + (last - first) / 2;
+        auto begin = this->_order.begin();
+        std::nth_element(begin + std::ptrdiff_t(first),
+            begin + std::ptrdiff_t(mid), begin + std::ptrdiff_t(last),
+            [&](std::uint32_t a, std::uint32_t b)
+            {
+                return by_x ? std::tie(s[a].x(), a) < std::tie(s[b].x(), b)
+                            : std::tie(s[a].y(), a) < std::tie(s[b].y(), b);
+            });
+        return mid;
+    }
+
+    /**
+     * @brief topology and merging segments of a subtree, bottom-up
+     */
+    auto _build(std::size_t first, std::size_t last) -> std::uint32_t
+    {
+        if (last - first == 1)
+        {
+            return this->_order[first];
+        }
+        const auto mid = this->_split(first, last);
+        const auto a = this->_build(first, mid);
+        const auto b = this->_build(mid, last);
+        const auto p = this->_id(first, last);
+        this->_merge(p, a, b);
+        return p;
+    }
+
+    /**
+     * @brief zero-skew merge of children a and b into node p
+     */
+    void _merge(std::uint32_t p, std::uint32_t a, std::uint32_t b)
+    {
+        const auto& ta = this->_delay[a];
+        const auto& tb = this->_delay[b];
+        const auto d = this->_ms[a].distance(this->_ms[b]);
+        auto ea = (d + tb - ta) / 2;
+        auto eb = d - ea;
+        // a subtree too slow for the balance point to lie between the
+        // two segments gets no wire, the other one a snaked detour
+        if (ea < T(0))
+        {
+            ea = T(0);
+            eb = ta - tb;
+        }
+        else if (eb < T(0))
+        {
+            ea = tb - ta;
+            eb = T(0);
+        }
+        const auto ra = this->_ms[a].enlarged(ea).rotated();
+        const auto rb = this->_ms[b].enlarged(eb).rotated();
+        // with ea + eb >= d the two regions touch; clamping only absorbs
+        // rounding in inexact arithmetic
+        auto meet = [](const interval<T>& r, const interval<T>& s)
+        {
+            auto lo = std::max(r.lower(), s.lower());
+            auto hi = std::min(r.upper(), s.upper());
+            if (hi < lo)
+            {
+                lo = hi = (lo + hi) / 2;
+            }
+            return interval<T> {lo, hi};
+        };
+        this->_ms[p] =
+            trr<T> {rectangle<T> {meet(ra.x(), rb.x()), meet(ra.y(), rb.y())}};
+        this->_delay[p] = ta + ea;
+        this->_tree.parents[a] = p;
+        this->_tree.parents[b] = p;
+        this->_tree.wires[a] = ea;
+        this->_tree.wires[b] = eb;
+    }
+
+    /**
+     * @brief position node c next to its already placed parent p
+     */
+    void _place(std::uint32_t c, std::uint32_t p)
+    {
+        this->_pos[c] = this->_ms[c].nearest_rotated(this->_pos[p]);
+    }
+
+    /**
+     * @brief place the nodes below a subtree's (placed) root, top-down
+     */
+    void _embed(std::size_t first, std::size_t last)
+    {
+        if (last - first < 2)
+        {
+            return;
+        }
+        const auto mid = first + (last - first) / 2;
+        const auto p = this->_id(first, last);
+        this->_place(this->_id(first, mid), p);
+        this->_place(this->_id(mid, last), p);
+        this->_embed(first, mid);
+        this->_embed(mid, last);
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Zero-skew clock tree by deferred-merge embedding (DME)
+ *
+ * Bottom-up, every merge node gets the Manhattan arc of points from which
+ * both child subtrees are reached with equal path length; top-down, each
+ * node is then placed on its arc as close as possible to its parent. The
+ * topology is a balanced means-and-medians bipartition of the sinks.
+ * After the top few levels, subtrees are built, merged and embedded in
+ * parallel; the result does not depend on the number of threads.
+ * O(n log n) time.
+ *
+ * The balance points lie at half-integer offsets, which compound down the
+ * tree, so T must be a field type: double, or a rational for exact skew.
+ * Integer sink coordinates can be passed converted, and the tree
+ * positions rounded afterwards if need be.
+ *
+ * @tparam T
+ * @param sinks
+ * @param num_threads (0 = hardware concurrency)
+ * @return zero_skew_tree<T>
+ */
+template <typename T>
+inline auto dme_zero_skew(gsl::span<const point<T>> sinks,
+    unsigned num_threads = 0) -> zero_skew_tree<T>
+{
+    static_assert(!std::is_integral<T>::value,
+        "zero-skew merging needs exact halving; use a floating or rational T");
+    auto tree = zero_skew_tree<T> {};
+    if (sinks.empty())
+    {
+        return tree;
+    }
+    if (sinks.size() == 1)
+    {
+        tree.positions.push_back(sinks[0]);
+        tree.parents.push_back(zero_skew_tree<T>::none);
+        tree.wires.push_back(T(0));
+        tree.root = 0;
+        return tree;
+    }
+    auto engine = detail::dme_engine<T> {sinks, tree};
+    engine.run(num_threads);
+    return tree;
+}
+
+} // namespace recti
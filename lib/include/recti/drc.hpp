@@ -0,0 +1,612 @@
+#pragma once
+
+#include "grid_index.hpp"
+#include "parallel.hpp"
+#include "recti.hpp"
+#include "rpolygon.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <gsl/span>
+#include <numeric>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Kind of a design-rule violation
+ *
+ */
+enum class drc_rule : std::uint8_t
+{
+    spacing,
+    width,
+    enclosure
+};
+
+/**
+ * @brief A design-rule violation
+ *
+ * For spacing, `a` and `b` are the two shapes and `value` is their
+ * edge-to-edge Manhattan distance; for width, `a == b` and `value` is the
+ * offending width; for enclosure, `a` is the inner and `b` the outer shape
+ * set's first shape touching the marker, and `value` is the enclosure
+ * actually achieved. `marker` is the region to look at.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct drc_violation
+{
+    drc_rule rule;
+    std::uint32_t a;
+    std::uint32_t b;
+    T value;
+    rectangle<T> marker;
+};
+
+/**
+ * @brief Number of pieces the checkers hand to one task
+ *
+ * Tiles are consecutive pieces in the order of their left edge. The
+ * violations of a tile are sorted before they are streamed, so the output
+ * order depends on this constant but not on the number of threads.
+ */
+inline constexpr std::size_t drc_tile_size = 4096;
+
+/**
+ * @brief A set of shapes (rectangles and rectilinear polygons) to check
+ *
+ * Every shape is stored as pieces of its horizontal slab decomposition
+ * (used for spacing and enclosure, and for widths along x) and of its
+ * vertical one (for widths along y). A rectangle is its own single piece.
+ *
+ * @tparam T
+ */
+template <typename T>
+class shape_set
+{
+  private:
+    std::vector<rectangle<T>> _hpieces;
+    std::vector<std::uint32_t> _hshape;
+    std::vector<rectangle<T>> _vpieces;
+    std::vector<std::uint32_t> _vshape;
+    std::uint32_t _num_shapes {0};
+
+  public:
+    /**
+     * @brief add a rectangle
+     *
+     * @param r
+     * @return std::uint32_t the shape id
+     */
+    auto add(const rectangle<T>& r) -> std::uint32_t
+    {
+        this->_hpieces.push_back(r);
+        this->_hshape.push_back(this->_num_shapes);
+        this->_vpieces.push_back(r);
+        this->_vshape.push_back(this->_num_shapes);
+        return this->_num_shapes++;
+    }
+
+    /**
+     * @brief add a rectilinear polygon given by its pointset
+     *
+     * @param S
+     * @return std::uint32_t the shape id
+     */
+    auto add(gsl::span<const point<T>> S) -> std::uint32_t
+    {
+        for (auto&& r : rpolygon_slabs<T>(S, false))
+        {
+            this->_hpieces.push_back(r);
+            this->_hshape.push_back(this->_num_shapes);
+        }
+        for (auto&& r : rpolygon_slabs<T>(S, true))
+        {
+            this->_vpieces.push_back(r);
+            this->_vshape.push_back(this->_num_shapes);
+        }
+        return this->_num_shapes++;
+    }
+
+    /**
+     * @brief number of shapes
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return this->_num_shapes;
+    }
+
+    /**
+     * @brief pieces of the horizontal slab decomposition
+     *
+     * @return gsl::span<const rectangle<T>>
+     */
+    [[nodiscard]] auto pieces() const -> gsl::span<const rectangle<T>>
+    {
+        return this->_hpieces;
+    }
+
+    /**
+     * @brief shape id of each piece
+     *
+     * @return gsl::span<const std::uint32_t>
+     */
+    [[nodiscard]] auto piece_shape() const -> gsl::span<const std::uint32_t>
+    {
+        return this->_hshape;
+    }
+
+    /**
+     * @brief pieces of the vertical slab decomposition
+     *
+     * @return gsl::span<const rectangle<T>>
+     */
+    [[nodiscard]] auto vpieces() const -> gsl::span<const rectangle<T>>
+    {
+        return this->_vpieces;
+    }
+
+    /**
+     * @brief shape id of each vertical piece
+     *
+     * @return gsl::span<const std::uint32_t>
+     */
+    [[nodiscard]] auto vpiece_shape() const -> gsl::span<const std::uint32_t>
+    {
+        return this->_vshape;
+    }
+};
+
+namespace detail
+{
+
+/**
+ * @brief gap between two closed intervals (0 if they overlap)
+ */
+template <typename T>
+inline auto gap(const interval<T>& a, const interval<T>& b) -> T
+{
+    return a.upper() < b.lower() ? b.lower() - a.upper()
+        : b.upper() < a.lower()  ? a.lower() - b.upper()
+                                 : T(0);
+}
+
+/**
+ * @brief the span between two closed intervals, or their intersection
+ */
+template <typename T>
+inline auto between(const interval<T>& a, const interval<T>& b) -> interval<T>
+{
+    const auto lo = std::max(a.lower(), b.lower());
+    const auto hi = std::min(a.upper(), b.upper());
+    return hi < lo ? interval<T> {hi, lo} : interval<T> {lo, hi};
+}
+
+/**
+ * @brief Run work over tiles of [0, n) in parallel and stream the results
+ *
+ * At most one tile per worker is in flight, which bounds the memory held
+ * for violations. Tiles are streamed in order, each sorted.
+ *
+ * @param work callable(first, last, std::vector<drc_violation<T>>&)
+ * @param fn callable(const drc_violation<T>&)
+ */
+template <typename T, typename Work, typename Fn>
+inline void drc_tiles(
+    std::size_t n, Work&& work, Fn&& fn, unsigned num_threads)
+{
+    const auto num_tiles = (n + drc_tile_size - 1) / drc_tile_size;
+    const auto nw = std::size_t(num_workers(num_threads));
+    auto out = std::vector<std::vector<drc_violation<T>>>(nw);
+    for (auto first = std::size_t(0); first < num_tiles; first += nw)
+    {
+        const auto count = std::min(nw, num_tiles - first);
+        parallel_for(
+            count,
+            [&](std::size_t i)
+            {
+                auto& v = out[i];
+                v.clear();
+                const auto t = first + i;
+                work(t * drc_tile_size, std::min(n, (t + 1) * drc_tile_size),
+                    v);
+                std::sort(v.begin(), v.end(),
+                    [](const auto& p, const auto& q)
+                    {
+                        return std::tie(p.rule, p.a, p.b, p.marker.x().lower(),
+                                   p.marker.y().lower()) <
+                            std::tie(q.rule, q.a, q.b, q.marker.x().lower(),
+                                q.marker.y().lower());
+                    });
+            },
+            num_threads);
+        for (auto i = 0U; i != count; ++i)
+        {
+            for (auto&& v : out[i])
+            {
+                fn(v);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Spacing check over pieces tagged with (set, shape)
+ *
+ * The pieces are binned with make_grid_index(); piece i looks up the bins
+ * under its window expanded by min_spacing and is compared with the pieces
+ * found there that come after it in left-edge order. A candidate is taken
+ * only in the bin holding the lower-left corner of its overlap with the
+ * window, so no pair is tested twice and the lookups need no shared
+ * state. Long pieces only meet the pieces near them in y. Pairs at
+ * distance 0 touch and are not violations.
+ */
+template <typename T, typename Fn>
+inline void check_spacing_pieces(gsl::span<const rectangle<T>> pieces,
+    gsl::span<const std::uint32_t> set, gsl::span<const std::uint32_t> shape,
+    bool across_sets, const T& min_spacing, Fn&& fn, unsigned num_threads)
+{
+    if (pieces.empty())
+    {
+        return;
+    }
+    auto order = std::vector<std::uint32_t>(pieces.size());
+    std::iota(order.begin(), order.end(), 0U);
+    std::stable_sort(order.begin(), order.end(),
+        [&](auto a, auto b)
+        { return pieces[a].x().lower() < pieces[b].x().lower(); });
+    auto pos = std::vector<std::uint32_t>(pieces.size());
+    for (auto k = 0U; k != order.size(); ++k)
+    {
+        pos[order[k]] = k;
+    }
+    const auto gi = make_grid_index<T>(pieces, num_threads);
+    drc_tiles<T>(
+        order.size(),
+        [&](std::size_t first, std::size_t last,
+            std::vector<drc_violation<T>>& out)
+        {
+            for (auto k = first; k != last; ++k)
+            {
+                const auto i = order[k];
+                const auto& p = pieces[i];
+                const auto w = rectangle<T> {
+                    interval<T> {p.x().lower() - min_spacing,
+                        p.x().upper() + min_spacing},
+                    interval<T> {p.y().lower() - min_spacing,
+                        p.y().upper() + min_spacing}};
+                const auto [x0, y0] = gi.locate(w.lower());
+                const auto [x1, y1] = gi.locate(w.upper());
+                for (auto iy = y0; iy <= y1; ++iy)
+                {
+                    for (auto ix = x0; ix <= x1; ++ix)
+                    {
+                        for (auto j : gi.bin(ix, iy))
+                        {
+                            const auto& q = pieces[j];
+                            if (pos[j] <= k || !q.overlaps(w) ||
+                                gi.locate(point<T> {
+                                    std::max(q.x().lower(), w.x().lower()),
+                                    std::max(q.y().lower(), w.y().lower())}) !=
+                                    std::make_pair(ix, iy))
+                            {
+                                continue;
+                            }
+                            const auto eligible = across_sets
+                                ? set[i] != set[j]
+                                : shape[i] != shape[j];
+                            if (!eligible)
+                            {
+                                continue;
+                            }
+                            const auto d =
+                                gap(p.x(), q.x()) + gap(p.y(), q.y());
+                            if (d == T(0) || !(d < min_spacing))
+                            {
+                                continue;
+                            }
+                            auto a = shape[i];
+                            auto b = shape[j];
+                            if (across_sets ? set[i] != 0 : b < a)
+                            {
+                                std::swap(a, b);
+                            }
+                            out.push_back(drc_violation<T> {drc_rule::spacing,
+                                a, b, d,
+                                rectangle<T> {between(p.x(), q.x()),
+                                    between(p.y(), q.y())}});
+                        }
+                    }
+                }
+            }
+        },
+        fn, num_threads);
+}
+
+/**
+ * @brief whether the union of the candidates covers the window
+ */
+template <typename T>
+inline auto covers(const rectangle<T>& window,
+    const std::vector<rectangle<T>>& cands) -> bool
+{
+    auto xs = std::vector<T> {window.x().lower(), window.x().upper()};
+    for (auto&& c : cands)
+    {
+        if (window.x().lower() < c.x().lower() &&
+            c.x().lower() < window.x().upper())
+        {
+            xs.push_back(c.x().lower());
+        }
+        if (window.x().lower() < c.x().upper() &&
+            c.x().upper() < window.x().upper())
+        {
+            xs.push_back(c.x().upper());
+        }
+    }
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    // a window of zero width is a single slab [x, x]
+    const auto num_slabs = std::max<std::size_t>(xs.size() - 1, 1);
+    auto ys = std::vector<interval<T>> {};
+    for (auto k = 0U; k != num_slabs; ++k)
+    {
+        const auto& x0 = xs[k];
+        const auto& x1 = xs[std::min<std::size_t>(k + 1, xs.size() - 1)];
+        ys.clear();
+        for (auto&& c : cands)
+        {
+            if (!(x0 < c.x().lower()) && !(c.x().upper() < x1))
+            {
+                ys.push_back(c.y());
+            }
+        }
+        std::sort(ys.begin(), ys.end(),
+            [](const auto& a, const auto& b) { return a.lower() < b.lower(); });
+        auto cur = window.y().lower();
+        for (auto&& y : ys)
+        {
+            if (cur < y.lower())
+            {
+                break;
+            }
+            cur = std::max(cur, y.upper());
+        }
+        if (cur < window.y().upper())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+
+/**
+ * @brief Minimum-spacing check between the shapes of one set
+ *
+ * Reports every pair of pieces of different shapes whose edge-to-edge
+ * Manhattan distance is positive and below min_spacing, with a < b.
+ * Pieces of the same shape are not checked against each other.
+ *
+ * @tparam T
+ * @tparam Fn
+ * @param s
+ * @param min_spacing
+ * @param fn callable(const drc_violation<T>&), called from this thread
+ * @param num_threads (0 = hardware concurrency)
+ */
+template <typename T, typename Fn>
+inline void check_spacing(const shape_set<T>& s, const T& min_spacing,
+    Fn&& fn, unsigned num_threads = 0)
+{
+    const auto set = std::vector<std::uint32_t>(s.pieces().size(), 0);
+    detail::check_spacing_pieces<T>(s.pieces(), set, s.piece_shape(), false,
+        min_spacing, fn, num_threads);
+}
+
+/**
+ * @brief Minimum-spacing check between two shape sets
+ *
+ * `a` is a shape of `s1` and `b` one of `s2`.
+ *
+ * @tparam T
+ * @tparam Fn
+ * @param s1
+ * @param s2
+ * @param min_spacing
+ * @param fn callable(const drc_violation<T>&), called from this thread
+ * @param num_threads (0 = hardware concurrency)
+ */
+template <typename T, typename Fn>
+inline void check_spacing(const shape_set<T>& s1, const shape_set<T>& s2,
+    const T& min_spacing, Fn&& fn, unsigned num_threads = 0)
+{
+    auto pieces = std::vector<rectangle<T>>(
+        s1.pieces().begin(), s1.pieces().end());
+    pieces.insert(pieces.end(), s2.pieces().begin(), s2.pieces().end());
+    auto shape = std::vector<std::uint32_t>(
+        s1.piece_shape().begin(), s1.piece_shape().end());
+    shape.insert(
+        shape.end(), s2.piece_shape().begin(), s2.piece_shape().end());
+    auto set = std::vector<std::uint32_t>(s1.pieces().size(), 0);
+    set.resize(pieces.size(), 1);
+    detail::check_spacing_pieces<T>(
+        pieces, set, shape, true, min_spacing, fn, num_threads);
+}
+
+/**
+ * @brief Minimum-width check
+ *
+ * Every maximal horizontal run (a piece of the horizontal decomposition)
+ * narrower than min_width, and every maximal vertical run shorter than
+ * min_width, is a violation.
+ *
+ * @tparam T
+ * @tparam Fn
+ * @param s
+ * @param min_width
+ * @param fn callable(const drc_violation<T>&), called from this thread
+ * @param num_threads (0 = hardware concurrency)
+ */
+template <typename T, typename Fn>
+inline void check_width(const shape_set<T>& s, const T& min_width, Fn&& fn,
+    unsigned num_threads = 0)
+{
+    const auto nh = s.pieces().size();
+    detail::drc_tiles<T>(
+        nh + s.vpieces().size(),
+        [&](std::size_t first, std::size_t last,
+            std::vector<drc_violation<T>>& out)
+        {
+            for (auto k = first; k != last; ++k)
+            {
+                const auto horizontal = k < nh;
+                const auto& p =
+                    horizontal ? s.pieces()[k] : s.vpieces()[k - nh];
+                const auto id = horizontal ? s.piece_shape()[k]
+                                           : s.vpiece_shape()[k - nh];
+                const auto w = horizontal ? p.x().len() : p.y().len();
+                if (w < min_width)
+                {
+                    out.push_back(
+                        drc_violation<T> {drc_rule::width, id, id, w, p});
+                }
+            }
+        },
+        fn, num_threads);
+}
+
+/**
+ * @brief Enclosure check: every inner shape grown by margin must be
+ * covered by the union of the outer shapes
+ *
+ * Each inner piece is grown by margin on all four sides and tested for
+ * coverage against the outer pieces near it, looked up in a grid_index
+ * over the outer pieces, so long rails and wells only meet the inner
+ * pieces in the bins they cross. For a failing piece, `value` is the
+ * largest margin m <= margin that would pass (0 if the piece itself is
+ * not covered) and `b` is the lowest-numbered outer shape overlapping the
+ * piece, or UINT32_MAX.
+ *
+ * @tparam T
+ * @tparam Fn
+ * @param inner
+ * @param outer
+ * @param margin
+ * @param fn callable(const drc_violation<T>&), called from this thread
+ * @param num_threads (0 = hardware concurrency)
+ */
+template <typename T, typename Fn>
+inline void check_enclosure(const shape_set<T>& inner,
+    const shape_set<T>& outer, const T& margin, Fn&& fn,
+    unsigned num_threads = 0)
+{
+    const auto op = outer.pieces();
+    auto gi = std::optional<grid_index<T>> {};
+    if (!op.empty())
+    {
+        gi.emplace(make_grid_index<T>(op, num_threads));
+    }
+    auto grow = [](const rectangle<T>& r, const T& m)
+    {
+        return rectangle<T> {
+            interval<T> {r.x().lower() - m, r.x().upper() + m},
+            interval<T> {r.y().lower() - m, r.y().upper() + m}};
+    };
+    // outer pieces overlapping w, each once: a piece spanning several
+    // bins is taken from the bin holding its overlap's lower-left corner
+    auto for_each_near = [&](const rectangle<T>& w, auto&& visit)
+    {
+        if (!gi)
+        {
+            return;
+        }
+        const auto [x0, y0] = gi->locate(w.lower());
+        const auto [x1, y1] = gi->locate(w.upper());
+        for (auto iy = y0; iy <= y1; ++iy)
+        {
+            for (auto ix = x0; ix <= x1; ++ix)
+            {
+                for (auto j : gi->bin(ix, iy))
+                {
+                    const auto& c = op[j];
+                    if (c.overlaps(w) &&
+                        gi->locate(point<T> {
+                            std::max(c.x().lower(), w.x().lower()),
+                            std::max(c.y().lower(), w.y().lower())}) ==
+                            std::make_pair(ix, iy))
+                    {
+                        visit(j);
+                    }
+                }
+            }
+        }
+    };
+    const auto ip = inner.pieces();
+    detail::drc_tiles<T>(
+        ip.size(),
+        [&](std::size_t first, std::size_t last,
+            std::vector<drc_violation<T>>& out)
+        {
+            auto cands = std::vector<rectangle<T>> {};
+            auto offsets = std::vector<T> {};
+            for (auto k = first; k != last; ++k)
+            {
+                const auto& p = ip[k];
+                const auto w = grow(p, margin);
+                cands.clear();
+                auto b = UINT32_MAX;
+                for_each_near(w,
+                    [&](std::uint32_t j)
+                    {
+                        cands.push_back(op[j]);
+                        if (op[j].overlaps(p))
+                        {
+                            b = std::min(b, outer.piece_shape()[j]);
+                        }
+                    });
+                if (detail::covers(w, cands))
+                {
+                    continue;
+                }
+                // coverage only changes where a grown side meets an edge
+                offsets.assign(1, T(0));
+                for (auto&& c : cands)
+                {
+                    for (auto d : {p.x().lower() - c.x().lower(),
+                             c.x().upper() - p.x().upper(),
+                             p.y().lower() - c.y().lower(),
+                             c.y().upper() - p.y().upper()})
+                    {
+                        if (T(0) < d && d < margin)
+                        {
+                            offsets.push_back(d);
+                        }
+                    }
+                }
+                std::sort(offsets.rbegin(), offsets.rend());
+                auto value = T(0);
+                for (auto&& m : offsets)
+                {
+                    if (detail::covers(grow(p, m), cands))
+                    {
+                        value = m;
+                        break;
+                    }
+                }
+                out.push_back(drc_violation<T> {drc_rule::enclosure,
+                    inner.piece_shape()[k], b, value, w});
+            }
+        },
+        fn, num_threads);
+}
+
+} // namespace recti
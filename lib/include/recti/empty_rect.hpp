@@ -0,0 +1,770 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <gsl/span>
+#include <numeric>
+#include <queue>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+namespace detail
+{
+
+/**
+ * @brief Floor profile of a sweep line over n elementary x intervals
+ *
+ * Leaf i holds the floor of column i -- the highest obstacle top (or the
+ * window bottom) passed so far -- and a count of the obstacles covering
+ * it right now; a covered column is blocked and compares above every
+ * floor. Covers are kept per node without pushing them down (as in the
+ * classic union-area tree), floor assignments are pushed down lazily,
+ * and every node keeps the number of free leaves below it and the range
+ * of their floors. That is enough to answer "first column after i whose
+ * floor differs" and "nearest column left/right of i above floor f" in
+ * O(log n), which lets the sweep walk the staircase piece by piece.
+ *
+ * @tparam T
+ */
+template <typename T>
+class staircase
+{
+  private:
+    struct node
+    {
+        int cover {0};          // obstacles covering the whole node
+        std::uint32_t free {0}; // uncovered leaves below
+        bool tagged {false};    // all leaves below have floor lo
+        T lo {};                // floor range of the free leaves
+        T hi {};
+    };
+
+    std::size_t _n;
+    std::vector<node> _t;
+
+  public:
+    static constexpr auto none = std::size_t(-1);
+
+    /**
+     * @brief n free columns, all with the given floor
+     */
+    staircase(std::size_t n, const T& floor)
+        : _n {n}
+        , _t(4 * n)
+    {
+        assert(n != 0 && n < std::size_t(UINT32_MAX));
+        this->_build(1, 0, n);
+        this->_apply(1, floor);
+    }
+
+    /**
+     * @brief add d to the cover count of columns [first, last)
+     */
+    void cover(std::size_t first, std::size_t last, int d)
+    {
+        this->_cover(1, 0, this->_n, first, last, d);
+    }
+
+    /**
+     * @brief set the floor of columns [first, last)
+     */
+    void assign(std::size_t first, std::size_t last, const T& floor)
+    {
+        this->_assign(1, 0, this->_n, first, last, floor);
+    }
+
+    /**
+     * @brief whether column i is blocked, and its floor
+     */
+    [[nodiscard]] auto value(std::size_t i) -> std::pair<bool, T>
+    {
+        auto k = std::size_t(1);
+        auto l = std::size_t(0);
+        auto r = this->_n;
+        auto blocked = false;
+        while (true)
+        {
+            blocked = blocked || this->_t[k].cover > 0;
+            if (r - l == 1)
+            {
+                return {blocked, this->_t[k].lo};
+            }
+            this->_push(k);
+            const auto m = l + (r - l) / 2;
+            if (i < m)
+            {
+                k = 2 * k;
+                r = m;
+            }
+            else
+            {
+                k = 2 * k + 1;
+                l = m;
+            }
+        }
+    }
+
+    /**
+     * @brief first column in (i, last) unlike column i, or last
+     */
+    [[nodiscard]] auto next_change(std::size_t i, std::size_t last)
+        -> std::size_t
+    {
+        const auto v = this->value(i);
+        auto differs = [&v](const node& t, std::size_t size, bool blocked)
+        {
+            if (blocked)
+            {
+                return !v.first;
+            }
+            if (v.first)
+            {
+                return t.free != 0;
+            }
+            return t.free != size || t.lo < v.second || v.second < t.hi;
+        };
+        const auto j =
+            this->_first(1, 0, this->_n, i + 1, last, false, differs);
+        return j == none ? last : j;
+    }
+
+    /**
+     * @brief one past the last column before i above floor f, or 0
+     */
+    [[nodiscard]] auto left_end(std::size_t i, const T& f) -> std::size_t
+    {
+        const auto j =
+            this->_last(1, 0, this->_n, 0, i, false, this->_above(f));
+        return j == none ? 0 : j + 1;
+    }
+
+    /**
+     * @brief the first column from i on above floor f, or n
+     */
+    [[nodiscard]] auto right_end(std::size_t i, const T& f) -> std::size_t
+    {
+        const auto j =
+            this->_first(1, 0, this->_n, i, this->_n, false, this->_above(f));
+        return j == none ? this->_n : j;
+    }
+
+  private:
+    static auto _above(const T& f)
+    {
+        return [&f](const node& t, std::size_t size, bool blocked)
+        { return blocked || t.free != size || f < t.hi; };
+    }
+
+    void _build(std::size_t k, std::size_t l, std::size_t r)
+    {
+        this->_t[k].free = std::uint32_t(r - l);
+        if (r - l > 1)
+        {
+            const auto m = l + (r - l) / 2;
+            this->_build(2 * k, l, m);
+            this->_build(2 * k + 1, m, r);
+        }
+    }
+
+    void _apply(std::size_t k, const T& floor)
+    {
+        auto& t = this->_t[k];
+        t.tagged = true;
+        t.lo = floor;
+        t.hi = floor;
+    }
+
+    void _push(std::size_t k)
+    {
+        if (this->_t[k].tagged)
+        {
+            this->_apply(2 * k, this->_t[k].lo);
+            this->_apply(2 * k + 1, this->_t[k].lo);
+            this->_t[k].tagged = false;
+        }
+    }
+
+    void _pull(std::size_t k, std::size_t l, std::size_t r)
+    {
+        auto& t = this->_t[k];
+        if (r - l == 1)
+        {
+            t.free = t.cover > 0 ? 0 : 1;
+            return;
+        }
+        const auto& a = this->_t[2 * k];
+        const auto& b = this->_t[2 * k + 1];
+        t.free = t.cover > 0 ? 0 : a.free + b.free;
+        if (t.tagged)
+        {
+            return;
+        }
+        if (a.free == 0)
+        {
+            t.lo = b.lo;
+            t.hi = b.hi;
+        }
+        else if (b.free == 0)
+        {
+            t.lo = a.lo;
+            t.hi = a.hi;
+        }
+        else
+        {
+            t.lo = std::min(a.lo, b.lo);
+            t.hi = std::max(a.hi, b.hi);
+        }
+    }
+
+    void _cover(std::size_t k, std::size_t l, std::size_t r,
+        std::size_t first, std::size_t last, int d)
+    {
+        if (last <= l || r <= first)
+        {
+            return;
+        }
+        if (first <= l && r <= last)
+        {
+            this->_t[k].cover += d;
+            this->_pull(k, l, r);
+            return;
+        }
+        this->_push(k);
+        const auto m = l + (r - l) / 2;
+        this->_cover(2 * k, l, m, first, last, d);
+        this->_cover(2 * k + 1, m, r, first, last, d);
+        this->_pull(k, l, r);
+    }
+
+    void _assign(std::size_t k, std::size_t l, std::size_t r,
+        std::size_t first, std::size_t last, const T& floor)
+    {
+        if (last <= l || r <= first)
+        {
+            return;
+        }
+        if (first <= l && r <= last)
+        {
+            this->_apply(k, floor);
+            return;
+        }
+        this->_push(k);
+        const auto m = l + (r - l) / 2;
+        this->_assign(2 * k, l, m, first, last, floor);
+        this->_assign(2 * k + 1, m, r, first, last, floor);
+        this->_pull(k, l, r);
+    }
+
+    /**
+     * @brief first leaf in [first, last) with has(node, size, blocked)
+     *
+     * `has` must be exact on every node: true iff some leaf below
+     * qualifies. Covers of the ancestors arrive as `blocked`.
+     */
+    template <typename Has>
+    auto _first(std::size_t k, std::size_t l, std::size_t r,
+        std::size_t first, std::size_t last, bool blocked, const Has& has)
+        -> std::size_t
+    {
+        if (last <= l || r <= first)
+        {
+            return none;
+        }
+        blocked = blocked || this->_t[k].cover > 0;
+        if (!has(this->_t[k], r - l, blocked))
+        {
+            return none;
+        }
+        if (r - l == 1)
+        {
+            return l;
+        }
+        this->_push(k);
+        const auto m = l + (r - l) / 2;
+        const auto j = this->_first(2 * k, l, m, first, last, blocked, has);
+        return j != none
+            ? j
+            : this->_first(2 * k + 1, m, r, first, last, blocked, has);
+    }
+
+    /**
+     * @brief last leaf in [first, last) with has(node, size, blocked)
+     */
+    template <typename Has>
+    auto _last(std::size_t k, std::size_t l, std::size_t r,
+        std::size_t first, std::size_t last, bool blocked, const Has& has)
+        -> std::size_t
+    {
+        if (last <= l || r <= first)
+        {
+            return none;
+        }
+        blocked = blocked || this->_t[k].cover > 0;
+        if (!has(this->_t[k], r - l, blocked))
+        {
+            return none;
+        }
+        if (r - l == 1)
+        {
+            return l;
+        }
+        this->_push(k);
+        const auto m = l + (r - l) / 2;
+        const auto j =
+            this->_last(2 * k + 1, m, r, first, last, blocked, has);
+        return j != none ? j
+                         : this->_last(2 * k, l, m, first, last, blocked, has);
+    }
+};
+
+/**
+ * @brief Enumerate the maximal empty rectangles of a window
+ *
+ * A sweep line moves up over the obstacle bottoms and tops, keeping the
+ * staircase of column floors in a detail::staircase. A maximal empty
+ * rectangle has its top at an obstacle bottom (or at the window top), and
+ * below that line it is a maximal histogram rectangle of the staircase:
+ * a run of free columns with floors at most f that contains a floor of
+ * exactly f and is walled in by higher floors, blocked columns or the
+ * window. At each event line only the runs meeting the obstacles that
+ * start there are reported: those through either end of such an
+ * obstacle, found by raising the level to the lower wall one step at a
+ * time, and those around each staircase piece under it (a run may be
+ * found twice; each event batch is deduplicated). Every step yields a
+ * rectangle, and the pieces under an obstacle are at most about twice
+ * the rectangles found there, so the sweep takes O((n + k) log n) time
+ * for n obstacles and k maximal rectangles, in O(n) memory.
+ *
+ * @tparam T
+ * @tparam Fn
+ * @param window
+ * @param obstacles
+ * @param fn callable(const rectangle<T>&)
+ */
+template <typename T, typename Fn>
+inline void for_each_maximal_empty(const rectangle<T>& window,
+    gsl::span<const rectangle<T>> obstacles, Fn&& fn)
+{
+    if (!(window.x().lower() < window.x().upper()) ||
+        !(window.y().lower() < window.y().upper()))
+    {
+        return;
+    }
+    auto xs = std::vector<T> {window.x().lower(), window.x().upper()};
+    auto clipped = std::vector<rectangle<T>> {};
+    for (auto&& r : obstacles)
+    {
+        const auto x0 = std::max(r.x().lower(), window.x().lower());
+        const auto x1 = std::min(r.x().upper(), window.x().upper());
+        const auto y0 = std::max(r.y().lower(), window.y().lower());
+        const auto y1 = std::min(r.y().upper(), window.y().upper());
+        if (x0 < x1 && y0 < y1) // the interiors overlap
+        {
+            clipped.emplace_back(interval<T> {x0, x1}, interval<T> {y0, y1});
+            xs.push_back(x0);
+            xs.push_back(x1);
+        }
+    }
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    const auto nx = xs.size() - 1;
+    auto rank = [&](const T& a)
+    {
+        return std::size_t(
+            std::lower_bound(xs.begin(), xs.end(), a) - xs.begin());
+    };
+    const auto m = clipped.size();
+    auto cols = std::vector<std::pair<std::size_t, std::size_t>>(m);
+    for (auto i = 0U; i != m; ++i)
+    {
+        cols[i] = {rank(clipped[i].x().lower()), rank(clipped[i].x().upper())};
+    }
+    auto bottoms = std::vector<std::uint32_t>(m);
+    std::iota(bottoms.begin(), bottoms.end(), 0U);
+    auto tops = bottoms;
+    std::sort(bottoms.begin(), bottoms.end(),
+        [&](std::uint32_t a, std::uint32_t b)
+        { return clipped[a].y().lower() < clipped[b].y().lower(); });
+    std::sort(tops.begin(), tops.end(),
+        [&](std::uint32_t a, std::uint32_t b)
+        { return clipped[a].y().upper() < clipped[b].y().upper(); });
+
+    auto st = staircase<T> {nx, window.y().lower()};
+    auto batch = std::vector<std::tuple<std::size_t, std::size_t, T>> {};
+    auto starts = std::vector<std::pair<std::size_t, std::size_t>> {};
+    // the runs of the staircase below line y that meet columns [qa, qb)
+    auto report = [&](std::size_t qa, std::size_t qb, const T& y)
+    {
+        auto add = [&](std::size_t l, std::size_t r, const T& f)
+        {
+            if (f < y)
+            {
+                batch.emplace_back(l, r, f);
+            }
+        };
+        for (auto i = qa; i < qb;)
+        {
+            const auto [inf, f] = st.value(i);
+            const auto j = st.next_change(i, qb);
+            if (!inf)
+            {
+                add(st.left_end(i, f), st.right_end(j, f), f);
+            }
+            i = j;
+        }
+        for (auto i : {qa, qb - 1})
+        {
+            auto [inf, f] = st.value(i);
+            if (inf)
+            {
+                continue;
+            }
+            auto l = st.left_end(i, f);
+            auto r = st.right_end(i, f);
+            while (true)
+            {
+                add(l, r, f);
+                // the lower free wall is the next level
+                auto wall = false;
+                if (l != 0)
+                {
+                    const auto [b, g] = st.value(l - 1);
+                    if (!b)
+                    {
+                        f = g;
+                        wall = true;
+                    }
+                }
+                if (r != nx)
+                {
+                    const auto [b, g] = st.value(r);
+                    if (!b && (!wall || g < f))
+                    {
+                        f = g;
+                        wall = true;
+                    }
+                }
+                if (!wall)
+                {
+                    break;
+                }
+                l = st.left_end(l, f);
+                r = st.right_end(r, f);
+            }
+        }
+    };
+    auto flush = [&](const T& y)
+    {
+        std::sort(batch.begin(), batch.end());
+        batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
+        for (auto&& [l, r, f] : batch)
+        {
+            fn(rectangle<T> {interval<T> {xs[l], xs[r]}, interval<T> {f, y}});
+        }
+        batch.clear();
+    };
+
+    auto ib = std::size_t(0);
+    auto it = std::size_t(0);
+    while (ib != m || it != m)
+    {
+        // tops at the window top stay blocked for the last report
+        const auto y = ib != m &&
+                (it == m ||
+                    !(clipped[tops[it]].y().upper() <
+                        clipped[bottoms[ib]].y().lower()))
+            ? clipped[bottoms[ib]].y().lower()
+            : clipped[tops[it]].y().upper();
+        if (!(y < window.y().upper()))
+        {
+            break;
+        }
+        starts.clear();
+        for (auto e = ib; e != m && clipped[bottoms[e]].y().lower() == y; ++e)
+        {
+            starts.push_back(cols[bottoms[e]]);
+        }
+        std::sort(starts.begin(), starts.end());
+        for (auto s = std::size_t(0); s != starts.size();)
+        {
+            auto [qa, qb] = starts[s];
+            for (++s; s != starts.size() && starts[s].first <= qb; ++s)
+            {
+                qb = std::max(qb, starts[s].second);
+            }
+            report(qa, qb, y);
+        }
+        flush(y);
+        for (; it != m && clipped[tops[it]].y().upper() == y; ++it)
+        {
+            const auto [a, b] = cols[tops[it]];
+            st.assign(a, b, y);
+            st.cover(a, b, -1);
+        }
+        for (; ib != m && clipped[bottoms[ib]].y().lower() == y; ++ib)
+        {
+            const auto [a, b] = cols[bottoms[ib]];
+            st.cover(a, b, 1);
+        }
+    }
+    report(0, nx, window.y().upper());
+    flush(window.y().upper());
+}
+
+/**
+ * @brief larger area first, then lower-left corner
+ */
+template <typename T>
+inline auto larger_empty(const rectangle<T>& a, const rectangle<T>& b) -> bool
+{
+    const auto aa = a.area();
+    const auto ab = b.area();
+    return ab < aa ||
+        (!(aa < ab) &&
+            std::tie(a.x().lower(), a.y().lower(), a.x().upper()) <
+                std::tie(b.x().lower(), b.y().lower(), b.x().upper()));
+}
+
+} // namespace detail
+
+/**
+ * @brief All maximal empty rectangles of a window
+ *
+ * A rectangle is empty when its interior misses every obstacle, and
+ * maximal when no empty rectangle inside the window strictly contains it.
+ * The result is in the enumeration order (by top edge, then left edge).
+ *
+ * @tparam T
+ * @param window
+ * @param obstacles
+ * @return std::vector<rectangle<T>>
+ */
+template <typename T>
+inline auto maximal_empty_rectangles(const rectangle<T>& window,
+    gsl::span<const rectangle<T>> obstacles) -> std::vector<rectangle<T>>
+{
+    auto res = std::vector<rectangle<T>> {};
+    detail::for_each_maximal_empty(
+        window, obstacles, [&](const rectangle<T>& r) { res.push_back(r); });
+    return res;
+}
+
+/**
+ * @brief The k largest maximal empty rectangles of a window
+ *
+ * @tparam T
+ * @param window
+ * @param obstacles
+ * @param k
+ * @return std::vector<rectangle<T>> largest first
+ */
+template <typename T>
+inline auto largest_empty_rectangles(const rectangle<T>& window,
+    gsl::span<const rectangle<T>> obstacles, std::size_t k)
+    -> std::vector<rectangle<T>>
+{
+    auto cmp = [](const rectangle<T>& a, const rectangle<T>& b)
+    { return detail::larger_empty(a, b); };
+    // min-heap by the same order: the top is the smallest kept rectangle
+    auto heap = std::priority_queue<rectangle<T>, std::vector<rectangle<T>>,
+        decltype(cmp)> {cmp};
+    if (k == 0)
+    {
+        return {};
+    }
+    detail::for_each_maximal_empty(window, obstacles,
+        [&](const rectangle<T>& r)
+        {
+            if (heap.size() < k)
+            {
+                heap.push(r);
+            }
+            else if (detail::larger_empty(r, heap.top()))
+            {
+                heap.pop();
+                heap.push(r);
+            }
+        });
+    auto res = std::vector<rectangle<T>> {};
+    while (!heap.empty())
+    {
+        res.push_back(heap.top());
+        heap.pop();
+    }
+    std::reverse(res.begin(), res.end());
+    return res;
+}
+
+/**
+ * @brief Maximal empty rectangles per tile, computed in parallel
+ *
+ * The window is split into tiles_x * tiles_y equal tiles (the last ones
+ * take the remainder). A side of zero length gets a single tile, and for
+ * an integral T a side of length w at most w tiles, so that no tile is
+ * degenerate. Each reported rectangle is maximal within its own tile;
+ * rectangles crossing tile borders are reported in pieces. The result is
+ * ordered by tile (row-major), then by enumeration order.
+ *
+ * The obstacles are first bucketed by the tiles they touch, in CSR form
+ * with two counting passes as in grid_index, so each tile sweeps only
+ * its own: O(n + tiles) work before the sweeps.
+ *
+ * @tparam T
+ * @param window
+ * @param obstacles
+ * @param tiles_x
+ * @param tiles_y
+ * @param num_threads (0 = hardware concurrency)
+ * @return std::vector<rectangle<T>>
+ */
+template <typename T>
+inline auto maximal_empty_rectangles_tiled(const rectangle<T>& window,
+    gsl::span<const rectangle<T>> obstacles, std::size_t tiles_x,
+    std::size_t tiles_y, unsigned num_threads = 0)
+    -> std::vector<rectangle<T>>
+{
+    assert(tiles_x != 0 && tiles_y != 0);
+    auto clamp = [](const T& len, std::size_t tiles) -> std::size_t
+    {
+        if (!(T(0) < len))
+        {
+            return 1;
+        }
+        if constexpr (std::is_integral<T>::value)
+        {
+            return std::min(tiles, std::size_t(len));
+        }
+        return tiles;
+    };
+    tiles_x = clamp(window.x().len(), tiles_x);
+    tiles_y = clamp(window.y().len(), tiles_y);
+    const auto wx = window.x().len() / T(tiles_x);
+    const auto wy = window.y().len() / T(tiles_y);
+    auto tile = [&](std::size_t t) -> rectangle<T>
+    {
+        const auto tx = t % tiles_x;
+        const auto ty = t / tiles_x;
+        const auto x0 = window.x().lower() + T(tx) * wx;
+        const auto y0 = window.y().lower() + T(ty) * wy;
+        const auto x1 = tx + 1 == tiles_x ? window.x().upper() : x0 + wx;
+        const auto y1 = ty + 1 == tiles_y ? window.y().upper() : y0 + wy;
+        return {interval<T> {x0, x1}, interval<T> {y0, y1}};
+    };
+    // tile column (or row) of a coordinate, clamped into the window
+    auto index = [](const T& v, const T& lower, const T& w, std::size_t n)
+    {
+        if (n == 1 || !(lower < v))
+        {
+            return std::size_t(0);
+        }
+        return std::min(std::size_t((v - lower) / w), n - 1);
+    };
+    // visit the tiles overlapping obstacle id; the index range is widened
+    // by one on each side (closed borders, rounding) and then checked
+    auto for_each_tile = [&](std::size_t id, auto&& visit)
+    {
+        const auto& r = obstacles[id];
+        if (!r.overlaps(window))
+        {
+            return;
+        }
+        const auto& X = window.x();
+        const auto& Y = window.y();
+        const auto x0 = index(r.x().lower(), X.lower(), wx, tiles_x);
+        const auto x1 = index(r.x().upper(), X.lower(), wx, tiles_x);
+        const auto y0 = index(r.y().lower(), Y.lower(), wy, tiles_y);
+        const auto y1 = index(r.y().upper(), Y.lower(), wy, tiles_y);
+        const auto tx1 = std::min(x1 + 1, tiles_x - 1);
+        const auto ty1 = std::min(y1 + 1, tiles_y - 1);
+        for (auto ty = std::max(y0, std::size_t(1)) - 1; ty <= ty1; ++ty)
+        {
+            for (auto tx = std::max(x0, std::size_t(1)) - 1; tx <= tx1; ++tx)
+            {
+                const auto t = ty * tiles_x + tx;
+                if (r.overlaps(tile(t)))
+                {
+                    visit(t);
+                }
+            }
+        }
+    };
+
+    const auto n = obstacles.size();
+    assert(n <= std::size_t(UINT32_MAX));
+    const auto ntiles = tiles_x * tiles_y;
+    const auto nt = num_chunks(n, num_threads);
+    auto cursor = std::vector<std::vector<std::size_t>>(
+        nt, std::vector<std::size_t>(ntiles, 0));
+    // pass 1: count
+    parallel_chunks(
+        n,
+        [&](unsigned tid, std::size_t first, std::size_t last)
+        {
+            auto& cnt = cursor[tid];
+            for (auto id = first; id != last; ++id)
+            {
+                for_each_tile(id, [&cnt](std::size_t t) { ++cnt[t]; });
+            }
+        },
+        nt);
+    auto start = std::vector<std::size_t>(ntiles + 1, 0);
+    auto total = std::size_t(0);
+    for (auto t = std::size_t(0); t != ntiles; ++t)
+    {
+        start[t] = total;
+        for (auto&& cnt : cursor)
+        {
+            const auto c = cnt[t];
+            cnt[t] = total;
+            total += c;
+        }
+    }
+    start[ntiles] = total;
+    auto items = std::vector<std::uint32_t>(total);
+    // pass 2: fill
+    parallel_chunks(
+        n,
+        [&](unsigned tid, std::size_t first, std::size_t last)
+        {
+            auto& pos = cursor[tid];
+            for (auto id = first; id != last; ++id)
+            {
+                for_each_tile(id,
+                    [&](std::size_t t)
+                    { items[pos[t]++] = std::uint32_t(id); });
+            }
+        },
+        nt);
+
+    auto per_tile = std::vector<std::vector<rectangle<T>>>(ntiles);
+    parallel_for(
+        ntiles,
+        [&](std::size_t t)
+        {
+            auto local = std::vector<rectangle<T>> {};
+            local.reserve(start[t + 1] - start[t]);
+            for (auto k = start[t]; k != start[t + 1]; ++k)
+            {
+                local.push_back(obstacles[items[k]]);
+            }
+            per_tile[t] = maximal_empty_rectangles<T>(tile(t), local);
+        },
+        num_threads);
+    auto res = std::vector<rectangle<T>> {};
+    for (auto&& v : per_tile)
+    {
+        res.insert(res.end(), v.begin(), v.end());
+    }
+    return res;
+}
+
+} // namespace recti
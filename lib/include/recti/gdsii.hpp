@@ -0,0 +1,822 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <gsl/span>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief GDSII record types used by the reader and the writer
+ *
+ * A record is a big-endian uint16 length (including the 4 header bytes),
+ * a record type and a data type byte, followed by the payload.
+ */
+namespace gds
+{
+
+enum record : std::uint8_t
+{
+    header = 0x00,
+    bgnlib = 0x01,
+    libname = 0x02,
+    units = 0x03,
+    endlib = 0x04,
+    bgnstr = 0x05,
+    strname = 0x06,
+    endstr = 0x07,
+    boundary = 0x08,
+    path = 0x09,
+    sref = 0x0A,
+    aref = 0x0B,
+    text = 0x0C,
+    layer = 0x0D,
+    datatype = 0x0E,
+    xy = 0x10,
+    endel = 0x11,
+    node = 0x15,
+    box = 0x2D,
+    boxtype = 0x2E
+};
+
+enum data_type : std::uint8_t
+{
+    no_data = 0,
+    int2 = 2,
+    int4 = 3,
+    real8 = 5,
+    ascii = 6
+};
+
+/// XY records hold at most this many points (65535-byte records)
+inline constexpr std::size_t max_points = 8191;
+
+inline auto get_u16(const std::byte* p) -> std::uint16_t
+{
+    return std::uint16_t(unsigned(p[0]) << 8 | unsigned(p[1]));
+}
+
+inline auto get_i32(const std::byte* p) -> std::int32_t
+{
+    return std::int32_t(std::uint32_t(p[0]) << 24 |
+        std::uint32_t(p[1]) << 16 | std::uint32_t(p[2]) << 8 |
+        std::uint32_t(p[3]));
+}
+
+/**
+ * @brief decode an 8-byte GDSII real (excess-64, base-16 exponent)
+ */
+inline auto get_real8(const std::byte* p) -> double
+{
+    auto mantissa = std::uint64_t(0);
+    for (auto i = 1; i != 8; ++i)
+    {
+        mantissa = mantissa << 8 | std::uint64_t(p[i]);
+    }
+    const auto b = unsigned(p[0]);
+    const auto v = std::ldexp(double(mantissa),
+        4 * (int(b & 0x7FU) - 64) - 56);
+    return (b & 0x80U) != 0 ? -v : v;
+}
+
+/**
+ * @brief encode an 8-byte GDSII real
+ */
+inline void put_real8(double v, unsigned char* out)
+{
+    std::fill(out, out + 8, 0);
+    if (v == 0.0)
+    {
+        return;
+    }
+    const auto sign = v < 0.0 ? 0x80U : 0U;
+    v = std::fabs(v);
+    auto e = 64;
+    while (v >= 1.0)
+    {
+        v /= 16.0;
+        ++e;
+    }
+    while (v < 1.0 / 16.0)
+    {
+        v *= 16.0;
+        --e;
+    }
+    auto mantissa = std::uint64_t(std::llround(std::ldexp(v, 56)));
+    if (mantissa >> 56 != 0) // rounded up to 1.0
+    {
+        mantissa >>= 4;
+        ++e;
+    }
+    out[0] = static_cast<unsigned char>(sign | unsigned(e));
+    for (auto i = 7; i != 0; --i)
+    {
+        out[i] = static_cast<unsigned char>(mantissa & 0xFFU);
+        mantissa >>= 8;
+    }
+}
+
+} // namespace gds
+
+/**
+ * @brief Outcome of reading a GDSII stream
+ *
+ */
+enum class gds_status : std::uint8_t
+{
+    ok,
+    truncated,  //!< a record runs past the end of the data
+    bad_record, //!< malformed record or record out of place
+    bad_header  //!< does not start with a HEADER record
+};
+
+/**
+ * @brief Library-level data of a GDSII stream
+ *
+ */
+struct gds_library
+{
+    std::string name;
+    double user_unit {1e-3};  //!< user units per database unit
+    double meter_unit {1e-9}; //!< meters per database unit
+    std::uint32_t num_structures {0};
+};
+
+/**
+ * @brief How a boundary was classified
+ *
+ */
+enum class gds_shape_kind : std::uint8_t
+{
+    rectangle, //!< axis-aligned box (BOX records always are)
+    rpolygon,  //!< rectilinear; points is an rpolygon pointset
+    polygon    //!< anything else; points is the vertex list
+};
+
+/**
+ * @brief One BOUNDARY or BOX element as passed to the read callback
+ *
+ * For rpolygon shapes `points` follows the rpolygon convention (from
+ * points[i - 1] to points[i] a horizontal then a vertical step), so
+ * rpolygon<T>(points) builds the polygon; for general polygons it is the
+ * plain vertex list for polygon<T>(points). The span is only valid
+ * during the callback. A boundary whose vertices are all repeated or
+ * collinear encloses no area and is skipped; a BOX is always passed.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct gds_shape
+{
+    std::uint32_t structure; //!< index of the structure in file order
+    std::int16_t layer;
+    std::int16_t datatype;
+    gds_shape_kind kind;
+    rectangle<T> bbox; //!< the shape itself for rectangles
+    gsl::span<const point<T>> points;
+};
+
+namespace detail
+{
+
+/**
+ * @brief Remove repeated and collinear vertices of a closed vertex list
+ *
+ * @return true if all remaining edges are axis-parallel
+ */
+template <typename T>
+inline auto simplify_boundary(std::vector<point<T>>& pts) -> bool
+{
+    if (pts.size() > 1 && pts.front() == pts.back())
+    {
+        pts.pop_back();
+    }
+    pts.erase(std::unique(pts.begin(), pts.end()), pts.end());
+    // drop vertices lying on the segment between their neighbours;
+    // repeat around the seam until nothing changes
+    auto changed = true;
+    while (changed && pts.size() > 2)
+    {
+        changed = false;
+        auto out = std::size_t(0);
+        const auto n = pts.size();
+        for (auto i = 0U; i != n; ++i)
+        {
+            const auto& a = out == 0 ? pts[n - 1] : pts[out - 1];
+            const auto& b = pts[i];
+            const auto& c = pts[(i + 1) % n];
+            const auto cross = (b.x() - a.x()) * (c.y() - b.y()) -
+                (b.y() - a.y()) * (c.x() - b.x());
+            if (cross == 0 || b == c)
+            {
+                changed = true;
+                continue;
+            }
+            pts[out++] = b;
+        }
+        pts.erase(pts.begin() + long(out), pts.end());
+    }
+    const auto n = pts.size();
+    for (auto i = 0U; i != n; ++i)
+    {
+        const auto& a = pts[i];
+        const auto& b = pts[(i + 1) % n];
+        if (a.x() != b.x() && a.y() != b.y())
+        {
+            return false;
+        }
+    }
+    return n >= 4;
+}
+
+/**
+ * @brief Parser state of one contiguous part of a stream
+ *
+ * Holds a single reusable vertex buffer, so memory stays proportional to
+ * the largest element, not to the file.
+ */
+template <typename T>
+class gds_decoder
+{
+  private:
+    std::vector<point<T>> _pts;
+    std::vector<point<T>> _set;
+
+  public:
+    /**
+     * @brief decode the elements in [first, last) of data
+     *
+     * `first` must be at a record boundary outside any element.
+     */
+    template <typename Fn>
+    auto run(gsl::span<const std::byte> data, std::size_t first,
+        std::size_t last, std::uint32_t structure, Fn&& fn) -> gds_status
+    {
+        auto in_element = false;
+        auto wanted = false;
+        auto is_box = false;
+        auto layer = std::int16_t(0);
+        auto datatype = std::int16_t(0);
+        this->_pts.clear();
+        auto pos = first;
+        while (pos < last)
+        {
+            if (data.size() - pos < 4)
+            {
+                return gds_status::truncated;
+            }
+            const auto* rec = data.data() + pos;
+            const auto len = std::size_t(gds::get_u16(rec));
+            if (len < 4 || len % 2 != 0)
+            {
+                return gds_status::bad_record;
+            }
+            if (data.size() - pos < len)
+            {
+                return gds_status::truncated;
+            }
+            const auto type = std::uint8_t(rec[2]);
+            const auto* body = rec + 4;
+            const auto n = len - 4;
+            switch (type)
+            {
+            case gds::bgnstr:
+                ++structure;
+                break;
+            case gds::boundary:
+            case gds::box:
+            case gds::path:
+            case gds::sref:
+            case gds::aref:
+            case gds::text:
+            case gds::node:
+                if (in_element)
+                {
+                    return gds_status::bad_record;
+                }
+                in_element = true;
+                wanted = type == gds::boundary || type == gds::box;
+                is_box = type == gds::box;
+                this->_pts.clear();
+                break;
+            case gds::layer:
+            case gds::datatype:
+                if (n < 2)
+                {
+                    return gds_status::bad_record;
+                }
+                (type == gds::layer ? layer : datatype) =
+                    std::int16_t(gds::get_u16(body));
+                break;
+            case gds::xy:
+                if (!in_element || n % 8 != 0)
+                {
+                    return gds_status::bad_record;
+                }
+                if (wanted)
+                {
+                    for (auto k = 0U; k != n; k += 8)
+                    {
+                        this->_pts.emplace_back(T(gds::get_i32(body + k)),
+                            T(gds::get_i32(body + k + 4)));
+                    }
+                }
+                break;
+            case gds::endlib:
+                return in_element ? gds_status::bad_record : gds_status::ok;
+            case gds::endel:
+                if (!in_element)
+                {
+                    return gds_status::bad_record;
+                }
+                if (wanted && !this->_pts.empty())
+                {
+                    this->_emit(structure, layer, datatype, is_box, fn);
+                }
+                in_element = false;
+                break;
+            default:
+                break; // properties, text, library records ...
+            }
+            pos += len;
+        }
+        return in_element ? gds_status::truncated : gds_status::ok;
+    }
+
+  private:
+    template <typename Fn>
+    void _emit(std::uint32_t structure, std::int16_t layer,
+        std::int16_t datatype, bool is_box, Fn&& fn)
+    {
+        auto& pts = this->_pts;
+        auto xs = std::minmax_element(pts.begin(), pts.end(),
+            [](const auto& a, const auto& b) { return a.x() < b.x(); });
+        auto ys = std::minmax_element(pts.begin(), pts.end(),
+            [](const auto& a, const auto& b) { return a.y() < b.y(); });
+        const auto bbox =
+            rectangle<T> {interval<T> {xs.first->x(), xs.second->x()},
+                interval<T> {ys.first->y(), ys.second->y()}};
+        auto shape = gds_shape<T> {structure, layer, datatype,
+            gds_shape_kind::rectangle, bbox, {}};
+        if (is_box)
+        {
+            fn(shape);
+            return;
+        }
+        const auto rectilinear = simplify_boundary(pts);
+        if (pts.size() < 3)
+        {
+            return; // all vertices repeated or collinear: no area
+        }
+        if (rectilinear && pts.size() == 4)
+        {
+            fn(shape);
+            return;
+        }
+        if (!rectilinear)
+        {
+            shape.kind = gds_shape_kind::polygon;
+            shape.points = pts;
+            fn(shape);
+            return;
+        }
+        // keep every other corner, starting where a horizontal edge
+        // leaves, so that each step is horizontal then vertical
+        const auto s = pts[0].y() == pts[1].y() ? 0U : 1U;
+        this->_set.clear();
+        for (auto i = s; i < pts.size(); i += 2)
+        {
+            this->_set.push_back(pts[i]);
+        }
+        shape.kind = gds_shape_kind::rpolygon;
+        shape.points = this->_set;
+        fn(shape);
+    }
+};
+
+/**
+ * @brief a position where decoding can start, and the structure count
+ */
+struct gds_split
+{
+    std::size_t offset;
+    std::uint32_t structure;
+};
+
+} // namespace detail
+
+/**
+ * @brief Read the BOUNDARY and BOX elements of a GDSII stream
+ *
+ * The data is typically a mapped_file. A first pass only hops over the
+ * record headers to pick the library data and up to one split point per
+ * thread at element starts; the parts between split points are then
+ * decoded in parallel. Each part has one reusable vertex buffer, so
+ * memory does not grow with the file.
+ *
+ * The callback is invoked as fn(part, shape) and, with more than one
+ * thread, concurrently for different parts. Within a part shapes come in
+ * file order and parts are numbered in file order, so collecting per part
+ * and concatenating restores the file order. Hierarchy (SREF, AREF) and
+ * PATH, TEXT elements are skipped.
+ *
+ * @tparam T coordinate type (database units)
+ * @tparam Fn
+ * @param data the whole stream
+ * @param fn callable(unsigned part, const gds_shape<T>&)
+ * @param lib receives the library name and units (may be null)
+ * @param num_threads (0 = hardware concurrency)
+ * @return gds_status the first error in file order, if any
+ */
+template <typename T, typename Fn>
+inline auto read_gdsii(gsl::span<const std::byte> data, Fn&& fn,
+    gds_library* lib = nullptr, unsigned num_threads = 0) -> gds_status
+{
+    if (data.size() < 4 || std::uint8_t(data[2]) != gds::header)
+    {
+        return gds_status::bad_header;
+    }
+    const auto parts = num_workers(num_threads);
+    const auto step = data.size() / parts + 1;
+    auto splits = std::vector<detail::gds_split> {{0, 0}};
+    auto info = gds_library {};
+    auto structure = std::uint32_t(0);
+    auto in_element = false;
+    auto pos = std::size_t(0);
+    while (pos + 4 <= data.size())
+    {
+        const auto* rec = data.data() + pos;
+        const auto len = std::size_t(gds::get_u16(rec));
+        if (len < 4 || data.size() - pos < len)
+        {
+            break; // reported by the decoder of the last part
+        }
+        const auto type = std::uint8_t(rec[2]);
+        if (type == gds::bgnstr)
+        {
+            ++structure;
+        }
+        else if (type == gds::endel)
+        {
+            in_element = false;
+        }
+        else if (type == gds::boundary || type == gds::box ||
+            type == gds::path || type == gds::sref || type == gds::aref ||
+            type == gds::text || type == gds::node)
+        {
+            if (!in_element && pos >= splits.size() * step)
+            {
+                // structure counts BGNSTR records before this position
+                splits.push_back({pos, structure - 1});
+            }
+            in_element = true;
+        }
+        else if (type == gds::libname)
+        {
+            auto name = std::string(
+                reinterpret_cast<const char*>(rec + 4), len - 4);
+            name.erase(name.find_last_not_of('\0') + 1);
+            info.name = name;
+        }
+        else if (type == gds::units && len >= 20)
+        {
+            info.user_unit = gds::get_real8(rec + 4);
+            info.meter_unit = gds::get_real8(rec + 12);
+        }
+        else if (type == gds::endlib)
+        {
+            break; // anything after it is padding
+        }
+        pos += len;
+    }
+    info.num_structures = structure;
+    const auto end = data.size();
+    // the part before the first BGNSTR starts "before" structure 0
+    splits[0].structure = std::uint32_t(-1);
+
+    auto status = std::vector<gds_status>(splits.size(), gds_status::ok);
+    parallel_for(
+        splits.size(),
+        [&](std::size_t k)
+        {
+            const auto last =
+                k + 1 == splits.size() ? end : splits[k + 1].offset;
+            auto dec = detail::gds_decoder<T> {};
+            status[k] = dec.run(data, splits[k].offset, last,
+                splits[k].structure,
+                [&](const gds_shape<T>& s) { fn(unsigned(k), s); });
+        },
+        num_threads);
+    if (lib != nullptr)
+    {
+        *lib = std::move(info);
+    }
+    for (auto s : status)
+    {
+        if (s != gds_status::ok)
+        {
+            return s;
+        }
+    }
+    return gds_status::ok;
+}
+
+/**
+ * @brief Streaming GDSII writer
+ *
+ * Writes the library header on construction; shapes go into the
+ * structure opened by begin_structure(). Nothing is buffered beyond one
+ * record.
+ *
+ * @tparam T coordinate type (database units, must fit in int32)
+ */
+template <typename T>
+class gds_writer
+{
+  private:
+    std::ostream& _os;
+    std::vector<unsigned char> _rec;
+    bool _in_structure {false};
+
+  public:
+    /**
+     * @brief Construct a new gds writer object
+     *
+     * @param os binary output stream
+     * @param name library name
+     * @param user_unit user units per database unit
+     * @param meter_unit meters per database unit
+     */
+    gds_writer(std::ostream& os, const std::string& name,
+        double user_unit = 1e-3, double meter_unit = 1e-9)
+        : _os {os}
+    {
+        this->_begin(gds::header, gds::int2);
+        this->_int2(600);
+        this->_end();
+        this->_begin(gds::bgnlib, gds::int2);
+        this->_dates();
+        this->_end();
+        this->_string(gds::libname, name);
+        this->_begin(gds::units, gds::real8);
+        this->_real8(user_unit);
+        this->_real8(meter_unit);
+        this->_end();
+    }
+
+    /**
+     * @brief open a structure (closing the previous one)
+     *
+     * @param name
+     */
+    void begin_structure(const std::string& name)
+    {
+        this->end_structure();
+        this->_begin(gds::bgnstr, gds::int2);
+        this->_dates();
+        this->_end();
+        this->_string(gds::strname, name);
+        this->_in_structure = true;
+    }
+
+    void end_structure()
+    {
+        if (this->_in_structure)
+        {
+            this->_begin(gds::endstr, gds::no_data);
+            this->_end();
+            this->_in_structure = false;
+        }
+    }
+
+    /**
+     * @brief write a rectangle as a BOUNDARY (or a BOX) element
+     *
+     * @param r
+     * @param layer
+     * @param datatype
+     * @param as_box write a BOX record instead
+     * @return false (and nothing written) if a coordinate does not fit
+     *         in int32
+     */
+    auto write(const rectangle<T>& r, std::int16_t layer,
+        std::int16_t datatype = 0, bool as_box = false) -> bool
+    {
+        const auto xl = r.x().lower();
+        const auto xu = r.x().upper();
+        const auto yl = r.y().lower();
+        const auto yu = r.y().upper();
+        const auto corners = std::array<point<T>, 5> {point<T> {xl, yl},
+            point<T> {xu, yl}, point<T> {xu, yu}, point<T> {xl, yu},
+            point<T> {xl, yl}};
+        if (!gds_writer::_fits(corners))
+        {
+            return false;
+        }
+        this->_element(as_box ? gds::box : gds::boundary, layer, datatype,
+            corners);
+        return true;
+    }
+
+    /**
+     * @brief write an rpolygon pointset as a BOUNDARY element
+     *
+     * @param pointset as for rpolygon<T>
+     * @param layer
+     * @param datatype
+     * @return false (and nothing written) if it is empty, has too many
+     *         vertices for one XY record or a coordinate outside int32
+     */
+    auto write_rpolygon(gsl::span<const point<T>> pointset,
+        std::int16_t layer, std::int16_t datatype = 0) -> bool
+    {
+        if (pointset.empty())
+        {
+            return false;
+        }
+        auto corners = std::vector<point<T>> {};
+        corners.reserve(2 * pointset.size() + 1);
+        auto prev = pointset[pointset.size() - 1];
+        for (auto&& p : pointset)
+        {
+            corners.emplace_back(p.x(), prev.y());
+            corners.push_back(p);
+            prev = p;
+        }
+        corners.erase(
+            std::unique(corners.begin(), corners.end()), corners.end());
+        corners.push_back(corners.front());
+        return this->write_polygon(corners, layer, datatype);
+    }
+
+    /**
+     * @brief write a closed vertex list as a BOUNDARY element
+     *
+     * The list is closed automatically if its last vertex differs from
+     * the first.
+     *
+     * @param points
+     * @param layer
+     * @param datatype
+     * @return false (and nothing written) if it is empty, has too many
+     *         vertices for one XY record or a coordinate outside int32
+     */
+    auto write_polygon(gsl::span<const point<T>> points, std::int16_t layer,
+        std::int16_t datatype = 0) -> bool
+    {
+        if (points.empty())
+        {
+            return false;
+        }
+        const auto closed = points.front() == points[points.size() - 1];
+        if (points.size() + (closed ? 0 : 1) > gds::max_points ||
+            !gds_writer::_fits(points))
+        {
+            return false;
+        }
+        this->_element(gds::boundary, layer, datatype, points, !closed);
+        return true;
+    }
+
+    /**
+     * @brief close the open structure and the library
+     *
+     * @return true if the stream is still good
+     */
+    auto finish() -> bool
+    {
+        this->end_structure();
+        this->_begin(gds::endlib, gds::no_data);
+        this->_end();
+        return bool(this->_os);
+    }
+
+  private:
+    void _element(std::uint8_t type, std::int16_t layer,
+        std::int16_t datatype, gsl::span<const point<T>> points,
+        bool close = false)
+    {
+        assert(this->_in_structure);
+        this->_begin(type, gds::no_data);
+        this->_end();
+        this->_begin(gds::layer, gds::int2);
+        this->_int2(layer);
+        this->_end();
+        this->_begin(type == gds::box ? gds::boxtype : gds::datatype,
+            gds::int2);
+        this->_int2(datatype);
+        this->_end();
+        this->_begin(gds::xy, gds::int4);
+        for (auto&& p : points)
+        {
+            this->_int4(p.x());
+            this->_int4(p.y());
+        }
+        if (close)
+        {
+            this->_int4(points.front().x());
+            this->_int4(points.front().y());
+        }
+        this->_end();
+        this->_begin(gds::endel, gds::no_data);
+        this->_end();
+    }
+
+    void _begin(std::uint8_t type, std::uint8_t dtype)
+    {
+        this->_rec.assign({0, 0, type, dtype});
+    }
+
+    void _end()
+    {
+        const auto len = this->_rec.size();
+        assert(len <= 0xFFFF);
+        this->_rec[0] = static_cast<unsigned char>(len >> 8);
+        this->_rec[1] = static_cast<unsigned char>(len & 0xFF);
+        this->_os.write(reinterpret_cast<const char*>(this->_rec.data()),
+            std::streamsize(len));
+    }
+
+    void _int2(std::int32_t v)
+    {
+        const auto u = std::uint16_t(v);
+        this->_rec.push_back(static_cast<unsigned char>(u >> 8));
+        this->_rec.push_back(static_cast<unsigned char>(u & 0xFF));
+    }
+
+    /**
+     * @brief whether a coordinate is representable as int32
+     */
+    static auto _fits(const T& v) -> bool
+    {
+        if constexpr (!std::is_integral<T>::value)
+        {
+            return !(v < T(INT32_MIN)) && !(T(INT32_MAX) < v);
+        }
+        else if constexpr (std::is_signed<T>::value)
+        {
+            return INT32_MIN <= std::int64_t(v) && std::int64_t(v) <= INT32_MAX;
+        }
+        else
+        {
+            return std::uint64_t(v) <= std::uint64_t(INT32_MAX);
+        }
+    }
+
+    static auto _fits(gsl::span<const point<T>> points) -> bool
+    {
+        return std::all_of(points.begin(), points.end(),
+            [](const point<T>& p)
+            { return gds_writer::_fits(p.x()) && gds_writer::_fits(p.y()); });
+    }
+
+    void _int4(const T& v)
+    {
+        assert(gds_writer::_fits(v));
+        const auto u = std::uint32_t(std::int32_t(v));
+        for (auto s = 24; s >= 0; s -= 8)
+        {
+            this->_rec.push_back(static_cast<unsigned char>(u >> s));
+        }
+    }
+
+    void _real8(double v)
+    {
+        unsigned char buf[8];
+        gds::put_real8(v, buf);
+        this->_rec.insert(this->_rec.end(), buf, buf + 8);
+    }
+
+    void _dates()
+    {
+        // modification and access time; left at zero for reproducibility
+        for (auto i = 0; i != 12; ++i)
+        {
+            this->_int2(0);
+        }
+    }
+
+    void _string(std::uint8_t type, const std::string& s)
+    {
+        this->_begin(type, gds::ascii);
+        this->_rec.insert(this->_rec.end(), s.begin(), s.end());
+        if (s.size() % 2 != 0)
+        {
+            this->_rec.push_back(0);
+        }
+        this->_end();
+    }
+};
+
+} // namespace recti
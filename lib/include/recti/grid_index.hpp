@@ -0,0 +1,391 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <gsl/span>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Uniform grid bin index over rectangles (or points)
+ *
+ * Suited to layouts whose shapes are roughly uniform in size (standard
+ * cells, pins). Bins are laid out row-major over a fixed extent with a
+ * constant pitch; coordinates outside the extent are clamped into the
+ * border bins. The bin-to-shape relation is kept in CSR form: the shape
+ * ids of bin `b` are `_items[_start[b]] .. _items[_start[b + 1] - 1]`,
+ * filled by two counting passes. A shape that spans several bins is listed
+ * in each of them; window queries report it only once by stamping it with
+ * the current query generation.
+ *
+ * Queries reuse a mutable stamp array, so one grid_index must not be
+ * queried from several threads at the same time.
+ *
+ * @tparam T
+ */
+template <typename T>
+class grid_index
+{
+  private:
+    point<T> _origin;
+    T _pitch_x;
+    T _pitch_y;
+    std::size_t _nx;
+    std::size_t _ny;
+    std::vector<rectangle<T>> _shapes;
+    std::vector<std::size_t> _start;   // CSR offsets, size num_bins() + 1
+    std::vector<std::uint32_t> _items; // shape ids, grouped by bin
+    mutable std::vector<std::uint32_t> _stamp;
+    mutable std::uint32_t _generation {0};
+
+  public:
+    /**
+     * @brief Construct a new grid index object
+     *
+     * @param extent region covered by the bins
+     * @param pitch_x bin width
+     * @param pitch_y bin height
+     */
+    grid_index(const rectangle<T>& extent, const T& pitch_x, const T& pitch_y)
+        : _origin {extent.lower()}
+        , _pitch_x {pitch_x}
+        , _pitch_y {pitch_y}
+        , _nx {std::size_t(extent.x().len() / pitch_x) + 1}
+        , _ny {std::size_t(extent.y().len() / pitch_y) + 1}
+        , _start(_nx * _ny + 1, 0)
+    {
+        assert(T(0) < pitch_x && T(0) < pitch_y);
+    }
+
+    /**
+     * @brief Construct a new grid index object with square bins
+     *
+     * @param extent region covered by the bins
+     * @param pitch bin width and height
+     */
+    grid_index(const rectangle<T>& extent, const T& pitch)
+        : grid_index(extent, pitch, pitch)
+    {
+    }
+
+    /**
+     * @brief (Re)build the index over a set of rectangles
+     *
+     * The shape id reported by queries is the position in `shapes`. The
+     * resulting layout does not depend on `num_threads`.
+     *
+     * @param shapes
+     * @param num_threads (0 = hardware concurrency)
+     */
+    void build(gsl::span<const rectangle<T>> shapes, unsigned num_threads = 0)
+    {
+        this->_shapes.assign(shapes.begin(), shapes.end());
+        this->_build(num_threads);
+    }
+
+    /**
+     * @brief (Re)build the index over a set of points
+     *
+     * @param pts
+     * @param num_threads (0 = hardware concurrency)
+     */
+    void build(gsl::span<const point<T>> pts, unsigned num_threads = 0)
+    {
+        this->_shapes.clear();
+        this->_shapes.reserve(pts.size());
+        for (auto&& p : pts)
+        {
+            this->_shapes.emplace_back(
+                interval<T> {p.x(), p.x()}, interval<T> {p.y(), p.y()});
+        }
+        this->_build(num_threads);
+    }
+
+    /**
+     * @brief number of indexed shapes
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return this->_shapes.size();
+    }
+
+    /**
+     * @brief number of bins in x and y
+     *
+     * @return std::pair<std::size_t, std::size_t>
+     */
+    [[nodiscard]] auto dims() const noexcept
+        -> std::pair<std::size_t, std::size_t>
+    {
+        return {this->_nx, this->_ny};
+    }
+
+    /**
+     * @brief the indexed shape with the given id
+     *
+     * @param id
+     * @return const rectangle<T>&
+     */
+    [[nodiscard]] auto shape(std::size_t id) const -> const rectangle<T>&
+    {
+        return this->_shapes[id];
+    }
+
+    /**
+     * @brief shape ids registered in bin (ix, iy)
+     *
+     * @param ix
+     * @param iy
+     * @return gsl::span<const std::uint32_t>
+     */
+    [[nodiscard]] auto bin(std::size_t ix, std::size_t iy) const
+        -> gsl::span<const std::uint32_t>
+    {
+        const auto b = iy * this->_nx + ix;
+        return {this->_items.data() + this->_start[b],
+            this->_start[b + 1] - this->_start[b]};
+    }
+
+    /**
+     * @brief bin (ix, iy) containing a point, clamped into the grid
+     *
+     * @param p
+     * @return std::pair<std::size_t, std::size_t>
+     */
+    [[nodiscard]] auto locate(const point<T>& p) const
+        -> std::pair<std::size_t, std::size_t>
+    {
+        return {this->_bin_x(p.x()), this->_bin_y(p.y())};
+    }
+
+    /**
+     * @brief Call fn(id) once for every shape overlapping the window
+     *
+     * Shapes are reported in bin order, and in ascending id order within a
+     * bin.
+     *
+     * @tparam Fn
+     * @param window closed query window
+     * @param fn
+     */
+    template <typename Fn>
+    void query(const rectangle<T>& window, Fn&& fn) const
+    {
+        const auto x0 = this->_bin_x(window.x().lower());
+        const auto x1 = this->_bin_x(window.x().upper());
+        const auto y0 = this->_bin_y(window.y().lower());
+        const auto y1 = this->_bin_y(window.y().upper());
+        // a shape is listed at most once per bin
+        const auto multi = x0 != x1 || y0 != y1;
+        const auto gen = multi ? this->_next_generation() : 0U;
+        for (auto iy = y0; iy <= y1; ++iy)
+        {
+            for (auto ix = x0; ix <= x1; ++ix)
+            {
+                for (auto id : this->bin(ix, iy))
+                {
+                    if (multi)
+                    {
+                        if (this->_stamp[id] == gen)
+                        {
+                            continue;
+                        }
+                        this->_stamp[id] = gen;
+                    }
+                    if (this->_shapes[id].overlaps(window))
+                    {
+                        fn(std::size_t(id));
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief ids of all shapes overlapping the window
+     *
+     * @param window closed query window
+     * @return std::vector<std::size_t>
+     */
+    [[nodiscard]] auto query(const rectangle<T>& window) const
+        -> std::vector<std::size_t>
+    {
+        auto res = std::vector<std::size_t> {};
+        this->query(window, [&res](std::size_t id) { res.push_back(id); });
+        return res;
+    }
+
+  private:
+    [[nodiscard]] auto _bin_x(const T& x) const -> std::size_t
+    {
+        if (x < this->_origin.x())
+        {
+            return 0;
+        }
+        auto i = std::size_t((x - this->_origin.x()) / this->_pitch_x);
+        return std::min(i, this->_nx - 1);
+    }
+
+    [[nodiscard]] auto _bin_y(const T& y) const -> std::size_t
+    {
+        if (y < this->_origin.y())
+        {
+            return 0;
+        }
+        auto i = std::size_t((y - this->_origin.y()) / this->_pitch_y);
+        return std::min(i, this->_ny - 1);
+    }
+
+    [[nodiscard]] auto _next_generation() const -> std::uint32_t
+    {
+        if (++this->_generation == 0) // wrapped around
+        {
+            std::fill(this->_stamp.begin(), this->_stamp.end(), 0U);
+            this->_generation = 1;
+        }
+        return this->_generation;
+    }
+
+    /**
+     * @brief Two counting passes over fixed shape chunks
+     *
+     * Each chunk counts its own shapes per bin; the exclusive prefix over
+     * (bin, chunk) then gives every chunk a private write cursor per bin,
+     * so the fill pass needs no synchronisation and yields the same layout
+     * as a serial build.
+     *
+     * @param num_threads
+     */
+    void _build(unsigned num_threads)
+    {
+        const auto n = this->_shapes.size();
+        assert(n <= std::size_t(UINT32_MAX));
+        const auto nb = this->_nx * this->_ny;
+        const auto nt = num_chunks(n, num_threads);
+        auto cursor = std::vector<std::vector<std::size_t>>(
+            nt, std::vector<std::size_t>(nb, 0));
+
+        auto for_each_bin = [this](std::size_t id, auto&& visit)
+        {
+            const auto& r = this->_shapes[id];
+            const auto x0 = this->_bin_x(r.x().lower());
+            const auto x1 = this->_bin_x(r.x().upper());
+            const auto y0 = this->_bin_y(r.y().lower());
+            const auto y1 = this->_bin_y(r.y().upper());
+            for (auto iy = y0; iy <= y1; ++iy)
+            {
+                for (auto ix = x0; ix <= x1; ++ix)
+                {
+                    visit(iy * this->_nx + ix);
+                }
+            }
+        };
+
+        // pass 1: count
+        parallel_chunks(
+            n,
+            [&](unsigned tid, std::size_t first, std::size_t last)
+            {
+                auto& cnt = cursor[tid];
+                for (auto id = first; id != last; ++id)
+                {
+                    for_each_bin(id, [&cnt](std::size_t b) { ++cnt[b]; });
+                }
+            },
+            nt);
+
+        this->_start.assign(nb + 1, 0);
+        auto total = std::size_t(0);
+        for (auto b = std::size_t(0); b != nb; ++b)
+        {
+            this->_start[b] = total;
+            for (auto&& cnt : cursor)
+            {
+                const auto c = cnt[b];
+                cnt[b] = total;
+                total += c;
+            }
+        }
+        this->_start[nb] = total;
+        this->_items.resize(total);
+
+        // pass 2: fill
+        parallel_chunks(
+            n,
+            [&](unsigned tid, std::size_t first, std::size_t last)
+            {
+                auto& pos = cursor[tid];
+                for (auto id = first; id != last; ++id)
+                {
+                    for_each_bin(id,
+                        [&](std::size_t b)
+                        { this->_items[pos[b]++] = std::uint32_t(id); });
+                }
+            },
+            nt);
+
+        this->_stamp.assign(n, 0U);
+        this->_generation = 0;
+    }
+};
+
+/**
+ * @brief Build a grid_index sized to a set of shapes
+ *
+ * The extent is the shapes' bounding box and the square pitch the larger
+ * of the median shape size (max of width and height) and the side of a
+ * bin holding one shape on average, so there are at most about 3n + 1
+ * bins and an ordinary shape spans O(1) of them.
+ *
+ * @tparam T
+ * @param shapes at least one
+ * @param num_threads (0 = hardware concurrency)
+ * @return grid_index<T>
+ */
+template <typename T>
+inline auto make_grid_index(
+    gsl::span<const rectangle<T>> shapes, unsigned num_threads = 0)
+    -> grid_index<T>
+{
+    const auto n = shapes.size();
+    assert(n != 0);
+    auto xl = shapes[0].x().lower();
+    auto xh = shapes[0].x().upper();
+    auto yl = shapes[0].y().lower();
+    auto yh = shapes[0].y().upper();
+    auto sizes = std::vector<T> {};
+    sizes.reserve(n);
+    for (auto&& r : shapes)
+    {
+        xl = std::min(xl, r.x().lower());
+        xh = std::max(xh, r.x().upper());
+        yl = std::min(yl, r.y().lower());
+        yh = std::max(yh, r.y().upper());
+        sizes.push_back(std::max(r.x().len(), r.y().len()));
+    }
+    auto mid = sizes.begin() + std::ptrdiff_t(n / 2);
+    std::nth_element(sizes.begin(), mid, sizes.end());
+    const auto w = double(xh - xl);
+    const auto h = double(yh - yl);
+    auto pitch = T(std::max({std::sqrt(w * h / double(n)),
+        std::max(w, h) / double(n), double(*mid)}));
+    if (!(T(0) < pitch))
+    {
+        pitch = T(1);
+    }
+    auto gi = grid_index<T> {
+        rectangle<T> {interval<T> {xl, xh}, interval<T> {yl, yh}}, pitch};
+    gi.build(shapes, num_threads);
+    return gi;
+}
+
+} // namespace recti
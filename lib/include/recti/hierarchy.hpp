@@ -0,0 +1,621 @@
+#pragma once
+
+#include "grid_index.hpp"
+#include "parallel.hpp"
+#include "polygon.hpp"
+#include "recti.hpp"
+#include "rpolygon.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <gsl/span>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Placement of a child cell inside its parent
+ *
+ * Only translations are supported for now; orientations will be added as
+ * a separate transform field.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct cell_instance
+{
+    std::uint32_t cell; //!< id of the instantiated cell
+    vector2<T> offset;  //!< child origin in parent coordinates
+};
+
+namespace detail
+{
+
+/**
+ * @brief Rectangle moved by a vector
+ *
+ * @tparam T
+ * @param r
+ * @param v
+ * @return rectangle<T>
+ */
+template <typename T>
+inline auto translated(const rectangle<T>& r, const vector2<T>& v)
+    -> rectangle<T>
+{
+    return {interval<T> {r.x().lower() + v.x(), r.x().upper() + v.x()},
+        interval<T> {r.y().lower() + v.y(), r.y().upper() + v.y()}};
+}
+
+/**
+ * @brief Smallest rectangle enclosing both
+ *
+ * @tparam T
+ * @param a
+ * @param b
+ * @return rectangle<T>
+ */
+template <typename T>
+inline auto enclosing(const rectangle<T>& a, const rectangle<T>& b)
+    -> rectangle<T>
+{
+    return {interval<T> {std::min(a.x().lower(), b.x().lower()),
+                std::max(a.x().upper(), b.x().upper())},
+        interval<T> {std::min(a.y().lower(), b.y().lower()),
+            std::max(a.y().upper(), b.y().upper())}};
+}
+
+} // namespace detail
+
+/**
+ * @brief Hierarchical layout of cells that are placed by instances
+ *
+ * Every cell owns its shapes (rectangles and polygons, in cell
+ * coordinates) and a list of child instances. Nothing is ever flattened:
+ * a window or point query starts at a top cell and, on the way down,
+ * moves the query into each child's coordinates instead of moving the
+ * child's shapes. A hit is reported as (cell, shape id, offset), where
+ * offset is the accumulated placement of the cell; a caller that needs
+ * the placed polygon builds it from `polygon(cell, id)` and shifts it
+ * with the O(1) `operator+=` of polygon/rpolygon.
+ *
+ * After the last edit, `build()` computes the cell extents bottom-up and
+ * gives each cell a grid index over its shape bounding boxes and the
+ * extents of its instances, so a query only descends into instances that
+ * overlap the (translated) window. Small cells are scanned linearly.
+ *
+ * Queries reuse the stamps of the per-cell grid indexes, so one
+ * hierarchy must not be queried from several threads at the same time,
+ * nor from inside a query callback.
+ *
+ * @tparam T
+ */
+template <typename T>
+class cell_hierarchy
+{
+  public:
+    static constexpr auto npos = UINT32_MAX;
+
+  private:
+    static constexpr auto _min_indexed = std::size_t(32);
+
+    struct cell_data
+    {
+        std::vector<rectangle<T>> bbox;    // per shape
+        std::vector<std::uint32_t> poly;   // per shape, npos for rectangles
+        std::vector<std::size_t> poly_start {0};
+        std::vector<point<T>> poly_points; // CSR by polygon
+        std::vector<std::uint8_t> rectilinear; // per polygon
+        std::vector<cell_instance<T>> instances;
+        std::vector<rectangle<T>> items; // shapes, then instance extents
+        std::optional<grid_index<T>> index;
+    };
+
+    std::vector<cell_data> _cells;
+    std::vector<rectangle<T>> _extent; // valid where !_empty
+    std::vector<std::uint8_t> _empty;
+    std::vector<std::uint32_t> _order; // children before parents
+    bool _built {false};
+
+  public:
+    /**
+     * @brief Add an empty cell
+     *
+     * @return std::uint32_t cell id
+     */
+    auto add_cell() -> std::uint32_t
+    {
+        assert(this->_cells.size() < std::size_t(npos));
+        this->_cells.emplace_back();
+        this->_built = false;
+        return std::uint32_t(this->_cells.size() - 1);
+    }
+
+    /**
+     * @brief number of cells
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto num_cells() const noexcept -> std::size_t
+    {
+        return this->_cells.size();
+    }
+
+    /**
+     * @brief Add a rectangle to a cell
+     *
+     * @param cell
+     * @param r in cell coordinates
+     * @return std::uint32_t shape id within the cell
+     */
+    auto add(std::uint32_t cell, const rectangle<T>& r) -> std::uint32_t
+    {
+        auto& c = this->_cells[cell];
+        c.bbox.push_back(r);
+        c.poly.push_back(npos);
+        this->_built = false;
+        return std::uint32_t(c.bbox.size() - 1);
+    }
+
+    /**
+     * @brief Add a rectilinear polygon to a cell
+     *
+     * @param cell
+     * @param pointset vertices in rpolygon order, in cell coordinates
+     * @return std::uint32_t shape id within the cell
+     */
+    auto add_rpolygon(std::uint32_t cell, gsl::span<const point<T>> pointset)
+        -> std::uint32_t
+    {
+        return this->_add_polygon(cell, pointset, true);
+    }
+
+    /**
+     * @brief Add a general polygon to a cell
+     *
+     * @param cell
+     * @param pointset vertices in order, in cell coordinates
+     * @return std::uint32_t shape id within the cell
+     */
+    auto add_polygon(std::uint32_t cell, gsl::span<const point<T>> pointset)
+        -> std::uint32_t
+    {
+        return this->_add_polygon(cell, pointset, false);
+    }
+
+    /**
+     * @brief Place a child cell inside a parent cell
+     *
+     * @param parent
+     * @param child
+     * @param offset child origin in parent coordinates
+     * @return std::uint32_t instance id within the parent
+     */
+    auto add_instance(std::uint32_t parent, std::uint32_t child,
+        const vector2<T>& offset) -> std::uint32_t
+    {
+        assert(child < this->_cells.size());
+        auto& c = this->_cells[parent];
+        c.instances.push_back(cell_instance<T> {child, offset});
+        this->_built = false;
+        return std::uint32_t(c.instances.size() - 1);
+    }
+
+    /**
+     * @brief number of shapes owned by a cell (not counting its children)
+     *
+     * @param cell
+     * @return std::size_t
+     */
+    [[nodiscard]] auto num_shapes(std::uint32_t cell) const -> std::size_t
+    {
+        return this->_cells[cell].bbox.size();
+    }
+
+    /**
+     * @brief child instances of a cell
+     *
+     * @param cell
+     * @return gsl::span<const cell_instance<T>>
+     */
+    [[nodiscard]] auto instances(std::uint32_t cell) const
+        -> gsl::span<const cell_instance<T>>
+    {
+        return this->_cells[cell].instances;
+    }
+
+    /**
+     * @brief bounding box of a shape, in cell coordinates
+     *
+     * @param cell
+     * @param shape
+     * @return const rectangle<T>&
+     */
+    [[nodiscard]] auto bbox(std::uint32_t cell, std::uint32_t shape) const
+        -> const rectangle<T>&
+    {
+        return this->_cells[cell].bbox[shape];
+    }
+
+    /**
+     * @brief whether a shape is a polygon rather than a rectangle
+     *
+     * @param cell
+     * @param shape
+     * @return true
+     * @return false
+     */
+    [[nodiscard]] auto is_polygon(std::uint32_t cell, std::uint32_t shape) const
+        -> bool
+    {
+        return this->_cells[cell].poly[shape] != npos;
+    }
+
+    /**
+     * @brief whether a polygon shape was added as rectilinear
+     *
+     * @param cell
+     * @param shape
+     * @return true
+     * @return false
+     */
+    [[nodiscard]] auto is_rectilinear(
+        std::uint32_t cell, std::uint32_t shape) const -> bool
+    {
+        const auto& c = this->_cells[cell];
+        assert(c.poly[shape] != npos);
+        return c.rectilinear[c.poly[shape]] != 0;
+    }
+
+    /**
+     * @brief vertices of a polygon shape, in cell coordinates
+     *
+     * @param cell
+     * @param shape
+     * @return gsl::span<const point<T>>
+     */
+    [[nodiscard]] auto polygon(std::uint32_t cell, std::uint32_t shape) const
+        -> gsl::span<const point<T>>
+    {
+        const auto& c = this->_cells[cell];
+        const auto k = c.poly[shape];
+        assert(k != npos);
+        return {c.poly_points.data() + c.poly_start[k],
+            c.poly_start[k + 1] - c.poly_start[k]};
+    }
+
+    /**
+     * @brief Compute cell extents and per-cell indexes
+     *
+     * Must be called after the last edit and before any query. The cell
+     * indexes are built in parallel, one cell per task.
+     *
+     * @param num_threads (0 = hardware concurrency)
+     * @return false if the instances form a cycle
+     */
+    auto build(unsigned num_threads = 0) -> bool
+    {
+        const auto n = this->_cells.size();
+        if (!this->_topological_order())
+        {
+            return false;
+        }
+
+        // own shapes first, then children in bottom-up order
+        this->_empty.assign(n, 1);
+        this->_extent.clear();
+        for (auto&& c : this->_cells)
+        {
+            auto ext = c.bbox.empty()
+                ? rectangle<T> {interval<T> {T(0), T(0)},
+                      interval<T> {T(0), T(0)}}
+                : c.bbox.front();
+            for (auto&& b : c.bbox)
+            {
+                ext = detail::enclosing(ext, b);
+            }
+            this->_extent.push_back(ext);
+        }
+        for (auto id : this->_order)
+        {
+            const auto& c = this->_cells[id];
+            auto empty = c.bbox.empty();
+            auto ext = this->_extent[id];
+            for (auto&& inst : c.instances)
+            {
+                if (this->_empty[inst.cell] != 0)
+                {
+                    continue;
+                }
+                const auto child =
+                    detail::translated(this->_extent[inst.cell], inst.offset);
+                ext = empty ? child : detail::enclosing(ext, child);
+                empty = false;
+            }
+            this->_extent[id] = ext;
+            this->_empty[id] = empty ? 1 : 0;
+        }
+
+        parallel_for(
+            n,
+            [this](std::size_t id)
+            {
+                auto& c = this->_cells[id];
+                c.items = c.bbox;
+                for (auto&& inst : c.instances)
+                {
+                    // empty children keep a slot so that item ids line up
+                    c.items.push_back(
+                        detail::translated(this->_extent[inst.cell],
+                            inst.offset));
+                }
+                c.index.reset();
+                if (c.items.size() >= _min_indexed)
+                {
+                    const auto& ext = this->_extent[id];
+                    c.index.emplace(ext, _pitch(ext, c.items.size()));
+                    c.index->build(c.items, 1);
+                }
+            },
+            num_threads);
+        this->_built = true;
+        return true;
+    }
+
+    /**
+     * @brief whether a cell (with its children) contains no shapes
+     *
+     * @param cell
+     * @return true
+     * @return false
+     */
+    [[nodiscard]] auto empty(std::uint32_t cell) const -> bool
+    {
+        assert(this->_built);
+        return this->_empty[cell] != 0;
+    }
+
+    /**
+     * @brief bounding box of a non-empty cell and all of its children
+     *
+     * @param cell
+     * @return const rectangle<T>&
+     */
+    [[nodiscard]] auto extent(std::uint32_t cell) const -> const rectangle<T>&
+    {
+        assert(this->_built && this->_empty[cell] == 0);
+        return this->_extent[cell];
+    }
+
+    /**
+     * @brief number of shapes the cell would have if it were flattened
+     *
+     * @param cell
+     * @return std::uint64_t
+     */
+    [[nodiscard]] auto flat_size(std::uint32_t cell) const -> std::uint64_t
+    {
+        assert(this->_built);
+        auto cnt = std::vector<std::uint64_t>(this->_cells.size(), 0);
+        for (auto id : this->_order)
+        {
+            const auto& c = this->_cells[id];
+            auto total = std::uint64_t(c.bbox.size());
+            for (auto&& inst : c.instances)
+            {
+                total += cnt[inst.cell];
+            }
+            cnt[id] = total;
+        }
+        return cnt[cell];
+    }
+
+    /**
+     * @brief Call fn(cell, shape, offset) for every placed shape whose
+     * bounding box overlaps the window
+     *
+     * Rectangles are therefore reported exactly, polygons by their
+     * bounding box. The placed shape is the cell's shape moved by offset.
+     *
+     * @tparam Fn
+     * @param top cell the window is given in
+     * @param window closed query window
+     * @param fn callable(std::uint32_t, std::uint32_t, const vector2<T>&)
+     */
+    template <typename Fn>
+    void query(std::uint32_t top, const rectangle<T>& window, Fn&& fn) const
+    {
+        assert(this->_built);
+        if (this->_empty[top] == 0 && this->_extent[top].overlaps(window))
+        {
+            this->_query(top, window, vector2<T> {T(0), T(0)},
+                [&fn](std::uint32_t cell, std::uint32_t shape,
+                    const vector2<T>& offset, const rectangle<T>&)
+                { fn(cell, shape, offset); });
+        }
+    }
+
+    /**
+     * @brief Call fn(cell, shape, offset) for every placed shape that
+     * contains the point
+     *
+     * Rectangles are closed; polygons use the half-open crossing test of
+     * point_in_rpolygon / point_in_polygon.
+     *
+     * @tparam Fn
+     * @param top cell the point is given in
+     * @param q
+     * @param fn callable(std::uint32_t, std::uint32_t, const vector2<T>&)
+     */
+    template <typename Fn>
+    void query(std::uint32_t top, const point<T>& q, Fn&& fn) const
+    {
+        assert(this->_built);
+        const auto window = rectangle<T> {
+            interval<T> {q.x(), q.x()}, interval<T> {q.y(), q.y()}};
+        if (this->_empty[top] != 0 || !this->_extent[top].contains(q))
+        {
+            return;
+        }
+        this->_query(top, window, vector2<T> {T(0), T(0)},
+            [this, &fn](std::uint32_t cell, std::uint32_t shape,
+                const vector2<T>& offset, const rectangle<T>& local)
+            {
+                const auto& c = this->_cells[cell];
+                const auto k = c.poly[shape];
+                if (k != npos)
+                {
+                    const auto p = local.lower();
+                    const auto S = this->polygon(cell, shape);
+                    if (c.rectilinear[k] != 0 ? !point_in_rpolygon(S, p)
+                                              : !point_in_polygon(S, p))
+                    {
+                        return;
+                    }
+                }
+                fn(cell, shape, offset);
+            });
+    }
+
+  private:
+    auto _add_polygon(std::uint32_t cell, gsl::span<const point<T>> pointset,
+        bool rectilinear) -> std::uint32_t
+    {
+        assert(!pointset.empty());
+        auto& c = this->_cells[cell];
+        auto lo = pointset.front();
+        auto hi = pointset.front();
+        for (auto&& p : pointset)
+        {
+            lo = point<T> {std::min(lo.x(), p.x()), std::min(lo.y(), p.y())};
+            hi = point<T> {std::max(hi.x(), p.x()), std::max(hi.y(), p.y())};
+        }
+        c.bbox.emplace_back(
+            interval<T> {lo.x(), hi.x()}, interval<T> {lo.y(), hi.y()});
+        c.poly.push_back(std::uint32_t(c.rectilinear.size()));
+        c.rectilinear.push_back(rectilinear ? 1 : 0);
+        c.poly_points.insert(
+            c.poly_points.end(), pointset.begin(), pointset.end());
+        c.poly_start.push_back(c.poly_points.size());
+        this->_built = false;
+        return std::uint32_t(c.bbox.size() - 1);
+    }
+
+    /**
+     * @brief Bin pitch giving about one bin per item
+     *
+     * The pitch is never below extent / items along the longer side, so a
+     * thin extent cannot blow up the number of bins.
+     *
+     * @param ext
+     * @param n
+     * @return T
+     */
+    [[nodiscard]] static auto _pitch(const rectangle<T>& ext, std::size_t n)
+        -> T
+    {
+        const auto w = double(ext.x().len());
+        const auto h = double(ext.y().len());
+        const auto p =
+            std::max(std::sqrt(w * h / double(n)), std::max(w, h) / double(n));
+        return p > 1.0 ? T(p) : T(1);
+    }
+
+    /**
+     * @brief Order the cells children-first by an iterative DFS
+     *
+     * @return false if some cell (indirectly) instantiates itself
+     */
+    auto _topological_order() -> bool
+    {
+        const auto n = this->_cells.size();
+        // 0 = unvisited, 1 = on the DFS stack, 2 = done
+        auto state = std::vector<std::uint8_t>(n, 0);
+        auto stack = std::vector<std::pair<std::uint32_t, std::size_t>> {};
+        this->_order.clear();
+        for (auto root = std::uint32_t(0); root != n; ++root)
+        {
+            if (state[root] != 0)
+            {
+                continue;
+            }
+            state[root] = 1;
+            stack.emplace_back(root, 0);
+            while (!stack.empty())
+            {
+                auto& [id, next] = stack.back();
+                const auto& inst = this->_cells[id].instances;
+                if (next == inst.size())
+                {
+                    state[id] = 2;
+                    this->_order.push_back(id);
+                    stack.pop_back();
+                    continue;
+                }
+                const auto child = inst[next++].cell;
+                if (state[child] == 1)
+                {
+                    return false;
+                }
+                if (state[child] == 0)
+                {
+                    state[child] = 1;
+                    stack.emplace_back(child, 0);
+                }
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Report the items of one cell that overlap the local window
+     *
+     * @param id cell
+     * @param window query window in the cell's coordinates
+     * @param offset placement of the cell in the top cell
+     * @param fn callable(cell, shape, offset, local window)
+     */
+    template <typename Fn>
+    void _query(std::uint32_t id, const rectangle<T>& window,
+        const vector2<T>& offset, const Fn& fn) const
+    {
+        const auto& c = this->_cells[id];
+        const auto ns = c.bbox.size();
+        auto visit = [&](std::size_t k)
+        {
+            if (k < ns)
+            {
+                fn(id, std::uint32_t(k), offset, window);
+                return;
+            }
+            const auto& inst = c.instances[k - ns];
+            if (this->_empty[inst.cell] != 0)
+            {
+                return;
+            }
+            const auto local =
+                vector2<T> {T(0) - inst.offset.x(), T(0) - inst.offset.y()};
+            auto placed = offset;
+            placed += inst.offset;
+            this->_query(inst.cell, detail::translated(window, local), placed,
+                fn);
+        };
+        if (c.index)
+        {
+            c.index->query(window, visit);
+            return;
+        }
+        for (auto k = std::size_t(0); k != c.items.size(); ++k)
+        {
+            if (c.items[k].overlaps(window))
+            {
+                visit(k);
+            }
+        }
+    }
+};
+
+} // namespace recti
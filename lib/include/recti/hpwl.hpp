@@ -0,0 +1,371 @@
+#pragma once
+
+#include "netlist.hpp"
+#include "parallel.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <gsl/span>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Half-perimeter wirelength of a set of points
+ *
+ * @tparam T
+ * @param pts (non-empty)
+ * @return T
+ */
+template <typename T>
+inline auto hpwl(gsl::span<const point<T>> pts) -> T
+{
+    assert(!pts.empty());
+    auto xlo = pts[0].x();
+    auto xhi = xlo;
+    auto ylo = pts[0].y();
+    auto yhi = ylo;
+    for (auto&& p : pts)
+    {
+        xlo = std::min(xlo, p.x());
+        xhi = std::max(xhi, p.x());
+        ylo = std::min(ylo, p.y());
+        yhi = std::max(yhi, p.y());
+    }
+    return (xhi - xlo) + (yhi - ylo);
+}
+
+/**
+ * @brief Batched and incremental HPWL engine for a placement netlist
+ *
+ * Pin coordinates are kept as structure-of-arrays in net order, so the
+ * bounding box of a net is a branch-free min/max reduction over contiguous
+ * memory that the compiler vectorises. Along with each net's bounding box
+ * the engine keeps how many pins sit on each of its four boundaries.
+ * Moving a cell updates the boxes of its nets in O(1) per pin; a net is
+ * rescanned only when a boundary count drops to zero, i.e. when its last
+ * boundary pin moved inward.
+ *
+ * @tparam T
+ */
+template <typename T>
+class hpwl_engine
+{
+  private:
+    std::vector<std::size_t> _net_start;
+    std::vector<std::uint32_t> _pin_net;
+    std::vector<std::uint32_t> _pin_cell;
+    std::vector<T> _off_x;
+    std::vector<T> _off_y;
+    std::vector<T> _px; // pin x, net order
+    std::vector<T> _py; // pin y, net order
+    std::vector<point<T>> _cells;
+    std::vector<std::size_t> _cell_start; // cell -> pins CSR
+    std::vector<std::uint32_t> _cell_pins;
+
+    // per-net bounding box and number of pins on each boundary
+    std::vector<T> _xlo;
+    std::vector<T> _xhi;
+    std::vector<T> _ylo;
+    std::vector<T> _yhi;
+    std::vector<std::uint32_t> _nxlo;
+    std::vector<std::uint32_t> _nxhi;
+    std::vector<std::uint32_t> _nylo;
+    std::vector<std::uint32_t> _nyhi;
+
+    T _total {0};
+    std::size_t _num_rescans {0};
+    std::vector<std::uint32_t> _stamp;
+    std::uint32_t _generation {0};
+    std::vector<std::uint32_t> _touched;
+
+  public:
+    /**
+     * @brief Construct a new hpwl engine object
+     *
+     * Nets without pins have zero wirelength.
+     *
+     * @param nl
+     * @param cells initial cell positions
+     * @param num_threads (0 = hardware concurrency)
+     */
+    hpwl_engine(const netlist<T>& nl, gsl::span<const point<T>> cells,
+        unsigned num_threads = 0)
+        : _net_start(nl.net_start)
+        , _pin_net(nl.num_pins())
+        , _pin_cell(nl.pin_cell)
+        , _cells(cells.begin(), cells.end())
+        , _cell_start(cells.size() + 1, 0)
+        , _cell_pins(nl.num_pins())
+    {
+        const auto num_nets = nl.num_nets();
+        const auto num_pins = nl.num_pins();
+        assert(num_pins <= std::size_t(UINT32_MAX));
+        this->_off_x.reserve(num_pins);
+        this->_off_y.reserve(num_pins);
+        for (auto&& v : nl.pin_offset)
+        {
+            this->_off_x.push_back(v.x());
+            this->_off_y.push_back(v.y());
+        }
+        for (auto e = 0U; e != num_nets; ++e)
+        {
+            for (auto p = this->_net_start[e]; p != this->_net_start[e + 1];
+                 ++p)
+            {
+                this->_pin_net[p] = e;
+            }
+        }
+        for (auto c : this->_pin_cell)
+        {
+            ++this->_cell_start[c + 1];
+        }
+        for (auto c = 0U; c != cells.size(); ++c)
+        {
+            this->_cell_start[c + 1] += this->_cell_start[c];
+        }
+        auto pos = std::vector<std::size_t>(
+            this->_cell_start.begin(), this->_cell_start.end() - 1);
+        for (auto p = 0U; p != num_pins; ++p)
+        {
+            this->_cell_pins[pos[this->_pin_cell[p]]++] = p;
+        }
+
+        this->_px.resize(num_pins);
+        this->_py.resize(num_pins);
+        for (auto vec : {&this->_xlo, &this->_xhi, &this->_ylo, &this->_yhi})
+        {
+            vec->assign(num_nets, T(0));
+        }
+        for (auto vec :
+            {&this->_nxlo, &this->_nxhi, &this->_nylo, &this->_nyhi})
+        {
+            vec->assign(num_nets, 0U);
+        }
+        this->_stamp.assign(num_nets, 0U);
+        this->recompute(num_threads);
+    }
+
+    /**
+     * @brief Recompute every pin position and net box from scratch
+     *
+     * @param num_threads (0 = hardware concurrency)
+     * @return T total HPWL
+     */
+    auto recompute(unsigned num_threads = 0) -> T
+    {
+        parallel_for(
+            this->_px.size(),
+            [this](std::size_t p)
+            {
+                const auto& c = this->_cells[this->_pin_cell[p]];
+                this->_px[p] = c.x() + this->_off_x[p];
+                this->_py[p] = c.y() + this->_off_y[p];
+            },
+            num_threads);
+
+        const auto num_nets = this->num_nets();
+        const auto nt = num_chunks(num_nets, num_threads);
+        auto partial = std::vector<T>(nt, T(0));
+        parallel_chunks(
+            num_nets,
+            [&](unsigned tid, std::size_t first, std::size_t last)
+            {
+                auto sum = T(0);
+                for (auto e = first; e != last; ++e)
+                {
+                    this->_rescan(e);
+                    sum += this->net_hpwl(e);
+                }
+                partial[tid] = sum;
+            },
+            nt);
+        this->_total = T(0);
+        for (auto&& s : partial)
+        {
+            this->_total += s;
+        }
+        return this->_total;
+    }
+
+    /**
+     * @brief Move a cell and update the HPWL of its nets
+     *
+     * @param cell
+     * @param pos new position
+     * @return T total HPWL after the move
+     */
+    auto move_cell(std::size_t cell, const point<T>& pos) -> T
+    {
+        this->_cells[cell] = pos;
+        if (++this->_generation == 0)
+        {
+            std::fill(this->_stamp.begin(), this->_stamp.end(), 0U);
+            this->_generation = 1;
+        }
+        this->_touched.clear();
+        const auto first = this->_cell_start[cell];
+        const auto last = this->_cell_start[cell + 1];
+        for (auto k = first; k != last; ++k)
+        {
+            const auto p = this->_cell_pins[k];
+            const auto e = this->_pin_net[p];
+            if (this->_stamp[e] != this->_generation)
+            {
+                this->_stamp[e] = this->_generation;
+                this->_touched.push_back(e);
+                this->_total -= this->net_hpwl(e);
+            }
+            const auto x = pos.x() + this->_off_x[p];
+            const auto y = pos.y() + this->_off_y[p];
+            _update(this->_px[p], x, this->_xlo[e], this->_nxlo[e],
+                this->_xhi[e], this->_nxhi[e]);
+            _update(this->_py[p], y, this->_ylo[e], this->_nylo[e],
+                this->_yhi[e], this->_nyhi[e]);
+            this->_px[p] = x;
+            this->_py[p] = y;
+        }
+        for (auto e : this->_touched)
+        {
+            if (this->_nxlo[e] == 0 || this->_nxhi[e] == 0 ||
+                this->_nylo[e] == 0 || this->_nyhi[e] == 0)
+            {
+                this->_rescan(e);
+                ++this->_num_rescans;
+            }
+            this->_total += this->net_hpwl(e);
+        }
+        return this->_total;
+    }
+
+    /**
+     * @brief total HPWL
+     *
+     * @return T
+     */
+    [[nodiscard]] auto total() const noexcept -> T
+    {
+        return this->_total;
+    }
+
+    /**
+     * @brief HPWL of net e
+     *
+     * @param e
+     * @return T
+     */
+    [[nodiscard]] auto net_hpwl(std::size_t e) const -> T
+    {
+        return (this->_xhi[e] - this->_xlo[e]) +
+            (this->_yhi[e] - this->_ylo[e]);
+    }
+
+    /**
+     * @brief bounding box of net e (meaningless for nets without pins)
+     *
+     * @param e
+     * @return rectangle<T>
+     */
+    [[nodiscard]] auto net_bbox(std::size_t e) const -> rectangle<T>
+    {
+        return {interval<T> {this->_xlo[e], this->_xhi[e]},
+            interval<T> {this->_ylo[e], this->_yhi[e]}};
+    }
+
+    /**
+     * @brief
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto num_nets() const noexcept -> std::size_t
+    {
+        return this->_net_start.size() - 1;
+    }
+
+    /**
+     * @brief number of nets rescanned by move_cell() so far
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto num_rescans() const noexcept -> std::size_t
+    {
+        return this->_num_rescans;
+    }
+
+  private:
+    /**
+     * @brief Move one coordinate of a pin from `from` to `to`
+     *
+     * `lo`/`hi` stay valid bounds throughout; a boundary count of zero
+     * means the bound may be loose and the net must be rescanned.
+     */
+    static void _update(const T& from, const T& to, T& lo, std::uint32_t& nlo,
+        T& hi, std::uint32_t& nhi)
+    {
+        nlo -= from == lo ? 1 : 0;
+        nhi -= from == hi ? 1 : 0;
+        if (to < lo)
+        {
+            lo = to;
+            nlo = 1;
+        }
+        else if (to == lo)
+        {
+            ++nlo;
+        }
+        if (hi < to)
+        {
+            hi = to;
+            nhi = 1;
+        }
+        else if (to == hi)
+        {
+            ++nhi;
+        }
+    }
+
+    /**
+     * @brief Exact bounding box and boundary counts of net e
+     *
+     * @param e
+     */
+    void _rescan(std::size_t e)
+    {
+        const auto first = this->_net_start[e];
+        const auto n = this->_net_start[e + 1] - first;
+        if (n == 0)
+        {
+            return;
+        }
+        _reduce(&this->_px[first], n, this->_xlo[e], this->_nxlo[e],
+            this->_xhi[e], this->_nxhi[e]);
+        _reduce(&this->_py[first], n, this->_ylo[e], this->_nylo[e],
+            this->_yhi[e], this->_nyhi[e]);
+    }
+
+    static void _reduce(const T* v, std::size_t n, T& lo, std::uint32_t& nlo,
+        T& hi, std::uint32_t& nhi)
+    {
+        auto mn = v[0];
+        auto mx = v[0];
+        for (auto i = std::size_t(1); i != n; ++i) // vectorisable
+        {
+            mn = std::min(mn, v[i]);
+            mx = std::max(mx, v[i]);
+        }
+        auto cl = 0U;
+        auto ch = 0U;
+        for (auto i = std::size_t(0); i != n; ++i)
+        {
+            cl += v[i] == mn ? 1U : 0U;
+            ch += v[i] == mx ? 1U : 0U;
+        }
+        lo = mn;
+        hi = mx;
+        nlo = cl;
+        nhi = ch;
+    }
+};
+
+} // namespace recti
@@ -0,0 +1,403 @@
+#pragma once
+
+#include "drc.hpp"
+#include "parallel.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Violations added and cleared by one batch of edits
+ *
+ * A violation whose value or marker changed is listed in both, the old
+ * one in `cleared` and the new one in `added`. Both are sorted by (a, b).
+ *
+ * @tparam T
+ */
+template <typename T>
+struct drc_delta
+{
+    std::vector<drc_violation<T>> added;
+    std::vector<drc_violation<T>> cleared;
+};
+
+/**
+ * @brief Spacing and width checker that stays live under shape edits
+ *
+ * Shapes are rectangles with stable ids. They are kept in a dynamic grid
+ * of bins together with the current violation set and, per shape, the
+ * shapes it has a spacing violation with. Edits (insert, remove, move)
+ * are staged; commit() re-checks only the edited shapes against their
+ * neighbourhood within min_spacing, in parallel, and diffs the result
+ * against the violations those shapes had before. Violations between two
+ * untouched shapes cannot change, so a batch costs time proportional to
+ * the edited shapes' neighbourhoods, not to the design.
+ *
+ * Violations follow check_spacing() and check_width() on rectangles: a
+ * spacing violation has a < b; a width violation has a == b and reports
+ * the smaller side.
+ *
+ * @tparam T
+ */
+template <typename T>
+class incremental_drc
+{
+  private:
+    point<T> _origin;
+    T _pitch;
+    std::size_t _nx;
+    std::size_t _ny;
+    T _min_spacing;
+    T _min_width;
+    std::vector<std::vector<std::uint32_t>> _bins;
+    std::vector<rectangle<T>> _shapes;
+    std::vector<bool> _alive;
+    std::vector<bool> _dirty_flag;
+    std::vector<std::uint32_t> _dirty;
+    std::vector<std::vector<std::uint32_t>> _partners;
+    std::unordered_map<std::uint64_t, drc_violation<T>> _violations;
+
+  public:
+    /**
+     * @brief Construct a new incremental drc object
+     *
+     * @param extent region covered by the bins (shapes may lie outside)
+     * @param pitch bin size, typically a few times min_spacing
+     * @param min_spacing
+     * @param min_width
+     */
+    incremental_drc(const rectangle<T>& extent, const T& pitch,
+        const T& min_spacing, const T& min_width)
+        : _origin {extent.lower()}
+        , _pitch {pitch}
+        , _nx {std::size_t(extent.x().len() / pitch) + 1}
+        , _ny {std::size_t(extent.y().len() / pitch) + 1}
+        , _min_spacing {min_spacing}
+        , _min_width {min_width}
+        , _bins(_nx * _ny)
+    {
+        assert(T(0) < pitch);
+    }
+
+    /**
+     * @brief number of shape ids handed out (including removed ones)
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return this->_shapes.size();
+    }
+
+    [[nodiscard]] auto alive(std::uint32_t id) const -> bool
+    {
+        return this->_alive[id];
+    }
+
+    [[nodiscard]] auto shape(std::uint32_t id) const -> const rectangle<T>&
+    {
+        return this->_shapes[id];
+    }
+
+    /**
+     * @brief stage the insertion of a shape
+     *
+     * @param r
+     * @return std::uint32_t its id
+     */
+    auto insert(const rectangle<T>& r) -> std::uint32_t
+    {
+        assert(this->_shapes.size() < std::size_t(UINT32_MAX));
+        const auto id = std::uint32_t(this->_shapes.size());
+        this->_shapes.push_back(r);
+        this->_alive.push_back(true);
+        this->_dirty_flag.push_back(false);
+        this->_partners.emplace_back();
+        this->_bin_update(id, true);
+        this->_touch(id);
+        return id;
+    }
+
+    /**
+     * @brief stage the removal of a shape
+     *
+     * @param id
+     */
+    void remove(std::uint32_t id)
+    {
+        assert(this->_alive[id]);
+        this->_bin_update(id, false);
+        this->_alive[id] = false;
+        this->_touch(id);
+    }
+
+    /**
+     * @brief stage moving (or resizing) a shape
+     *
+     * @param id
+     * @param r new geometry
+     */
+    void move(std::uint32_t id, const rectangle<T>& r)
+    {
+        assert(this->_alive[id]);
+        this->_bin_update(id, false);
+        this->_shapes[id] = r;
+        this->_bin_update(id, true);
+        this->_touch(id);
+    }
+
+    /**
+     * @brief re-check the shapes edited since the last commit
+     *
+     * @param num_threads (0 = hardware concurrency)
+     * @return drc_delta<T>
+     */
+    auto commit(unsigned num_threads = 0) -> drc_delta<T>
+    {
+        auto& dirty = this->_dirty;
+        std::sort(dirty.begin(), dirty.end());
+
+        // violations the edited shapes had before
+        auto before = std::map<std::uint64_t, drc_violation<T>> {};
+        for (auto d : dirty)
+        {
+            auto collect = [&](std::uint32_t p)
+            {
+                const auto k = _key(d, p);
+                const auto it = this->_violations.find(k);
+                if (it != this->_violations.end())
+                {
+                    before.emplace(k, it->second);
+                }
+            };
+            collect(d);
+            for (auto p : this->_partners[d])
+            {
+                collect(p);
+            }
+        }
+
+        // violations they have now; the index is only read here
+        auto found = std::vector<std::vector<drc_violation<T>>>(dirty.size());
+        parallel_for(
+            dirty.size(),
+            [&](std::size_t k) { this->_check(dirty[k], found[k]); },
+            num_threads);
+        auto after = std::map<std::uint64_t, drc_violation<T>> {};
+        for (auto&& vs : found)
+        {
+            for (auto&& v : vs)
+            {
+                after.emplace(_key(v.a, v.b), v);
+            }
+        }
+
+        auto res = drc_delta<T> {};
+        for (auto&& [k, v] : before)
+        {
+            const auto it = after.find(k);
+            if (it == after.end() || !_same(v, it->second))
+            {
+                res.cleared.push_back(v);
+                this->_erase(v);
+            }
+        }
+        for (auto&& [k, v] : after)
+        {
+            const auto it = before.find(k);
+            if (it == before.end() || !_same(v, it->second))
+            {
+                res.added.push_back(v);
+                this->_violations.emplace(k, v);
+                if (v.a != v.b)
+                {
+                    this->_partners[v.a].push_back(v.b);
+                    this->_partners[v.b].push_back(v.a);
+                }
+            }
+        }
+
+        for (auto d : dirty)
+        {
+            this->_dirty_flag[d] = false;
+        }
+        dirty.clear();
+        return res;
+    }
+
+    /**
+     * @brief number of current violations (as of the last commit)
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto num_violations() const noexcept -> std::size_t
+    {
+        return this->_violations.size();
+    }
+
+    /**
+     * @brief current violations, sorted by (a, b)
+     *
+     * @return std::vector<drc_violation<T>>
+     */
+    [[nodiscard]] auto violations() const -> std::vector<drc_violation<T>>
+    {
+        auto res = std::vector<drc_violation<T>> {};
+        res.reserve(this->_violations.size());
+        for (auto&& kv : this->_violations)
+        {
+            res.push_back(kv.second);
+        }
+        std::sort(res.begin(), res.end(),
+            [](const auto& p, const auto& q)
+            { return _key(p.a, p.b) < _key(q.a, q.b); });
+        return res;
+    }
+
+  private:
+    static auto _key(std::uint32_t a, std::uint32_t b) -> std::uint64_t
+    {
+        if (b < a)
+        {
+            std::swap(a, b);
+        }
+        return (std::uint64_t(a) << 32) | b;
+    }
+
+    static auto _same(const drc_violation<T>& p, const drc_violation<T>& q)
+        -> bool
+    {
+        return p.value == q.value && p.marker == q.marker;
+    }
+
+    void _touch(std::uint32_t id)
+    {
+        if (!this->_dirty_flag[id])
+        {
+            this->_dirty_flag[id] = true;
+            this->_dirty.push_back(id);
+        }
+    }
+
+    void _erase(const drc_violation<T>& v)
+    {
+        this->_violations.erase(_key(v.a, v.b));
+        if (v.a == v.b)
+        {
+            return;
+        }
+        auto drop = [](std::vector<std::uint32_t>& list, std::uint32_t x)
+        {
+            const auto it = std::find(list.begin(), list.end(), x);
+            assert(it != list.end());
+            *it = list.back();
+            list.pop_back();
+        };
+        drop(this->_partners[v.a], v.b);
+        drop(this->_partners[v.b], v.a);
+    }
+
+    [[nodiscard]] auto _bin(const T& v, const T& o, std::size_t n) const
+        -> std::size_t
+    {
+        if (v < o)
+        {
+            return 0;
+        }
+        return std::min(std::size_t((v - o) / this->_pitch), n - 1);
+    }
+
+    /**
+     * @brief call fn(bin) for every bin a rectangle meets
+     */
+    template <typename Fn>
+    void _for_bins(const rectangle<T>& r, Fn&& fn) const
+    {
+        const auto& o = this->_origin;
+        const auto x0 = this->_bin(r.x().lower(), o.x(), this->_nx);
+        const auto x1 = this->_bin(r.x().upper(), o.x(), this->_nx);
+        const auto y0 = this->_bin(r.y().lower(), o.y(), this->_ny);
+        const auto y1 = this->_bin(r.y().upper(), o.y(), this->_ny);
+        for (auto iy = y0; iy <= y1; ++iy)
+        {
+            for (auto ix = x0; ix <= x1; ++ix)
+            {
+                fn(iy * this->_nx + ix);
+            }
+        }
+    }
+
+    void _bin_update(std::uint32_t id, bool add)
+    {
+        this->_for_bins(this->_shapes[id],
+            [&](std::size_t b)
+            {
+                auto& bin = this->_bins[b];
+                if (add)
+                {
+                    bin.push_back(id);
+                    return;
+                }
+                const auto it = std::find(bin.begin(), bin.end(), id);
+                assert(it != bin.end());
+                *it = bin.back();
+                bin.pop_back();
+            });
+    }
+
+    /**
+     * @brief current violations of one shape (none if it was removed)
+     */
+    void _check(std::uint32_t id, std::vector<drc_violation<T>>& out) const
+    {
+        if (!this->_alive[id])
+        {
+            return;
+        }
+        const auto& p = this->_shapes[id];
+        const auto w = std::min(p.x().len(), p.y().len());
+        if (w < this->_min_width)
+        {
+            out.push_back(drc_violation<T> {drc_rule::width, id, id, w, p});
+        }
+        const auto& s = this->_min_spacing;
+        const auto window = rectangle<T> {
+            interval<T> {p.x().lower() - s, p.x().upper() + s},
+            interval<T> {p.y().lower() - s, p.y().upper() + s}};
+        auto cands = std::vector<std::uint32_t> {};
+        this->_for_bins(window,
+            [&](std::size_t b)
+            {
+                cands.insert(cands.end(), this->_bins[b].begin(),
+                    this->_bins[b].end());
+            });
+        std::sort(cands.begin(), cands.end());
+        cands.erase(std::unique(cands.begin(), cands.end()), cands.end());
+        for (auto j : cands)
+        {
+            if (j == id)
+            {
+                continue;
+            }
+            const auto& q = this->_shapes[j];
+            const auto d =
+                detail::gap(p.x(), q.x()) + detail::gap(p.y(), q.y());
+            if (d == T(0) || !(d < s))
+            {
+                continue;
+            }
+            out.push_back(drc_violation<T> {drc_rule::spacing,
+                std::min(id, j), std::max(id, j), d,
+                rectangle<T> {detail::between(p.x(), q.x()),
+                    detail::between(p.y(), q.y())}});
+        }
+    }
+};
+
+} // namespace recti
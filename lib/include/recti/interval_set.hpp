@@ -0,0 +1,354 @@
+#pragma once
+
+#include "recti.hpp"
+#include <algorithm>
+#include <gsl/span>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Set of disjoint closed intervals in a sorted flat vector
+ *
+ * The boundaries are stored as l0, u0, l1, u1, ... with u_i < l_{i+1}, so
+ * the members are pairwise `<`-ordered in the sense of interval::operator<.
+ * Intervals that share a point are merged. Membership is a binary search
+ * over the boundaries; union, intersection and subtraction of two sets are
+ * linear merges.
+ *
+ * @tparam T
+ */
+template <typename T>
+class interval_set
+{
+  private:
+    std::vector<T> _bounds;
+
+  public:
+    /**
+     * @brief Construct an empty interval set
+     *
+     */
+    interval_set() = default;
+
+    /**
+     * @brief Construct a new interval set from arbitrary intervals
+     *
+     * @param ivs
+     */
+    explicit interval_set(gsl::span<const interval<T>> ivs)
+    {
+        auto sorted = std::vector<interval<T>>(ivs.begin(), ivs.end());
+        std::sort(sorted.begin(), sorted.end(),
+            [](const auto& a, const auto& b) { return a.lower() < b.lower(); });
+        for (auto&& a : sorted)
+        {
+            this->_append(a.lower(), a.upper());
+        }
+    }
+
+    /**
+     * @brief number of disjoint intervals
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return this->_bounds.size() / 2;
+    }
+
+    /**
+     * @brief
+     *
+     * @return true if the set is empty
+     */
+    [[nodiscard]] auto empty() const noexcept -> bool
+    {
+        return this->_bounds.empty();
+    }
+
+    /**
+     * @brief the i-th interval, in increasing order
+     *
+     * @param i
+     * @return interval<T>
+     */
+    [[nodiscard]] auto operator[](std::size_t i) const -> interval<T>
+    {
+        return {this->_bounds[2 * i], this->_bounds[2 * i + 1]};
+    }
+
+    /**
+     * @brief total length of the set
+     *
+     * @return T
+     */
+    [[nodiscard]] auto measure() const -> T
+    {
+        auto sum = T(0);
+        for (auto i = 0U; i < this->_bounds.size(); i += 2)
+        {
+            sum += this->_bounds[i + 1] - this->_bounds[i];
+        }
+        return sum;
+    }
+
+    /**
+     * @brief
+     *
+     * @param rhs
+     * @return true
+     * @return false
+     */
+    auto operator==(const interval_set& rhs) const -> bool
+    {
+        return this->_bounds == rhs._bounds;
+    }
+
+    /**
+     * @brief
+     *
+     * @param rhs
+     * @return true
+     * @return false
+     */
+    auto operator!=(const interval_set& rhs) const -> bool
+    {
+        return !(*this == rhs);
+    }
+
+    /**
+     * @brief whether x lies in one of the intervals, O(log n)
+     *
+     * @param x
+     * @return true
+     * @return false
+     */
+    [[nodiscard]] auto contains(const T& x) const -> bool
+    {
+        const auto p = std::size_t(
+            std::upper_bound(this->_bounds.begin(), this->_bounds.end(), x) -
+            this->_bounds.begin());
+        return p % 2 == 1 || (p != 0 && this->_bounds[p - 1] == x);
+    }
+
+    /**
+     * @brief whether a lies within a single interval of the set, O(log n)
+     *
+     * @param a
+     * @return true
+     * @return false
+     */
+    [[nodiscard]] auto contains(const interval<T>& a) const -> bool
+    {
+        const auto i = this->_find(a.lower());
+        return i != this->size() && (*this)[i].contains(a);
+    }
+
+    /**
+     * @brief insert an interval, merging it with the ones it overlaps
+     *
+     * @param a
+     */
+    void insert(const interval<T>& a)
+    {
+        auto& b = this->_bounds;
+        // first member whose upper bound is >= a.lower()
+        const auto i = this->_find(a.lower());
+        // one past the last member whose lower bound is <= a.upper()
+        auto j = i;
+        while (j != this->size() && !(a.upper() < b[2 * j]))
+        {
+            ++j;
+        }
+        if (i == j)
+        {
+            const T ins[2] = {a.lower(), a.upper()};
+            b.insert(b.begin() + std::ptrdiff_t(2 * i), ins, ins + 2);
+            return;
+        }
+        b[2 * i] = std::min(b[2 * i], a.lower());
+        b[2 * i + 1] = std::max(b[2 * j - 1], a.upper());
+        b.erase(b.begin() + std::ptrdiff_t(2 * i + 2),
+            b.begin() + std::ptrdiff_t(2 * j));
+    }
+
+    /**
+     * @brief union with another set, in linear time
+     *
+     * @param rhs
+     * @return interval_set
+     */
+    [[nodiscard]] auto unite(const interval_set& rhs) const -> interval_set
+    {
+        auto res = interval_set {};
+        res._bounds.reserve(this->_bounds.size() + rhs._bounds.size());
+        auto i = 0U;
+        auto j = 0U;
+        while (i != this->size() || j != rhs.size())
+        {
+            const auto take_lhs = j == rhs.size() ||
+                (i != this->size() &&
+                    !(rhs._bounds[2 * j] < this->_bounds[2 * i]));
+            const auto& src = take_lhs ? this->_bounds : rhs._bounds;
+            auto& k = take_lhs ? i : j;
+            res._append(src[2 * k], src[2 * k + 1]);
+            ++k;
+        }
+        return res;
+    }
+
+    /**
+     * @brief intersection with another set, in linear time
+     *
+     * @param rhs
+     * @return interval_set
+     */
+    [[nodiscard]] auto intersect(const interval_set& rhs) const
+        -> interval_set
+    {
+        auto res = interval_set {};
+        auto i = 0U;
+        auto j = 0U;
+        while (i != this->size() && j != rhs.size())
+        {
+            const auto a = (*this)[i];
+            const auto c = rhs[j];
+            if (a.overlaps(c))
+            {
+                res._bounds.push_back(std::max(a.lower(), c.lower()));
+                res._bounds.push_back(std::min(a.upper(), c.upper()));
+            }
+            if (a.upper() < c.upper())
+            {
+                ++i;
+            }
+            else
+            {
+                ++j;
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief closure of the difference with another set, in linear time
+     *
+     * Removing [3, 5] from [0, 10] leaves [0, 3] and [5, 10]; intervals of
+     * this set that rhs does not touch are kept as they are.
+     *
+     * @param rhs
+     * @return interval_set
+     */
+    [[nodiscard]] auto subtract(const interval_set& rhs) const
+        -> interval_set
+    {
+        auto res = interval_set {};
+        auto j = 0U;
+        for (auto i = 0U; i != this->size(); ++i)
+        {
+            const auto a = (*this)[i];
+            while (j != rhs.size() && rhs._bounds[2 * j + 1] < a.lower())
+            {
+                ++j;
+            }
+            auto cur = a.lower();
+            auto touched = false;
+            for (auto k = j;
+                 k != rhs.size() && !(a.upper() < rhs._bounds[2 * k]); ++k)
+            {
+                touched = true;
+                if (cur < rhs._bounds[2 * k])
+                {
+                    res._append(cur, rhs._bounds[2 * k]);
+                }
+                cur = std::max(cur, rhs._bounds[2 * k + 1]);
+            }
+            if (!touched)
+            {
+                res._append(a.lower(), a.upper());
+            }
+            else if (cur < a.upper())
+            {
+                res._append(cur, a.upper());
+            }
+        }
+        return res;
+    }
+
+    /**
+     * @brief start of the first free gap of length >= len at or after x
+     *
+     * Returns the smallest s >= x such that [s, s + len] overlaps no member
+     * except at its end points. The space after the last member is
+     * unbounded, so a gap always exists. O(log n + gaps skipped).
+     *
+     * @param x
+     * @param len
+     * @return T
+     */
+    [[nodiscard]] auto first_gap(const T& x, const T& len) const -> T
+    {
+        const auto& b = this->_bounds;
+        // first member whose upper bound is > x
+        auto i =
+            std::size_t(std::upper_bound(b.begin(), b.end(), x) - b.begin()) /
+            2;
+        auto s = x;
+        for (; i != this->size(); ++i)
+        {
+            if (b[2 * i] < s)
+            {
+                s = b[2 * i + 1]; // x is inside member i
+                continue;
+            }
+            if (!(b[2 * i] < s + len))
+            {
+                return s;
+            }
+            s = b[2 * i + 1];
+        }
+        return s;
+    }
+
+  private:
+    /**
+     * @brief index of the first member whose upper bound is >= x
+     */
+    [[nodiscard]] auto _find(const T& x) const -> std::size_t
+    {
+        auto lo = std::size_t(0);
+        auto hi = this->size();
+        while (lo != hi)
+        {
+            const auto mid = lo + (hi - lo) / 2;
+            if (this->_bounds[2 * mid + 1] < x)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    /**
+     * @brief append [l, u] with l >= the last lower bound, merging if needed
+     */
+    void _append(const T& l, const T& u)
+    {
+        auto& b = this->_bounds;
+        if (!b.empty() && !(b.back() < l))
+        {
+            b.back() = std::max(b.back(), u);
+            return;
+        }
+        b.push_back(l);
+        b.push_back(u);
+    }
+};
+
+} // namespace recti
@@ -0,0 +1,259 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <gsl/span>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Static KD-tree for Manhattan (L1) nearest-neighbour queries
+ *
+ * The tree is implicit in a flat array: the node covering [lo, hi) stores
+ * its splitting point at mid = lo + (hi - lo) / 2, with the left subtree
+ * in [lo, mid) and the right one in [mid + 1, hi). Each node splits along
+ * the axis of larger spread. Queries track the per-axis offset of the
+ * query point to the current cell, so the pruning bound is the exact L1
+ * distance to the cell.
+ *
+ * Ties are broken by the smaller input index, so results are deterministic
+ * and identical to a brute-force scan. The tree is immutable after
+ * construction, so concurrent queries are safe.
+ *
+ * @tparam T
+ */
+template <typename T>
+class l1_kdtree
+{
+  private:
+    std::vector<point<T>> _pts;        // points in tree order
+    std::vector<std::uint32_t> _ids;   // input index of each tree slot
+    std::vector<std::uint8_t> _axis;   // split axis of each node (0 = x)
+
+    using candidate = std::pair<T, std::uint32_t>; // (distance, id)
+
+  public:
+    /**
+     * @brief Construct a new l1 kdtree object
+     *
+     * @param pts
+     */
+    explicit l1_kdtree(gsl::span<const point<T>> pts)
+        : _axis(pts.size(), 0)
+    {
+        assert(pts.size() <= std::size_t(UINT32_MAX));
+        auto idx = std::vector<std::uint32_t>(pts.size());
+        for (auto i = 0U; i != idx.size(); ++i)
+        {
+            idx[i] = i;
+        }
+        this->_build(pts, idx, 0, idx.size());
+        this->_pts.reserve(pts.size());
+        for (auto i : idx)
+        {
+            this->_pts.push_back(pts[i]);
+        }
+        this->_ids = std::move(idx);
+    }
+
+    /**
+     * @brief number of points
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return this->_pts.size();
+    }
+
+    /**
+     * @brief index of the point nearest to q
+     *
+     * @param q
+     * @return std::size_t
+     */
+    [[nodiscard]] auto nearest(const point<T>& q) const -> std::size_t
+    {
+        assert(!this->_pts.empty());
+        auto best = std::vector<candidate> {};
+        this->_search(q, 1, best);
+        return best.front().second;
+    }
+
+    /**
+     * @brief indices of the k points nearest to q, closest first
+     *
+     * @param q
+     * @param k
+     * @return std::vector<std::size_t> (min(k, size()) entries)
+     */
+    [[nodiscard]] auto knn(const point<T>& q, std::size_t k) const
+        -> std::vector<std::size_t>
+    {
+        auto best = std::vector<candidate> {};
+        this->_search(q, k, best);
+        std::sort_heap(best.begin(), best.end());
+        auto res = std::vector<std::size_t>(best.size());
+        std::transform(best.begin(), best.end(), res.begin(),
+            [](const candidate& c) { return std::size_t(c.second); });
+        return res;
+    }
+
+    /**
+     * @brief nearest point of every query, answered in parallel
+     *
+     * @param queries
+     * @param num_threads (0 = hardware concurrency)
+     * @return std::vector<std::size_t>
+     */
+    [[nodiscard]] auto nearest(gsl::span<const point<T>> queries,
+        unsigned num_threads = 0) const -> std::vector<std::size_t>
+    {
+        auto res = std::vector<std::size_t>(queries.size());
+        parallel_for(
+            queries.size(),
+            [&](std::size_t i) { res[i] = this->nearest(queries[i]); },
+            num_threads);
+        return res;
+    }
+
+    /**
+     * @brief k nearest points of every query, answered in parallel
+     *
+     * @param queries
+     * @param k
+     * @param num_threads (0 = hardware concurrency)
+     * @return std::vector<std::size_t> row-major, min(k, size()) per query
+     */
+    [[nodiscard]] auto knn(gsl::span<const point<T>> queries, std::size_t k,
+        unsigned num_threads = 0) const -> std::vector<std::size_t>
+    {
+        const auto kk = std::min(k, this->size());
+        auto res = std::vector<std::size_t>(queries.size() * kk);
+        parallel_for(
+            queries.size(),
+            [&](std::size_t i)
+            {
+                auto r = this->knn(queries[i], kk);
+                std::copy(r.begin(), r.end(), res.begin() + i * kk);
+            },
+            num_threads);
+        return res;
+    }
+
+  private:
+    void _build(gsl::span<const point<T>> pts, std::vector<std::uint32_t>& idx,
+        std::size_t lo, std::size_t hi)
+    {
+        if (hi - lo <= 1)
+        {
+            return;
+        }
+        auto [xmin, xmax] = std::minmax_element(idx.begin() + lo,
+            idx.begin() + hi,
+            [&](auto a, auto b) { return pts[a].x() < pts[b].x(); });
+        auto [ymin, ymax] = std::minmax_element(idx.begin() + lo,
+            idx.begin() + hi,
+            [&](auto a, auto b) { return pts[a].y() < pts[b].y(); });
+        const auto axis = (pts[*xmax].x() - pts[*xmin].x()) <
+                pts[*ymax].y() - pts[*ymin].y()
+            ? 1
+            : 0;
+        const auto mid = lo + (hi - lo) / 2;
+        if (axis == 0)
+        {
+            std::nth_element(idx.begin() + lo, idx.begin() + mid,
+                idx.begin() + hi,
+                [&](auto a, auto b) { return pts[a].x() < pts[b].x(); });
+        }
+        else
+        {
+            std::nth_element(idx.begin() + lo, idx.begin() + mid,
+                idx.begin() + hi,
+                [&](auto a, auto b) { return pts[a].y() < pts[b].y(); });
+        }
+        this->_axis[mid] = std::uint8_t(axis);
+        this->_build(pts, idx, lo, mid);
+        this->_build(pts, idx, mid + 1, hi);
+    }
+
+    void _search(
+        const point<T>& q, std::size_t k, std::vector<candidate>& best) const
+    {
+        if (k == 0 || this->_pts.empty())
+        {
+            return;
+        }
+        best.reserve(k);
+        T off[2] = {T(0), T(0)};
+        this->_visit(q, k, 0, this->_pts.size(), off, T(0), best);
+    }
+
+    /**
+     * @brief Depth-first search with incremental L1 cell distance
+     *
+     * @param rd L1 distance from q to the cell of [lo, hi)
+     * @param off per-axis components of rd
+     * @param best max-heap of the current k best candidates
+     */
+    void _visit(const point<T>& q, std::size_t k, std::size_t lo,
+        std::size_t hi, T (&off)[2], const T& rd,
+        std::vector<candidate>& best) const
+    {
+        if (lo >= hi)
+        {
+            return;
+        }
+        const auto mid = lo + (hi - lo) / 2;
+        const auto& p = this->_pts[mid];
+        auto c = candidate {manhattan_distance(q, p), this->_ids[mid]};
+        if (best.size() < k)
+        {
+            best.push_back(c);
+            std::push_heap(best.begin(), best.end());
+        }
+        else if (c < best.front())
+        {
+            std::pop_heap(best.begin(), best.end());
+            best.back() = c;
+            std::push_heap(best.begin(), best.end());
+        }
+
+        const auto axis = this->_axis[mid];
+        const auto& qa = axis == 0 ? q.x() : q.y();
+        const auto& pa = axis == 0 ? p.x() : p.y();
+        const auto go_left = !(pa < qa);
+        if (go_left)
+        {
+            this->_visit(q, k, lo, mid, off, rd, best);
+        }
+        else
+        {
+            this->_visit(q, k, mid + 1, hi, off, rd, best);
+        }
+
+        const auto old = off[axis];
+        const auto gap = go_left ? pa - qa : qa - pa;
+        const auto rd_far = rd - old + gap;
+        if (best.size() < k || !(best.front().first < rd_far))
+        {
+            off[axis] = gap;
+            if (go_left)
+            {
+                this->_visit(q, k, mid + 1, hi, off, rd_far, best);
+            }
+            else
+            {
+                this->_visit(q, k, lo, mid, off, rd_far, best);
+            }
+            off[axis] = old;
+        }
+    }
+};
+
+} // namespace recti
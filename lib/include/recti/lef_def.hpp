@@ -0,0 +1,1708 @@
+#pragma once
+
+#include "netlist.hpp"
+#include "parallel.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Outcome of parsing a LEF or DEF file
+ *
+ */
+enum class lef_def_status : std::uint8_t
+{
+    ok,
+    syntax_error,     //!< unexpected token or unterminated block
+    unknown_reference //!< a net names a component or pin that is not there
+};
+
+/**
+ * @brief DEF orientation (N = R0, W = R90, S = R180, E = R270, F = mirrored)
+ *
+ */
+enum class def_orient : std::uint8_t
+{
+    N,
+    W,
+    S,
+    E,
+    FN,
+    FW,
+    FS,
+    FE
+};
+
+/**
+ * @brief Placement status of a DEF component or pin
+ *
+ */
+enum class def_place : std::uint8_t
+{
+    unplaced,
+    placed,
+    fixed,
+    cover
+};
+
+/**
+ * @brief A LEF macro pin: its name and port rectangles
+ *
+ * @tparam T
+ */
+template <typename T>
+struct lef_pin
+{
+    std::string_view name;
+    std::vector<rectangle<T>> shapes;
+};
+
+/**
+ * @brief A LEF macro; geometry is relative to its lower-left corner
+ *
+ * @tparam T
+ */
+template <typename T>
+struct lef_macro
+{
+    std::string_view name;
+    std::string_view cls; //!< CLASS (CORE, BLOCK, PAD, ...)
+    vector2<T> size;
+    std::vector<lef_pin<T>> pins;
+    std::vector<rectangle<T>> obstructions;
+};
+
+/**
+ * @brief The macros of a LEF file, in database units
+ *
+ * Names point into the parsed text, which must outlive the library.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct lef_library
+{
+    double dbu {1000}; //!< database units per micron
+    std::vector<lef_macro<T>> macros;
+    std::unordered_map<std::string_view, std::uint32_t> index;
+
+    /**
+     * @brief look up a macro by name
+     *
+     * @param name
+     * @return const lef_macro<T>* null if there is none
+     */
+    [[nodiscard]] auto find(std::string_view name) const
+        -> const lef_macro<T>*
+    {
+        const auto it = this->index.find(name);
+        return it == this->index.end() ? nullptr : &this->macros[it->second];
+    }
+};
+
+/**
+ * @brief A DEF placement row
+ *
+ * @tparam T
+ */
+template <typename T>
+struct def_row
+{
+    std::string_view name;
+    std::string_view site;
+    point<T> origin;
+    def_orient orient;
+    std::uint32_t num_x; //!< DO num_x BY num_y
+    std::uint32_t num_y;
+    vector2<T> step;
+};
+
+/**
+ * @brief A DEF component (cell instance)
+ *
+ * @tparam T
+ */
+template <typename T>
+struct def_component
+{
+    std::string_view name;
+    std::string_view macro;
+    point<T> position; //!< lower-left corner of the placed footprint
+    def_orient orient;
+    def_place status;
+};
+
+/**
+ * @brief A DEF I/O pin
+ *
+ * @tparam T
+ */
+template <typename T>
+struct def_pin
+{
+    std::string_view name;
+    std::string_view net;
+    point<T> position;
+    def_orient orient;
+    def_place status;
+    std::string_view layer; //!< empty if the pin has no LAYER shape
+    rectangle<T> shape;     //!< absolute, if layer is not empty
+};
+
+/**
+ * @brief A DEF blockage rectangle; layer is empty for placement blockages
+ *
+ * @tparam T
+ */
+template <typename T>
+struct def_blockage
+{
+    std::string_view layer;
+    rectangle<T> shape;
+};
+
+/**
+ * @brief The subset of a DEF design used for placement
+ *
+ * `nets` uses cells 0 .. components.size() - 1 for the components and
+ * the following ids for the I/O pins, in the order of `pins`; see
+ * cell_positions(). Component pin offsets come from the LEF macro pin
+ * (centre of its port shapes) when a library is given, else they are
+ * zero. Names point into the parsed text, which must outlive the design.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct def_design
+{
+    std::string_view name;
+    double dbu {1000}; //!< database units per micron
+    rectangle<T> die_area {
+        interval<T> {T(0), T(0)}, interval<T> {T(0), T(0)}};
+    std::vector<def_row<T>> rows;
+    std::vector<def_component<T>> components;
+    std::vector<def_pin<T>> pins;
+    std::vector<def_blockage<T>> blockages;
+    std::vector<std::string_view> net_names;
+    netlist<T> nets;
+
+    /**
+     * @brief positions of the netlist cells: components, then I/O pins
+     *
+     * @return std::vector<point<T>>
+     */
+    [[nodiscard]] auto cell_positions() const -> std::vector<point<T>>
+    {
+        auto res = std::vector<point<T>> {};
+        res.reserve(this->components.size() + this->pins.size());
+        for (auto&& c : this->components)
+        {
+            res.push_back(c.position);
+        }
+        for (auto&& p : this->pins)
+        {
+            res.push_back(p.position);
+        }
+        return res;
+    }
+};
+
+namespace detail
+{
+
+/**
+ * @brief blanks and control characters separate tokens
+ */
+inline auto is_space(char c) -> bool
+{
+    return static_cast<unsigned char>(c) <= ' ';
+}
+
+/**
+ * @brief the high bit of every byte of w that is a blank, a control
+ * character or ';'
+ *
+ * The SWAR byte test: subtracting 0x21 from every byte borrows into its
+ * high bit iff it is below 0x21, and likewise for ';' once xored to zero.
+ * A borrow can only flag bytes above a true match, so the lowest flagged
+ * byte is exact; bytes >= 0x80 never match.
+ */
+inline auto delimiter_mask(std::uint64_t w) -> std::uint64_t
+{
+    constexpr auto ones = ~std::uint64_t(0) / 255;
+    const auto semi = w ^ (ones * ';');
+    return (((w - ones * 0x21) & ~w) | ((semi - ones) & ~semi)) &
+        (ones * 0x80);
+}
+
+inline auto little_endian() -> bool
+{
+    const auto one = std::uint32_t(1);
+    auto b = std::uint8_t(0);
+    std::memcpy(&b, &one, 1);
+    return b == 1;
+}
+
+/**
+ * @brief the first blank, control character or ';' at or after s[i]
+ *
+ * Eight bytes at a time: on a little-endian host the first flagged byte
+ * of a word is at the lowest set bit of its mask, found with a de Bruijn
+ * style multiply rather than a loop.
+ */
+inline auto token_end(std::string_view s, std::size_t i) -> std::size_t
+{
+    const auto n = s.size();
+    if (little_endian())
+    {
+        for (auto w = std::uint64_t(0); i + 8 <= n; i += 8)
+        {
+            std::memcpy(&w, s.data() + i, 8);
+            if (const auto m = delimiter_mask(w); m != 0)
+            {
+                // the lowest flag is bit 8k + 7; k is then the top byte
+                constexpr auto index = std::uint64_t(0x0001020304050607);
+                return i + std::size_t(((m & -m) >> 7) * index >> 56);
+            }
+        }
+    }
+    while (i != n && !is_space(s[i]) && s[i] != ';')
+    {
+        ++i;
+    }
+    return i;
+}
+
+/**
+ * @brief hint that *p is about to be read
+ */
+inline void prefetch(const void* p)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#else
+    static_cast<void>(p);
+#endif
+}
+
+/**
+ * @brief Read-only name -> id table over views into the parsed text
+ *
+ * Open addressing with linear probing at load factor <= 1/2. It is only
+ * read after being filled, so lookups from several threads are safe.
+ */
+class name_table
+{
+  private:
+    struct slot
+    {
+        std::string_view key;
+        std::uint32_t id;  // id + 1, 0 = empty
+        std::uint32_t tag; // high hash bits: most misses skip the key
+    };
+    std::vector<slot> _slots;
+    std::size_t _mask;
+
+  public:
+    /**
+     * @brief the hash of a name, eight bytes per multiply
+     */
+    static auto hash(std::string_view s) -> std::uint64_t
+    {
+        constexpr auto mul = std::uint64_t(0x9E3779B97F4A7C15ULL);
+        auto h = std::uint64_t(s.size()) * mul;
+        auto i = std::size_t(0);
+        for (auto w = std::uint64_t(0); i + 8 <= s.size(); i += 8)
+        {
+            std::memcpy(&w, s.data() + i, 8);
+            h = (h ^ w) * mul;
+            h ^= h >> 32;
+        }
+        auto w = std::uint64_t(0);
+        for (auto k = 0U; i != s.size(); ++i, k += 8)
+        {
+            w |= std::uint64_t(static_cast<unsigned char>(s[i])) << k;
+        }
+        h = (h ^ w) * mul;
+        return h ^ (h >> 29);
+    }
+
+    /**
+     * @brief Construct a table for up to `capacity` names
+     *
+     * @param capacity
+     */
+    explicit name_table(std::size_t capacity)
+    {
+        auto size = std::size_t(16);
+        while (size < 2 * capacity)
+        {
+            size *= 2;
+        }
+        this->_slots.resize(size, slot {{}, 0, 0});
+        this->_mask = size - 1;
+    }
+
+    /**
+     * @brief add a name; the first id of a repeated name is kept
+     */
+    void insert(std::string_view name, std::uint32_t id)
+    {
+        const auto h = hash(name);
+        const auto tag = std::uint32_t(h >> 32);
+        auto k = std::size_t(h) & this->_mask;
+        for (; this->_slots[k].id != 0; k = (k + 1) & this->_mask)
+        {
+            if (this->_slots[k].tag == tag && this->_slots[k].key == name)
+            {
+                return;
+            }
+        }
+        this->_slots[k] = slot {name, id + 1, tag};
+    }
+
+    /**
+     * @brief start fetching the slot where a lookup of hash h begins
+     */
+    void prefetch(std::uint64_t h) const
+    {
+        detail::prefetch(&this->_slots[std::size_t(h) & this->_mask]);
+    }
+
+    /**
+     * @brief once the slot is cached, start fetching the name it holds
+     *
+     * @return the id find() is likely to return, or UINT32_MAX
+     */
+    auto prefetch_name(std::uint64_t h) const -> std::uint32_t
+    {
+        const auto tag = std::uint32_t(h >> 32);
+        const auto& e = this->_slots[std::size_t(h) & this->_mask];
+        if (e.id == 0 || e.tag != tag)
+        {
+            return UINT32_MAX;
+        }
+        detail::prefetch(e.key.data());
+        return e.id - 1;
+    }
+
+    /**
+     * @brief the id of a name, or UINT32_MAX
+     */
+    [[nodiscard]] auto find(std::string_view name) const -> std::uint32_t
+    {
+        return this->find(name, hash(name));
+    }
+
+    /**
+     * @brief the id of a name whose hash() is h, or UINT32_MAX
+     */
+    [[nodiscard]] auto find(std::string_view name, std::uint64_t h) const
+        -> std::uint32_t
+    {
+        const auto tag = std::uint32_t(h >> 32);
+        auto k = std::size_t(h) & this->_mask;
+        for (; this->_slots[k].id != 0; k = (k + 1) & this->_mask)
+        {
+            if (this->_slots[k].tag == tag && this->_slots[k].key == name)
+            {
+                return this->_slots[k].id - 1;
+            }
+        }
+        return UINT32_MAX;
+    }
+};
+
+/**
+ * @brief Zero-copy LEF/DEF tokenizer
+ *
+ * Tokens are whitespace separated; ';' is always a token of its own,
+ * quoted strings are one token and '#' starts a comment at a token
+ * boundary. Tokens are views into the text.
+ */
+class lef_def_tokens
+{
+  private:
+    std::string_view _s;
+    std::size_t _pos {0};
+
+  public:
+    explicit lef_def_tokens(std::string_view s)
+        : _s {s}
+    {
+    }
+
+    [[nodiscard]] auto pos() const noexcept -> std::size_t
+    {
+        return this->_pos;
+    }
+
+    void seek(std::size_t pos)
+    {
+        this->_pos = pos;
+    }
+
+    /**
+     * @brief the next token, empty at the end of the text
+     */
+    auto next() -> std::string_view
+    {
+        const auto& s = this->_s;
+        const auto n = s.size();
+        auto i = this->_pos;
+        while (i != n && (is_space(s[i]) || s[i] == '#'))
+        {
+            if (s[i] == '#')
+            {
+                while (i != n && s[i] != '\n')
+                {
+                    ++i;
+                }
+                continue;
+            }
+            ++i;
+        }
+        const auto first = i;
+        if (i != n && s[i] == ';')
+        {
+            ++i;
+        }
+        else if (i != n && s[i] == '"')
+        {
+            const auto q = s.find('"', i + 1);
+            i = q == std::string_view::npos ? n : q + 1;
+        }
+        else if (i + 1 < n && (is_space(s[i + 1]) || s[i + 1] == ';'))
+        {
+            ++i; // "-", "+", "(", ")", "N", ...: most DEF tokens
+        }
+        else
+        {
+            i = token_end(s, i);
+        }
+        this->_pos = i;
+        return s.substr(first, i - first);
+    }
+
+    /**
+     * @brief skip up to and including the next ';'
+     *
+     * @return false at the end of the text
+     */
+    auto skip_statement() -> bool
+    {
+        for (auto t = this->next(); !t.empty(); t = this->next())
+        {
+            if (t == ";")
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief skip up to and including the tokens "END name"
+     *
+     * @return false at the end of the text
+     */
+    auto skip_block(std::string_view name) -> bool
+    {
+        for (auto t = this->next(); !t.empty(); t = this->next())
+        {
+            if (t == "END" && this->next() == name)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+/**
+ * @brief parse a decimal number (sign, digits, fraction, exponent)
+ *
+ * The first 19 significant digits are kept exactly, which is more than a
+ * double holds; further digits are dropped (truncating, not rounding)
+ * and only scale the integer part.
+ */
+inline auto parse_real(std::string_view s, double& v) -> bool
+{
+    auto i = std::size_t(0);
+    const auto n = s.size();
+    const auto neg = n != 0 && s[0] == '-';
+    if (n != 0 && (s[0] == '-' || s[0] == '+'))
+    {
+        ++i;
+    }
+    auto mant = std::uint64_t(0);
+    auto scale = 0;
+    auto digits = 0;
+    auto take = [&](char c, bool fraction)
+    {
+        ++digits;
+        if (mant < 1000000000000000000ULL)
+        {
+            mant = mant * 10 + std::uint64_t(c - '0');
+            scale -= fraction ? 1 : 0;
+        }
+        else
+        {
+            scale += fraction ? 0 : 1;
+        }
+    };
+    for (; i != n && '0' <= s[i] && s[i] <= '9'; ++i)
+    {
+        take(s[i], false);
+    }
+    if (i != n && s[i] == '.')
+    {
+        for (++i; i != n && '0' <= s[i] && s[i] <= '9'; ++i)
+        {
+            take(s[i], true);
+        }
+    }
+    if (digits == 0)
+    {
+        return false;
+    }
+    if (i != n && (s[i] == 'e' || s[i] == 'E'))
+    {
+        auto e = 0.0;
+        if (!parse_real(s.substr(i + 1), e))
+        {
+            return false;
+        }
+        scale += int(e);
+        i = n;
+    }
+    if (i != n)
+    {
+        return false;
+    }
+    // powers of ten up to 1e22 are exact: divide rather than multiply by
+    // an inexact negative power
+    v = scale == 0 ? double(mant)
+        : scale < 0    ? double(mant) / std::pow(10.0, -scale)
+                       : double(mant) * std::pow(10.0, scale);
+    v = neg ? -v : v;
+    return true;
+}
+
+template <typename T>
+inline auto to_coord(double v) -> T
+{
+    if constexpr (std::is_integral<T>::value)
+    {
+        return T(std::llround(v));
+    }
+    else
+    {
+        return T(v);
+    }
+}
+
+/**
+ * @brief parse a plain decimal integer ([+-]digits) that fits in T
+ *
+ * @return false for anything else, which parse_real() may still accept
+ */
+template <typename T>
+inline auto parse_integer(std::string_view s, T& v) -> bool
+{
+    const auto n = s.size();
+    const auto neg = n != 0 && s[0] == '-';
+    auto i = std::size_t(n != 0 && (neg || s[0] == '+') ? 1 : 0);
+    if (i == n || n - i > 18)
+    {
+        return false;
+    }
+    auto m = std::int64_t(0);
+    for (; i != n; ++i)
+    {
+        const auto d = unsigned(static_cast<unsigned char>(s[i])) - '0';
+        if (9 < d)
+        {
+            return false;
+        }
+        m = m * 10 + std::int64_t(d);
+    }
+    m = neg ? -m : m;
+    using limits = std::numeric_limits<T>;
+    if (sizeof(T) < sizeof(m) &&
+        (m < std::int64_t(limits::lowest()) || std::int64_t(limits::max()) < m))
+    {
+        return false;
+    }
+    v = T(m);
+    return true;
+}
+
+/**
+ * @brief read a number scaled by `scale` into a coordinate
+ *
+ * Unscaled integers, which is what DEF coordinates are, are converted
+ * directly for an integral T rather than through a double.
+ */
+template <typename T>
+inline auto read_coord(lef_def_tokens& tok, double scale, T& out) -> bool
+{
+    const auto t = tok.next();
+    if constexpr (std::is_integral<T>::value)
+    {
+        if (scale == 1.0 && parse_integer(t, out))
+        {
+            return true;
+        }
+    }
+    auto v = 0.0;
+    if (!parse_real(t, v))
+    {
+        return false;
+    }
+    out = to_coord<T>(v * scale);
+    return true;
+}
+
+/**
+ * @brief read "( x y )"
+ */
+template <typename T>
+inline auto read_def_point(lef_def_tokens& tok, T& x, T& y) -> bool
+{
+    return tok.next() == "(" && read_coord(tok, 1.0, x) &&
+        read_coord(tok, 1.0, y) && tok.next() == ")";
+}
+
+inline auto parse_orient(std::string_view s, def_orient& o) -> bool
+{
+    const auto flip = s.size() == 2 && s[0] == 'F';
+    if (s.size() != 1 && !flip)
+    {
+        return false;
+    }
+    const auto k = std::string_view {"NWSE"}.find(s.back());
+    if (k == std::string_view::npos)
+    {
+        return false;
+    }
+    o = def_orient(k + (flip ? 4 : 0));
+    return true;
+}
+
+/**
+ * @brief the placement status named by a `+ KEY` option, if it is one
+ *
+ * Dispatches on the first character: most options of a component or a
+ * pin are not placement statuses.
+ */
+inline auto parse_place(std::string_view s, def_place& p) -> bool
+{
+    auto k = def_place::unplaced;
+    switch (s.empty() ? '\0' : s[0])
+    {
+    case 'P':
+        k = s == "PLACED" ? def_place::placed : k;
+        break;
+    case 'F':
+        k = s == "FIXED" ? def_place::fixed : k;
+        break;
+    case 'C':
+        k = s == "COVER" ? def_place::cover : k;
+        break;
+    default:
+        break;
+    }
+    if (k == def_place::unplaced)
+    {
+        return false;
+    }
+    p = k;
+    return true;
+}
+
+/**
+ * @brief Map a point of a w x h cell into its placed footprint
+ *
+ * The result is relative to the lower-left corner of the oriented
+ * footprint; with w = h = 0 it is the plain rotation about the origin.
+ */
+template <typename T>
+inline auto orient_vector(def_orient o, const T& x, const T& y, const T& w,
+    const T& h) -> vector2<T>
+{
+    switch (o)
+    {
+    case def_orient::W:
+        return {h - y, x};
+    case def_orient::S:
+        return {w - x, h - y};
+    case def_orient::E:
+        return {y, w - x};
+    case def_orient::FN:
+        return {w - x, y};
+    case def_orient::FW:
+        return {y, x};
+    case def_orient::FS:
+        return {x, h - y};
+    case def_orient::FE:
+        return {h - y, w - x};
+    default:
+        return {x, y};
+    }
+}
+
+/**
+ * @brief find "END kw" at token boundaries, starting at pos
+ *
+ * Quoted strings and '#' comments that open at a token boundary are
+ * stepped over as the tokenizer would, so an "END kw" inside them does
+ * not end the section. Only the markers are searched for (find(), i.e.
+ * memchr), so the scan stays one fast pass over ordinary sections.
+ */
+inline auto find_end(std::string_view s, std::size_t pos, std::string_view kw)
+    -> std::size_t
+{
+    constexpr auto npos = std::string_view::npos;
+    auto boundary = [&](std::size_t i)
+    { return i == 0 || is_space(s[i - 1]) || s[i - 1] == ';'; };
+    auto quote = s.find('"', pos);
+    auto hash = s.find('#', pos);
+    auto i = s.find("END", pos);
+    while (i != npos)
+    {
+        const auto q = std::min(quote, hash);
+        if (q < i)
+        {
+            auto resume = q + 1;
+            if (boundary(q))
+            {
+                const auto close = s.find(s[q] == '"' ? '"' : '\n', q + 1);
+                if (close == npos)
+                {
+                    return npos;
+                }
+                resume = close + 1;
+            }
+            quote = quote < resume ? s.find('"', resume) : quote;
+            hash = hash < resume ? s.find('#', resume) : hash;
+            i = i < resume ? s.find("END", resume) : i;
+            continue;
+        }
+        auto j = i + 3;
+        if (boundary(i) && j != s.size() && is_space(s[j]))
+        {
+            while (j != s.size() && is_space(s[j]))
+            {
+                ++j;
+            }
+            const auto k = j + kw.size();
+            if (s.substr(j, kw.size()) == kw &&
+                (k == s.size() || is_space(s[k])))
+            {
+                return i;
+            }
+        }
+        i = s.find("END", i + 1);
+    }
+    return npos;
+}
+
+/**
+ * @brief Split a section body into up to `parts` runs of whole statements
+ *
+ * A statement starts with a "-" token right after a ';'.
+ */
+inline auto split_statements(std::string_view body, std::size_t parts)
+    -> std::vector<std::string_view>
+{
+    auto cuts = std::vector<std::size_t> {0};
+    for (auto k = 1U; k < parts; ++k)
+    {
+        auto i = std::max(cuts.back(), body.size() * k / parts);
+        for (i = body.find(';', i); i != std::string_view::npos;
+             i = body.find(';', i + 1))
+        {
+            auto j = i + 1;
+            while (j != body.size() && is_space(body[j]))
+            {
+                ++j;
+            }
+            if (j + 1 < body.size() && body[j] == '-' && is_space(body[j + 1]))
+            {
+                break;
+            }
+        }
+        if (i == std::string_view::npos)
+        {
+            break;
+        }
+        cuts.push_back(i + 1);
+    }
+    cuts.push_back(body.size());
+    auto res = std::vector<std::string_view> {};
+    for (auto k = 0U; k + 1 < cuts.size(); ++k)
+    {
+        res.push_back(body.substr(cuts[k], cuts[k + 1] - cuts[k]));
+    }
+    return res;
+}
+
+/**
+ * @brief read "[MASK n] x1 y1 x2 y2 ;" in microns
+ */
+template <typename T>
+inline auto read_lef_rect(
+    lef_def_tokens& tok, double dbu, std::vector<rectangle<T>>& out) -> bool
+{
+    auto c = std::array<double, 4> {};
+    auto t = tok.next();
+    if (t == "MASK")
+    {
+        tok.next();
+        t = tok.next();
+    }
+    for (auto k = 0U; k != 4; ++k, t = tok.next())
+    {
+        if (!parse_real(t, c[k]))
+        {
+            return false;
+        }
+    }
+    if (t != ";")
+    {
+        return false;
+    }
+    out.emplace_back(interval<T> {to_coord<T>(std::min(c[0], c[2]) * dbu),
+                         to_coord<T>(std::max(c[0], c[2]) * dbu)},
+        interval<T> {to_coord<T>(std::min(c[1], c[3]) * dbu),
+            to_coord<T>(std::max(c[1], c[3]) * dbu)});
+    return true;
+}
+
+/**
+ * @brief parse a MACRO block after its name
+ */
+template <typename T>
+inline auto parse_lef_macro(lef_def_tokens& tok, double dbu,
+    std::string_view name, lef_macro<T>& m) -> bool
+{
+    m.name = name;
+    auto origin = vector2<T> {T(0), T(0)};
+    // geometry is collected first and shifted by ORIGIN at the end
+    for (auto t = tok.next(); !t.empty(); t = tok.next())
+    {
+        if (t == "END")
+        {
+            if (tok.next() != name)
+            {
+                return false;
+            }
+            const auto shift = [&](rectangle<T>& r)
+            {
+                r = rectangle<T> {
+                    interval<T> {r.x().lower() + origin.x(),
+                        r.x().upper() + origin.x()},
+                    interval<T> {r.y().lower() + origin.y(),
+                        r.y().upper() + origin.y()}};
+            };
+            for (auto&& p : m.pins)
+            {
+                std::for_each(p.shapes.begin(), p.shapes.end(), shift);
+            }
+            std::for_each(m.obstructions.begin(), m.obstructions.end(), shift);
+            return true;
+        }
+        if (t == "CLASS")
+        {
+            m.cls = tok.next();
+            if (!tok.skip_statement())
+            {
+                return false;
+            }
+        }
+        else if (t == "ORIGIN" || t == "SIZE")
+        {
+            auto a = T(0);
+            auto b = T(0);
+            if (!read_coord(tok, dbu, a) ||
+                (t == "SIZE" && tok.next() != "BY") ||
+                !read_coord(tok, dbu, b) || tok.next() != ";")
+            {
+                return false;
+            }
+            (t == "SIZE" ? m.size : origin) = vector2<T> {a, b};
+        }
+        else if (t == "PIN")
+        {
+            auto& pin = m.pins.emplace_back(lef_pin<T> {tok.next(), {}});
+            for (auto u = tok.next();; u = tok.next())
+            {
+                if (u.empty())
+                {
+                    return false;
+                }
+                if (u == "END")
+                {
+                    if (tok.next() != pin.name)
+                    {
+                        return false;
+                    }
+                    break;
+                }
+                if (u != "PORT")
+                {
+                    tok.skip_statement();
+                    continue;
+                }
+                for (auto v = tok.next(); v != "END"; v = tok.next())
+                {
+                    const auto ok = v == "RECT"
+                        ? read_lef_rect(tok, dbu, pin.shapes)
+                        : tok.skip_statement();
+                    if (!ok)
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+        else if (t == "OBS")
+        {
+            for (auto v = tok.next(); v != "END"; v = tok.next())
+            {
+                const auto ok = v == "RECT"
+                    ? read_lef_rect(tok, dbu, m.obstructions)
+                    : tok.skip_statement();
+                if (!ok)
+                {
+                    return false;
+                }
+            }
+        }
+        else if (!tok.skip_statement())
+        {
+            return false;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief centre of a macro pin's port shapes (zero if it has none)
+ */
+template <typename T>
+inline auto pin_center(const lef_pin<T>& p) -> vector2<T>
+{
+    if (p.shapes.empty())
+    {
+        return {T(0), T(0)};
+    }
+    auto xl = p.shapes[0].x().lower();
+    auto xu = p.shapes[0].x().upper();
+    auto yl = p.shapes[0].y().lower();
+    auto yu = p.shapes[0].y().upper();
+    for (auto&& r : p.shapes)
+    {
+        xl = std::min(xl, r.x().lower());
+        xu = std::max(xu, r.x().upper());
+        yl = std::min(yl, r.y().lower());
+        yu = std::max(yu, r.y().upper());
+    }
+    return {(xl + xu) / 2, (yl + yu) / 2};
+}
+
+/**
+ * @brief parse a run of COMPONENTS statements
+ */
+template <typename T>
+inline auto parse_def_components(
+    std::string_view text, std::vector<def_component<T>>& out) -> bool
+{
+    auto tok = lef_def_tokens {text};
+    for (auto t = tok.next(); !t.empty(); t = tok.next())
+    {
+        if (t != "-")
+        {
+            return false;
+        }
+        auto c = def_component<T> {tok.next(), tok.next(),
+            point<T> {T(0), T(0)}, def_orient::N, def_place::unplaced};
+        for (auto u = tok.next(); u != ";"; u = tok.next())
+        {
+            if (u.empty())
+            {
+                return false;
+            }
+            if (u != "+")
+            {
+                continue; // arguments of options we do not keep
+            }
+            auto status = def_place::unplaced;
+            if (parse_place(tok.next(), status))
+            {
+                auto x = T(0);
+                auto y = T(0);
+                if (!read_def_point(tok, x, y) ||
+                    !parse_orient(tok.next(), c.orient))
+                {
+                    return false;
+                }
+                c.position = point<T> {x, y};
+                c.status = status;
+            }
+        }
+        out.push_back(c);
+    }
+    return true;
+}
+
+/**
+ * @brief parse a run of PINS statements
+ */
+template <typename T>
+inline auto parse_def_pins(std::string_view text, std::vector<def_pin<T>>& out)
+    -> bool
+{
+    auto tok = lef_def_tokens {text};
+    for (auto t = tok.next(); !t.empty(); t = tok.next())
+    {
+        if (t != "-")
+        {
+            return false;
+        }
+        const auto zero = rectangle<T> {
+            interval<T> {T(0), T(0)}, interval<T> {T(0), T(0)}};
+        auto p = def_pin<T> {tok.next(), {}, point<T> {T(0), T(0)},
+            def_orient::N, def_place::unplaced, {}, zero};
+        auto rect = std::array<T, 4> {};
+        auto placed = false;
+        for (auto u = tok.next(); u != ";"; u = tok.next())
+        {
+            if (u.empty())
+            {
+                return false;
+            }
+            if (u != "+")
+            {
+                continue;
+            }
+            const auto key = tok.next();
+            if (key == "NET")
+            {
+                p.net = tok.next();
+            }
+            else if (key == "LAYER" && p.layer.empty())
+            {
+                p.layer = tok.next();
+                auto v = tok.next();
+                while (!v.empty() && v != "(") // MASK, SPACING, ...
+                {
+                    v = tok.next();
+                }
+                if (!read_coord(tok, 1.0, rect[0]) ||
+                    !read_coord(tok, 1.0, rect[1]) || tok.next() != ")" ||
+                    !read_def_point(tok, rect[2], rect[3]))
+                {
+                    return false;
+                }
+            }
+            else if (!placed && parse_place(key, p.status))
+            {
+                auto x = T(0);
+                auto y = T(0);
+                if (!read_def_point(tok, x, y) ||
+                    !parse_orient(tok.next(), p.orient))
+                {
+                    return false;
+                }
+                p.position = point<T> {x, y};
+                placed = true;
+            }
+        }
+        if (!p.layer.empty())
+        {
+            // the LAYER shape is relative to the pin and rotates with it
+            const auto a = orient_vector(
+                p.orient, rect[0], rect[1], T(0), T(0));
+            const auto b = orient_vector(
+                p.orient, rect[2], rect[3], T(0), T(0));
+            const auto& o = p.position;
+            p.shape = rectangle<T> {
+                interval<T> {o.x() + std::min(a.x(), b.x()),
+                    o.x() + std::max(a.x(), b.x())},
+                interval<T> {o.y() + std::min(a.y(), b.y()),
+                    o.y() + std::max(a.y(), b.y())}};
+        }
+        out.push_back(p);
+    }
+    return true;
+}
+
+/**
+ * @brief parse a run of BLOCKAGES statements (RECT shapes only)
+ */
+template <typename T>
+inline auto parse_def_blockages(
+    std::string_view text, std::vector<def_blockage<T>>& out) -> bool
+{
+    auto tok = lef_def_tokens {text};
+    for (auto t = tok.next(); !t.empty(); t = tok.next())
+    {
+        if (t != "-")
+        {
+            return false;
+        }
+        const auto kind = tok.next();
+        const auto layer =
+            kind == "LAYER" ? tok.next() : std::string_view {};
+        for (auto u = tok.next(); u != ";"; u = tok.next())
+        {
+            if (u.empty())
+            {
+                return false;
+            }
+            if (u != "RECT")
+            {
+                continue;
+            }
+            auto c = std::array<T, 4> {};
+            if (!read_def_point(tok, c[0], c[1]) ||
+                !read_def_point(tok, c[2], c[3]))
+            {
+                return false;
+            }
+            out.push_back(def_blockage<T> {layer,
+                rectangle<T> {interval<T> {std::min(c[0], c[2]),
+                                  std::max(c[0], c[2])},
+                    interval<T> {
+                        std::min(c[1], c[3]), std::max(c[1], c[3])}}});
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief append the results of parallel runs, in run order
+ */
+template <typename U>
+inline void append_runs(std::vector<U>& out, std::vector<std::vector<U>>& runs)
+{
+    if (out.empty() && runs.size() == 1)
+    {
+        out = std::move(runs[0]);
+        return;
+    }
+    auto n = out.size();
+    for (auto&& r : runs)
+    {
+        n += r.size();
+    }
+    out.reserve(n);
+    for (auto&& r : runs)
+    {
+        out.insert(out.end(), r.begin(), r.end());
+    }
+}
+
+/**
+ * @brief nets of one run of NETS statements, resolved to cells
+ */
+template <typename T>
+struct def_net_part
+{
+    std::vector<std::string_view> names;
+    netlist<T> nets;
+    lef_def_status status {lef_def_status::ok};
+};
+
+} // namespace detail
+
+/**
+ * @brief Parse the macros of a LEF file
+ *
+ * Keeps MACRO names, CLASS, SIZE, pin PORT rectangles and OBS
+ * rectangles, shifted by ORIGIN so that they are relative to the macro's
+ * lower-left corner. Technology blocks (LAYER, SITE, VIA, ...) are
+ * skipped. Coordinates are converted to database units with `dbu` per
+ * micron, or with the file's DATABASE MICRONS (default 1000) if dbu is 0.
+ *
+ * @tparam T
+ * @param text the whole file (e.g. a mapped_file); must outlive `lib`
+ * @param lib output
+ * @param dbu database units per micron, 0 to use the file's
+ * @return lef_def_status
+ */
+template <typename T>
+inline auto parse_lef(std::string_view text, lef_library<T>& lib,
+    double dbu = 0) -> lef_def_status
+{
+    lib = lef_library<T> {};
+    lib.dbu = dbu != 0 ? dbu : 1000;
+    auto tok = detail::lef_def_tokens {text};
+    for (auto t = tok.next(); !t.empty(); t = tok.next())
+    {
+        auto ok = true;
+        if (t == "MACRO")
+        {
+            const auto name = tok.next();
+            auto m = lef_macro<T> {{}, {}, vector2<T> {T(0), T(0)}, {}, {}};
+            ok = detail::parse_lef_macro(tok, lib.dbu, name, m);
+            lib.index.emplace(name, std::uint32_t(lib.macros.size()));
+            lib.macros.push_back(std::move(m));
+        }
+        else if (t == "UNITS")
+        {
+            for (auto u = tok.next(); ok && u != "END"; u = tok.next())
+            {
+                auto v = 0.0;
+                if (u == "DATABASE" && tok.next() == "MICRONS" &&
+                    detail::parse_real(tok.next(), v) && dbu == 0)
+                {
+                    lib.dbu = v;
+                }
+                ok = !u.empty() && tok.skip_statement();
+            }
+            ok = ok && tok.next() == "UNITS";
+        }
+        else if (t == "END")
+        {
+            if (tok.next() == "LIBRARY")
+            {
+                break;
+            }
+        }
+        else if (t == "LAYER" || t == "SITE" || t == "VIA" ||
+            t == "VIARULE" || t == "NONDEFAULTRULE" || t == "ARRAY")
+        {
+            ok = tok.skip_block(tok.next());
+        }
+        else if (t == "PROPERTYDEFINITIONS" || t == "SPACING" ||
+            t == "BEGINEXT")
+        {
+            ok = tok.skip_block(t == "BEGINEXT" ? "ENDEXT" : t);
+        }
+        else
+        {
+            ok = tok.skip_statement();
+        }
+        if (!ok)
+        {
+            return lef_def_status::syntax_error;
+        }
+    }
+    return lef_def_status::ok;
+}
+
+/**
+ * @brief Parse the placement subset of a DEF file
+ *
+ * Reads DESIGN, UNITS, DIEAREA (bounding box), ROW, and the COMPONENTS,
+ * PINS, BLOCKAGES (RECT shapes) and NETS sections; everything else is
+ * skipped. The top level is tokenized once while section bodies are
+ * located by their END lines, then split at statement boundaries and
+ * parsed in parallel: first components, pins and blockages, then the
+ * nets, which need the component names. The result does not depend on
+ * `num_threads`.
+ *
+ * @tparam T
+ * @param text the whole file (e.g. a mapped_file); must outlive `design`
+ * @param design output
+ * @param lef macros for pin offsets (may be null)
+ * @param num_threads (0 = hardware concurrency)
+ * @return lef_def_status
+ */
+template <typename T>
+inline auto parse_def(std::string_view text, def_design<T>& design,
+    const lef_library<T>* lef = nullptr, unsigned num_threads = 0)
+    -> lef_def_status
+{
+    constexpr auto syntax_error = lef_def_status::syntax_error;
+    design = def_design<T> {};
+    auto sections = std::array<std::string_view, 4> {}; // C, P, B, N
+    static constexpr std::string_view kept[] = {
+        "COMPONENTS", "PINS", "BLOCKAGES", "NETS"};
+    auto tok = detail::lef_def_tokens {text};
+    for (auto t = tok.next(); !t.empty(); t = tok.next())
+    {
+        auto ok = true;
+        if (t == "DESIGN")
+        {
+            design.name = tok.next();
+            ok = tok.skip_statement();
+        }
+        else if (t == "UNITS")
+        {
+            ok = tok.next() == "DISTANCE" && tok.next() == "MICRONS" &&
+                detail::parse_real(tok.next(), design.dbu) &&
+                tok.next() == ";";
+        }
+        else if (t == "DIEAREA")
+        {
+            auto x = T(0);
+            auto y = T(0);
+            ok = detail::read_def_point(tok, x, y);
+            auto lo = point<T> {x, y};
+            auto hi = lo;
+            for (auto u = tok.next(); ok && u != ";"; u = tok.next())
+            {
+                tok.seek(tok.pos() - u.size());
+                ok = detail::read_def_point(tok, x, y);
+                lo = point<T> {std::min(lo.x(), x), std::min(lo.y(), y)};
+                hi = point<T> {std::max(hi.x(), x), std::max(hi.y(), y)};
+            }
+            design.die_area = rectangle<T> {interval<T> {lo.x(), hi.x()},
+                interval<T> {lo.y(), hi.y()}};
+        }
+        else if (t == "ROW")
+        {
+            auto r = def_row<T> {tok.next(), tok.next(),
+                point<T> {T(0), T(0)}, def_orient::N, 1, 1,
+                vector2<T> {T(0), T(0)}};
+            auto c = std::array<T, 4> {};
+            auto n = std::array<double, 2> {1, 1};
+            ok = detail::read_coord(tok, 1.0, c[0]) &&
+                detail::read_coord(tok, 1.0, c[1]) &&
+                detail::parse_orient(tok.next(), r.orient);
+            auto u = tok.next();
+            if (ok && u == "DO")
+            {
+                ok = detail::parse_real(tok.next(), n[0]) &&
+                    tok.next() == "BY" &&
+                    detail::parse_real(tok.next(), n[1]);
+                u = tok.next();
+                if (ok && u == "STEP")
+                {
+                    ok = detail::read_coord(tok, 1.0, c[2]) &&
+                        detail::read_coord(tok, 1.0, c[3]);
+                    u = tok.next();
+                }
+            }
+            r.origin = point<T> {c[0], c[1]};
+            r.num_x = std::uint32_t(n[0]);
+            r.num_y = std::uint32_t(n[1]);
+            r.step = vector2<T> {c[2], c[3]};
+            design.rows.push_back(r);
+            ok = ok && (u == ";" || tok.skip_statement());
+        }
+        else if (t == "END")
+        {
+            if (tok.next() == "DESIGN")
+            {
+                break;
+            }
+        }
+        else if (t == "COMPONENTS" || t == "PINS" || t == "NETS" ||
+            t == "BLOCKAGES" || t == "SPECIALNETS" || t == "VIAS" ||
+            t == "REGIONS" || t == "GROUPS" || t == "FILLS" ||
+            t == "NONDEFAULTRULES" || t == "PROPERTYDEFINITIONS" ||
+            t == "SCANCHAINS" || t == "STYLES" || t == "SLOTS" ||
+            t == "PINPROPERTIES")
+        {
+            ok = tok.skip_statement();
+            const auto first = tok.pos();
+            const auto end = detail::find_end(text, first, t);
+            if (!ok || end == std::string_view::npos)
+            {
+                return syntax_error;
+            }
+            for (auto k = 0U; k != 4; ++k)
+            {
+                if (t == kept[k])
+                {
+                    sections[k] = text.substr(first, end - first);
+                }
+            }
+            tok.seek(end);
+            tok.next(); // END
+            tok.next(); // the section name
+        }
+        else
+        {
+            ok = tok.skip_statement();
+        }
+        if (!ok)
+        {
+            return syntax_error;
+        }
+    }
+
+    // components, pins and blockages
+    const auto parts = std::size_t(num_workers(num_threads));
+    auto comp_runs = detail::split_statements(sections[0], parts);
+    auto pin_runs = detail::split_statements(sections[1], parts);
+    auto blk_runs = detail::split_statements(sections[2], parts);
+    const auto nc = comp_runs.size();
+    const auto np = pin_runs.size();
+    auto comps = std::vector<std::vector<def_component<T>>>(nc);
+    auto pins = std::vector<std::vector<def_pin<T>>>(np);
+    auto blks = std::vector<std::vector<def_blockage<T>>>(blk_runs.size());
+    auto oks = std::vector<char>(nc + np + blk_runs.size());
+    parallel_for(
+        oks.size(),
+        [&](std::size_t k)
+        {
+            oks[k] = k < nc ? detail::parse_def_components(
+                                  comp_runs[k], comps[k])
+                : k < nc + np
+                ? detail::parse_def_pins(pin_runs[k - nc], pins[k - nc])
+                : detail::parse_def_blockages(
+                      blk_runs[k - nc - np], blks[k - nc - np]);
+        },
+        num_threads);
+    if (std::find(oks.begin(), oks.end(), 0) != oks.end())
+    {
+        return syntax_error;
+    }
+    detail::append_runs(design.components, comps);
+    detail::append_runs(design.pins, pins);
+    detail::append_runs(design.blockages, blks);
+    if (std::all_of(sections[3].begin(), sections[3].end(), detail::is_space))
+    {
+        return lef_def_status::ok; // no nets: no names to look up
+    }
+
+    // name lookup for the nets
+    const auto scale = lef != nullptr ? design.dbu / lef->dbu : 1.0;
+    auto sc = [&](const T& a) { return detail::to_coord<T>(a * scale); };
+    // pin centres and sizes in DEF units, once per macro
+    const auto nm = lef != nullptr ? lef->macros.size() : std::size_t(0);
+    auto sites =
+        std::vector<std::vector<std::pair<std::string_view, vector2<T>>>>(nm);
+    auto sizes = std::vector<vector2<T>>(nm, vector2<T> {T(0), T(0)});
+    for (auto m = 0U; m != nm; ++m)
+    {
+        const auto& mac = lef->macros[m];
+        for (auto&& p : mac.pins)
+        {
+            const auto v = detail::pin_center(p);
+            sites[m].emplace_back(p.name, vector2<T> {sc(v.x()), sc(v.y())});
+        }
+        sizes[m] = vector2<T> {sc(mac.size.x()), sc(mac.size.y())};
+    }
+    // macro and orientation packed per component: one cache line per pin
+    auto comp_ref = std::vector<std::pair<std::uint32_t, def_orient>>(
+        design.components.size(), {UINT32_MAX, def_orient::N});
+    auto comp_id = detail::name_table {design.components.size()};
+    for (auto i = 0U; i != design.components.size(); ++i)
+    {
+        const auto& c = design.components[i];
+        comp_id.insert(c.name, i);
+        const auto* m = lef != nullptr ? lef->find(c.macro) : nullptr;
+        if (m != nullptr)
+        {
+            comp_ref[i] = {std::uint32_t(m - lef->macros.data()), c.orient};
+        }
+    }
+    auto pin_id = detail::name_table {design.pins.size()};
+    for (auto i = 0U; i != design.pins.size(); ++i)
+    {
+        pin_id.insert(design.pins[i].name,
+            std::uint32_t(design.components.size() + i));
+    }
+    auto offset = [&](std::uint32_t c, std::string_view pin) -> vector2<T>
+    {
+        const auto [m, orient] = comp_ref[c];
+        if (m == UINT32_MAX)
+        {
+            return {T(0), T(0)};
+        }
+        const auto& ps = sites[m];
+        const auto it = std::find_if(ps.begin(), ps.end(),
+            [&](const auto& p) { return p.first == pin; });
+        if (it == ps.end())
+        {
+            return {T(0), T(0)};
+        }
+        const auto& v = it->second;
+        return detail::orient_vector(
+            orient, v.x(), v.y(), sizes[m].x(), sizes[m].y());
+    };
+
+    // nets
+    const auto net_runs = detail::split_statements(sections[3], parts);
+    auto nets = std::vector<detail::def_net_part<T>>(net_runs.size());
+    parallel_for(
+        net_runs.size(),
+        [&](std::size_t k)
+        {
+            auto& out = nets[k];
+            // references are resolved in batches: the lookups are bound
+            // by memory latency, and the table slots, then the names and
+            // components they hold, of a whole batch are fetched at once
+            struct reference
+            {
+                const detail::name_table* table;
+                std::string_view name;
+                std::string_view pin;
+                std::uint64_t hash;
+                std::size_t at;
+            };
+            constexpr auto batch_size = std::size_t(256);
+            auto batch = std::vector<reference> {};
+            batch.reserve(batch_size);
+            auto flush = [&]() -> bool
+            {
+                for (auto&& r : batch)
+                {
+                    r.table->prefetch(r.hash);
+                }
+                for (auto&& r : batch)
+                {
+                    const auto id = r.table->prefetch_name(r.hash);
+                    if (r.table == &comp_id && id < comp_ref.size())
+                    {
+                        detail::prefetch(&comp_ref[id]);
+                    }
+                }
+                for (auto&& r : batch)
+                {
+                    const auto id = r.table->find(r.name, r.hash);
+                    if (id == UINT32_MAX)
+                    {
+                        return false;
+                    }
+                    out.nets.pin_cell[r.at] = id;
+                    if (r.table == &comp_id)
+                    {
+                        out.nets.pin_offset[r.at] = offset(id, r.pin);
+                    }
+                }
+                batch.clear();
+                return true;
+            };
+            // earlier references are reported before a syntax error
+            auto fail = [&]
+            {
+                out.status = flush() ? syntax_error
+                                     : lef_def_status::unknown_reference;
+            };
+            auto tk = detail::lef_def_tokens {net_runs[k]};
+            for (auto t = tk.next(); !t.empty(); t = tk.next())
+            {
+                if (t != "-")
+                {
+                    fail();
+                    return;
+                }
+                out.names.push_back(tk.next());
+                for (auto u = tk.next(); u != ";"; u = tk.next())
+                {
+                    if (u == "+")
+                    {
+                        tk.skip_statement(); // routing and properties
+                        break;
+                    }
+                    if (u != "(")
+                    {
+                        fail();
+                        return;
+                    }
+                    const auto comp = tk.next();
+                    const auto pin = tk.next();
+                    while (!u.empty() && u != ")")
+                    {
+                        u = tk.next();
+                    }
+                    if (u.empty())
+                    {
+                        fail();
+                        return;
+                    }
+                    if (comp == "*")
+                    {
+                        continue; // every component, not supported
+                    }
+                    if (batch.size() == batch_size && !flush())
+                    {
+                        out.status = lef_def_status::unknown_reference;
+                        return;
+                    }
+                    const auto io = comp == "PIN";
+                    const auto& table = io ? pin_id : comp_id;
+                    const auto name = io ? pin : comp;
+                    batch.push_back(reference {&table, name, pin,
+                        detail::name_table::hash(name), out.nets.num_pins()});
+                    out.nets.add_pin(UINT32_MAX, vector2<T> {T(0), T(0)});
+                }
+                out.nets.close_net();
+            }
+            if (!flush())
+            {
+                out.status = lef_def_status::unknown_reference;
+            }
+        },
+        num_threads);
+    if (nets.size() == 1 && nets[0].status == lef_def_status::ok)
+    {
+        design.net_names = std::move(nets[0].names);
+        design.nets = std::move(nets[0].nets);
+        return lef_def_status::ok;
+    }
+    auto& nl = design.nets;
+    for (auto&& part : nets)
+    {
+        if (part.status != lef_def_status::ok)
+        {
+            return part.status;
+        }
+        design.net_names.insert(
+            design.net_names.end(), part.names.begin(), part.names.end());
+        const auto base = nl.num_pins();
+        for (auto i = 1U; i < part.nets.net_start.size(); ++i)
+        {
+            nl.net_start.push_back(base + part.nets.net_start[i]);
+        }
+        nl.pin_cell.insert(nl.pin_cell.end(), part.nets.pin_cell.begin(),
+            part.nets.pin_cell.end());
+        nl.pin_offset.insert(nl.pin_offset.end(),
+            part.nets.pin_offset.begin(), part.nets.pin_offset.end());
+    }
+    return lef_def_status::ok;
+}
+
+/**
+ * @brief Placed footprint of a component, from its LEF macro
+ *
+ * @tparam T
+ * @param design
+ * @param i component index
+ * @param lef
+ * @return rectangle<T> a point at the position if the macro is unknown
+ */
+template <typename T>
+inline auto placed_footprint(const def_design<T>& design, std::size_t i,
+    const lef_library<T>& lef) -> rectangle<T>
+{
+    const auto& c = design.components[i];
+    auto w = T(0);
+    auto h = T(0);
+    if (const auto* m = lef.find(c.macro))
+    {
+        const auto scale = design.dbu / lef.dbu;
+        w = detail::to_coord<T>(m->size.x() * scale);
+        h = detail::to_coord<T>(m->size.y() * scale);
+    }
+    const auto o = c.orient;
+    if (o == def_orient::W || o == def_orient::E || o == def_orient::FW ||
+        o == def_orient::FE)
+    {
+        std::swap(w, h);
+    }
+    return {interval<T> {c.position.x(), c.position.x() + w},
+        interval<T> {c.position.y(), c.position.y() + h}};
+}
+
+} // namespace recti
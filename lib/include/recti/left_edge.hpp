@@ -0,0 +1,166 @@
+#pragma once
+
+#include "recti.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <gsl/span>
+#include <numeric>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Track id per interval and the number of tracks used
+ *
+ */
+struct track_assignment
+{
+    std::vector<std::uint32_t> track;
+    std::size_t num_tracks {0};
+};
+
+/**
+ * @brief Streaming left-edge track assigner
+ *
+ * Intervals must arrive in non-decreasing order of their lower bound. Two
+ * closed intervals may share a track only if they are disjoint, i.e. one
+ * is `<` the other. Each interval gets the lowest-numbered free track, so
+ * the number of tracks equals the maximum clique size (optimal). Memory
+ * is proportional to the number of tracks, not to the number of intervals.
+ *
+ * @tparam T
+ */
+template <typename T>
+class left_edge_stream
+{
+  private:
+    using busy_track = std::pair<T, std::uint32_t>; // (upper bound, track)
+    std::priority_queue<busy_track, std::vector<busy_track>,
+        std::greater<busy_track>>
+        _busy;
+    std::priority_queue<std::uint32_t, std::vector<std::uint32_t>,
+        std::greater<std::uint32_t>>
+        _free;
+    std::uint32_t _num_tracks {0};
+#ifndef NDEBUG
+    bool _started {false};
+    T _last {};
+#endif
+
+  public:
+    /**
+     * @brief assign a track to the next interval
+     *
+     * @param a
+     * @return std::uint32_t
+     */
+    auto push(const interval<T>& a) -> std::uint32_t
+    {
+#ifndef NDEBUG
+        assert(!this->_started || !(a.lower() < this->_last));
+        this->_started = true;
+        this->_last = a.lower();
+#endif
+        while (!this->_busy.empty() && this->_busy.top().first < a.lower())
+        {
+            this->_free.push(this->_busy.top().second);
+            this->_busy.pop();
+        }
+        auto t = this->_num_tracks;
+        if (this->_free.empty())
+        {
+            ++this->_num_tracks;
+        }
+        else
+        {
+            t = this->_free.top();
+            this->_free.pop();
+        }
+        this->_busy.emplace(a.upper(), t);
+        return t;
+    }
+
+    /**
+     * @brief number of tracks used so far
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto num_tracks() const noexcept -> std::size_t
+    {
+        return this->_num_tracks;
+    }
+};
+
+/**
+ * @brief Assign tracks to intervals with the left-edge algorithm
+ *
+ * O(n log n); uses the minimum number of tracks.
+ *
+ * @tparam T
+ * @param ivs
+ * @return track_assignment
+ */
+template <typename T>
+inline auto left_edge(gsl::span<const interval<T>> ivs) -> track_assignment
+{
+    auto order = std::vector<std::uint32_t>(ivs.size());
+    std::iota(order.begin(), order.end(), 0U);
+    std::stable_sort(order.begin(), order.end(),
+        [&](auto a, auto b) { return ivs[a].lower() < ivs[b].lower(); });
+    auto res = track_assignment {};
+    res.track.resize(ivs.size());
+    auto stream = left_edge_stream<T> {};
+    for (auto i : order)
+    {
+        res.track[i] = stream.push(ivs[i]);
+    }
+    res.num_tracks = stream.num_tracks();
+    return res;
+}
+
+/**
+ * @brief Assign tracks to horizontal segments, independently per y
+ *
+ * Segments at different y never conflict, so every y is coloured on its
+ * own; track ids are relative to the segment's y and `num_tracks` is the
+ * largest count over all y.
+ *
+ * @tparam T
+ * @param segs
+ * @return track_assignment
+ */
+template <typename T>
+inline auto left_edge(gsl::span<const hsegment<T>> segs) -> track_assignment
+{
+    auto order = std::vector<std::uint32_t>(segs.size());
+    std::iota(order.begin(), order.end(), 0U);
+    std::stable_sort(order.begin(), order.end(),
+        [&](auto a, auto b)
+        {
+            const auto& sa = segs[a];
+            const auto& sb = segs[b];
+            return sa.y() < sb.y() ||
+                (!(sb.y() < sa.y()) && sa.x().lower() < sb.x().lower());
+        });
+    auto res = track_assignment {};
+    res.track.resize(segs.size());
+    for (auto first = order.begin(); first != order.end();)
+    {
+        const auto& y = segs[*first].y();
+        auto stream = left_edge_stream<T> {};
+        auto it = first;
+        for (; it != order.end() && segs[*it].y() == y; ++it)
+        {
+            res.track[*it] = stream.push(segs[*it].x());
+        }
+        res.num_tracks = std::max(res.num_tracks, stream.num_tracks());
+        first = it;
+    }
+    return res;
+}
+
+} // namespace recti
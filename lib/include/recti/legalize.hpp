@@ -0,0 +1,358 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <gsl/span>
+#include <numeric>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Result of a legalization run
+ *
+ * @tparam T
+ */
+template <typename T>
+struct legalization
+{
+    std::vector<rectangle<T>> cells;     //!< legal positions, input order
+    std::vector<std::size_t> unplaced;   //!< cells that did not fit any row
+    T displacement {0};                  //!< total L1 displacement
+};
+
+namespace detail
+{
+
+/**
+ * @brief One placement row of the Abacus legalizer
+ *
+ * Cells are appended in increasing order of their target x. Consecutive
+ * abutting cells form a cluster whose optimal position, the mean of its
+ * cells' target positions shifted by their offsets within the cluster, is
+ * kept as (e, q, w) with x = q / e. A cluster that overlaps its predecessor
+ * is merged into it.
+ *
+ * @tparam T
+ */
+template <typename T>
+class abacus_row
+{
+  private:
+    struct cluster
+    {
+        std::size_t first; // index of its first cell in _cells
+        T e;               // number of cells
+        T q;               // sum of (target x - offset in cluster)
+        T w;               // total width
+        T x;               // position
+    };
+
+    hsegment<T> _row;
+    T _used {0};
+    std::vector<std::uint32_t> _cells;
+    std::vector<cluster> _clusters;
+
+  public:
+    explicit abacus_row(const hsegment<T>& row)
+        : _row {row}
+    {
+    }
+
+    [[nodiscard]] auto y() const -> const T&
+    {
+        return this->_row.y();
+    }
+
+    /**
+     * @brief x position a cell would get if appended now, if it fits
+     *
+     * @param tx target x of the cell
+     * @param w width of the cell
+     * @param[out] x
+     * @return true if the cell fits
+     */
+    [[nodiscard]] auto trial(const T& tx, const T& w, T& x) const -> bool
+    {
+        if (this->_row.x().len() < this->_used + w)
+        {
+            return false;
+        }
+        auto e = T(1);
+        auto q = tx;
+        auto cw = w;
+        auto k = this->_clusters.size();
+        auto cx = this->_clamp(q / e, cw);
+        // merge backward while overlapping, without touching the row
+        while (k != 0)
+        {
+            const auto& c = this->_clusters[k - 1];
+            if (!(cx < c.x + c.w))
+            {
+                break;
+            }
+            q = c.q + q - e * c.w;
+            e += c.e;
+            cw += c.w;
+            cx = this->_clamp(q / e, cw);
+            --k;
+        }
+        x = cx + cw - w;
+        return true;
+    }
+
+    /**
+     * @brief append a cell
+     *
+     * @param id
+     * @param tx target x
+     * @param w width
+     */
+    void place(std::uint32_t id, const T& tx, const T& w)
+    {
+        this->_used += w;
+        this->_cells.push_back(id);
+        this->_clusters.push_back(
+            cluster {this->_cells.size() - 1, T(1), tx, w, T(0)});
+        this->_clusters.back().x = this->_clamp(tx, w);
+        while (this->_clusters.size() > 1)
+        {
+            auto& c = this->_clusters.back();
+            auto& p = this->_clusters[this->_clusters.size() - 2];
+            if (!(c.x < p.x + p.w))
+            {
+                break;
+            }
+            p.q = p.q + c.q - c.e * p.w;
+            p.e += c.e;
+            p.w += c.w;
+            p.x = this->_clamp(p.q / p.e, p.w);
+            this->_clusters.pop_back();
+        }
+    }
+
+    /**
+     * @brief write the final x positions of the placed cells
+     *
+     * @tparam Fn
+     * @param fn callable(id, x)
+     */
+    template <typename Fn>
+    void for_each_position(Fn&& fn) const
+    {
+        for (auto k = 0U; k != this->_clusters.size(); ++k)
+        {
+            const auto& c = this->_clusters[k];
+            const auto last = k + 1 == this->_clusters.size()
+                ? this->_cells.size()
+                : this->_clusters[k + 1].first;
+            auto x = c.x;
+            for (auto i = c.first; i != last; ++i)
+            {
+                x += fn(this->_cells[i], x);
+            }
+        }
+    }
+
+  private:
+    [[nodiscard]] auto _clamp(const T& x, const T& w) const -> T
+    {
+        const auto& span = this->_row.x();
+        return std::max(span.lower(), std::min(x, span.upper() - w));
+    }
+};
+
+/**
+ * @brief Abacus over a subset of cells and a contiguous range of rows
+ *
+ * @tparam T
+ */
+template <typename T>
+inline void abacus_region(gsl::span<const rectangle<T>> cells,
+    gsl::span<const hsegment<T>> rows, gsl::span<const std::uint32_t> ids,
+    legalization<T>& res, std::vector<std::size_t>& unplaced)
+{
+    auto row_state = std::vector<abacus_row<T>> {};
+    row_state.reserve(rows.size());
+    for (auto&& r : rows)
+    {
+        row_state.emplace_back(r);
+    }
+    auto absdiff = [](const T& a, const T& b) { return a < b ? b - a : a - b; };
+
+    for (auto id : ids)
+    {
+        const auto& c = cells[id];
+        const auto tx = c.x().lower();
+        const auto ty = c.y().lower();
+        const auto w = c.x().len();
+        // rows are sorted by y: search outward from the nearest one
+        const auto start = std::size_t(
+            std::lower_bound(rows.begin(), rows.end(), ty,
+                [](const hsegment<T>& r, const T& y) { return r.y() < y; }) -
+            rows.begin());
+        auto found = false;
+        auto best_cost = T(0);
+        auto best_row = std::size_t(0);
+        auto try_row = [&](std::size_t r)
+        {
+            const auto dy = absdiff(rows[r].y(), ty);
+            if (found && !(dy < best_cost))
+            {
+                return false; // rows further away cannot do better
+            }
+            auto x = T(0);
+            if (row_state[r].trial(tx, w, x))
+            {
+                const auto cost = dy + absdiff(x, tx);
+                if (!found || cost < best_cost)
+                {
+                    found = true;
+                    best_cost = cost;
+                    best_row = r;
+                }
+            }
+            return true;
+        };
+        auto up = start;
+        auto down = start;
+        auto up_open = true;
+        auto down_open = true;
+        while (up_open || down_open)
+        {
+            if (up_open)
+            {
+                up_open = up < rows.size() && try_row(up++);
+            }
+            if (down_open)
+            {
+                down_open = down != 0 && try_row(--down);
+            }
+        }
+        if (!found)
+        {
+            unplaced.push_back(id);
+            continue;
+        }
+        row_state[best_row].place(id, tx, w);
+    }
+
+    for (auto&& r : row_state)
+    {
+        r.for_each_position(
+            [&](std::uint32_t id, const T& x) -> T
+            {
+                const auto& c = cells[id];
+                res.cells[id] = rectangle<T> {
+                    interval<T> {x, x + c.x().len()},
+                    interval<T> {r.y(), r.y() + c.y().len()}};
+                return c.x().len();
+            });
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Row-based legalization with Abacus cluster merging
+ *
+ * Cells are visited in order of their lower-left x and each is appended to
+ * the row where it ends up with the least L1 displacement, collapsing
+ * overlapping clusters as in Abacus (Spindler et al., ISPD 2008). Cells
+ * keep their size and are placed with their lower edge on the row's y.
+ *
+ * With num_regions > 1 the rows, sorted by y, are split into that many
+ * bands of consecutive rows; every cell is assigned to the band of its
+ * nearest row and the bands are legalized independently in parallel.
+ * Cells that fit no row of their band are reported in `unplaced` and keep
+ * their input position.
+ *
+ * @tparam T
+ * @param cells global placement (single-row-height cells)
+ * @param rows placement rows: x-span at a fixed y
+ * @param num_regions
+ * @param num_threads (0 = hardware concurrency)
+ * @return legalization<T>
+ */
+template <typename T>
+inline auto abacus_legalize(gsl::span<const rectangle<T>> cells,
+    gsl::span<const hsegment<T>> rows, std::size_t num_regions = 1,
+    unsigned num_threads = 0) -> legalization<T>
+{
+    assert(cells.size() <= std::size_t(UINT32_MAX));
+    auto res = legalization<T> {};
+    res.cells.assign(cells.begin(), cells.end());
+    if (rows.empty())
+    {
+        res.unplaced.resize(cells.size());
+        std::iota(res.unplaced.begin(), res.unplaced.end(), std::size_t(0));
+        return res;
+    }
+
+    auto sorted_rows = std::vector<hsegment<T>>(rows.begin(), rows.end());
+    std::sort(sorted_rows.begin(), sorted_rows.end(),
+        [](const auto& a, const auto& b)
+        {
+            return a.y() < b.y() ||
+                (!(b.y() < a.y()) && a.x().lower() < b.x().lower());
+        });
+    const auto nr = std::max<std::size_t>(
+        1, std::min(num_regions, sorted_rows.size()));
+    auto band_start = std::vector<std::size_t>(nr + 1);
+    for (auto b = 0U; b <= nr; ++b)
+    {
+        band_start[b] = b * sorted_rows.size() / nr;
+    }
+
+    // cells by x, then distributed to the band of their nearest row
+    auto order = std::vector<std::uint32_t>(cells.size());
+    std::iota(order.begin(), order.end(), 0U);
+    std::stable_sort(order.begin(), order.end(),
+        [&](auto a, auto b)
+        { return cells[a].x().lower() < cells[b].x().lower(); });
+    // band b takes the cells below the midpoint to the next band's first row
+    auto band_limit = std::vector<T> {};
+    for (auto b = 1U; b < nr; ++b)
+    {
+        const auto& lo = sorted_rows[band_start[b] - 1].y();
+        const auto& hi = sorted_rows[band_start[b]].y();
+        band_limit.push_back(lo + (hi - lo) / 2);
+    }
+    auto band_ids = std::vector<std::vector<std::uint32_t>>(nr);
+    for (auto id : order)
+    {
+        const auto b = std::upper_bound(band_limit.begin(), band_limit.end(),
+                           cells[id].y().lower()) -
+            band_limit.begin();
+        band_ids[std::size_t(b)].push_back(id);
+    }
+
+    auto band_unplaced = std::vector<std::vector<std::size_t>>(nr);
+    parallel_for(
+        nr,
+        [&](std::size_t b)
+        {
+            detail::abacus_region<T>(cells,
+                gsl::span<const hsegment<T>>(sorted_rows).subspan(
+                    band_start[b], band_start[b + 1] - band_start[b]),
+                band_ids[b], res, band_unplaced[b]);
+        },
+        num_threads);
+
+    for (auto&& u : band_unplaced)
+    {
+        res.unplaced.insert(res.unplaced.end(), u.begin(), u.end());
+    }
+    std::sort(res.unplaced.begin(), res.unplaced.end());
+    for (auto i = 0U; i != cells.size(); ++i)
+    {
+        res.displacement +=
+            manhattan_distance(cells[i].lower(), res.cells[i].lower());
+    }
+    return res;
+}
+
+} // namespace recti
@@ -0,0 +1,693 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <gsl/span>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief A point on a given routing layer
+ *
+ * @tparam T
+ */
+template <typename T>
+struct layered_point
+{
+    point<T> pos;
+    std::uint32_t layer;
+};
+
+/**
+ * @brief Multi-layer routing grid with bit-packed occupancy
+ *
+ * Grid node (ix, iy) of every layer sits at origin + (ix, iy) * pitch.
+ * Each (layer, row) owns a whole number of 64-bit words, so nodes whose
+ * columns lie in different 64-column stripes never share a word and may
+ * be updated from different threads.
+ *
+ * @tparam T
+ */
+template <typename T>
+class occupancy_grid
+{
+  private:
+    point<T> _origin;
+    T _pitch;
+    std::size_t _nx;
+    std::size_t _ny;
+    std::size_t _nl;
+    std::size_t _words; // words per row
+    std::vector<std::uint64_t> _bits;
+
+  public:
+    /**
+     * @brief Construct a new, fully free occupancy grid
+     *
+     * @param origin position of node (0, 0)
+     * @param pitch distance between neighbouring nodes
+     * @param nx number of columns
+     * @param ny number of rows
+     * @param num_layers
+     */
+    occupancy_grid(const point<T>& origin, const T& pitch, std::size_t nx,
+        std::size_t ny, std::size_t num_layers)
+        : _origin {origin}
+        , _pitch {pitch}
+        , _nx {nx}
+        , _ny {ny}
+        , _nl {num_layers}
+        , _words {(nx + 63) / 64}
+        , _bits(_words * ny * num_layers, 0)
+    {
+        assert(T(0) < pitch);
+        assert(nx * ny * num_layers <= std::size_t(UINT32_MAX));
+    }
+
+    [[nodiscard]] auto nx() const noexcept -> std::size_t
+    {
+        return this->_nx;
+    }
+
+    [[nodiscard]] auto ny() const noexcept -> std::size_t
+    {
+        return this->_ny;
+    }
+
+    [[nodiscard]] auto num_layers() const noexcept -> std::size_t
+    {
+        return this->_nl;
+    }
+
+    [[nodiscard]] auto num_nodes() const noexcept -> std::size_t
+    {
+        return this->_nx * this->_ny * this->_nl;
+    }
+
+    /**
+     * @brief node id of (ix, iy) on layer l
+     *
+     * @return std::uint32_t
+     */
+    [[nodiscard]] auto node(std::size_t ix, std::size_t iy,
+        std::size_t l) const noexcept -> std::uint32_t
+    {
+        return std::uint32_t((l * this->_ny + iy) * this->_nx + ix);
+    }
+
+    /**
+     * @brief (ix, iy, layer) of a node id
+     *
+     * @param n
+     * @return std::array<std::uint32_t, 3>
+     */
+    [[nodiscard]] auto coords(std::uint32_t n) const noexcept
+        -> std::array<std::uint32_t, 3>
+    {
+        const auto r = n / this->_nx;
+        return {std::uint32_t(n % this->_nx), std::uint32_t(r % this->_ny),
+            std::uint32_t(r / this->_ny)};
+    }
+
+    /**
+     * @brief position of node (ix, iy)
+     *
+     * @return point<T>
+     */
+    [[nodiscard]] auto position(std::size_t ix, std::size_t iy) const
+        -> point<T>
+    {
+        return {this->_origin.x() + T(ix) * this->_pitch,
+            this->_origin.y() + T(iy) * this->_pitch};
+    }
+
+    /**
+     * @brief node nearest to a layered point (clamped into the grid)
+     *
+     * @param p
+     * @return std::uint32_t
+     */
+    [[nodiscard]] auto snap(const layered_point<T>& p) const -> std::uint32_t
+    {
+        assert(p.layer < this->_nl);
+        auto nearest = [this](const T& d, std::size_t n)
+        {
+            auto i = this->_floor(d);
+            if (this->_pitch < (d - T(i) * this->_pitch) * 2)
+            {
+                ++i;
+            }
+            return std::size_t(
+                std::clamp<long long>(i, 0, static_cast<long long>(n) - 1));
+        };
+        return this->node(nearest(p.pos.x() - this->_origin.x(), this->_nx),
+            nearest(p.pos.y() - this->_origin.y(), this->_ny), p.layer);
+    }
+
+    [[nodiscard]] auto blocked(std::uint32_t n) const noexcept -> bool
+    {
+        const auto [ix, iy, l] = this->coords(n);
+        return (this->_word(ix, iy, l) >> (ix % 64)) & 1U;
+    }
+
+    [[nodiscard]] auto blocked(std::size_t ix, std::size_t iy,
+        std::size_t l) const noexcept -> bool
+    {
+        return (this->_word(ix, iy, l) >> (ix % 64)) & 1U;
+    }
+
+    void block(std::uint32_t n) noexcept
+    {
+        const auto [ix, iy, l] = this->coords(n);
+        this->_word(ix, iy, l) |= std::uint64_t(1) << (ix % 64);
+    }
+
+    void unblock(std::uint32_t n) noexcept
+    {
+        const auto [ix, iy, l] = this->coords(n);
+        this->_word(ix, iy, l) &= ~(std::uint64_t(1) << (ix % 64));
+    }
+
+    /**
+     * @brief block every node of layer l covered by a (closed) rectangle
+     *
+     * @param l
+     * @param obstacle
+     */
+    void block(std::size_t l, const rectangle<T>& obstacle)
+    {
+        long long x0 = 0;
+        long long x1 = 0;
+        long long y0 = 0;
+        long long y1 = 0;
+        if (!this->_span(obstacle.x(), this->_origin.x(), this->_nx, x0, x1) ||
+            !this->_span(obstacle.y(), this->_origin.y(), this->_ny, y0, y1))
+        {
+            return;
+        }
+        for (auto iy = y0; iy <= y1; ++iy)
+        {
+            // whole words at once
+            for (auto w = x0 / 64; w <= x1 / 64; ++w)
+            {
+                const auto lo = std::max(x0, w * 64) - w * 64;
+                const auto hi = std::min(x1, w * 64 + 63) - w * 64;
+                const auto mask = (~std::uint64_t(0) >> (63 - (hi - lo)))
+                    << lo;
+                this->_word(std::size_t(w * 64), std::size_t(iy), l) |= mask;
+            }
+        }
+    }
+
+    /**
+     * @brief block the nodes covered by a set of obstacles on layer l
+     *
+     * @param l
+     * @param obstacles
+     */
+    void block(std::size_t l, gsl::span<const rectangle<T>> obstacles)
+    {
+        for (auto&& r : obstacles)
+        {
+            this->block(l, r);
+        }
+    }
+
+  private:
+    [[nodiscard]] auto _word(std::size_t ix, std::size_t iy,
+        std::size_t l) const noexcept -> const std::uint64_t&
+    {
+        return this->_bits[(l * this->_ny + iy) * this->_words + ix / 64];
+    }
+
+    [[nodiscard]] auto _word(std::size_t ix, std::size_t iy,
+        std::size_t l) noexcept -> std::uint64_t&
+    {
+        return this->_bits[(l * this->_ny + iy) * this->_words + ix / 64];
+    }
+
+    /**
+     * @brief floor(d / pitch)
+     */
+    [[nodiscard]] auto _floor(const T& d) const -> long long
+    {
+        auto i = static_cast<long long>(d / this->_pitch);
+        if (d < T(i) * this->_pitch)
+        {
+            --i;
+        }
+        return i;
+    }
+
+    /**
+     * @brief indices [first, last] of the nodes inside a closed interval
+     */
+    [[nodiscard]] auto _span(const interval<T>& a, const T& origin,
+        std::size_t n, long long& first, long long& last) const -> bool
+    {
+        const auto lo = a.lower() - origin;
+        first = this->_floor(lo);
+        if (T(first) * this->_pitch < lo)
+        {
+            ++first;
+        }
+        last = this->_floor(a.upper() - origin);
+        first = std::max(first, 0LL);
+        last = std::min(last, static_cast<long long>(n) - 1);
+        return first <= last;
+    }
+};
+
+/**
+ * @brief Search parameters of the maze router
+ *
+ */
+struct maze_options
+{
+    std::uint32_t via_cost {2};      //!< cost of a layer change (a step is 1)
+    std::uint32_t margin {8};        //!< nodes searched beyond the pins' bbox
+    std::size_t region_width {256};  //!< columns per parallel region
+};
+
+namespace detail
+{
+
+/**
+ * @brief search window of a net: inclusive node ranges x0, x1, y0, y1
+ *
+ * The bounding box of the pins' nodes grown by `opts.margin` nodes.
+ */
+template <typename T>
+inline auto maze_window(const occupancy_grid<T>& grid,
+    const maze_options& opts, gsl::span<const layered_point<T>> pins)
+    -> std::array<std::size_t, 4>
+{
+    auto w = std::array<std::size_t, 4> {grid.nx(), 0, grid.ny(), 0};
+    for (auto&& p : pins)
+    {
+        const auto c = grid.coords(grid.snap(p));
+        w[0] = std::min<std::size_t>(w[0], c[0]);
+        w[1] = std::max<std::size_t>(w[1], c[0]);
+        w[2] = std::min<std::size_t>(w[2], c[1]);
+        w[3] = std::max<std::size_t>(w[3], c[1]);
+    }
+    const auto m = std::size_t(opts.margin);
+    w[0] = w[0] < m ? 0 : w[0] - m;
+    w[1] = std::min(w[1] + m, grid.nx() - 1);
+    w[2] = w[2] < m ? 0 : w[2] - m;
+    w[3] = std::min(w[3] + m, grid.ny() - 1);
+    return w;
+}
+
+} // namespace detail
+
+/**
+ * @brief Routed wires of one net
+ *
+ * @tparam T
+ */
+template <typename T>
+struct maze_route
+{
+    bool routed {false};  //!< every pin was connected
+    std::uint32_t cost {0};
+    std::vector<hsegment<T>> hsegments;
+    std::vector<std::uint32_t> hsegment_layers;
+    std::vector<vsegment<T>> vsegments;
+    std::vector<std::uint32_t> vsegment_layers;
+    std::vector<point<T>> vias;
+    std::vector<std::uint32_t> via_layers; //!< lower of the two layers
+};
+
+/**
+ * @brief A* maze router over an occupancy grid
+ *
+ * A multi-pin net is grown one pin at a time (nearest unconnected pin
+ * first): every node of the partial tree is a source with cost 0 and the
+ * search runs towards the next pin with the Manhattan distance plus the
+ * via cost of the layer difference as the heuristic. All costs are small
+ * integers and the heuristic is consistent, so open nodes are kept in
+ * buckets indexed by f instead of a binary heap. The search is confined
+ * to the bounding box of the pins grown by `margin` nodes. The routed
+ * nodes are marked as blocked for later nets; a pin node may be blocked
+ * and still be reached.
+ *
+ * The router owns its search workspace (costs, parents, buckets), sized
+ * to the grid once and reused, so routing a net does not allocate beyond
+ * its result. Use one router per thread.
+ *
+ * @tparam T
+ */
+template <typename T>
+class maze_router
+{
+  private:
+    occupancy_grid<T>& _grid;
+    maze_options _opts;
+    std::vector<std::uint32_t> _g;
+    std::vector<std::uint32_t> _parent;
+    std::vector<std::uint32_t> _stamp;
+    std::uint32_t _generation {0};
+    std::vector<std::vector<std::uint32_t>> _buckets;
+    std::vector<std::uint32_t> _tree;
+    std::vector<std::uint32_t> _pins;
+    std::vector<std::uint32_t> _dist;
+    std::vector<std::uint32_t> _path;
+
+  public:
+    /**
+     * @brief Construct a new maze router object
+     *
+     * @param grid
+     * @param opts
+     */
+    explicit maze_router(occupancy_grid<T>& grid, const maze_options& opts = {})
+        : _grid {grid}
+        , _opts {opts}
+        , _g(grid.num_nodes())
+        , _parent(grid.num_nodes())
+        , _stamp(grid.num_nodes(), 0)
+    {
+    }
+
+    /**
+     * @brief route one net and block its nodes in the grid
+     *
+     * @param pins
+     * @return maze_route<T>
+     */
+    auto route(gsl::span<const layered_point<T>> pins) -> maze_route<T>
+    {
+        auto res = maze_route<T> {};
+        res.routed = true;
+        if (pins.empty())
+        {
+            return res;
+        }
+        const auto w = detail::maze_window(this->_grid, this->_opts, pins);
+        this->_pins.clear();
+        for (auto&& p : pins)
+        {
+            this->_pins.push_back(this->_grid.snap(p));
+        }
+        this->_tree.assign(1, this->_pins[0]);
+        // Prim order: _dist[i] is the estimate from pin i to the connected
+        // pins, UINT32_MAX once pin i is connected
+        this->_dist.assign(pins.size(), UINT32_MAX);
+        for (auto i = 1U; i != pins.size(); ++i)
+        {
+            this->_dist[i] = this->_h(this->_pins[0], this->_pins[i]);
+        }
+        for (auto k = 1U; k != pins.size(); ++k)
+        {
+            const auto best = std::size_t(
+                std::min_element(this->_dist.begin(), this->_dist.end()) -
+                this->_dist.begin());
+            this->_dist[best] = UINT32_MAX;
+            for (auto i = 0U; i != pins.size(); ++i)
+            {
+                if (this->_dist[i] != UINT32_MAX)
+                {
+                    this->_dist[i] = std::min(this->_dist[i],
+                        this->_h(this->_pins[best], this->_pins[i]));
+                }
+            }
+            auto cost = std::uint32_t(0);
+            if (!this->_search(this->_pins[best], w, cost))
+            {
+                res.routed = false;
+                continue;
+            }
+            res.cost += cost;
+            this->_emit(res);
+            this->_tree.insert(
+                this->_tree.end(), this->_path.begin(), this->_path.end() - 1);
+        }
+        for (auto n : this->_tree)
+        {
+            this->_grid.block(n);
+        }
+        return res;
+    }
+
+  private:
+    /**
+     * @brief admissible cost estimate between two nodes
+     */
+    [[nodiscard]] auto _h(std::uint32_t a, std::uint32_t b) const
+        -> std::uint32_t
+    {
+        const auto ca = this->_grid.coords(a);
+        const auto cb = this->_grid.coords(b);
+        auto diff = [](std::uint32_t u, std::uint32_t v)
+        { return u < v ? v - u : u - v; };
+        return diff(ca[0], cb[0]) + diff(ca[1], cb[1]) +
+            diff(ca[2], cb[2]) * this->_opts.via_cost;
+    }
+
+    void _push(std::uint32_t n, std::uint32_t f)
+    {
+        if (this->_buckets.size() <= f)
+        {
+            this->_buckets.resize(std::size_t(f) + 1);
+        }
+        this->_buckets[f].push_back(n);
+    }
+
+    /**
+     * @brief A* from the current tree to target; fills _path target-first
+     */
+    auto _search(std::uint32_t target, const std::array<std::size_t, 4>& w,
+        std::uint32_t& cost) -> bool
+    {
+        if (++this->_generation == 0)
+        {
+            std::fill(this->_stamp.begin(), this->_stamp.end(), 0U);
+            this->_generation = 1;
+        }
+        const auto gen = this->_generation;
+        auto f_min = UINT32_MAX;
+        auto f_max = std::uint32_t(0);
+        for (auto n : this->_tree)
+        {
+            this->_stamp[n] = gen;
+            this->_g[n] = 0;
+            this->_parent[n] = n;
+            const auto f = this->_h(n, target);
+            f_min = std::min(f_min, f);
+            f_max = std::max(f_max, f);
+            this->_push(n, f);
+        }
+        const auto nl = this->_grid.num_layers();
+        auto found = false;
+        auto f = f_min;
+        for (; f <= f_max && !found; ++f)
+        {
+            // expanding a node may add to the current bucket
+            while (!this->_buckets[f].empty())
+            {
+                const auto n = this->_buckets[f].back();
+                this->_buckets[f].pop_back();
+                const auto g = this->_g[n];
+                if (g + this->_h(n, target) != f)
+                {
+                    continue; // stale entry
+                }
+                if (n == target)
+                {
+                    found = true;
+                    break;
+                }
+                const auto c = this->_grid.coords(n);
+                const auto ix = std::size_t(c[0]);
+                const auto iy = std::size_t(c[1]);
+                const auto l = std::size_t(c[2]);
+                auto relax = [&](std::size_t jx, std::size_t jy, std::size_t jl,
+                                 std::uint32_t step)
+                {
+                    const auto m = this->_grid.node(jx, jy, jl);
+                    if (m != target && this->_grid.blocked(jx, jy, jl))
+                    {
+                        return;
+                    }
+                    const auto gm = g + step;
+                    if (this->_stamp[m] == gen && !(gm < this->_g[m]))
+                    {
+                        return;
+                    }
+                    this->_stamp[m] = gen;
+                    this->_g[m] = gm;
+                    this->_parent[m] = n;
+                    const auto fm = gm + this->_h(m, target);
+                    f_max = std::max(f_max, fm);
+                    this->_push(m, fm);
+                };
+                if (ix > w[0])
+                {
+                    relax(ix - 1, iy, l, 1);
+                }
+                if (ix < w[1])
+                {
+                    relax(ix + 1, iy, l, 1);
+                }
+                if (iy > w[2])
+                {
+                    relax(ix, iy - 1, l, 1);
+                }
+                if (iy < w[3])
+                {
+                    relax(ix, iy + 1, l, 1);
+                }
+                if (l > 0)
+                {
+                    relax(ix, iy, l - 1, this->_opts.via_cost);
+                }
+                if (l + 1 < nl)
+                {
+                    relax(ix, iy, l + 1, this->_opts.via_cost);
+                }
+            }
+        }
+        for (auto b = f_min; b <= f_max; ++b)
+        {
+            this->_buckets[b].clear();
+        }
+        if (!found)
+        {
+            return false;
+        }
+        cost = this->_g[target];
+        this->_path.clear();
+        for (auto n = target;; n = this->_parent[n])
+        {
+            this->_path.push_back(n);
+            if (this->_parent[n] == n)
+            {
+                break;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief append the wires of _path, merging collinear steps
+     */
+    void _emit(maze_route<T>& res) const
+    {
+        const auto& path = this->_path;
+        for (auto i = 0U; i + 1 < path.size();)
+        {
+            const auto a = this->_grid.coords(path[i]);
+            const auto b = this->_grid.coords(path[i + 1]);
+            const auto axis = a[0] != b[0] ? 0 : a[1] != b[1] ? 1 : 2;
+            if (axis == 2)
+            {
+                res.vias.push_back(this->_grid.position(a[0], a[1]));
+                res.via_layers.push_back(std::min(a[2], b[2]));
+                ++i;
+                continue;
+            }
+            auto j = i + 1;
+            while (j + 1 < path.size())
+            {
+                const auto c = this->_grid.coords(path[j]);
+                const auto d = this->_grid.coords(path[j + 1]);
+                if (c[2] != d[2] || c[1 - axis] != d[1 - axis])
+                {
+                    break;
+                }
+                ++j;
+            }
+            const auto e = this->_grid.coords(path[j]);
+            const auto p = this->_grid.position(a[0], a[1]);
+            const auto q = this->_grid.position(e[0], e[1]);
+            if (axis == 0)
+            {
+                res.hsegments.emplace_back(
+                    interval<T> {
+                        std::min(p.x(), q.x()), std::max(p.x(), q.x())},
+                    p.y());
+                res.hsegment_layers.push_back(a[2]);
+            }
+            else
+            {
+                res.vsegments.emplace_back(p.x(),
+                    interval<T> {
+                        std::min(p.y(), q.y()), std::max(p.y(), q.y())});
+                res.vsegment_layers.push_back(a[2]);
+            }
+            i = j;
+        }
+    }
+};
+
+/**
+ * @brief Route many nets, independent regions in parallel
+ *
+ * The grid is cut into vertical stripes of `region_width` columns
+ * (rounded up to a multiple of 64, so stripes share no occupancy word).
+ * Nets whose search window lies inside one stripe are routed by stripe in
+ * parallel, each stripe in input order with one router per thread; the
+ * remaining nets are routed afterwards, sequentially in input order. The
+ * result does not depend on `num_threads`.
+ *
+ * @tparam T
+ * @param grid
+ * @param pins pins of all nets, grouped by net
+ * @param net_start CSR offsets into pins, size num_nets + 1
+ * @param opts
+ * @param num_threads (0 = hardware concurrency)
+ * @return std::vector<maze_route<T>>
+ */
+template <typename T>
+inline auto maze_route_nets(occupancy_grid<T>& grid,
+    gsl::span<const layered_point<T>> pins,
+    gsl::span<const std::size_t> net_start, const maze_options& opts = {},
+    unsigned num_threads = 0) -> std::vector<maze_route<T>>
+{
+    assert(!net_start.empty());
+    const auto num_nets = net_start.size() - 1;
+    auto net_pins = [&](std::size_t e)
+    { return pins.subspan(net_start[e], net_start[e + 1] - net_start[e]); };
+    const auto width = std::max<std::size_t>(
+        64, (opts.region_width + 63) / 64 * 64);
+    const auto num_regions = (grid.nx() + width - 1) / width;
+    auto region_nets = std::vector<std::vector<std::size_t>>(num_regions + 1);
+    for (auto e = 0U; e != num_nets; ++e)
+    {
+        const auto w = detail::maze_window(grid, opts, net_pins(e));
+        const auto r = w[0] <= w[1] && w[0] / width == w[1] / width
+            ? w[0] / width
+            : num_regions;
+        region_nets[r].push_back(e);
+    }
+
+    auto res = std::vector<maze_route<T>>(num_nets);
+    parallel_chunks(
+        num_regions,
+        [&](unsigned /* tid */, std::size_t first, std::size_t last)
+        {
+            auto router = maze_router<T> {grid, opts};
+            for (auto r = first; r != last; ++r)
+            {
+                for (auto e : region_nets[r])
+                {
+                    res[e] = router.route(net_pins(e));
+                }
+            }
+        },
+        num_threads);
+    auto router = maze_router<T> {grid, opts};
+    for (auto e : region_nets[num_regions])
+    {
+        res[e] = router.route(net_pins(e));
+    }
+    return res;
+}
+
+} // namespace recti
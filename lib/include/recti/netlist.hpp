@@ -0,0 +1,82 @@
+#pragma once
+
+#include "recti.hpp"
+#include <cstdint>
+#include <gsl/span>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Placement netlist in CSR form
+ *
+ * Pins are numbered in net order: the pins of net i are
+ * net_start[i] .. net_start[i + 1] - 1. Every pin belongs to one cell and
+ * sits at a fixed offset from the cell's position.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct netlist
+{
+    std::vector<std::size_t> net_start {0}; //!< CSR offsets, num_nets() + 1
+    std::vector<std::uint32_t> pin_cell;    //!< owning cell of each pin
+    std::vector<vector2<T>> pin_offset;     //!< pin position - cell position
+
+    /**
+     * @brief append a pin to the net currently being built
+     *
+     * @param cell
+     * @param offset
+     */
+    void add_pin(std::uint32_t cell, const vector2<T>& offset)
+    {
+        this->pin_cell.push_back(cell);
+        this->pin_offset.push_back(offset);
+    }
+
+    /**
+     * @brief finish the net currently being built
+     *
+     */
+    void close_net()
+    {
+        this->net_start.push_back(this->pin_cell.size());
+    }
+
+    /**
+     * @brief
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto num_nets() const noexcept -> std::size_t
+    {
+        return this->net_start.size() - 1;
+    }
+
+    /**
+     * @brief
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto num_pins() const noexcept -> std::size_t
+    {
+        return this->pin_cell.size();
+    }
+
+    /**
+     * @brief cells of the pins of net i
+     *
+     * @param i
+     * @return gsl::span<const std::uint32_t>
+     */
+    [[nodiscard]] auto net_cells(std::size_t i) const
+        -> gsl::span<const std::uint32_t>
+    {
+        return {this->pin_cell.data() + this->net_start[i],
+            this->net_start[i + 1] - this->net_start[i]};
+    }
+};
+
+} // namespace recti
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Number of worker threads used by the parallel kernels
+ *
+ * @param num_threads requested number of threads (0 = hardware concurrency)
+ * @return unsigned
+ */
+inline auto num_workers(unsigned num_threads = 0) noexcept -> unsigned
+{
+    if (num_threads == 0)
+    {
+        num_threads = std::thread::hardware_concurrency();
+    }
+    return std::max(num_threads, 1U);
+}
+
+/**
+ * @brief Number of chunks parallel_chunks() splits n items into
+ *
+ * @param n number of items
+ * @param num_threads requested number of threads (0 = hardware concurrency)
+ * @return unsigned
+ */
+inline auto num_chunks(std::size_t n, unsigned num_threads = 0) noexcept
+    -> unsigned
+{
+    return unsigned(std::min<std::size_t>(
+        num_workers(num_threads), std::max<std::size_t>(n, 1)));
+}
+
+/**
+ * @brief Split [0, n) into contiguous chunks and process them in parallel
+ *
+ * The callable is invoked as fn(tid, first, last) once per chunk. Chunk
+ * `tid` always covers the same index range for a given (n, num_threads),
+ * so per-thread partial results can be combined deterministically. The
+ * calling thread processes chunk 0 itself.
+ *
+ * @tparam Fn
+ * @param n number of items
+ * @param fn callable(unsigned tid, std::size_t first, std::size_t last)
+ * @param num_threads requested number of threads (0 = hardware concurrency)
+ * @return unsigned the number of chunks actually used
+ */
+template <typename Fn>
+inline auto parallel_chunks(std::size_t n, Fn&& fn, unsigned num_threads = 0)
+    -> unsigned
+{
+    const auto nt = num_chunks(n, num_threads);
+    if (nt == 1)
+    {
+        fn(0U, std::size_t(0), n);
+        return 1U;
+    }
+    const auto chunk = (n + nt - 1) / nt;
+    auto workers = std::vector<std::thread> {};
+    workers.reserve(nt - 1);
+    for (auto tid = 1U; tid != nt; ++tid)
+    {
+        auto first = std::min(n, tid * chunk);
+        auto last = std::min(n, first + chunk);
+        workers.emplace_back(
+            [&fn, tid, first, last]() { fn(tid, first, last); });
+    }
+    fn(0U, std::size_t(0), std::min(n, chunk));
+    for (auto&& w : workers)
+    {
+        w.join();
+    }
+    return nt;
+}
+
+/**
+ * @brief Parallel loop over [0, n)
+ *
+ * @tparam Fn
+ * @param n number of items
+ * @param fn callable(std::size_t i)
+ * @param num_threads requested number of threads (0 = hardware concurrency)
+ */
+template <typename Fn>
+inline void parallel_for(std::size_t n, Fn&& fn, unsigned num_threads = 0)
+{
+    parallel_chunks(
+        n,
+        [&fn](unsigned /* tid */, std::size_t first, std::size_t last)
+        {
+            for (auto i = first; i != last; ++i)
+            {
+                fn(i);
+            }
+        },
+        num_threads);
+}
+
+/**
+ * @brief Sort [first, last) with a parallel merge sort
+ *
+ * The range is split as by parallel_chunks(), every chunk is sorted on its
+ * own thread and neighbouring runs are then merged pairwise, each round of
+ * merges in parallel. Small ranges are sorted serially. Not stable.
+ *
+ * @tparam RandomIt
+ * @tparam Compare not an integer, so that parallel_sort(first, last, 4)
+ *         picks the thread-count overload below
+ * @param first
+ * @param last
+ * @param comp strict weak ordering
+ * @param num_threads requested number of threads (0 = hardware concurrency)
+ */
+template <typename RandomIt, typename Compare,
+    typename = std::enable_if_t<!std::is_integral<Compare>::value>>
+inline void parallel_sort(
+    RandomIt first, RandomIt last, Compare comp, unsigned num_threads = 0)
+{
+    const auto n = std::size_t(last - first);
+    if (n < 8192)
+    {
+        num_threads = 1;
+    }
+    auto at = [first](std::size_t i) { return first + std::ptrdiff_t(i); };
+    const auto nt = parallel_chunks(
+        n,
+        [&](unsigned /* tid */, std::size_t a, std::size_t b)
+        { std::sort(at(a), at(b), comp); },
+        num_threads);
+    const auto chunk = (n + nt - 1) / nt;
+    for (auto width = chunk; nt > 1 && width < n; width *= 2)
+    {
+        parallel_for(
+            (n + 2 * width - 1) / (2 * width),
+            [&](std::size_t k)
+            {
+                const auto a = 2 * width * k;
+                std::inplace_merge(at(a), at(std::min(n, a + width)),
+                    at(std::min(n, a + 2 * width)), comp);
+            },
+            num_threads);
+    }
+}
+
+/**
+ * @brief Sort [first, last) ascending with a parallel merge sort
+ *
+ * @tparam RandomIt
+ * @param first
+ * @param last
+ * @param num_threads requested number of threads (0 = hardware concurrency)
+ */
+template <typename RandomIt>
+inline void parallel_sort(
+    RandomIt first, RandomIt last, unsigned num_threads = 0)
+{
+    parallel_sort(first, last, std::less<> {}, num_threads);
+}
+
+} // namespace recti
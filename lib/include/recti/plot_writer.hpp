@@ -0,0 +1,581 @@
+#pragma once
+
+#include "recti.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <gsl/span>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Output language of a plot_writer
+ *
+ */
+enum class plot_format : std::uint8_t
+{
+    svg,
+    tikz
+};
+
+namespace detail
+{
+
+/**
+ * @brief append the decimal text of an integer
+ */
+inline void append_int(std::string& buf, long long v)
+{
+    static constexpr char digits[] = "00010203040506070809"
+                                     "10111213141516171819"
+                                     "20212223242526272829"
+                                     "30313233343536373839"
+                                     "40414243444546474849"
+                                     "50515253545556575859"
+                                     "60616263646566676869"
+                                     "70717273747576777879"
+                                     "80818283848586878889"
+                                     "90919293949596979899";
+    char tmp[24];
+    auto* end = tmp + sizeof(tmp);
+    auto* p = end;
+    auto u = v < 0 ? 0ULL - static_cast<unsigned long long>(v)
+                   : static_cast<unsigned long long>(v);
+    while (u >= 100)
+    {
+        const auto k = (u % 100) * 2;
+        u /= 100;
+        *--p = digits[k + 1];
+        *--p = digits[k];
+    }
+    if (u >= 10)
+    {
+        *--p = digits[u * 2 + 1];
+        *--p = digits[u * 2];
+    }
+    else
+    {
+        *--p = char('0' + u);
+    }
+    if (v < 0)
+    {
+        *--p = '-';
+    }
+    buf.append(p, std::size_t(end - p));
+}
+
+/**
+ * @brief append a coordinate: integers exactly, others with 6 digits
+ */
+template <typename T>
+inline void append_coord(std::string& buf, const T& v)
+{
+    if constexpr (std::is_integral<T>::value)
+    {
+        append_int(buf, static_cast<long long>(v));
+    }
+    else
+    {
+        char tmp[32];
+        const auto n = std::snprintf(tmp, sizeof(tmp), "%g", double(v));
+        buf.append(tmp, std::size_t(n));
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Streaming SVG / TikZ writer for large shape sets
+ *
+ * Shapes are formatted into one reusable buffer that is flushed to the
+ * stream in large blocks, with a digit-pair fast path for integer
+ * coordinates. Shapes whose bounding box misses the viewport are culled.
+ * Shapes smaller than a pixel in both directions are merged: each output
+ * pixel gets at most one pixel-sized square, however many tiny shapes
+ * fall into it, so a full-chip dump stays at a viewable size.
+ *
+ * Coordinates are written in layout units; SVG output flips the y axis
+ * with a group transform, so y grows upwards as in the layout.
+ *
+ * @tparam T
+ */
+template <typename T>
+class plot_writer
+{
+  private:
+    std::ostream& _os;
+    plot_format _format;
+    rectangle<T> _view;
+    std::size_t _width_px;
+    std::size_t _height_px;
+    double _pixel; // layout units per pixel
+    std::vector<std::uint64_t> _marked;
+    std::string _buf;
+    std::string _style;
+    bool _in_group {false};
+    std::size_t _written {0};
+    std::size_t _culled {0};
+    std::size_t _merged {0};
+
+    static constexpr std::size_t flush_size = std::size_t(1) << 20;
+
+  public:
+    /**
+     * @brief Construct a new plot writer object and write the header
+     *
+     * @param os output stream
+     * @param format
+     * @param viewport the visible part of the layout
+     * @param width_px output size in pixels of the longer viewport side;
+     *        sets the merge threshold and bounds the pixel bitmap
+     */
+    plot_writer(std::ostream& os, plot_format format,
+        const rectangle<T>& viewport, std::size_t width_px = 2048)
+        : _os {os}
+        , _format {format}
+        , _view {viewport}
+        , _width_px {std::max<std::size_t>(width_px, 1)}
+    {
+        // the longer side sets the pixel size, so neither side exceeds the
+        // requested pixel count, however thin or tall the viewport
+        const auto w = double(viewport.x().len());
+        const auto h = double(viewport.y().len());
+        const auto side = std::max(w, h) > 0.0 ? std::max(w, h) : 1.0;
+        const auto max_px = this->_width_px;
+        auto pixels = [&](double len)
+        {
+            const auto n = std::ceil(len / this->_pixel);
+            return !(1.0 <= n) ? std::size_t(1)
+                               : std::min(max_px, std::size_t(n));
+        };
+        this->_pixel = side / double(max_px);
+        this->_width_px = pixels(w);
+        this->_height_px = pixels(h);
+        this->_marked.assign(
+            (this->_width_px * this->_height_px + 63) / 64, 0);
+        this->_buf.reserve(flush_size + 4096);
+
+        auto& b = this->_buf;
+        const auto& x = viewport.x();
+        const auto& y = viewport.y();
+        if (format == plot_format::svg)
+        {
+            b += "<svg xmlns='http://www.w3.org/2000/svg' viewBox='";
+            this->_coord(x.lower());
+            b += ' ';
+            if constexpr (std::is_integral<T>::value)
+            {
+                detail::append_int(b, -static_cast<long long>(y.upper()));
+            }
+            else
+            {
+                this->_coord(-y.upper());
+            }
+            b += ' ';
+            this->_coord(x.len());
+            b += ' ';
+            this->_coord(y.len());
+            b += "' width='";
+            detail::append_int(b, (long long)this->_width_px);
+            b += "' height='";
+            detail::append_int(b, (long long)this->_height_px);
+            b += "'>\n<g transform='scale(1,-1)'>\n";
+        }
+        else
+        {
+            // about 16cm on the longer side
+            char tmp[64];
+            const auto n = std::snprintf(tmp, sizeof(tmp),
+                "\\begin{tikzpicture}[x=%gcm,y=%gcm]\n", 16.0 / side,
+                16.0 / side);
+            b.append(tmp, std::size_t(n));
+        }
+    }
+
+    plot_writer(const plot_writer&) = delete;
+    auto operator=(const plot_writer&) -> plot_writer& = delete;
+
+    /**
+     * @brief set fill and stroke colours of the following shapes
+     *
+     * @param fill e.g. "#88C0D0" or "none" (SVG), "blue!30" (TikZ)
+     * @param stroke
+     */
+    void style(const std::string& fill, const std::string& stroke = "none")
+    {
+        auto& b = this->_buf;
+        if (this->_format == plot_format::svg)
+        {
+            this->_close_group();
+            b += "<g fill='" + fill + "' stroke='" + stroke + "'>\n";
+            this->_in_group = true;
+        }
+        else
+        {
+            this->_style = "[fill=" + fill +
+                (stroke == "none" ? std::string {} : ",draw=" + stroke) + "]";
+        }
+    }
+
+    /**
+     * @brief add a rectangle
+     *
+     * @param r
+     */
+    void add(const rectangle<T>& r)
+    {
+        if (this->_visible(r))
+        {
+            this->_rect(r);
+        }
+    }
+
+    /**
+     * @brief add a rectilinear polygon given as an rpolygon pointset
+     *
+     * From pointset[i - 1] to pointset[i] the boundary runs horizontally,
+     * then vertically, as in rpolygon.
+     *
+     * @param pointset
+     */
+    void add_rpolygon(gsl::span<const point<T>> pointset)
+    {
+        if (pointset.empty() || !this->_visible(_bbox(pointset)))
+        {
+            return;
+        }
+        auto& b = this->_buf;
+        const auto& last = pointset[pointset.size() - 1];
+        if (this->_format == plot_format::svg)
+        {
+            b += "<path d='M";
+            this->_coord(last.x());
+            b += ' ';
+            this->_coord(last.y());
+            for (auto&& p : pointset)
+            {
+                b += 'H';
+                this->_coord(p.x());
+                b += 'V';
+                this->_coord(p.y());
+            }
+            b += "Z'/>\n";
+        }
+        else
+        {
+            this->_tikz_fill();
+            this->_point(last.x(), last.y());
+            for (auto&& p : pointset)
+            {
+                b += " -| ";
+                this->_point(p.x(), p.y());
+            }
+            b += " -- cycle;\n";
+        }
+        this->_done();
+    }
+
+    /**
+     * @brief add a general polygon given by its vertices
+     *
+     * @param points
+     */
+    void add_polygon(gsl::span<const point<T>> points)
+    {
+        if (points.empty() || !this->_visible(_bbox(points)))
+        {
+            return;
+        }
+        auto& b = this->_buf;
+        if (this->_format == plot_format::svg)
+        {
+            auto cmd = 'M';
+            b += "<path d='";
+            for (auto&& p : points)
+            {
+                b += cmd;
+                this->_coord(p.x());
+                b += ' ';
+                this->_coord(p.y());
+                cmd = 'L';
+            }
+            b += "Z'/>\n";
+        }
+        else
+        {
+            this->_tikz_fill();
+            for (auto&& p : points)
+            {
+                this->_point(p.x(), p.y());
+                b += " -- ";
+            }
+            b += "cycle;\n";
+        }
+        this->_done();
+    }
+
+    /**
+     * @brief add a horizontal segment
+     *
+     * @param s
+     */
+    void add(const hsegment<T>& s)
+    {
+        this->_segment(s.x().lower(), s.y(), s.x().upper(), s.y());
+    }
+
+    /**
+     * @brief add a vertical segment
+     *
+     * @param s
+     */
+    void add(const vsegment<T>& s)
+    {
+        this->_segment(s.x(), s.y().lower(), s.x(), s.y().upper());
+    }
+
+    /**
+     * @brief add every shape of a range
+     *
+     * @tparam Shape rectangle, hsegment or vsegment
+     * @param shapes
+     */
+    template <typename Shape>
+    void add_all(gsl::span<const Shape> shapes)
+    {
+        for (auto&& s : shapes)
+        {
+            this->add(s);
+        }
+    }
+
+    /**
+     * @brief write the trailer and flush
+     *
+     * @return true if the stream is still good
+     */
+    auto finish() -> bool
+    {
+        this->_close_group();
+        this->_buf += this->_format == plot_format::svg
+            ? "</g>\n</svg>\n"
+            : "\\end{tikzpicture}\n";
+        this->_flush();
+        this->_os.flush();
+        return bool(this->_os);
+    }
+
+    /**
+     * @brief number of shapes written (merged pixels included)
+     */
+    [[nodiscard]] auto written() const noexcept -> std::size_t
+    {
+        return this->_written;
+    }
+
+    /**
+     * @brief number of shapes dropped for lying outside the viewport
+     */
+    [[nodiscard]] auto culled() const noexcept -> std::size_t
+    {
+        return this->_culled;
+    }
+
+    /**
+     * @brief number of sub-pixel shapes folded into an already drawn pixel
+     */
+    [[nodiscard]] auto merged() const noexcept -> std::size_t
+    {
+        return this->_merged;
+    }
+
+  private:
+    static auto _bbox(gsl::span<const point<T>> pts) -> rectangle<T>
+    {
+        auto xl = pts[0].x();
+        auto xu = xl;
+        auto yl = pts[0].y();
+        auto yu = yl;
+        for (auto&& p : pts)
+        {
+            xl = std::min(xl, p.x());
+            xu = std::max(xu, p.x());
+            yl = std::min(yl, p.y());
+            yu = std::max(yu, p.y());
+        }
+        return {interval<T> {xl, xu}, interval<T> {yl, yu}};
+    }
+
+    void _tikz_fill()
+    {
+        this->_buf += "\\fill";
+        this->_buf += this->_style;
+        this->_buf += ' ';
+    }
+
+    void _coord(const T& v)
+    {
+        detail::append_coord(this->_buf, v);
+    }
+
+    void _point(const T& x, const T& y)
+    {
+        this->_buf += '(';
+        this->_coord(x);
+        this->_buf += ',';
+        this->_coord(y);
+        this->_buf += ')';
+    }
+
+    void _done()
+    {
+        ++this->_written;
+        if (this->_buf.size() >= flush_size)
+        {
+            this->_flush();
+        }
+    }
+
+    void _flush()
+    {
+        this->_os.write(this->_buf.data(), std::streamsize(this->_buf.size()));
+        this->_buf.clear();
+    }
+
+    void _close_group()
+    {
+        if (this->_in_group)
+        {
+            this->_buf += "</g>\n";
+            this->_in_group = false;
+        }
+    }
+
+    /**
+     * @brief cull, or merge a sub-pixel shape into its pixel
+     *
+     * @return true if the caller should draw the shape itself
+     */
+    auto _visible(const rectangle<T>& r) -> bool
+    {
+        if (!this->_view.overlaps(r))
+        {
+            ++this->_culled;
+            return false;
+        }
+        if (!(double(r.x().len()) < this->_pixel &&
+                double(r.y().len()) < this->_pixel))
+        {
+            return true;
+        }
+        const auto cx = double(r.x().lower() - this->_view.x().lower()) +
+            double(r.x().len()) / 2;
+        const auto cy = double(r.y().lower() - this->_view.y().lower()) +
+            double(r.y().len()) / 2;
+        const auto ix = std::min(this->_width_px - 1,
+            std::size_t(std::max(cx, 0.0) / this->_pixel));
+        const auto iy = std::min(this->_height_px - 1,
+            std::size_t(std::max(cy, 0.0) / this->_pixel));
+        const auto k = iy * this->_width_px + ix;
+        auto& word = this->_marked[k / 64];
+        const auto bit = std::uint64_t(1) << (k % 64);
+        if ((word & bit) != 0)
+        {
+            ++this->_merged;
+            return false;
+        }
+        word |= bit;
+        this->_pixel_square(ix, iy);
+        return false;
+    }
+
+    /**
+     * @brief draw one pixel-sized square (snapped outwards to T)
+     */
+    void _pixel_square(std::size_t ix, std::size_t iy)
+    {
+        auto snap = [](double v, bool up)
+        {
+            if constexpr (std::is_integral<T>::value)
+            {
+                return T(up ? std::ceil(v) : std::floor(v));
+            }
+            else
+            {
+                return T(v);
+            }
+        };
+        const auto& o = this->_view;
+        const auto p = this->_pixel;
+        const auto x0 = double(o.x().lower()) + double(ix) * p;
+        const auto y0 = double(o.y().lower()) + double(iy) * p;
+        const auto sq = rectangle<T> {
+            interval<T> {snap(x0, false), snap(x0 + p, true)},
+            interval<T> {snap(y0, false), snap(y0 + p, true)}};
+        this->_rect(sq);
+    }
+
+    void _rect(const rectangle<T>& r)
+    {
+        auto& b = this->_buf;
+        if (this->_format == plot_format::svg)
+        {
+            b += "<rect x='";
+            this->_coord(r.x().lower());
+            b += "' y='";
+            this->_coord(r.y().lower());
+            b += "' width='";
+            this->_coord(r.x().len());
+            b += "' height='";
+            this->_coord(r.y().len());
+            b += "'/>\n";
+        }
+        else
+        {
+            this->_tikz_fill();
+            this->_point(r.x().lower(), r.y().lower());
+            b += " rectangle ";
+            this->_point(r.x().upper(), r.y().upper());
+            b += ";\n";
+        }
+        this->_done();
+    }
+
+    void _segment(const T& x0, const T& y0, const T& x1, const T& y1)
+    {
+        const auto box = rectangle<T> {
+            interval<T> {x0, x1}, interval<T> {y0, y1}};
+        if (!this->_visible(box))
+        {
+            return;
+        }
+        auto& b = this->_buf;
+        if (this->_format == plot_format::svg)
+        {
+            b += "<path fill='none' stroke='black' d='M";
+            this->_coord(x0);
+            b += ' ';
+            this->_coord(y0);
+            b += x0 == x1 ? 'V' : 'H';
+            this->_coord(x0 == x1 ? y1 : x1);
+            b += "'/>\n";
+        }
+        else
+        {
+            b += "\\draw ";
+            this->_point(x0, y0);
+            b += " -- ";
+            this->_point(x1, y1);
+            b += ";\n";
+        }
+        this->_done();
+    }
+};
+
+} // namespace recti
@@ -4,6 +4,7 @@
 #include "recti.hpp"
 #include <algorithm>
 #include <gsl/span>
+#include <utility>
 #include <vector>
 
 namespace recti
@@ -37,6 +38,38 @@ class polygon
         }
     }
 
+    /**
+     * @brief Construct a new polygon object from its parts
+     *
+     * @param origin first vertex
+     * @param vecs the other vertices, relative to origin
+     */
+    constexpr polygon(const point<T>& origin, std::vector<vector2<T>> vecs)
+        : _origin {origin}
+        , _vecs {std::move(vecs)}
+    {
+    }
+
+    /**
+     * @brief first vertex; the others are stored relative to it
+     *
+     * @return const point<T>&
+     */
+    [[nodiscard]] constexpr auto origin() const noexcept -> const point<T>&
+    {
+        return this->_origin;
+    }
+
+    /**
+     * @brief vertices after the first, relative to origin()
+     *
+     * @return gsl::span<const vector2<T>>
+     */
+    [[nodiscard]] auto vecs() const noexcept -> gsl::span<const vector2<T>>
+    {
+        return this->_vecs;
+    }
+
     /**
      * @brief
      *
@@ -311,6 +311,22 @@ class point : boost::totally_ordered<point<T1, T2>,
 };
 #pragma pack(pop)
 
+/**
+ * @brief Manhattan (L1) distance between two points
+ *
+ * @tparam T
+ * @param a
+ * @param b
+ * @return T
+ */
+template <typename T>
+constexpr auto manhattan_distance(const point<T>& a, const point<T>& b) -> T
+{
+    auto dx = a.x() < b.x() ? b.x() - a.x() : a.x() - b.x();
+    auto dy = a.y() < b.y() ? b.y() - a.y() : a.y() - b.y();
+    return dx + dy;
+}
+
 /**
  * @brief 2D point
  *
@@ -497,6 +513,20 @@ class interval : boost::totally_ordered<interval<T>>
     {
         return !(a < this->lower() || this->upper() < a);
     }
+
+    /**
+     * @brief whether two closed intervals share at least one point
+     *
+     * @tparam U
+     * @param a
+     * @return true
+     * @return false
+     */
+    template <typename U>
+    [[nodiscard]] constexpr auto overlaps(const interval<U>& a) const -> bool
+    {
+        return !(a.upper() < this->lower() || this->upper() < a.lower());
+    }
 };
 #pragma pack(pop)
 
@@ -548,6 +578,18 @@ struct rectangle : point<interval<T>>
         return this->x().contains(rhs.x()) && this->y().contains(rhs.y());
     }
 
+    /**
+     * @brief whether two closed rectangles share at least one point
+     *
+     * @param rhs
+     * @return true
+     * @return false
+     */
+    [[nodiscard]] constexpr auto overlaps(const rectangle& rhs) const -> bool
+    {
+        return this->x().overlaps(rhs.x()) && this->y().overlaps(rhs.y());
+    }
+
     /**
      * @brief
      *
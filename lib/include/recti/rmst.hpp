@@ -0,0 +1,172 @@
+#pragma once
+
+#include "coordinate_map.hpp"
+#include "disjoint_set.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <gsl/span>
+#include <numeric>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Octant-partition neighbour graph (Guibas-Stolfi / Zhou)
+ *
+ * For every point, finds its L1-nearest neighbour in each of four octants
+ * (the other four are covered by symmetry, as the edges are undirected).
+ * Each octant pass transforms the coordinates so that the octant becomes
+ * { x' >= x, y' - x' >= y - x }, sweeps the points by decreasing x and
+ * keeps, in a Fenwick tree over the compressed keys y - x, the inserted
+ * point of minimum x + y for every suffix of keys. The resulting graph has
+ * at most 4n edges and contains a rectilinear minimum spanning tree.
+ *
+ * @tparam T
+ * @param pts
+ * @return std::vector<std::pair<std::uint32_t, std::uint32_t>>
+ */
+template <typename T>
+inline auto octant_neighbour_edges(gsl::span<const point<T>> pts)
+    -> std::vector<std::pair<std::uint32_t, std::uint32_t>>
+{
+    constexpr auto none = UINT32_MAX;
+    const auto n = pts.size();
+    assert(n < std::size_t(none));
+
+    auto xs = std::vector<T> {};
+    auto ys = std::vector<T> {};
+    xs.reserve(n);
+    ys.reserve(n);
+    for (auto&& p : pts)
+    {
+        xs.push_back(p.x());
+        ys.push_back(p.y());
+    }
+
+    auto edges = std::vector<std::pair<std::uint32_t, std::uint32_t>> {};
+    edges.reserve(4 * n);
+    auto idx = std::vector<std::uint32_t>(n);
+    auto keys = coordinate_map<T> {};
+    auto tree = std::vector<std::uint32_t> {};
+
+    for (auto dir = 0; dir != 4; ++dir)
+    {
+        if (dir % 2 == 1)
+        {
+            xs.swap(ys);
+        }
+        else if (dir == 2)
+        {
+            for (auto&& x : xs)
+            {
+                x = -x;
+            }
+        }
+
+        std::iota(idx.begin(), idx.end(), 0U);
+        std::sort(idx.begin(), idx.end(),
+            [&](auto a, auto b)
+            { return std::tie(xs[b], ys[b]) < std::tie(xs[a], ys[a]); });
+
+        {
+            auto ks = std::vector<T> {};
+            ks.reserve(n);
+            for (auto i = 0U; i != n; ++i)
+            {
+                ks.push_back(ys[i] - xs[i]);
+            }
+            keys = coordinate_map<T> {std::move(ks), 1};
+        }
+        const auto m = keys.size();
+
+        // tree[r] holds the best point among reversed key ranks in
+        // (r - lowbit(r), r]; reversing turns suffix queries into prefixes
+        tree.assign(m + 1, none);
+        auto better = [&](std::uint32_t a, std::uint32_t b)
+        {
+            if (b == none)
+            {
+                return true;
+            }
+            const auto sa = xs[a] + ys[a];
+            const auto sb = xs[b] + ys[b];
+            return sa < sb || (!(sb < sa) && a < b);
+        };
+
+        for (auto i : idx)
+        {
+            const auto k = std::size_t(keys.rank(ys[i] - xs[i]));
+            const auto r = m - k;
+            auto j = none;
+            for (auto p = r; p != 0; p -= p & (~p + 1))
+            {
+                if (tree[p] != none && better(tree[p], j))
+                {
+                    j = tree[p];
+                }
+            }
+            if (j != none)
+            {
+                edges.emplace_back(std::min(i, j), std::max(i, j));
+            }
+            for (auto p = r; p <= m; p += p & (~p + 1))
+            {
+                if (better(i, tree[p]))
+                {
+                    tree[p] = i;
+                }
+            }
+        }
+    }
+    return edges;
+}
+
+/**
+ * @brief Rectilinear minimum spanning tree in O(n log n)
+ *
+ * Runs Kruskal with union-find over the octant neighbour graph. Edges of
+ * equal length are taken in index order, so the result is deterministic.
+ *
+ * @tparam T
+ * @param pts
+ * @return std::vector<std::pair<std::size_t, std::size_t>> n - 1 edges over
+ * input indices (fewer if pts is empty)
+ */
+template <typename T>
+inline auto rmst(gsl::span<const point<T>> pts)
+    -> std::vector<std::pair<std::size_t, std::size_t>>
+{
+    auto cand = std::vector<std::tuple<T, std::uint32_t, std::uint32_t>> {};
+    for (auto&& [u, v] : octant_neighbour_edges(pts))
+    {
+        cand.emplace_back(manhattan_distance(pts[u], pts[v]), u, v);
+    }
+    std::sort(cand.begin(), cand.end());
+    cand.erase(std::unique(cand.begin(), cand.end()), cand.end());
+
+    auto res = std::vector<std::pair<std::size_t, std::size_t>> {};
+    if (pts.empty())
+    {
+        return res;
+    }
+    res.reserve(pts.size() - 1);
+    auto ds = disjoint_set {pts.size()};
+    for (auto&& [w, u, v] : cand)
+    {
+        if (ds.unite(u, v))
+        {
+            res.emplace_back(u, v);
+            if (res.size() + 1 == pts.size())
+            {
+                break;
+            }
+        }
+    }
+    return res;
+}
+
+} // namespace recti
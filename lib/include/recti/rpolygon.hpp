@@ -3,6 +3,7 @@
 #include "recti.hpp"
 #include <algorithm>
 #include <gsl/span>
+#include <utility>
 #include <vector>
 
 namespace recti
@@ -36,6 +37,38 @@ class rpolygon
         }
     }
 
+    /**
+     * @brief Construct a new rpolygon object from its parts
+     *
+     * @param origin first vertex
+     * @param vecs the other vertices, relative to origin
+     */
+    constexpr rpolygon(const point<T>& origin, std::vector<vector2<T>> vecs)
+        : _origin {origin}
+        , _vecs {std::move(vecs)}
+    {
+    }
+
+    /**
+     * @brief first vertex; the others are stored relative to it
+     *
+     * @return const point<T>&
+     */
+    [[nodiscard]] constexpr auto origin() const noexcept -> const point<T>&
+    {
+        return this->_origin;
+    }
+
+    /**
+     * @brief vertices after the first, relative to origin()
+     *
+     * @return gsl::span<const vector2<T>>
+     */
+    [[nodiscard]] auto vecs() const noexcept -> gsl::span<const vector2<T>>
+    {
+        return this->_vecs;
+    }
+
     /**
      * @brief
      *
@@ -246,4 +279,142 @@ inline auto point_in_rpolygon(gsl::span<const point<T>> S, const point<T>& q)
     return c;
 }
 
+namespace detail
+{
+
+/**
+ * @brief Maximal runs of the slabs cut by a set of parallel edges
+ *
+ * Each edge is (position, extent). Between consecutive edge end points the
+ * plane is cut into bands; within a band the edges that span it are
+ * paired up by even-odd parity into runs. A run that continues unchanged
+ * through consecutive bands is reported once, as fn(run, bands spanned).
+ *
+ * @tparam T
+ * @tparam Fn
+ * @param edges
+ * @param fn callable(const interval<T>& run, const interval<T>& band)
+ */
+template <typename T, typename Fn>
+inline void slab_runs(const std::vector<std::pair<T, interval<T>>>& edges,
+    Fn&& fn)
+{
+    auto bands = std::vector<T> {};
+    for (auto&& e : edges)
+    {
+        bands.push_back(e.second.lower());
+        bands.push_back(e.second.upper());
+    }
+    std::sort(bands.begin(), bands.end());
+    bands.erase(std::unique(bands.begin(), bands.end()), bands.end());
+
+    using open_run = std::pair<interval<T>, T>; // (run, first band)
+    auto open = std::vector<open_run> {};
+    auto next = std::vector<open_run> {};
+    auto cuts = std::vector<T> {};
+    for (auto k = 0U; k + 1 < bands.size(); ++k)
+    {
+        const auto& lo = bands[k];
+        const auto& hi = bands[k + 1];
+        cuts.clear();
+        for (auto&& e : edges)
+        {
+            if (!(lo < e.second.lower()) && !(e.second.upper() < hi))
+            {
+                cuts.push_back(e.first);
+            }
+        }
+        assert(cuts.size() % 2 == 0);
+        std::sort(cuts.begin(), cuts.end());
+        next.clear();
+        auto j = 0U;
+        for (auto c = 0U; c < cuts.size(); c += 2)
+        {
+            if (!(cuts[c] < cuts[c + 1]))
+            {
+                continue;
+            }
+            while (j != open.size() && open[j].first.lower() < cuts[c])
+            {
+                fn(open[j].first, interval<T> {open[j].second, lo});
+                ++j;
+            }
+            if (j != open.size() && open[j].first.lower() == cuts[c] &&
+                open[j].first.upper() == cuts[c + 1])
+            {
+                next.push_back(open[j++]);
+            }
+            else
+            {
+                next.emplace_back(interval<T> {cuts[c], cuts[c + 1]}, lo);
+            }
+        }
+        for (; j != open.size(); ++j)
+        {
+            fn(open[j].first, interval<T> {open[j].second, lo});
+        }
+        std::swap(open, next);
+    }
+    for (auto&& r : open)
+    {
+        fn(r.first, interval<T> {r.second, bands.back()});
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Decompose a rectilinear polygon into maximal slabs
+ *
+ * The polygon is given as its pointset S, where S[i - 1] and S[i] are
+ * joined by a horizontal step followed by a vertical one (the convention
+ * of point_in_rpolygon). With `vertical == false` the interior is cut into
+ * horizontal slabs: each slab is a maximal x-run between two vertical
+ * edges, extended over as many consecutive y-bands as the run stays the
+ * same; `vertical == true` gives the transposed decomposition. The slabs
+ * tile the polygon without overlapping interiors. O(n^2) for n points.
+ *
+ * @tparam T
+ * @param S
+ * @param vertical
+ * @return std::vector<rectangle<T>>
+ */
+template <typename T>
+inline auto rpolygon_slabs(gsl::span<const point<T>> S, bool vertical = false)
+    -> std::vector<rectangle<T>>
+{
+    auto edges = std::vector<std::pair<T, interval<T>>> {};
+    auto p0 = S.back();
+    for (auto&& p1 : S)
+    {
+        if (!vertical && p0.y() != p1.y())
+        {
+            edges.emplace_back(p1.x(),
+                interval<T> {
+                    std::min(p0.y(), p1.y()), std::max(p0.y(), p1.y())});
+        }
+        if (vertical && p0.x() != p1.x())
+        {
+            edges.emplace_back(p0.y(),
+                interval<T> {
+                    std::min(p0.x(), p1.x()), std::max(p0.x(), p1.x())});
+        }
+        p0 = p1;
+    }
+    auto res = std::vector<rectangle<T>> {};
+    detail::slab_runs(edges,
+        [&](const interval<T>& run, const interval<T>& band)
+        {
+            if (vertical)
+            {
+                res.emplace_back(band, run);
+            }
+            else
+            {
+                res.emplace_back(run, band);
+            }
+        });
+    return res;
+}
+
 } // namespace recti
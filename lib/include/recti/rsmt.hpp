@@ -0,0 +1,514 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "recti.hpp"
+#include "rmst.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <gsl/span>
+#include <numeric>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Rectilinear Steiner tree of a net
+ *
+ * Tree nodes are numbered with the pins first (0 .. n - 1, the input
+ * order of the net) followed by the Steiner points (n, n + 1, ...). Every
+ * edge is drawn as an L-shape: horizontally from its first node, then
+ * vertically into its second node.
+ *
+ * @tparam T
+ */
+template <typename T>
+struct steiner_tree
+{
+    std::vector<point<T>> steiner_points;
+    std::vector<std::pair<std::size_t, std::size_t>> edges;
+    std::vector<hsegment<T>> hsegments;
+    std::vector<vsegment<T>> vsegments;
+    T length {0};
+};
+
+namespace detail
+{
+
+/**
+ * @brief Fill in the segments and the length of a steiner_tree
+ *
+ * @tparam T
+ * @param pins
+ * @param tree
+ */
+template <typename T>
+inline void finish_steiner_tree(
+    gsl::span<const point<T>> pins, steiner_tree<T>& tree)
+{
+    const auto n = pins.size();
+    auto node = [&](std::size_t i) -> const point<T>&
+    { return i < n ? pins[i] : tree.steiner_points[i - n]; };
+
+    tree.length = T(0);
+    for (auto&& [a, b] : tree.edges)
+    {
+        const auto& p = node(a);
+        const auto& q = node(b);
+        tree.length += manhattan_distance(p, q);
+        if (p.x() != q.x())
+        {
+            tree.hsegments.emplace_back(
+                interval<T> {std::min(p.x(), q.x()), std::max(p.x(), q.x())},
+                p.y());
+        }
+        if (p.y() != q.y())
+        {
+            tree.vsegments.emplace_back(q.x(),
+                interval<T> {std::min(p.y(), q.y()), std::max(p.y(), q.y())});
+        }
+    }
+}
+
+} // namespace detail
+
+/**
+ * @brief Exact rectilinear Steiner minimum tree for small nets
+ *
+ * Dreyfus-Wagner dynamic programming over the Hanan grid (an optimal tree
+ * exists on it, by Hanan's theorem). The relaxation step of every terminal
+ * subset is an L1 distance transform on the grid (two passes per axis), so
+ * the cost is O(3^k k^2) for k distinct pin locations. Intended for nets of
+ * up to about 9 pins.
+ *
+ * @tparam T
+ * @param pins
+ * @return steiner_tree<T>
+ */
+template <typename T>
+inline auto rsmt_exact(gsl::span<const point<T>> pins) -> steiner_tree<T>
+{
+    auto tree = steiner_tree<T> {};
+
+    // distinct pin locations, each represented by its first pin
+    auto order = std::vector<std::uint32_t>(pins.size());
+    std::iota(order.begin(), order.end(), 0U);
+    std::stable_sort(order.begin(), order.end(),
+        [&](auto a, auto b) { return pins[a] < pins[b]; });
+    order.erase(std::unique(order.begin(), order.end(),
+                    [&](auto a, auto b) { return pins[a] == pins[b]; }),
+        order.end());
+    const auto k = order.size();
+    assert(k <= 16);
+    if (k <= 1)
+    {
+        return tree;
+    }
+
+    auto xs = std::vector<T> {};
+    auto ys = std::vector<T> {};
+    for (auto i : order)
+    {
+        xs.push_back(pins[i].x());
+        ys.push_back(pins[i].y());
+    }
+    std::sort(xs.begin(), xs.end());
+    xs.erase(std::unique(xs.begin(), xs.end()), xs.end());
+    std::sort(ys.begin(), ys.end());
+    ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+    const auto nx = xs.size();
+    const auto ny = ys.size();
+    const auto nv = nx * ny;
+    auto coord = [&](std::size_t v) -> point<T>
+    { return {xs[v % nx], ys[v / nx]}; };
+
+    auto term = std::vector<std::size_t> {}; // Hanan node of each terminal
+    auto pin_of = std::vector<std::size_t>(nv, pins.size());
+    for (auto i : order)
+    {
+        const auto ix = std::size_t(
+            std::lower_bound(xs.begin(), xs.end(), pins[i].x()) - xs.begin());
+        const auto iy = std::size_t(
+            std::lower_bound(ys.begin(), ys.end(), pins[i].y()) - ys.begin());
+        term.push_back(iy * nx + ix);
+        pin_of[iy * nx + ix] = i;
+    }
+
+    // terminal k - 1 is the root; subsets range over the other k - 1
+    const auto full = (std::size_t(1) << (k - 1)) - 1;
+    auto cost = std::vector<T>((full + 1) * nv, T(0));
+    auto from = std::vector<std::uint16_t>((full + 1) * nv, 0);
+    auto split = std::vector<std::uint16_t>((full + 1) * nv, 0);
+
+    // dp[S][v] = min_u g[u] + |u - v|_1, as a separable transform
+    auto transform = [&](std::size_t S)
+    {
+        auto* d = &cost[S * nv];
+        auto* src = &from[S * nv];
+        auto relax = [&](std::size_t a, std::size_t b, const T& step)
+        {
+            if (d[b] + step < d[a])
+            {
+                d[a] = d[b] + step;
+                src[a] = src[b];
+            }
+        };
+        for (auto iy = 0U; iy != ny; ++iy)
+        {
+            const auto row = iy * nx;
+            for (auto ix = 1U; ix < nx; ++ix)
+            {
+                relax(row + ix, row + ix - 1, xs[ix] - xs[ix - 1]);
+            }
+            for (auto ix = nx - 1; ix-- > 0;)
+            {
+                relax(row + ix, row + ix + 1, xs[ix + 1] - xs[ix]);
+            }
+        }
+        for (auto ix = 0U; ix != nx; ++ix)
+        {
+            for (auto iy = 1U; iy < ny; ++iy)
+            {
+                relax(iy * nx + ix, (iy - 1) * nx + ix, ys[iy] - ys[iy - 1]);
+            }
+            for (auto iy = ny - 1; iy-- > 0;)
+            {
+                relax(iy * nx + ix, (iy + 1) * nx + ix, ys[iy + 1] - ys[iy]);
+            }
+        }
+    };
+
+    for (auto t = 0U; t + 1 < k; ++t)
+    {
+        const auto S = std::size_t(1) << t;
+        for (auto v = 0U; v != nv; ++v)
+        {
+            cost[S * nv + v] = manhattan_distance(coord(term[t]), coord(v));
+            from[S * nv + v] = std::uint16_t(term[t]);
+        }
+    }
+    for (auto S = std::size_t(1); S <= full; ++S)
+    {
+        if ((S & (S - 1)) == 0)
+        {
+            continue; // singleton
+        }
+        const auto low = S & (~S + 1);
+        auto* best = &cost[S * nv];
+        auto* best_S1 = &split[S * nv];
+        auto first = true;
+        // submask outer, node inner: contiguous rows for the compiler
+        for (auto S1 = (S - 1) & S; S1 != 0; S1 = (S1 - 1) & S)
+        {
+            if ((S1 & low) == 0)
+            {
+                continue; // each split once
+            }
+            const auto* c1 = &cost[S1 * nv];
+            const auto* c2 = &cost[(S ^ S1) * nv];
+            for (auto u = 0U; u != nv; ++u)
+            {
+                const auto c = c1[u] + c2[u];
+                if (first || c < best[u])
+                {
+                    best[u] = c;
+                    best_S1[u] = std::uint16_t(S1);
+                }
+            }
+            first = false;
+        }
+        for (auto u = 0U; u != nv; ++u)
+        {
+            from[S * nv + u] = std::uint16_t(u);
+        }
+        transform(S);
+    }
+
+    // reconstruct
+    auto node_id = std::vector<std::size_t>(nv, SIZE_MAX);
+    auto id_of = [&](std::size_t v) -> std::size_t
+    {
+        if (pin_of[v] != pins.size())
+        {
+            return pin_of[v];
+        }
+        if (node_id[v] == SIZE_MAX)
+        {
+            node_id[v] = pins.size() + tree.steiner_points.size();
+            tree.steiner_points.push_back(coord(v));
+        }
+        return node_id[v];
+    };
+    auto stack = std::vector<std::pair<std::size_t, std::size_t>> {
+        {full, term[k - 1]}};
+    while (!stack.empty())
+    {
+        auto [S, v] = stack.back();
+        stack.pop_back();
+        const auto u = std::size_t(from[S * nv + v]);
+        if (u != v)
+        {
+            const auto a = id_of(u);
+            tree.edges.emplace_back(a, id_of(v));
+        }
+        if ((S & (S - 1)) != 0)
+        {
+            const auto S1 = std::size_t(split[S * nv + u]);
+            stack.emplace_back(S1, u);
+            stack.emplace_back(S ^ S1, u);
+        }
+    }
+    detail::finish_steiner_tree(pins, tree);
+    return tree;
+}
+
+/**
+ * @brief Heuristic rectilinear Steiner tree for large nets
+ *
+ * Starts from the rectilinear MST and repeatedly substitutes pairs of
+ * edges (u, v), (u, w) that share a node by a Steiner point at the median
+ * of u, v and w (a restricted 1-Steiner move). Every round evaluates the
+ * gain of all adjacent edge pairs, then applies the positive ones greedily
+ * by decreasing gain as long as they touch disjoint edges, so each round
+ * costs O(n log n). Degree-2 Steiner points are removed at the end.
+ *
+ * @tparam T
+ * @param pins
+ * @return steiner_tree<T>
+ */
+template <typename T>
+inline auto rsmt_heuristic(gsl::span<const point<T>> pins) -> steiner_tree<T>
+{
+    const auto n = pins.size();
+    auto tree = steiner_tree<T> {};
+    auto nodes = std::vector<point<T>>(pins.begin(), pins.end());
+    auto edges = std::vector<std::pair<std::uint32_t, std::uint32_t>> {};
+    for (auto&& [u, v] : rmst(pins))
+    {
+        edges.emplace_back(std::uint32_t(u), std::uint32_t(v));
+    }
+
+    auto start = std::vector<std::uint32_t> {};
+    auto incident = std::vector<std::uint32_t> {};
+    auto build_incidence = [&]()
+    {
+        start.assign(nodes.size() + 1, 0);
+        for (auto&& [a, b] : edges)
+        {
+            ++start[a + 1];
+            ++start[b + 1];
+        }
+        for (auto i = 0U; i != nodes.size(); ++i)
+        {
+            start[i + 1] += start[i];
+        }
+        incident.resize(2 * edges.size());
+        auto pos = std::vector<std::uint32_t>(start.begin(), start.end() - 1);
+        for (auto e = 0U; e != edges.size(); ++e)
+        {
+            incident[pos[edges[e].first]++] = e;
+            incident[pos[edges[e].second]++] = e;
+        }
+    };
+    auto median = [](const T& a, const T& b, const T& c) -> T
+    { return std::max(std::min(a, b), std::min(std::max(a, b), c)); };
+
+    // (gain, u, e1, e2)
+    using move = std::tuple<T, std::uint32_t, std::uint32_t, std::uint32_t>;
+    auto moves = std::vector<move> {};
+    auto used = std::vector<bool> {};
+    while (true)
+    {
+        build_incidence();
+        moves.clear();
+        for (auto u = 0U; u != nodes.size(); ++u)
+        {
+            for (auto i = start[u]; i != start[u + 1]; ++i)
+            {
+                for (auto j = i + 1; j != start[u + 1]; ++j)
+                {
+                    const auto e1 = incident[i];
+                    const auto e2 = incident[j];
+                    const auto& pu = nodes[u];
+                    const auto& pv = nodes[edges[e1].first ^
+                        edges[e1].second ^ u];
+                    const auto& pw = nodes[edges[e2].first ^
+                        edges[e2].second ^ u];
+                    const auto m = point<T> {median(pu.x(), pv.x(), pw.x()),
+                        median(pu.y(), pv.y(), pw.y())};
+                    const auto gain = manhattan_distance(pu, pv) +
+                        manhattan_distance(pu, pw) -
+                        manhattan_distance(m, pu) - manhattan_distance(m, pv) -
+                        manhattan_distance(m, pw);
+                    if (T(0) < gain)
+                    {
+                        moves.emplace_back(gain, u, e1, e2);
+                    }
+                }
+            }
+        }
+        if (moves.empty())
+        {
+            break;
+        }
+        std::sort(moves.begin(), moves.end(),
+            [](const move& a, const move& b)
+            {
+                return std::get<0>(b) < std::get<0>(a) ||
+                    (!(std::get<0>(a) < std::get<0>(b)) &&
+                        std::tie(std::get<1>(a), std::get<2>(a),
+                            std::get<3>(a)) < std::tie(std::get<1>(b),
+                                                  std::get<2>(b),
+                                                  std::get<3>(b)));
+            });
+        used.assign(edges.size(), false);
+        for (auto&& [gain, u, e1, e2] : moves)
+        {
+            if (used[e1] || used[e2])
+            {
+                continue;
+            }
+            used[e1] = used[e2] = true;
+            const auto v = edges[e1].first ^ edges[e1].second ^ u;
+            const auto w = edges[e2].first ^ edges[e2].second ^ u;
+            const auto m = point<T> {
+                median(nodes[u].x(), nodes[v].x(), nodes[w].x()),
+                median(nodes[u].y(), nodes[v].y(), nodes[w].y())};
+            auto s = std::uint32_t(nodes.size());
+            for (auto c : {u, v, w})
+            {
+                if (nodes[c] == m)
+                {
+                    s = c;
+                }
+            }
+            if (s == nodes.size())
+            {
+                nodes.push_back(m);
+            }
+            edges[e1] = {s, v};
+            edges[e2] = {s, w};
+            edges.emplace_back(s, u);
+        }
+        edges.erase(std::remove_if(edges.begin(), edges.end(),
+                        [](const auto& e) { return e.first == e.second; }),
+            edges.end());
+        assert(edges.size() + 1 == nodes.size());
+    }
+
+    // splice out Steiner points of degree <= 2
+    build_incidence();
+    auto alive = std::vector<bool>(edges.size(), true);
+    for (auto s = std::uint32_t(n); s != nodes.size(); ++s)
+    {
+        auto nbr = std::vector<std::uint32_t> {};
+        for (auto i = start[s]; i != start[s + 1]; ++i)
+        {
+            if (alive[incident[i]])
+            {
+                nbr.push_back(incident[i]);
+            }
+        }
+        if (nbr.size() == 1)
+        {
+            alive[nbr[0]] = false;
+        }
+        else if (nbr.size() == 2)
+        {
+            // reuse the first edge; endpoints keep their incidence slot
+            auto& e = edges[nbr[0]];
+            auto other = edges[nbr[1]].first ^ edges[nbr[1]].second ^ s;
+            e = {e.first ^ e.second ^ s, other};
+            alive[nbr[1]] = false;
+            for (auto i = start[other]; i != start[other + 1]; ++i)
+            {
+                if (incident[i] == nbr[1])
+                {
+                    incident[i] = nbr[0];
+                }
+            }
+        }
+    }
+
+    auto new_id = std::vector<std::size_t>(nodes.size(), SIZE_MAX);
+    for (auto i = 0U; i != n; ++i)
+    {
+        new_id[i] = i;
+    }
+    for (auto e = 0U; e != edges.size(); ++e)
+    {
+        if (!alive[e])
+        {
+            continue;
+        }
+        for (auto c : {edges[e].first, edges[e].second})
+        {
+            if (new_id[c] == SIZE_MAX)
+            {
+                new_id[c] = n + tree.steiner_points.size();
+                tree.steiner_points.push_back(nodes[c]);
+            }
+        }
+        tree.edges.emplace_back(
+            new_id[edges[e].first], new_id[edges[e].second]);
+    }
+    detail::finish_steiner_tree(pins, tree);
+    return tree;
+}
+
+/**
+ * @brief Rectilinear Steiner minimum tree of a net
+ *
+ * Exact for nets with at most `exact_limit` pins, heuristic otherwise.
+ *
+ * @tparam T
+ * @param pins
+ * @param exact_limit
+ * @return steiner_tree<T>
+ */
+template <typename T>
+inline auto rsmt(gsl::span<const point<T>> pins, std::size_t exact_limit = 9)
+    -> steiner_tree<T>
+{
+    assert(exact_limit <= 16);
+    if (pins.size() <= exact_limit)
+    {
+        return rsmt_exact(pins);
+    }
+    return rsmt_heuristic(pins);
+}
+
+/**
+ * @brief Steiner trees of many nets, computed in parallel
+ *
+ * The pins of net i are pins[net_start[i]] .. pins[net_start[i + 1] - 1].
+ *
+ * @tparam T
+ * @param pins
+ * @param net_start CSR offsets (number of nets + 1 entries)
+ * @param exact_limit
+ * @param num_threads (0 = hardware concurrency)
+ * @return std::vector<steiner_tree<T>>
+ */
+template <typename T>
+inline auto rsmt_batch(gsl::span<const point<T>> pins,
+    gsl::span<const std::size_t> net_start, std::size_t exact_limit = 9,
+    unsigned num_threads = 0) -> std::vector<steiner_tree<T>>
+{
+    const auto num_nets = net_start.empty() ? 0 : net_start.size() - 1;
+    auto res = std::vector<steiner_tree<T>>(num_nets);
+    parallel_for(
+        num_nets,
+        [&](std::size_t i)
+        {
+            res[i] = rsmt(pins.subspan(net_start[i],
+                              net_start[i + 1] - net_start[i]),
+                exact_limit);
+        },
+        num_threads);
+    return res;
+}
+
+} // namespace recti
@@ -0,0 +1,788 @@
+#pragma once
+
+#include "recti.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <gsl/span>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief Dynamic R*-tree over rectangles with stable ids
+ *
+ * Follows Beckmann et al.: the subtree is chosen by least overlap
+ * enlargement just above the leaves and by least area enlargement
+ * higher up; a node that overflows for the first time on a level during
+ * one insertion gives up its M * 3 / 10 entries farthest from its centre,
+ * which are then reinserted; otherwise it is split along the axis with
+ * the least margin sum, at the distribution with the least overlap.
+ * Removal condenses the path and reinserts the entries of underfull
+ * nodes at their level.
+ *
+ * Nodes live in one arena (a vector plus a free list) and store their
+ * entries as coordinate arrays, so no node is allocated on its own. For
+ * placement, move_all() updates a shape in place when its leaf's bounding
+ * box still contains the new geometry and only reinserts the others.
+ *
+ * Queries do not modify the tree and may run concurrently, but not
+ * together with edits.
+ *
+ * @tparam T
+ * @tparam M maximum number of entries per node
+ */
+template <typename T, unsigned M = 16>
+class rstar_tree
+{
+    static_assert(M >= 4, "nodes need room for two entries per half");
+
+  public:
+    static constexpr auto npos = UINT32_MAX;
+
+  private:
+    static constexpr auto _min_fill = std::max(2U, M * 2 / 5);
+    static constexpr auto _num_reinsert = std::max(1U, M * 3 / 10);
+
+    struct entry
+    {
+        rectangle<T> rect;
+        std::uint32_t child; // node, or shape id in a leaf
+    };
+
+    struct node
+    {
+        // one spare slot so that an overflowing entry fits before the
+        // overflow is treated
+        std::array<T, M + 1> xl;
+        std::array<T, M + 1> xh;
+        std::array<T, M + 1> yl;
+        std::array<T, M + 1> yh;
+        std::array<std::uint32_t, M + 1> child;
+        std::uint32_t parent;
+        std::uint16_t count;
+        std::uint16_t level; // 0 = leaf
+    };
+
+    std::vector<node> _nodes;
+    std::vector<std::uint32_t> _free;
+    std::uint32_t _root;
+    std::vector<rectangle<T>> _rects;   // per id
+    std::vector<std::uint32_t> _leaf;   // per id, npos when removed
+    std::size_t _size {0};
+    std::vector<bool> _reinserted; // per level, during one insertion
+
+  public:
+    /**
+     * @brief Construct an empty tree
+     *
+     */
+    rstar_tree()
+        : _root {0}
+    {
+        this->_root = this->_alloc(0);
+    }
+
+    /**
+     * @brief number of shapes in the tree
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return this->_size;
+    }
+
+    /**
+     * @brief number of levels (1 for a single leaf)
+     *
+     * @return unsigned
+     */
+    [[nodiscard]] auto height() const -> unsigned
+    {
+        return unsigned(this->_nodes[this->_root].level) + 1;
+    }
+
+    /**
+     * @brief number of nodes in use
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto num_nodes() const noexcept -> std::size_t
+    {
+        return this->_nodes.size() - this->_free.size();
+    }
+
+    /**
+     * @brief whether an id refers to a shape in the tree
+     *
+     * @param id
+     * @return true
+     * @return false
+     */
+    [[nodiscard]] auto contains(std::uint32_t id) const -> bool
+    {
+        return id < this->_leaf.size() && this->_leaf[id] != npos;
+    }
+
+    /**
+     * @brief current geometry of a shape
+     *
+     * @param id
+     * @return const rectangle<T>&
+     */
+    [[nodiscard]] auto shape(std::uint32_t id) const -> const rectangle<T>&
+    {
+        return this->_rects[id];
+    }
+
+    /**
+     * @brief Insert a shape
+     *
+     * @param r
+     * @return std::uint32_t its id
+     */
+    auto insert(const rectangle<T>& r) -> std::uint32_t
+    {
+        assert(this->_rects.size() < std::size_t(npos));
+        const auto id = std::uint32_t(this->_rects.size());
+        this->_rects.push_back(r);
+        this->_leaf.push_back(npos);
+        this->_insert_item(id);
+        return id;
+    }
+
+    /**
+     * @brief Remove a shape
+     *
+     * @param id
+     */
+    void remove(std::uint32_t id)
+    {
+        assert(this->contains(id));
+        this->_remove_item(id);
+    }
+
+    /**
+     * @brief Move (or resize) a shape
+     *
+     * @param id
+     * @param r new geometry
+     * @return true if it was updated in place
+     */
+    auto move(std::uint32_t id, const rectangle<T>& r) -> bool
+    {
+        assert(this->contains(id));
+        this->_rects[id] = r;
+        if (this->_update_in_place(id))
+        {
+            return true;
+        }
+        this->_remove_item(id);
+        this->_insert_item(id);
+        return false;
+    }
+
+    /**
+     * @brief Move a batch of shapes
+     *
+     * Small displacements that stay inside the shape's leaf box are
+     * applied in place first; the remaining shapes are all removed and
+     * then reinserted, so that they see the final neighbourhood.
+     *
+     * @param moves (id, new geometry) pairs with distinct ids
+     * @return std::size_t number of shapes updated in place
+     */
+    auto move_all(gsl::span<const std::pair<std::uint32_t, rectangle<T>>> moves)
+        -> std::size_t
+    {
+        auto deferred = std::vector<std::uint32_t> {};
+        for (auto&& [id, r] : moves)
+        {
+            assert(this->contains(id));
+            this->_rects[id] = r;
+            if (!this->_update_in_place(id))
+            {
+                deferred.push_back(id);
+            }
+        }
+        for (auto id : deferred)
+        {
+            this->_remove_item(id);
+        }
+        for (auto id : deferred)
+        {
+            this->_insert_item(id);
+        }
+        return moves.size() - deferred.size();
+    }
+
+    /**
+     * @brief Call fn(id) for every shape overlapping the window
+     *
+     * @tparam Fn
+     * @param window closed query window
+     * @param fn callable(std::uint32_t)
+     */
+    template <typename Fn>
+    void query(const rectangle<T>& window, Fn&& fn) const
+    {
+        this->_query(this->_root, window, fn);
+    }
+
+    /**
+     * @brief ids of all shapes overlapping the window
+     *
+     * @param window closed query window
+     * @return std::vector<std::uint32_t>
+     */
+    [[nodiscard]] auto query(const rectangle<T>& window) const
+        -> std::vector<std::uint32_t>
+    {
+        auto res = std::vector<std::uint32_t> {};
+        this->query(window, [&res](std::uint32_t id) { res.push_back(id); });
+        return res;
+    }
+
+    /**
+     * @brief Check the structural invariants (for testing)
+     *
+     * Every entry box contains its subtree, every non-root node is at
+     * least 40% full, all leaves are on level 0, and the id-to-leaf map
+     * agrees with the leaves.
+     *
+     * @return true
+     * @return false
+     */
+    [[nodiscard]] auto valid() const -> bool
+    {
+        auto items = std::size_t(0);
+        auto ok = this->_valid(this->_root, npos, items);
+        for (auto id = std::uint32_t(0); id != this->_leaf.size(); ++id)
+        {
+            const auto n = this->_leaf[id];
+            if (n == npos)
+            {
+                continue;
+            }
+            const auto& nd = this->_nodes[n];
+            ok = ok && nd.level == 0 &&
+                std::find(nd.child.begin(), nd.child.begin() + nd.count,
+                    id) != nd.child.begin() + nd.count;
+        }
+        return ok && items == this->_size;
+    }
+
+  private:
+    [[nodiscard]] static auto _area(const rectangle<T>& r) -> double
+    {
+        return double(r.x().len()) * double(r.y().len());
+    }
+
+    [[nodiscard]] static auto _margin(const rectangle<T>& r) -> double
+    {
+        return double(r.x().len()) + double(r.y().len());
+    }
+
+    [[nodiscard]] static auto _cover(
+        const rectangle<T>& a, const rectangle<T>& b) -> rectangle<T>
+    {
+        return {interval<T> {std::min(a.x().lower(), b.x().lower()),
+                    std::max(a.x().upper(), b.x().upper())},
+            interval<T> {std::min(a.y().lower(), b.y().lower()),
+                std::max(a.y().upper(), b.y().upper())}};
+    }
+
+    [[nodiscard]] static auto _overlap(
+        const rectangle<T>& a, const rectangle<T>& b) -> double
+    {
+        const auto w = std::min(a.x().upper(), b.x().upper()) -
+            std::max(a.x().lower(), b.x().lower());
+        const auto h = std::min(a.y().upper(), b.y().upper()) -
+            std::max(a.y().lower(), b.y().lower());
+        return w > T(0) && h > T(0) ? double(w) * double(h) : 0.0;
+    }
+
+    [[nodiscard]] static auto _contains(
+        const rectangle<T>& a, const rectangle<T>& b) -> bool
+    {
+        return a.x().contains(b.x()) && a.y().contains(b.y());
+    }
+
+    [[nodiscard]] auto _rect(std::uint32_t n, unsigned k) const
+        -> rectangle<T>
+    {
+        const auto& nd = this->_nodes[n];
+        return {interval<T> {nd.xl[k], nd.xh[k]},
+            interval<T> {nd.yl[k], nd.yh[k]}};
+    }
+
+    void _set_rect(std::uint32_t n, unsigned k, const rectangle<T>& r)
+    {
+        auto& nd = this->_nodes[n];
+        nd.xl[k] = r.x().lower();
+        nd.xh[k] = r.x().upper();
+        nd.yl[k] = r.y().lower();
+        nd.yh[k] = r.y().upper();
+    }
+
+    [[nodiscard]] auto _mbr(std::uint32_t n) const -> rectangle<T>
+    {
+        const auto& nd = this->_nodes[n];
+        assert(nd.count != 0);
+        auto res = this->_rect(n, 0);
+        for (auto k = 1U; k != nd.count; ++k)
+        {
+            res = _cover(res, this->_rect(n, k));
+        }
+        return res;
+    }
+
+    auto _alloc(std::uint16_t level) -> std::uint32_t
+    {
+        auto n = std::uint32_t(0);
+        if (!this->_free.empty())
+        {
+            n = this->_free.back();
+            this->_free.pop_back();
+        }
+        else
+        {
+            n = std::uint32_t(this->_nodes.size());
+            this->_nodes.emplace_back();
+        }
+        auto& nd = this->_nodes[n];
+        nd.parent = npos;
+        nd.count = 0;
+        nd.level = level;
+        return n;
+    }
+
+    void _release(std::uint32_t n)
+    {
+        this->_nodes[n].count = 0;
+        this->_free.push_back(n);
+    }
+
+    /**
+     * @brief append an entry and point its child back at the node
+     */
+    void _append(std::uint32_t n, const entry& e)
+    {
+        auto& nd = this->_nodes[n];
+        assert(nd.count <= M);
+        const auto k = nd.count++;
+        nd.child[k] = e.child;
+        this->_set_rect(n, k, e.rect);
+        if (nd.level == 0)
+        {
+            this->_leaf[e.child] = n;
+        }
+        else
+        {
+            this->_nodes[e.child].parent = n;
+        }
+    }
+
+    void _erase_slot(std::uint32_t n, unsigned k)
+    {
+        auto& nd = this->_nodes[n];
+        const auto last = nd.count - 1U;
+        nd.child[k] = nd.child[last];
+        nd.xl[k] = nd.xl[last];
+        nd.xh[k] = nd.xh[last];
+        nd.yl[k] = nd.yl[last];
+        nd.yh[k] = nd.yh[last];
+        --nd.count;
+    }
+
+    [[nodiscard]] auto _slot(std::uint32_t n, std::uint32_t child) const
+        -> unsigned
+    {
+        const auto& nd = this->_nodes[n];
+        const auto it =
+            std::find(nd.child.begin(), nd.child.begin() + nd.count, child);
+        assert(it != nd.child.begin() + nd.count);
+        return unsigned(it - nd.child.begin());
+    }
+
+    [[nodiscard]] auto _entries(std::uint32_t n) const -> std::vector<entry>
+    {
+        auto res = std::vector<entry> {};
+        for (auto k = 0U; k != this->_nodes[n].count; ++k)
+        {
+            res.push_back(entry {this->_rect(n, k), this->_nodes[n].child[k]});
+        }
+        return res;
+    }
+
+    /**
+     * @brief recompute the parent entries of n and its ancestors, stopping
+     * as soon as a box does not change
+     */
+    void _adjust_up(std::uint32_t n)
+    {
+        while (n != this->_root)
+        {
+            const auto p = this->_nodes[n].parent;
+            const auto k = this->_slot(p, n);
+            const auto r = this->_mbr(n);
+            if (this->_rect(p, k) == r)
+            {
+                return;
+            }
+            this->_set_rect(p, k, r);
+            n = p;
+        }
+    }
+
+    [[nodiscard]] auto _update_in_place(std::uint32_t id) -> bool
+    {
+        const auto n = this->_leaf[id];
+        const auto& r = this->_rects[id];
+        if (n != this->_root)
+        {
+            const auto p = this->_nodes[n].parent;
+            if (!_contains(this->_rect(p, this->_slot(p, n)), r))
+            {
+                return false;
+            }
+        }
+        this->_set_rect(n, this->_slot(n, id), r);
+        return true;
+    }
+
+    void _insert_item(std::uint32_t id)
+    {
+        this->_reinserted.assign(this->height() + 1, false);
+        this->_insert(entry {this->_rects[id], id}, 0);
+        ++this->_size;
+    }
+
+    void _remove_item(std::uint32_t id)
+    {
+        const auto n = this->_leaf[id];
+        this->_erase_slot(n, this->_slot(n, id));
+        this->_leaf[id] = npos;
+        --this->_size;
+        this->_condense(n);
+    }
+
+    /**
+     * @brief descend from the root to a node on `level` for a new entry
+     */
+    [[nodiscard]] auto _choose(const rectangle<T>& r, unsigned level) const
+        -> std::uint32_t
+    {
+        auto n = this->_root;
+        while (this->_nodes[n].level > level)
+        {
+            const auto& nd = this->_nodes[n];
+            auto best = 0U;
+            auto best_cost = std::array<double, 3> {};
+            for (auto k = 0U; k != nd.count; ++k)
+            {
+                const auto e = this->_rect(n, k);
+                const auto grown = _cover(e, r);
+                auto cost = std::array<double, 3> {
+                    0.0, _area(grown) - _area(e), _area(e)};
+                if (nd.level == 1)
+                {
+                    for (auto j = 0U; j != nd.count; ++j)
+                    {
+                        if (j != k)
+                        {
+                            const auto o = this->_rect(n, j);
+                            cost[0] += _overlap(grown, o) - _overlap(e, o);
+                        }
+                    }
+                }
+                if (k == 0 || cost < best_cost)
+                {
+                    best = k;
+                    best_cost = cost;
+                }
+            }
+            n = nd.child[best];
+        }
+        return n;
+    }
+
+    void _insert(const entry& e, unsigned level)
+    {
+        const auto n = this->_choose(e.rect, level);
+        this->_append(n, e);
+        // an insertion only grows the boxes on the path
+        for (auto c = n; c != this->_root;)
+        {
+            const auto p = this->_nodes[c].parent;
+            const auto k = this->_slot(p, c);
+            const auto old = this->_rect(p, k);
+            const auto grown = _cover(old, e.rect);
+            if (grown == old)
+            {
+                break;
+            }
+            this->_set_rect(p, k, grown);
+            c = p;
+        }
+        if (this->_nodes[n].count > M)
+        {
+            this->_overflow(n);
+        }
+    }
+
+    void _overflow(std::uint32_t n)
+    {
+        const auto level = this->_nodes[n].level;
+        if (n != this->_root && !this->_reinserted[level])
+        {
+            this->_reinserted[level] = true;
+            this->_reinsert(n);
+            return;
+        }
+        this->_split(n);
+    }
+
+    /**
+     * @brief take out the entries farthest from the node centre and
+     * insert them again, nearest first
+     */
+    void _reinsert(std::uint32_t n)
+    {
+        auto es = this->_entries(n);
+        const auto box = this->_mbr(n);
+        auto dist = [&box](const rectangle<T>& r)
+        {
+            const auto dx = double(r.x().lower() + r.x().upper()) -
+                double(box.x().lower() + box.x().upper());
+            const auto dy = double(r.y().lower() + r.y().upper()) -
+                double(box.y().lower() + box.y().upper());
+            return dx * dx + dy * dy;
+        };
+        std::sort(es.begin(), es.end(),
+            [&](const entry& a, const entry& b)
+            { return dist(a.rect) < dist(b.rect); });
+        const auto keep = es.size() - _num_reinsert;
+        const auto level = this->_nodes[n].level;
+        this->_nodes[n].count = 0;
+        for (auto i = std::size_t(0); i != keep; ++i)
+        {
+            this->_append(n, es[i]);
+        }
+        this->_adjust_up(n);
+        for (auto i = keep; i != es.size(); ++i)
+        {
+            this->_insert(es[i], level);
+        }
+    }
+
+    /**
+     * @brief R* split of an overflowing node into itself and a sibling
+     */
+    void _split(std::uint32_t n)
+    {
+        auto es = this->_entries(n);
+        const auto total = unsigned(es.size());
+        auto lower = std::vector<rectangle<T>>(es.size(), es[0].rect);
+        auto upper = lower;
+        // bounding boxes of the first k and of the last total - k entries
+        auto sweep = [&]()
+        {
+            lower[0] = es[0].rect;
+            for (auto k = 1U; k != total; ++k)
+            {
+                lower[k] = _cover(lower[k - 1], es[k].rect);
+            }
+            upper[total - 1] = es[total - 1].rect;
+            for (auto k = total - 1; k-- != 0;)
+            {
+                upper[k] = _cover(upper[k + 1], es[k].rect);
+            }
+        };
+        auto sorted = [&](unsigned axis, bool by_upper)
+        {
+            auto key = [axis, by_upper](const entry& e)
+            {
+                const auto& i = axis == 0 ? e.rect.x() : e.rect.y();
+                return by_upper ? std::make_pair(i.upper(), i.lower())
+                                : std::make_pair(i.lower(), i.upper());
+            };
+            std::sort(es.begin(), es.end(),
+                [&key](const entry& a, const entry& b)
+                { return key(a) < key(b); });
+            sweep();
+        };
+
+        auto best_axis = 0U;
+        auto best_margin = 0.0;
+        for (auto axis = 0U; axis != 2; ++axis)
+        {
+            auto margin = 0.0;
+            for (auto by_upper : {false, true})
+            {
+                sorted(axis, by_upper);
+                for (auto k = _min_fill; k <= total - _min_fill; ++k)
+                {
+                    margin += _margin(lower[k - 1]) + _margin(upper[k]);
+                }
+            }
+            if (axis == 0 || margin < best_margin)
+            {
+                best_axis = axis;
+                best_margin = margin;
+            }
+        }
+
+        auto best = std::make_pair(-1.0, 0.0); // (overlap, area)
+        auto best_upper = false;
+        auto best_k = 0U;
+        for (auto by_upper : {false, true})
+        {
+            sorted(best_axis, by_upper);
+            for (auto k = _min_fill; k <= total - _min_fill; ++k)
+            {
+                const auto cost = std::make_pair(
+                    _overlap(lower[k - 1], upper[k]),
+                    _area(lower[k - 1]) + _area(upper[k]));
+                if (best.first < 0.0 || cost < best)
+                {
+                    best = cost;
+                    best_upper = by_upper;
+                    best_k = k;
+                }
+            }
+        }
+        sorted(best_axis, best_upper);
+
+        const auto level = this->_nodes[n].level;
+        const auto s = this->_alloc(level);
+        this->_nodes[n].count = 0;
+        for (auto k = 0U; k != total; ++k)
+        {
+            this->_append(k < best_k ? n : s, es[k]);
+        }
+
+        if (n == this->_root)
+        {
+            const auto r = this->_alloc(std::uint16_t(level + 1));
+            this->_append(r, entry {this->_mbr(n), n});
+            this->_append(r, entry {this->_mbr(s), s});
+            this->_root = r;
+            this->_reinserted.push_back(false);
+            return;
+        }
+        const auto p = this->_nodes[n].parent;
+        this->_set_rect(p, this->_slot(p, n), this->_mbr(n));
+        this->_append(p, entry {this->_mbr(s), s});
+        this->_adjust_up(p);
+        if (this->_nodes[p].count > M)
+        {
+            this->_overflow(p);
+        }
+    }
+
+    /**
+     * @brief dissolve underfull nodes on the path from n to the root and
+     * reinsert their entries at their level
+     */
+    void _condense(std::uint32_t n)
+    {
+        auto orphans = std::vector<std::pair<entry, unsigned>> {};
+        while (n != this->_root)
+        {
+            const auto p = this->_nodes[n].parent;
+            const auto k = this->_slot(p, n);
+            if (this->_nodes[n].count < _min_fill)
+            {
+                for (auto&& e : this->_entries(n))
+                {
+                    orphans.emplace_back(e, this->_nodes[n].level);
+                }
+                this->_erase_slot(p, k);
+                this->_release(n);
+            }
+            else
+            {
+                this->_set_rect(p, k, this->_mbr(n));
+            }
+            n = p;
+        }
+        for (auto&& [e, level] : orphans)
+        {
+            assert(this->_nodes[this->_root].level > level);
+            this->_reinserted.assign(this->height() + 1, false);
+            this->_insert(e, level);
+        }
+        while (this->_nodes[this->_root].level != 0 &&
+            this->_nodes[this->_root].count == 1)
+        {
+            const auto child = this->_nodes[this->_root].child[0];
+            this->_release(this->_root);
+            this->_root = child;
+            this->_nodes[child].parent = npos;
+        }
+    }
+
+    template <typename Fn>
+    void _query(std::uint32_t n, const rectangle<T>& w, Fn& fn) const
+    {
+        const auto& nd = this->_nodes[n];
+        const auto& x = w.x();
+        const auto& y = w.y();
+        for (auto k = 0U; k != nd.count; ++k)
+        {
+            if (nd.xh[k] < x.lower() || x.upper() < nd.xl[k] ||
+                nd.yh[k] < y.lower() || y.upper() < nd.yl[k])
+            {
+                continue;
+            }
+            if (nd.level == 0)
+            {
+                fn(nd.child[k]);
+            }
+            else
+            {
+                this->_query(nd.child[k], w, fn);
+            }
+        }
+    }
+
+    [[nodiscard]] auto _valid(std::uint32_t n, std::uint32_t parent,
+        std::size_t& items) const -> bool
+    {
+        const auto& nd = this->_nodes[n];
+        if (nd.parent != parent || nd.count > M ||
+            (n != this->_root && nd.count < _min_fill))
+        {
+            return false;
+        }
+        if (nd.level == 0)
+        {
+            for (auto k = 0U; k != nd.count; ++k)
+            {
+                if (!(this->_rect(n, k) == this->_rects[nd.child[k]]))
+                {
+                    return false;
+                }
+            }
+            items += nd.count;
+            return true;
+        }
+        for (auto k = 0U; k != nd.count; ++k)
+        {
+            const auto c = nd.child[k];
+            if (this->_nodes[c].level + 1 != nd.level ||
+                !_contains(this->_rect(n, k), this->_mbr(c)) ||
+                !this->_valid(c, n, items))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+} // namespace recti
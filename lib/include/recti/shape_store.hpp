@@ -0,0 +1,333 @@
+#pragma once
+
+#include "parallel.hpp"
+#include "polygon.hpp"
+#include "recti.hpp"
+#include "rpolygon.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <gsl/span>
+#include <utility>
+#include <vector>
+
+namespace recti
+{
+
+/**
+ * @brief An interned shape placed at an origin
+ *
+ * @tparam T
+ */
+template <typename T>
+struct shape_ref
+{
+    std::uint32_t id; //!< canonical shape in the store
+    point<T> origin;  //!< where its first canonical vertex lands
+};
+
+/**
+ * @brief Flyweight store of polygon vertex sequences
+ *
+ * A polygon is split, like rpolygon/polygon do internally, into an origin
+ * and the vectors from it to the other vertices. The store keeps one copy
+ * of every distinct vector sequence; an instance is then only a
+ * shape_ref, i.e. a shape id plus an origin. To also merge copies that
+ * start at a different vertex, every sequence is first rotated to start
+ * at its smallest vertex (by x, then y), which is also the origin
+ * recorded in the shape_ref.
+ *
+ * Shapes are found through an open-addressing hash table over the
+ * canonical vectors. Keep rectilinear and general polygons in separate
+ * stores, since the store does not know which pointset convention a
+ * sequence follows.
+ *
+ * @tparam T
+ */
+template <typename T>
+class shape_store
+{
+  private:
+    std::vector<std::size_t> _start {0};  // CSR offsets into _vecs
+    std::vector<vector2<T>> _vecs;        // canonical vectors, by shape
+    std::vector<std::uint64_t> _hash;     // per shape
+    std::vector<std::uint32_t> _slots;    // shape id + 1, 0 = empty
+    std::size_t _mask;
+    std::size_t _interned {0};
+
+  public:
+    /**
+     * @brief Construct an empty store
+     *
+     */
+    shape_store()
+        : _slots(16, 0U)
+        , _mask {15}
+    {
+    }
+
+    /**
+     * @brief Intern a polygon given by its vertices
+     *
+     * @param pointset vertices in order (rpolygon or polygon convention)
+     * @return shape_ref<T>
+     */
+    auto intern(gsl::span<const point<T>> pointset) -> shape_ref<T>
+    {
+        assert(!pointset.empty());
+        auto vertex = [pointset](std::size_t i) { return pointset[i]; };
+        const auto [m, h] = _canonical(pointset.size(), vertex);
+        return this->_intern(pointset.size(), vertex, m, h);
+    }
+
+    /**
+     * @brief Intern a rectilinear polygon
+     *
+     * @param P
+     * @return shape_ref<T>
+     */
+    auto intern(const rpolygon<T>& P) -> shape_ref<T>
+    {
+        return this->_intern_parts(P.origin(), P.vecs());
+    }
+
+    /**
+     * @brief Intern a polygon
+     *
+     * @param P
+     * @return shape_ref<T>
+     */
+    auto intern(const polygon<T>& P) -> shape_ref<T>
+    {
+        return this->_intern_parts(P.origin(), P.vecs());
+    }
+
+    /**
+     * @brief Intern a stream of polygons given in CSR form
+     *
+     * Polygon i has the vertices points[start[i]] .. points[start[i+1]-1].
+     * Canonical rotations and hashes are computed in parallel; the table
+     * is then updated serially in input order, so shape ids do not depend
+     * on num_threads.
+     *
+     * @param points
+     * @param start polygon offsets, size = number of polygons + 1
+     * @param num_threads (0 = hardware concurrency)
+     * @return std::vector<shape_ref<T>> one per polygon
+     */
+    auto intern_all(gsl::span<const point<T>> points,
+        gsl::span<const std::size_t> start, unsigned num_threads = 0)
+        -> std::vector<shape_ref<T>>
+    {
+        assert(!start.empty());
+        const auto n = start.size() - 1;
+        auto keys = std::vector<std::pair<std::size_t, std::uint64_t>>(n);
+        parallel_for(
+            n,
+            [&](std::size_t i)
+            {
+                const auto* first = points.data() + start[i];
+                keys[i] = _canonical(start[i + 1] - start[i],
+                    [first](std::size_t k) { return first[k]; });
+            },
+            num_threads);
+
+        auto res = std::vector<shape_ref<T>> {};
+        res.reserve(n);
+        for (auto i = std::size_t(0); i != n; ++i)
+        {
+            const auto* first = points.data() + start[i];
+            res.push_back(this->_intern(start[i + 1] - start[i],
+                [first](std::size_t k) { return first[k]; }, keys[i].first,
+                keys[i].second));
+        }
+        return res;
+    }
+
+    /**
+     * @brief number of distinct shapes
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto size() const noexcept -> std::size_t
+    {
+        return this->_hash.size();
+    }
+
+    /**
+     * @brief number of polygons interned so far, repeats included
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto num_interned() const noexcept -> std::size_t
+    {
+        return this->_interned;
+    }
+
+    /**
+     * @brief number of vectors stored for all distinct shapes
+     *
+     * @return std::size_t
+     */
+    [[nodiscard]] auto num_vecs() const noexcept -> std::size_t
+    {
+        return this->_vecs.size();
+    }
+
+    /**
+     * @brief canonical vectors of a shape (all vertices but the origin)
+     *
+     * @param id
+     * @return gsl::span<const vector2<T>>
+     */
+    [[nodiscard]] auto vecs(std::uint32_t id) const
+        -> gsl::span<const vector2<T>>
+    {
+        return {this->_vecs.data() + this->_start[id],
+            this->_start[id + 1] - this->_start[id]};
+    }
+
+    /**
+     * @brief Materialize an instance as an rpolygon
+     *
+     * @param ref
+     * @return rpolygon<T>
+     */
+    [[nodiscard]] auto to_rpolygon(const shape_ref<T>& ref) const
+        -> rpolygon<T>
+    {
+        const auto v = this->vecs(ref.id);
+        return {ref.origin, std::vector<vector2<T>>(v.begin(), v.end())};
+    }
+
+    /**
+     * @brief Materialize an instance as a polygon
+     *
+     * @param ref
+     * @return polygon<T>
+     */
+    [[nodiscard]] auto to_polygon(const shape_ref<T>& ref) const -> polygon<T>
+    {
+        const auto v = this->vecs(ref.id);
+        return {ref.origin, std::vector<vector2<T>>(v.begin(), v.end())};
+    }
+
+  private:
+    auto _intern_parts(const point<T>& origin, gsl::span<const vector2<T>> v)
+        -> shape_ref<T>
+    {
+        auto vertex = [&origin, v](std::size_t i)
+        {
+            auto p = origin;
+            if (i != 0)
+            {
+                p += v[i - 1];
+            }
+            return p;
+        };
+        const auto [m, h] = _canonical(v.size() + 1, vertex);
+        return this->_intern(v.size() + 1, vertex, m, h);
+    }
+
+    /**
+     * @brief Smallest vertex and hash of the rotated vector sequence
+     *
+     * @param n number of vertices
+     * @param vertex callable(i) -> point<T>
+     * @return std::pair<std::size_t, std::uint64_t>
+     */
+    template <typename Vertex>
+    static auto _canonical(std::size_t n, const Vertex& vertex)
+        -> std::pair<std::size_t, std::uint64_t>
+    {
+        auto m = std::size_t(0);
+        auto lo = vertex(0);
+        for (auto i = std::size_t(1); i != n; ++i)
+        {
+            const auto p = vertex(i);
+            if (p < lo)
+            {
+                lo = p;
+                m = i;
+            }
+        }
+        auto h = std::uint64_t(n) * 0x9E3779B97F4A7C15ULL;
+        auto mix = [&h](const T& c)
+        {
+            h = (h ^ std::uint64_t(std::hash<T> {}(c))) * 0x100000001B3ULL;
+            h ^= h >> 29;
+        };
+        for (auto k = std::size_t(1); k != n; ++k)
+        {
+            const auto v = vertex((m + k) % n) - lo;
+            mix(v.x());
+            mix(v.y());
+        }
+        return {m, h};
+    }
+
+    template <typename Vertex>
+    auto _intern(std::size_t n, const Vertex& vertex, std::size_t m,
+        std::uint64_t h) -> shape_ref<T>
+    {
+        ++this->_interned;
+        const auto lo = vertex(m);
+        auto same = [&](std::uint32_t id)
+        {
+            if (this->_hash[id] != h ||
+                this->_start[id + 1] - this->_start[id] != n - 1)
+            {
+                return false;
+            }
+            const auto* v = this->_vecs.data() + this->_start[id];
+            for (auto k = std::size_t(1); k != n; ++k)
+            {
+                if (!(v[k - 1] == vertex((m + k) % n) - lo))
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+        auto k = std::size_t(h) & this->_mask;
+        for (; this->_slots[k] != 0; k = (k + 1) & this->_mask)
+        {
+            if (same(this->_slots[k] - 1))
+            {
+                return {this->_slots[k] - 1, lo};
+            }
+        }
+
+        assert(this->_hash.size() < std::size_t(UINT32_MAX));
+        const auto id = std::uint32_t(this->_hash.size());
+        for (auto i = std::size_t(1); i != n; ++i)
+        {
+            this->_vecs.push_back(vertex((m + i) % n) - lo);
+        }
+        this->_start.push_back(this->_vecs.size());
+        this->_hash.push_back(h);
+        this->_slots[k] = id + 1;
+        if (2 * this->_hash.size() > this->_slots.size())
+        {
+            this->_grow();
+        }
+        return {id, lo};
+    }
+
+    void _grow()
+    {
+        this->_slots.assign(2 * this->_slots.size(), 0U);
+        this->_mask = this->_slots.size() - 1;
+        for (auto id = std::uint32_t(0); id != this->_hash.size(); ++id)
+        {
+            auto k = std::size_t(this->_hash[id]) & this->_mask;
+            while (this->_slots[k] != 0)
+            {
+                k = (k + 1) & this->_mask;
+            }
+            this->_slots[k] = id + 1;
+        }
+    }
+};
+
+} // namespace recti
@@ -0,0 +1,724 @@
+#pragma once
+
+#include "grid_index.hpp"
+#include "recti.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <gsl/span>
+#include <ostream>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace recti
+{
+
+/**
+ * @brief Binary layout snapshot, format version 1
+ *
+ * All integers are little-endian. The file starts with a fixed header
+ *
+ *     char     magic[8]        "RECTSNAP"
+ *     uint32   version         1
+ *     uint32   coord_type      sizeof(T) | kind << 8  (0 unsigned,
+ *                                                      1 signed, 2 float)
+ *     uint64   num_rects
+ *     uint64   num_polygons
+ *     uint64   num_points      total polygon points
+ *     uint32   num_sections
+ *     uint32   reserved
+ *
+ * followed by num_sections entries {uint32 id, uint32 reserved,
+ * uint64 offset, uint64 bytes}. Every section is a plain array starting
+ * at a multiple of 64 bytes:
+ *
+ *     rect_xl, rect_xu, rect_yl, rect_yu   T[num_rects]   (SoA)
+ *     poly_start       uint64[num_polygons + 1]  CSR offsets into points
+ *     poly_x, poly_y   T[num_points]   pointsets as used by rpolygon
+ *     index_geom       T[4]            origin x, y, pitch x, pitch y
+ *     index_dims       uint64[2]       bins in x and y
+ *     index_start      uint64[bins + 1]  CSR offsets (grid_index layout)
+ *     index_items      uint32[...]     rectangle ids, grouped by bin
+ *
+ * The four index sections are optional and come together. Unknown
+ * section ids are ignored by readers, so later versions can add sections.
+ */
+namespace snapshot
+{
+
+inline constexpr char magic[8] = {'R', 'E', 'C', 'T', 'S', 'N', 'A', 'P'};
+inline constexpr std::uint32_t version = 1;
+inline constexpr std::size_t header_size = 48;
+inline constexpr std::size_t entry_size = 24;
+inline constexpr std::size_t alignment = 64;
+
+enum section : std::uint32_t
+{
+    rect_xl,
+    rect_xu,
+    rect_yl,
+    rect_yu,
+    poly_start,
+    poly_x,
+    poly_y,
+    index_geom,
+    index_dims,
+    index_start,
+    index_items,
+    num_known_sections
+};
+
+template <typename T>
+inline constexpr auto coord_type() -> std::uint32_t
+{
+    static_assert(std::is_arithmetic<T>::value);
+    const auto kind = std::is_floating_point<T>::value ? 2U
+        : std::is_signed<T>::value                     ? 1U
+                                                       : 0U;
+    return std::uint32_t(sizeof(T)) | kind << 8;
+}
+
+inline auto little_endian_host() -> bool
+{
+    const auto one = std::uint32_t(1);
+    auto b = std::uint8_t(0);
+    std::memcpy(&b, &one, 1);
+    return b == 1;
+}
+
+} // namespace snapshot
+
+/**
+ * @brief Outcome of opening (validating) a snapshot
+ *
+ */
+enum class snapshot_status : std::uint8_t
+{
+    ok,
+    truncated,      //!< shorter than its header or section table says
+    bad_magic,
+    bad_version,
+    bad_coord_type, //!< written for another coordinate type
+    bad_endian,     //!< zero-copy views need a little-endian host
+    bad_section,    //!< missing, misaligned or wrongly sized section
+    bad_offsets     //!< CSR offsets or ids out of range (deep check only)
+};
+
+namespace detail
+{
+
+/**
+ * @brief little-endian byte sink over an ostream
+ */
+class le_writer
+{
+  private:
+    std::ostream& _os;
+    std::uint64_t _pos {0};
+
+  public:
+    explicit le_writer(std::ostream& os)
+        : _os {os}
+    {
+    }
+
+    [[nodiscard]] auto pos() const noexcept -> std::uint64_t
+    {
+        return this->_pos;
+    }
+
+    void bytes(const void* p, std::size_t n)
+    {
+        this->_os.write(static_cast<const char*>(p), std::streamsize(n));
+        this->_pos += n;
+    }
+
+    /**
+     * @brief write an arithmetic value in little-endian byte order
+     */
+    template <typename U>
+    void value(const U& v)
+    {
+        unsigned char buf[sizeof(U)];
+        std::memcpy(buf, &v, sizeof(U));
+        if (!snapshot::little_endian_host())
+        {
+            std::reverse(buf, buf + sizeof(U));
+        }
+        this->bytes(buf, sizeof(U));
+    }
+
+    void pad_to(std::uint64_t pos)
+    {
+        static const char zeros[snapshot::alignment] = {};
+        while (this->_pos < pos)
+        {
+            this->bytes(zeros,
+                std::size_t(std::min<std::uint64_t>(
+                    pos - this->_pos, snapshot::alignment)));
+        }
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Write a snapshot of rectangles and rectilinear polygons
+ *
+ * Polygons are given in CSR form: polygon i is the pointset
+ * poly_points[poly_start[i] .. poly_start[i + 1]). With index_pitch > 0 a
+ * grid_index over the rectangles' bounding box is built and stored, so
+ * readers can run window queries without building anything.
+ *
+ * @tparam T
+ * @param os binary output stream
+ * @param rects
+ * @param poly_points
+ * @param poly_start size num_polygons + 1 (or empty for no polygons)
+ * @param index_pitch bin size of the index section, 0 for none
+ * @return true if the stream is still good
+ */
+template <typename T>
+inline auto write_snapshot(std::ostream& os,
+    gsl::span<const rectangle<T>> rects,
+    gsl::span<const point<T>> poly_points,
+    gsl::span<const std::size_t> poly_start, const T& index_pitch = T(0))
+    -> bool
+{
+    namespace sn = snapshot;
+    const auto nr = std::uint64_t(rects.size());
+    const auto np =
+        std::uint64_t(poly_start.empty() ? 0 : poly_start.size() - 1);
+    assert(np == 0 || poly_start.back() == poly_points.size());
+
+    // the optional index
+    auto idx_geom = std::array<T, 4> {};
+    auto idx_dims = std::array<std::uint64_t, 2> {};
+    auto idx_start = std::vector<std::uint64_t> {};
+    auto idx_items = std::vector<std::uint32_t> {};
+    const auto with_index = T(0) < index_pitch && nr != 0;
+    if (with_index)
+    {
+        auto lo = rects[0].lower();
+        auto hi = rects[0].upper();
+        for (auto&& r : rects)
+        {
+            lo = point<T> {std::min(lo.x(), r.x().lower()),
+                std::min(lo.y(), r.y().lower())};
+            hi = point<T> {std::max(hi.x(), r.x().upper()),
+                std::max(hi.y(), r.y().upper())};
+        }
+        auto gi = grid_index<T> {
+            rectangle<T> {interval<T> {lo.x(), hi.x()},
+                interval<T> {lo.y(), hi.y()}},
+            index_pitch};
+        gi.build(rects);
+        const auto [nx, ny] = gi.dims();
+        idx_geom = {lo.x(), lo.y(), index_pitch, index_pitch};
+        idx_dims = {std::uint64_t(nx), std::uint64_t(ny)};
+        idx_start.push_back(0);
+        for (auto iy = 0U; iy != ny; ++iy)
+        {
+            for (auto ix = 0U; ix != nx; ++ix)
+            {
+                const auto b = gi.bin(ix, iy);
+                idx_items.insert(idx_items.end(), b.begin(), b.end());
+                idx_start.push_back(idx_items.size());
+            }
+        }
+    }
+
+    struct entry
+    {
+        std::uint32_t id;
+        std::uint64_t bytes;
+    };
+    auto entries = std::vector<entry> {{sn::rect_xl, nr * sizeof(T)},
+        {sn::rect_xu, nr * sizeof(T)}, {sn::rect_yl, nr * sizeof(T)},
+        {sn::rect_yu, nr * sizeof(T)}, {sn::poly_start, (np + 1) * 8},
+        {sn::poly_x, poly_points.size() * sizeof(T)},
+        {sn::poly_y, poly_points.size() * sizeof(T)}};
+    if (with_index)
+    {
+        entries.push_back({sn::index_geom, 4 * sizeof(T)});
+        entries.push_back({sn::index_dims, 2 * 8});
+        entries.push_back({sn::index_start, idx_start.size() * 8});
+        entries.push_back({sn::index_items, idx_items.size() * 4});
+    }
+    auto align = [](std::uint64_t p)
+    { return (p + sn::alignment - 1) / sn::alignment * sn::alignment; };
+    auto offsets = std::vector<std::uint64_t> {};
+    auto pos = align(sn::header_size + entries.size() * sn::entry_size);
+    for (auto&& e : entries)
+    {
+        offsets.push_back(pos);
+        pos = align(pos + e.bytes);
+    }
+
+    auto w = detail::le_writer {os};
+    w.bytes(sn::magic, sizeof(sn::magic));
+    w.value(sn::version);
+    w.value(sn::coord_type<T>());
+    w.value(nr);
+    w.value(np);
+    w.value(std::uint64_t(poly_points.size()));
+    w.value(std::uint32_t(entries.size()));
+    w.value(std::uint32_t(0));
+    for (auto i = 0U; i != entries.size(); ++i)
+    {
+        w.value(entries[i].id);
+        w.value(std::uint32_t(0));
+        w.value(offsets[i]);
+        w.value(entries[i].bytes);
+    }
+    auto section = [&](std::size_t i, auto&& emit)
+    {
+        w.pad_to(offsets[i]);
+        emit();
+    };
+    section(0, [&] { for (auto&& r : rects) w.value(r.x().lower()); });
+    section(1, [&] { for (auto&& r : rects) w.value(r.x().upper()); });
+    section(2, [&] { for (auto&& r : rects) w.value(r.y().lower()); });
+    section(3, [&] { for (auto&& r : rects) w.value(r.y().upper()); });
+    section(4,
+        [&]
+        {
+            w.value(std::uint64_t(0));
+            for (auto i = 1U; i <= np; ++i)
+            {
+                w.value(std::uint64_t(poly_start[i] - poly_start[0]));
+            }
+        });
+    section(5, [&] { for (auto&& p : poly_points) w.value(p.x()); });
+    section(6, [&] { for (auto&& p : poly_points) w.value(p.y()); });
+    if (with_index)
+    {
+        section(7, [&] { for (auto&& v : idx_geom) w.value(v); });
+        section(8, [&] { for (auto&& v : idx_dims) w.value(v); });
+        section(9, [&] { for (auto&& v : idx_start) w.value(v); });
+        section(10, [&] { for (auto&& v : idx_items) w.value(v); });
+    }
+    w.pad_to(pos);
+    return bool(os);
+}
+
+/**
+ * @brief Zero-copy read-only view of a snapshot in memory
+ *
+ * open() checks the header and the section table in O(1) (plus a linear
+ * scan of the CSR offsets when `deep` is set) and then points straight
+ * into the buffer, so a memory-mapped file is only paged in as its
+ * arrays are touched. The buffer must outlive the view and be aligned to
+ * at least alignof(std::uint64_t) (mmap and operator new both are).
+ *
+ * @tparam T
+ */
+template <typename T>
+class snapshot_view
+{
+  private:
+    std::size_t _nr {0};
+    std::size_t _np {0};
+    std::size_t _npts {0};
+    std::array<gsl::span<const T>, 4> _rect {};
+    gsl::span<const std::uint64_t> _poly_start {};
+    gsl::span<const T> _poly_x {};
+    gsl::span<const T> _poly_y {};
+    gsl::span<const T> _index_geom {};
+    gsl::span<const std::uint64_t> _index_dims {};
+    gsl::span<const std::uint64_t> _index_start {};
+    gsl::span<const std::uint32_t> _index_items {};
+
+  public:
+    /**
+     * @brief validate a snapshot and attach the view to it
+     *
+     * @param data
+     * @param deep also check every CSR offset and index item
+     * @return snapshot_status
+     */
+    auto open(gsl::span<const std::byte> data, bool deep = false)
+        -> snapshot_status
+    {
+        namespace sn = snapshot;
+        *this = snapshot_view {};
+        if (!sn::little_endian_host())
+        {
+            return snapshot_status::bad_endian;
+        }
+        if (data.size() < sn::header_size)
+        {
+            return snapshot_status::truncated;
+        }
+        const auto* base = data.data();
+        auto read = [&](std::size_t off, auto& v)
+        { std::memcpy(&v, base + off, sizeof(v)); };
+        if (std::memcmp(base, sn::magic, sizeof(sn::magic)) != 0)
+        {
+            return snapshot_status::bad_magic;
+        }
+        auto ver = std::uint32_t(0);
+        auto coord = std::uint32_t(0);
+        auto nr = std::uint64_t(0);
+        auto np = std::uint64_t(0);
+        auto npts = std::uint64_t(0);
+        auto ns = std::uint32_t(0);
+        read(8, ver);
+        read(12, coord);
+        read(16, nr);
+        read(24, np);
+        read(32, npts);
+        read(40, ns);
+        if (ver != sn::version)
+        {
+            return snapshot_status::bad_version;
+        }
+        if (coord != sn::coord_type<T>())
+        {
+            return snapshot_status::bad_coord_type;
+        }
+        if (data.size() < sn::header_size + std::uint64_t(ns) * sn::entry_size)
+        {
+            return snapshot_status::truncated;
+        }
+
+        auto found = std::array<bool, sn::num_known_sections> {};
+        auto sections = std::array<gsl::span<const std::byte>,
+            sn::num_known_sections> {};
+        for (auto i = 0U; i != ns; ++i)
+        {
+            const auto e = sn::header_size + i * sn::entry_size;
+            auto id = std::uint32_t(0);
+            auto off = std::uint64_t(0);
+            auto bytes = std::uint64_t(0);
+            read(e, id);
+            read(e + 8, off);
+            read(e + 16, bytes);
+            if (id >= sn::num_known_sections)
+            {
+                continue; // a later extension
+            }
+            if (off % sn::alignment != 0 || off > data.size() ||
+                bytes > data.size() - off)
+            {
+                return off > data.size() || bytes > data.size() - off
+                    ? snapshot_status::truncated
+                    : snapshot_status::bad_section;
+            }
+            found[id] = true;
+            sections[id] = data.subspan(std::size_t(off), std::size_t(bytes));
+        }
+        const auto n_idx = found[sn::index_geom] + found[sn::index_dims] +
+            found[sn::index_start] + found[sn::index_items];
+        if (!std::all_of(found.begin(), found.begin() + sn::index_geom,
+                [](bool f) { return f; }) ||
+            (n_idx != 0 && n_idx != 4))
+        {
+            return snapshot_status::bad_section;
+        }
+
+        auto bind = [&](auto& out, std::uint32_t id, std::uint64_t count)
+        {
+            using E = typename std::decay_t<decltype(out)>::element_type;
+            if (sections[id].size() != count * sizeof(E))
+            {
+                return false;
+            }
+            out = {reinterpret_cast<const E*>(sections[id].data()),
+                std::size_t(count)};
+            return true;
+        };
+        auto ok = true;
+        for (auto k = 0U; k != 4; ++k)
+        {
+            ok = ok && bind(this->_rect[k], sn::rect_xl + k, nr);
+        }
+        ok = ok && bind(this->_poly_start, sn::poly_start, np + 1);
+        ok = ok && bind(this->_poly_x, sn::poly_x, npts);
+        ok = ok && bind(this->_poly_y, sn::poly_y, npts);
+        if (ok && n_idx == 4)
+        {
+            ok = bind(this->_index_geom, sn::index_geom, 4) &&
+                bind(this->_index_dims, sn::index_dims, 2);
+            if (ok)
+            {
+                const auto bins =
+                    this->_index_dims[0] * this->_index_dims[1];
+                ok = bind(this->_index_start, sn::index_start, bins + 1) &&
+                    sections[sn::index_items].size() % 4 == 0 &&
+                    bind(this->_index_items, sn::index_items,
+                        sections[sn::index_items].size() / 4);
+            }
+        }
+        if (!ok)
+        {
+            *this = snapshot_view {};
+            return snapshot_status::bad_section;
+        }
+        this->_nr = std::size_t(nr);
+        this->_np = std::size_t(np);
+        this->_npts = std::size_t(npts);
+        if (deep && !this->_deep_check())
+        {
+            *this = snapshot_view {};
+            return snapshot_status::bad_offsets;
+        }
+        return snapshot_status::ok;
+    }
+
+    [[nodiscard]] auto num_rects() const noexcept -> std::size_t
+    {
+        return this->_nr;
+    }
+
+    [[nodiscard]] auto num_polygons() const noexcept -> std::size_t
+    {
+        return this->_np;
+    }
+
+    /**
+     * @brief the i-th rectangle
+     *
+     * @param i
+     * @return rectangle<T>
+     */
+    [[nodiscard]] auto rect(std::size_t i) const -> rectangle<T>
+    {
+        return {interval<T> {this->_rect[0][i], this->_rect[1][i]},
+            interval<T> {this->_rect[2][i], this->_rect[3][i]}};
+    }
+
+    /**
+     * @brief one coordinate array of the rectangles: 0 = x lower,
+     * 1 = x upper, 2 = y lower, 3 = y upper
+     *
+     * @param k
+     * @return gsl::span<const T>
+     */
+    [[nodiscard]] auto rect_coords(std::size_t k) const -> gsl::span<const T>
+    {
+        return this->_rect[k];
+    }
+
+    /**
+     * @brief x coordinates of the i-th polygon's pointset
+     *
+     * @param i
+     * @return gsl::span<const T>
+     */
+    [[nodiscard]] auto polygon_x(std::size_t i) const -> gsl::span<const T>
+    {
+        const auto first = std::size_t(this->_poly_start[i]);
+        return this->_poly_x.subspan(
+            first, std::size_t(this->_poly_start[i + 1]) - first);
+    }
+
+    /**
+     * @brief y coordinates of the i-th polygon's pointset
+     *
+     * @param i
+     * @return gsl::span<const T>
+     */
+    [[nodiscard]] auto polygon_y(std::size_t i) const -> gsl::span<const T>
+    {
+        const auto first = std::size_t(this->_poly_start[i]);
+        return this->_poly_y.subspan(
+            first, std::size_t(this->_poly_start[i + 1]) - first);
+    }
+
+    /**
+     * @brief the i-th polygon's pointset (a copy, e.g. for rpolygon)
+     *
+     * @param i
+     * @return std::vector<point<T>>
+     */
+    [[nodiscard]] auto polygon(std::size_t i) const -> std::vector<point<T>>
+    {
+        const auto xs = this->polygon_x(i);
+        const auto ys = this->polygon_y(i);
+        auto res = std::vector<point<T>> {};
+        res.reserve(xs.size());
+        for (auto k = 0U; k != xs.size(); ++k)
+        {
+            res.emplace_back(xs[k], ys[k]);
+        }
+        return res;
+    }
+
+    [[nodiscard]] auto has_index() const noexcept -> bool
+    {
+        return !this->_index_dims.empty();
+    }
+
+    /**
+     * @brief Call fn(id) once for every rectangle overlapping the window
+     *
+     * Uses the stored index (which must exist). A rectangle listed in
+     * several bins is reported only from the first bin, in row-major
+     * order, that both it and the window meet, so no scratch state is
+     * needed and the view may be queried from several threads.
+     *
+     * @tparam Fn
+     * @param window closed query window
+     * @param fn
+     */
+    template <typename Fn>
+    void query(const rectangle<T>& window, Fn&& fn) const
+    {
+        assert(this->has_index());
+        const auto& g = this->_index_geom;
+        const auto nx = std::size_t(this->_index_dims[0]);
+        const auto ny = std::size_t(this->_index_dims[1]);
+        auto bin = [](const T& v, const T& o, const T& p, std::size_t n)
+        {
+            return v < o ? std::size_t(0)
+                         : std::min(std::size_t((v - o) / p), n - 1);
+        };
+        const auto x0 = bin(window.x().lower(), g[0], g[2], nx);
+        const auto x1 = bin(window.x().upper(), g[0], g[2], nx);
+        const auto y0 = bin(window.y().lower(), g[1], g[3], ny);
+        const auto y1 = bin(window.y().upper(), g[1], g[3], ny);
+        for (auto iy = y0; iy <= y1; ++iy)
+        {
+            for (auto ix = x0; ix <= x1; ++ix)
+            {
+                const auto b = iy * nx + ix;
+                for (auto k = this->_index_start[b];
+                     k != this->_index_start[b + 1]; ++k)
+                {
+                    const auto id = std::size_t(this->_index_items[k]);
+                    const auto r = this->rect(id);
+                    if (!r.overlaps(window))
+                    {
+                        continue;
+                    }
+                    const auto fx = std::max(
+                        x0, bin(r.x().lower(), g[0], g[2], nx));
+                    const auto fy = std::max(
+                        y0, bin(r.y().lower(), g[1], g[3], ny));
+                    if (fx == ix && fy == iy)
+                    {
+                        fn(id);
+                    }
+                }
+            }
+        }
+    }
+
+  private:
+    [[nodiscard]] auto _deep_check() const -> bool
+    {
+        auto monotone = [](gsl::span<const std::uint64_t> s, std::uint64_t end)
+        {
+            if (s.empty() || s[0] != 0 || s[s.size() - 1] != end)
+            {
+                return false;
+            }
+            return std::is_sorted(s.begin(), s.end());
+        };
+        if (!monotone(this->_poly_start, this->_npts))
+        {
+            return false;
+        }
+        if (!this->has_index())
+        {
+            return true;
+        }
+        return monotone(this->_index_start, this->_index_items.size()) &&
+            std::all_of(this->_index_items.begin(), this->_index_items.end(),
+                [this](std::uint32_t id) { return id < this->_nr; });
+    }
+};
+
+/**
+ * @brief Read-only memory mapping of a whole file (POSIX)
+ *
+ */
+class mapped_file
+{
+  private:
+    void* _addr {nullptr};
+    std::size_t _size {0};
+
+  public:
+    mapped_file() = default;
+    mapped_file(const mapped_file&) = delete;
+    auto operator=(const mapped_file&) -> mapped_file& = delete;
+
+    ~mapped_file()
+    {
+        this->close();
+    }
+
+    /**
+     * @brief map a file
+     *
+     * @param path
+     * @return true on success
+     */
+    auto open(const char* path) -> bool
+    {
+        this->close();
+#if defined(__unix__) || defined(__APPLE__)
+        const auto fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st
+        {
+        };
+        if (::fstat(fd, &st) != 0 || st.st_size == 0)
+        {
+            ::close(fd);
+            return false;
+        }
+        auto* addr = ::mmap(
+            nullptr, std::size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED)
+        {
+            return false;
+        }
+        this->_addr = addr;
+        this->_size = std::size_t(st.st_size);
+        return true;
+#else
+        (void)path;
+        return false;
+#endif
+    }
+
+    void close()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if (this->_addr != nullptr)
+        {
+            ::munmap(this->_addr, this->_size);
+        }
+#endif
+        this->_addr = nullptr;
+        this->_size = 0;
+    }
+
+    /**
+     * @brief the mapped bytes
+     *
+     * @return gsl::span<const std::byte>
+     */
+    [[nodiscard]] auto data() const -> gsl::span<const std::byte>
+    {
+        return {static_cast<const std::byte*>(this->_addr), this->_size};
+    }
+};
+
+} // namespace recti
@@ -0,0 +1,238 @@
+#pragma once
+
+#include "recti.hpp"
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+
+namespace recti
+{
+
+/**
+ * @brief Rotate a point by 45 degrees: (x, y) -> (x + y, x - y)
+ *
+ * The rotation is exact for integers and turns L1 distance into L-infinity
+ * distance: |dx| + |dy| == max(|du|, |dv|). It also scales by sqrt(2),
+ * which keeps integer points on an integer lattice (of even u + v).
+ *
+ * @tparam T
+ * @param p
+ * @return point<T> the rotated point (u, v)
+ */
+template <typename T>
+constexpr auto rotate45(const point<T>& p) -> point<T>
+{
+    return {p.x() + p.y(), p.x() - p.y()};
+}
+
+/**
+ * @brief Inverse of rotate45(): (u, v) -> ((u + v) / 2, (u - v) / 2)
+ *
+ * @tparam T
+ * @param q rotated point; for integral T, u + v must be even
+ * @return point<T>
+ */
+template <typename T>
+constexpr auto unrotate45(const point<T>& q) -> point<T>
+{
+    if constexpr (std::is_integral<T>::value)
+    {
+        assert(((q.x() + q.y()) & 1) == 0);
+    }
+    return {(q.x() + q.y()) / 2, (q.x() - q.y()) / 2};
+}
+
+/**
+ * @brief Tilted rectangular region (TRR)
+ *
+ * A rectangle whose sides have slopes +1 and -1, stored as an ordinary
+ * rectangle in the rotated coordinates of rotate45(). A TRR of zero
+ * extent in one rotated direction is a Manhattan arc (a +-45 degree
+ * segment, possibly a single point). The set of points within L1
+ * distance r of a TRR is again a TRR, so the core operations of
+ * zero-skew clock routing -- distance, expansion and intersection --
+ * reduce to interval arithmetic and are exact for integer coordinates.
+ *
+ * @tparam T
+ */
+template <typename T>
+class trr
+{
+  private:
+    rectangle<T> _r; // in rotated coordinates
+
+  public:
+    /**
+     * @brief Construct from a rectangle in rotated coordinates
+     *
+     * @param rotated
+     */
+    explicit constexpr trr(const rectangle<T>& rotated)
+        : _r {rotated}
+    {
+    }
+
+    /**
+     * @brief Construct a single-point TRR
+     *
+     * @param p point in (x, y) coordinates
+     */
+    explicit constexpr trr(const point<T>& p)
+        : trr(p, T(0))
+    {
+    }
+
+    /**
+     * @brief Construct the L1 ball of a point
+     *
+     * @param p center in (x, y) coordinates
+     * @param radius
+     */
+    constexpr trr(const point<T>& p, const T& radius)
+        : _r {interval<T> {p.x() + p.y() - radius, p.x() + p.y() + radius},
+              interval<T> {p.x() - p.y() - radius, p.x() - p.y() + radius}}
+    {
+    }
+
+    /**
+     * @brief the region in rotated coordinates
+     */
+    [[nodiscard]] constexpr auto rotated() const -> const rectangle<T>&
+    {
+        return this->_r;
+    }
+
+    /**
+     * @brief whether the region is a single point
+     */
+    [[nodiscard]] constexpr auto is_point() const -> bool
+    {
+        return this->_r.x().len() == T(0) && this->_r.y().len() == T(0);
+    }
+
+    /**
+     * @brief whether the region is a Manhattan arc (or a point)
+     */
+    [[nodiscard]] constexpr auto is_arc() const -> bool
+    {
+        return this->_r.x().len() == T(0) || this->_r.y().len() == T(0);
+    }
+
+    /**
+     * @brief whether the region contains a point given in (x, y)
+     */
+    [[nodiscard]] constexpr auto contains(const point<T>& p) const -> bool
+    {
+        return this->_r.contains(rotate45(p));
+    }
+
+    /**
+     * @brief Points within L1 distance r of the region
+     *
+     * @param r non-negative radius
+     * @return trr
+     */
+    [[nodiscard]] constexpr auto enlarged(const T& r) const -> trr
+    {
+        return trr {rectangle<T> {
+            interval<T> {this->_r.x().lower() - r, this->_r.x().upper() + r},
+            interval<T> {
+                this->_r.y().lower() - r, this->_r.y().upper() + r}}};
+    }
+
+    /**
+     * @brief L1 distance between the closest points of two regions
+     *
+     * @param other
+     * @return T zero if they intersect
+     */
+    [[nodiscard]] constexpr auto distance(const trr& other) const -> T
+    {
+        return std::max(trr::_gap(this->_r.x(), other._r.x()),
+            trr::_gap(this->_r.y(), other._r.y()));
+    }
+
+    /**
+     * @brief L1 distance from a point given in (x, y)
+     */
+    [[nodiscard]] constexpr auto distance(const point<T>& p) const -> T
+    {
+        return this->distance(trr {p});
+    }
+
+    /**
+     * @brief Intersection of two regions
+     *
+     * @param other
+     * @param[out] res the intersection, when not empty
+     * @return false if the regions are disjoint
+     */
+    [[nodiscard]] constexpr auto intersect(
+        const trr& other, trr& res) const -> bool
+    {
+        const auto& a = this->_r;
+        const auto& b = other._r;
+        const auto ul = std::max(a.x().lower(), b.x().lower());
+        const auto uh = std::min(a.x().upper(), b.x().upper());
+        const auto vl = std::max(a.y().lower(), b.y().lower());
+        const auto vh = std::min(a.y().upper(), b.y().upper());
+        if (uh < ul || vh < vl)
+        {
+            return false;
+        }
+        res = trr {rectangle<T> {interval<T> {ul, uh}, interval<T> {vl, vh}}};
+        return true;
+    }
+
+    /**
+     * @brief A point of the region closest to q (both rotated)
+     *
+     * Clamping each rotated coordinate minimizes the L-infinity, hence
+     * the L1, distance.
+     *
+     * @param q point in rotated coordinates
+     * @return point<T> in rotated coordinates
+     */
+    [[nodiscard]] constexpr auto nearest_rotated(const point<T>& q) const
+        -> point<T>
+    {
+        return {trr::_clamp(q.x(), this->_r.x()),
+            trr::_clamp(q.y(), this->_r.y())};
+    }
+
+    /**
+     * @brief A point of the region closest to p (both in (x, y))
+     *
+     * For integral T the closest point may lie off the integer lattice;
+     * use nearest_rotated() there.
+     *
+     * @param p
+     * @return point<T>
+     */
+    [[nodiscard]] constexpr auto nearest(const point<T>& p) const -> point<T>
+    {
+        return unrotate45(this->nearest_rotated(rotate45(p)));
+    }
+
+  private:
+    static constexpr auto _gap(const interval<T>& a, const interval<T>& b)
+        -> T
+    {
+        if (a.upper() < b.lower())
+        {
+            return b.lower() - a.upper();
+        }
+        if (b.upper() < a.lower())
+        {
+            return a.lower() - b.upper();
+        }
+        return T(0);
+    }
+
+    static constexpr auto _clamp(const T& v, const interval<T>& r) -> T
+    {
+        return v < r.lower() ? r.lower() : r.upper() < v ? r.upper() : v;
+    }
+};
+
+} // namespace recti
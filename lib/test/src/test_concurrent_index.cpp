@@ -0,0 +1,176 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/concurrent_index.hpp>
+#include <recti/recti.hpp>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace recti;
+
+static auto random_rect(int extent, int size) -> rectangle<int>
+{
+    const auto x = std::rand() % (extent + 400) - 200;
+    const auto y = std::rand() % (extent + 400) - 200;
+    return {interval<int> {x, x + std::rand() % size},
+        interval<int> {y, y + std::rand() % size}};
+}
+
+static auto collect(const concurrent_index<int>::reader& rd,
+    const rectangle<int>& w) -> std::vector<std::uint32_t>
+{
+    auto res = std::vector<std::uint32_t> {};
+    rd.query(w,
+        [&](std::uint32_t id, const rectangle<int>&) { res.push_back(id); });
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+TEST_CASE("Concurrent index test (snapshots against brute force)")
+{
+    const auto extent =
+        rectangle<int> {interval<int> {0, 10000}, interval<int> {0, 10000}};
+    auto idx = concurrent_index<int> {extent, 500, 4};
+    auto shapes = std::vector<rectangle<int>> {};
+    auto alive = std::vector<bool> {};
+    auto brute = [&](const std::vector<rectangle<int>>& s,
+                     const std::vector<bool>& a, const rectangle<int>& w)
+    {
+        auto res = std::vector<std::uint32_t> {};
+        for (auto i = 0U; i != s.size(); ++i)
+        {
+            if (a[i] && s[i].overlaps(w))
+            {
+                res.push_back(i);
+            }
+        }
+        return res;
+    };
+
+    {
+        const auto rd = idx.read(0);
+        CHECK(rd.size() == 0);
+        CHECK(collect(rd, extent).empty());
+    }
+    for (auto round = 0; round != 8; ++round)
+    {
+        // an old snapshot must keep seeing the state it was taken at
+        auto old = idx.read(1);
+        const auto old_shapes = shapes;
+        const auto old_alive = alive;
+        for (auto i = 0; i != 500; ++i)
+        {
+            shapes.push_back(random_rect(10000, i % 50 == 0 ? 3000 : 300));
+            alive.push_back(true);
+            CHECK(idx.insert(shapes.back()) == shapes.size() - 1);
+        }
+        for (auto i = 0; i != 300; ++i)
+        {
+            const auto id = std::uint32_t(std::rand()) % shapes.size();
+            if (!alive[id])
+            {
+                continue;
+            }
+            if (i % 3 == 0)
+            {
+                idx.remove(id);
+                alive[id] = false;
+            }
+            else
+            {
+                shapes[id] = random_rect(10000, 300);
+                idx.move(id, shapes[id]);
+            }
+        }
+        idx.commit(round % 2 == 0 ? 1U : 3U);
+
+        const auto rd = idx.read(0);
+        CHECK(rd.number() == std::uint64_t(round + 1));
+        CHECK(rd.size() ==
+            std::size_t(std::count(alive.begin(), alive.end(), true)));
+        CHECK(old.number() == std::uint64_t(round));
+        for (auto q = 0; q != 50; ++q)
+        {
+            const auto w = random_rect(10000, q % 10 == 0 ? 5000 : 800);
+            CHECK(collect(rd, w) == brute(shapes, alive, w));
+            CHECK(collect(old, w) == brute(old_shapes, old_alive, w));
+        }
+        // the two live readers hold back the previous version only
+        CHECK(idx.reclaim() == 1);
+    }
+    CHECK(idx.reclaim() == 0);
+}
+
+TEST_CASE("Concurrent index test (readers during commits)")
+{
+    // every commit moves all shapes to a new width, so a reader that saw
+    // a half-applied batch would find two different widths
+    const auto n = 400U;
+    const auto num_readers = 3U;
+    const auto extent =
+        rectangle<int> {interval<int> {0, 4000}, interval<int> {0, 4000}};
+    auto idx = concurrent_index<int> {extent, 250, num_readers};
+    auto place = [](std::uint32_t i, int w)
+    {
+        const auto x = int(i % 20) * 200;
+        const auto y = int(i / 20) * 200;
+        return rectangle<int> {
+            interval<int> {x, x + w}, interval<int> {y, y + 50}};
+    };
+    for (auto i = 0U; i != n; ++i)
+    {
+        idx.insert(place(i, 1));
+    }
+    idx.commit(1);
+
+    auto done = std::atomic<bool> {false};
+    auto torn = std::atomic<unsigned> {0};
+    auto readers = std::vector<std::thread> {};
+    for (auto t = 0U; t != num_readers; ++t)
+    {
+        readers.emplace_back(
+            [&, t]()
+            {
+                while (!done.load())
+                {
+                    const auto rd = idx.read(t);
+                    auto count = 0U;
+                    auto width = -1;
+                    auto ok = rd.size() == n;
+                    rd.query(extent,
+                        [&](std::uint32_t, const rectangle<int>& r)
+                        {
+                            ++count;
+                            if (width >= 0 && r.x().len() != width)
+                            {
+                                ok = false;
+                            }
+                            width = r.x().len();
+                        });
+                    if (!ok || count != n)
+                    {
+                        torn.fetch_add(1);
+                    }
+                }
+            });
+    }
+    for (auto c = 2; c != 200; ++c)
+    {
+        for (auto i = 0U; i != n; ++i)
+        {
+            idx.move(i, place(i, 1 + c % 100));
+        }
+        idx.commit(1);
+    }
+    done.store(true);
+    for (auto&& th : readers)
+    {
+        th.join();
+    }
+    CHECK(torn.load() == 0);
+    CHECK(idx.reclaim() == 0);
+    CHECK(idx.read(0).number() == 199);
+}
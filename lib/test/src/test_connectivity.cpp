@@ -0,0 +1,174 @@
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/connectivity.hpp>
+#include <recti/disjoint_set.hpp>
+#include <recti/recti.hpp>
+#include <vector>
+
+using namespace recti;
+
+static auto random_rects(int n, int size) -> std::vector<rectangle<int>>
+{
+    auto rects = std::vector<rectangle<int>> {};
+    for (auto i = 0; i != n; ++i)
+    {
+        const auto x = std::rand() % size;
+        const auto y = std::rand() % size;
+        rects.emplace_back(interval<int> {x, x + std::rand() % 12},
+            interval<int> {y, y + std::rand() % 12});
+    }
+    return rects;
+}
+
+/// same partition, and labels numbered by smallest member
+static void check_labels(const component_labels& res, disjoint_set& ref)
+{
+    const auto n = res.component.size();
+    auto next = std::uint32_t(0);
+    for (auto i = 0U; i != n; ++i)
+    {
+        const auto r = ref.find(i);
+        auto first = i;
+        for (auto j = 0U; j != i; ++j)
+        {
+            if (ref.find(j) == r)
+            {
+                first = j;
+                break;
+            }
+        }
+        if (first == i)
+        {
+            CHECK(res.component[i] == next++);
+        }
+        else
+        {
+            CHECK(res.component[i] == res.component[first]);
+        }
+    }
+    CHECK(res.num_components == next);
+}
+
+TEST_CASE("Connected components test")
+{
+    const auto rects = random_rects(600, 300);
+    auto ref = disjoint_set {rects.size()};
+    for (auto i = 0U; i != rects.size(); ++i)
+    {
+        for (auto j = i + 1; j != rects.size(); ++j)
+        {
+            if (rects[i].overlaps(rects[j]))
+            {
+                ref.unite(i, j);
+            }
+        }
+    }
+    check_labels(connected_components<int>(rects, 1), ref);
+    check_labels(connected_components<int>(rects, 4), ref);
+}
+
+TEST_CASE("Connected components test (touching)")
+{
+    const auto rects = std::vector<rectangle<int>> {
+        {interval<int> {0, 2}, interval<int> {0, 2}},
+        {interval<int> {5, 6}, interval<int> {0, 1}},
+        {interval<int> {2, 3}, interval<int> {2, 4}}, // corner of #0
+        {interval<int> {3, 5}, interval<int> {-1, 0}}, // corner of #1
+    };
+    const auto res = connected_components<int>(rects);
+    CHECK(res.num_components == 2);
+    CHECK(res.component == std::vector<std::uint32_t> {0, 1, 0, 1});
+}
+
+TEST_CASE("Connected components test (rails and blocks)")
+{
+    // chip-wide rails, a few large blocks, many small shapes, duplicates
+    auto rects = random_rects(800, 2000);
+    for (auto y = 0; y < 2000; y += 150)
+    {
+        rects.emplace_back(interval<int> {-10, 2010}, interval<int> {y, y + 2});
+        rects.emplace_back(interval<int> {y, y + 3}, interval<int> {0, 700});
+    }
+    rects.emplace_back(interval<int> {300, 900}, interval<int> {1200, 1800});
+    rects.push_back(rects[5]);
+    auto ref = disjoint_set {rects.size()};
+    for (auto i = 0U; i != rects.size(); ++i)
+    {
+        for (auto j = i + 1; j != rects.size(); ++j)
+        {
+            if (rects[i].overlaps(rects[j]))
+            {
+                ref.unite(i, j);
+            }
+        }
+    }
+    check_labels(connected_components<int>(rects, 1), ref);
+    check_labels(connected_components<int>(rects, 3), ref);
+}
+
+TEST_CASE("Connected components test (multi-layer)")
+{
+    const auto rects = random_rects(300, 200);
+    auto layers = std::vector<std::uint32_t> {};
+    for (auto i = 0U; i != rects.size(); ++i)
+    {
+        layers.push_back(std::uint32_t(std::rand() % 3));
+    }
+    auto vias = std::vector<layer_via<int>> {};
+    for (auto&& r : random_rects(40, 200))
+    {
+        const auto l = std::uint32_t(std::rand() % 2);
+        vias.push_back({r, l, l + 1});
+    }
+    const auto n = rects.size();
+    auto ref = disjoint_set {n + vias.size()};
+    for (auto i = 0U; i != n; ++i)
+    {
+        for (auto j = i + 1; j != n; ++j)
+        {
+            if (layers[i] == layers[j] && rects[i].overlaps(rects[j]))
+            {
+                ref.unite(i, j);
+            }
+        }
+        for (auto v = 0U; v != vias.size(); ++v)
+        {
+            if ((layers[i] == vias[v].lower_layer ||
+                    layers[i] == vias[v].upper_layer) &&
+                rects[i].overlaps(vias[v].shape))
+            {
+                ref.unite(i, std::uint32_t(n + v));
+            }
+        }
+    }
+    for (auto v = 0U; v != vias.size(); ++v)
+    {
+        for (auto w = v + 1; w != vias.size(); ++w)
+        {
+            const auto& a = vias[v];
+            const auto& b = vias[w];
+            const auto share = a.lower_layer == b.lower_layer ||
+                a.lower_layer == b.upper_layer ||
+                a.upper_layer == b.lower_layer;
+            if (share && a.shape.overlaps(b.shape))
+            {
+                ref.unite(std::uint32_t(n + v), std::uint32_t(n + w));
+            }
+        }
+    }
+    check_labels(connected_components<int>(rects, layers, vias, 3), ref);
+}
+
+TEST_CASE("Concurrent disjoint set test")
+{
+    auto ds = concurrent_disjoint_set {1000};
+    parallel_for(
+        999,
+        [&](std::size_t i)
+        { ds.unite(std::uint32_t(i + 1), std::uint32_t(i)); },
+        4);
+    for (auto i = 0U; i != 1000; ++i)
+    {
+        CHECK(ds.find(i) == 0);
+    }
+}
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/coordinate_map.hpp>
+#include <recti/fractions.hpp>
+#include <recti/parallel.hpp>
+#include <recti/recti.hpp>
+#include <vector>
+
+using namespace recti;
+
+TEST_CASE("Coordinate map test (parallel sort)")
+{
+    for (auto n : {0U, 1U, 100U, 20000U, 100003U})
+    {
+        auto vs = std::vector<int> {};
+        for (auto i = 0U; i != n; ++i)
+        {
+            vs.push_back(std::rand() % 5000 - 2500);
+        }
+        auto want = vs;
+        std::sort(want.begin(), want.end());
+        for (auto nt : {1U, 3U, 4U})
+        {
+            auto got = vs;
+            parallel_sort(got.begin(), got.end(), nt);
+            CHECK(got == want);
+        }
+        // a plain int literal is a thread count, not a comparator
+        auto lit = vs;
+        parallel_sort(lit.begin(), lit.end(), 4);
+        CHECK(lit == want);
+        std::reverse(want.begin(), want.end());
+        parallel_sort(vs.begin(), vs.end(), std::greater<> {}, 3);
+        CHECK(vs == want);
+    }
+}
+
+TEST_CASE("Coordinate map test (ranks against brute force)")
+{
+    auto vs = std::vector<std::int64_t> {};
+    for (auto i = 0; i != 30000; ++i)
+    {
+        vs.push_back(std::int64_t(std::rand() % 4000) * 1000000007LL);
+    }
+    const auto m = coordinate_map<std::int64_t> {vs, 3};
+    auto distinct = vs;
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(
+        std::unique(distinct.begin(), distinct.end()), distinct.end());
+    REQUIRE(m.size() == distinct.size());
+    for (auto r = 0U; r != m.size(); ++r)
+    {
+        CHECK(m.value(r) == distinct[r]);
+        CHECK(m.rank(distinct[r]) == r);
+    }
+    const auto rs = m.ranks(vs, 3);
+    for (auto i = 0U; i != vs.size(); ++i)
+    {
+        CHECK(m.value(rs[i]) == vs[i]);
+    }
+    for (auto q = 0; q != 500; ++q)
+    {
+        const auto v = std::int64_t(std::rand() % 4100 - 50) * 1000000007LL +
+            std::rand() % 3 - 1;
+        const auto below = std::count_if(distinct.begin(), distinct.end(),
+            [&](auto d) { return d < v; });
+        const auto upto = std::count_if(distinct.begin(), distinct.end(),
+            [&](auto d) { return d <= v; });
+        CHECK(m.lower_rank(v) == std::uint32_t(below));
+        CHECK(m.upper_rank(v) == std::uint32_t(upto));
+        CHECK(m.contains(v) == (below != upto));
+    }
+    const auto [a, b] =
+        m.rank_range(interval<std::int64_t> {distinct[3] + 1, distinct[4] - 1});
+    CHECK(a == 4);
+    CHECK(b == 4);
+}
+
+TEST_CASE("Coordinate map test (fractions)")
+{
+    using F = fun::Fraction<int>;
+    auto vs = std::vector<F> {};
+    for (auto i = 0; i != 2000; ++i)
+    {
+        vs.emplace_back(std::rand() % 200 - 100, 1 + std::rand() % 12);
+    }
+    const auto m = coordinate_map<F> {vs, 2};
+    for (auto r = 1U; r < m.size(); ++r)
+    {
+        CHECK(m.value(r - 1) < m.value(r));
+    }
+    for (auto&& v : vs)
+    {
+        CHECK(m.value(m.rank(v)) == v);
+    }
+    CHECK(m.lower_rank(F {-100, 1}) == 0);
+    CHECK(m.upper_rank(F {100, 1}) == m.size());
+}
+
+TEST_CASE("Coordinate map test (rank space of mixed shapes)")
+{
+    auto rects = std::vector<rectangle<int>> {};
+    auto pts = std::vector<point<int>> {};
+    auto hsegs = std::vector<hsegment<int>> {};
+    auto vsegs = std::vector<vsegment<int>> {};
+    for (auto i = 0; i != 3000; ++i)
+    {
+        const auto x = std::rand() % 100000;
+        const auto y = std::rand() % 100000;
+        const auto w = 1 + std::rand() % 3000;
+        const auto h = 1 + std::rand() % 3000;
+        rects.push_back({interval<int> {x, x + w}, interval<int> {y, y + h}});
+        pts.emplace_back(y, x);
+        hsegs.push_back({interval<int> {x, x + h}, y});
+        vsegs.push_back({x, interval<int> {y, y + w}});
+    }
+    auto xs = std::vector<int> {};
+    auto ys = std::vector<int> {};
+    collect_coordinates<int>(rects, xs, ys);
+    collect_coordinates<int>(pts, xs, ys);
+    collect_coordinates<int>(hsegs, xs, ys);
+    collect_coordinates<int>(vsegs, xs, ys);
+    const auto rs = rank_space<int> {std::move(xs), std::move(ys), 3};
+    CHECK(rs.x().size() <= 4 * 3000);
+
+    const auto rr = rs.to_ranks(rects, 3);
+    const auto rp = rs.to_ranks(pts, 3);
+    REQUIRE(rr.size() == rects.size());
+    REQUIRE(rp.size() == pts.size());
+    CHECK(rs.to_rank(hsegs[5]).y() == rs.y().rank(hsegs[5].y()));
+    CHECK(rs.to_rank(vsegs[5]).x() == rs.x().rank(vsegs[5].x()));
+    // order-based predicates agree in rank space
+    for (auto i = 0U; i != 300; ++i)
+    {
+        CHECK(rs.to_value(rr[i]) == rects[i]);
+        CHECK(rs.to_value(rp[i]) == pts[i]);
+        for (auto j = 0U; j != 300; ++j)
+        {
+            CHECK(rr[i].overlaps(rr[j]) == rects[i].overlaps(rects[j]));
+            CHECK(rr[i].contains(rp[j]) == rects[i].contains(pts[j]));
+        }
+    }
+    // arbitrary windows select the same points
+    for (auto q = 0; q != 100; ++q)
+    {
+        const auto x = std::rand() % 100000;
+        const auto y = std::rand() % 100000;
+        const auto w =
+            rectangle<int> {interval<int> {x, x + std::rand() % 9000},
+                interval<int> {y, y + std::rand() % 9000}};
+        auto rw = rectangle<std::uint32_t> {
+            interval<std::uint32_t> {0, 0}, interval<std::uint32_t> {0, 0}};
+        const auto hit = rs.window(w, rw);
+        for (auto j = 0U; j != pts.size(); ++j)
+        {
+            CHECK(w.contains(pts[j]) == (hit && rw.contains(rp[j])));
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/density_map.hpp>
+#include <recti/recti.hpp>
+#include <vector>
+
+using namespace recti;
+
+static auto overlap_area(const rectangle<int>& a, const rectangle<int>& b)
+    -> int
+{
+    const auto w = std::min(a.x().upper(), b.x().upper()) -
+        std::max(a.x().lower(), b.x().lower());
+    const auto h = std::min(a.y().upper(), b.y().upper()) -
+        std::max(a.y().lower(), b.y().lower());
+    return w > 0 && h > 0 ? w * h : 0;
+}
+
+TEST_CASE("Density map test")
+{
+    auto cells = std::vector<rectangle<int>> {};
+    for (auto i = 0; i != 400; ++i)
+    {
+        auto x = std::rand() % 1000;
+        auto y = std::rand() % 1000;
+        cells.emplace_back(interval<int> {x, x + 1 + std::rand() % 40},
+            interval<int> {y, y + 10});
+    }
+    // a few tall ones spanning several row bands
+    for (auto i = 0; i != 20; ++i)
+    {
+        auto x = std::rand() % 1000;
+        auto y = std::rand() % 400;
+        cells.emplace_back(interval<int> {x, x + 1 + std::rand() % 40},
+            interval<int> {y, y + 1 + std::rand() % 600});
+    }
+    auto extent =
+        rectangle<int> {interval<int> {0, 1000}, interval<int> {0, 1000}};
+    auto D = density_map<int> {extent, 30, 40};
+    D.build(cells, 1);
+    CHECK(D.dims() == std::pair<std::size_t, std::size_t> {34, 25});
+
+    auto check_windows = [&](const density_map<int>& M)
+    {
+        for (auto k = 0; k != 50; ++k)
+        {
+            const auto ix0 = std::size_t(std::rand() % 34);
+            const auto iy0 = std::size_t(std::rand() % 25);
+            const auto ix1 = ix0 + std::size_t(std::rand()) % (34 - ix0);
+            const auto iy1 = iy0 + std::size_t(std::rand()) % (25 - iy0);
+            auto window = rectangle<int> {
+                interval<int> {int(ix0) * 30, int(ix1 + 1) * 30},
+                interval<int> {int(iy0) * 40, int(iy1 + 1) * 40}};
+            auto expect = 0;
+            for (auto&& r : cells)
+            {
+                expect += overlap_area(r, window);
+            }
+            CHECK(M.area(ix0, iy0, ix1, iy1) == expect);
+            CHECK(M.area(window) == expect);
+        }
+    };
+    check_windows(D);
+
+    // parallel build by row bands gives the same bins
+    for (auto nt : {2U, 4U, 7U, 30U})
+    {
+        auto D4 = density_map<int> {extent, 30, 40};
+        D4.build(cells, nt);
+        auto same = true;
+        for (auto iy = 0U; iy != 25; ++iy)
+        {
+            for (auto ix = 0U; ix != 34; ++ix)
+            {
+                same = same && D.bin_area(ix, iy) == D4.bin_area(ix, iy);
+            }
+        }
+        CHECK(same);
+    }
+
+    // incremental updates
+    for (auto k = 0; k != 100; ++k)
+    {
+        auto& r = cells[std::size_t(std::rand()) % cells.size()];
+        D.remove(r);
+        auto x = std::rand() % 1000;
+        auto y = std::rand() % 1000;
+        r = rectangle<int> {interval<int> {x, x + 1 + std::rand() % 40},
+            interval<int> {y, y + 10}};
+        D.add(r);
+        if (k % 20 == 0)
+        {
+            check_windows(D);
+        }
+    }
+    check_windows(D);
+}
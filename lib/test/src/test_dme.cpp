@@ -0,0 +1,174 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/dme.hpp>
+#include <recti/fractions.hpp>
+#include <recti/recti.hpp>
+#include <recti/trr.hpp>
+#include <vector>
+
+using namespace recti;
+
+template <typename T>
+static auto l1(const point<T>& a, const point<T>& b) -> T
+{
+    const auto dx = a.x() < b.x() ? b.x() - a.x() : a.x() - b.x();
+    const auto dy = a.y() < b.y() ? b.y() - a.y() : a.y() - b.y();
+    return dx + dy;
+}
+
+/**
+ * @brief check the tree shape, wire lengths and path delays
+ */
+template <typename T, typename Close>
+static void check_tree(const std::vector<point<T>>& sinks,
+    const zero_skew_tree<T>& tree, Close&& close)
+{
+    const auto n = sinks.size();
+    REQUIRE(tree.positions.size() == 2 * n - 1);
+    REQUIRE(tree.parents.size() == 2 * n - 1);
+    REQUIRE(tree.wires.size() == 2 * n - 1);
+    CHECK(tree.parents[tree.root] == zero_skew_tree<T>::none);
+    auto fanout = std::vector<int>(2 * n - 1, 0);
+    auto length = T(0);
+    for (auto i = 0U; i != 2 * n - 1; ++i)
+    {
+        length += tree.wires[i];
+        if (i == tree.root)
+        {
+            continue;
+        }
+        const auto p = tree.parents[i];
+        REQUIRE(p < 2 * n - 1);
+        CHECK(p >= n);
+        ++fanout[p];
+        // the wire can be snaked but never shorter than the distance
+        const auto d = l1(tree.positions[i], tree.positions[p]);
+        CHECK((!(tree.wires[i] < d) || close(tree.wires[i], d)));
+    }
+    for (auto i = n; i != 2 * n - 1; ++i)
+    {
+        CHECK(fanout[i] == 2);
+    }
+    CHECK(close(length, tree.length));
+    for (auto s = 0U; s != n; ++s)
+    {
+        CHECK(tree.positions[s] == sinks[s]);
+        auto delay = T(0);
+        auto steps = 0U;
+        for (auto i = s; i != tree.root && steps <= 2 * n; i = tree.parents[i])
+        {
+            delay += tree.wires[i];
+            ++steps;
+        }
+        CHECK(close(delay, tree.delay));
+    }
+}
+
+TEST_CASE("DME test (tilted rectangles)")
+{
+    const auto p = point<int> {3, -2};
+    CHECK(rotate45(p) == point<int> {1, 5});
+    CHECK(unrotate45(rotate45(p)) == p);
+
+    for (auto k = 0; k != 200; ++k)
+    {
+        const auto a = trr<int> {
+            point<int> {std::rand() % 40 - 20, std::rand() % 40 - 20},
+            std::rand() % 6};
+        const auto b = trr<int> {
+            point<int> {std::rand() % 40 - 20, std::rand() % 40 - 20},
+            std::rand() % 6}.enlarged(std::rand() % 3);
+        // brute force over the lattice
+        auto best = 1000;
+        auto common = 0;
+        for (auto x = -40; x <= 40; ++x)
+        {
+            for (auto y = -40; y <= 40; ++y)
+            {
+                const auto q = point<int> {x, y};
+                if (a.contains(q))
+                {
+                    best = std::min(best, b.distance(q));
+                }
+                common += a.contains(q) && b.contains(q) ? 1 : 0;
+            }
+        }
+        CHECK(a.distance(b) == best);
+        auto c = a;
+        const auto hit = a.intersect(b, c);
+        CHECK(hit == (common > 0));
+        if (hit)
+        {
+            CHECK(a.distance(b) == 0);
+        }
+        // the nearest point is on the region and at its distance
+        const auto q = point<int> {std::rand() % 40 - 20, std::rand() % 40};
+        const auto r = a.nearest_rotated(rotate45(q));
+        CHECK(a.rotated().contains(r));
+        const auto rq = rotate45(q);
+        CHECK(std::max(std::abs(r.x() - rq.x()), std::abs(r.y() - rq.y())) ==
+            a.distance(q));
+    }
+    const auto arc = trr<int> {point<int> {0, 0}}.enlarged(4);
+    CHECK(!arc.is_arc());
+    CHECK(trr<int> {point<int> {2, 2}}.is_point());
+}
+
+TEST_CASE("DME test (small nets)")
+{
+    auto exact = [](auto a, auto b) { return a == b; };
+    {
+        const auto sinks = std::vector<point<double>> {{0, 0}, {10, 0}};
+        const auto tree = dme_zero_skew<double>(sinks);
+        CHECK(tree.delay == 5);
+        CHECK(tree.positions[tree.root] == point<double> {5, 0});
+        check_tree(sinks, tree, exact);
+    }
+    {
+        const auto sinks = std::vector<point<double>> {{7, 3}};
+        const auto tree = dme_zero_skew<double>(sinks);
+        CHECK(tree.root == 0);
+        CHECK(tree.delay == 0);
+    }
+    CHECK(dme_zero_skew<double>(std::vector<point<double>> {}).root ==
+        zero_skew_tree<double>::none);
+
+    // exact arithmetic: zero skew to the last bit
+    using F = fun::Fraction<long long>;
+    auto sinks = std::vector<point<F>> {};
+    for (auto i = 0; i != 40; ++i)
+    {
+        sinks.emplace_back(F {std::rand() % 100, 1}, F {std::rand() % 100, 1});
+    }
+    const auto tree = dme_zero_skew<F>(sinks, 2);
+    check_tree(sinks, tree, exact);
+}
+
+TEST_CASE("DME test (random and clustered sinks)")
+{
+    auto close = [](double a, double b)
+    { return std::abs(a - b) <= 1e-9 * (1 + std::abs(a) + std::abs(b)); };
+    for (auto trial = 0; trial != 3; ++trial)
+    {
+        auto sinks = std::vector<point<double>> {};
+        for (auto i = 0; i != 3000; ++i)
+        {
+            // a few dense clusters, duplicates and far outliers
+            const auto c = std::rand() % 5;
+            const auto spread = trial == 2 ? 3 : 200 + c * 400;
+            sinks.emplace_back(c * 5000 + std::rand() % spread,
+                (c % 2) * 8000 + std::rand() % spread);
+        }
+        const auto tree = dme_zero_skew<double>(sinks, 1);
+        check_tree(sinks, tree, close);
+
+        // the result does not depend on the thread count
+        const auto par = dme_zero_skew<double>(sinks, 3);
+        CHECK(par.parents == tree.parents);
+        CHECK(par.positions == tree.positions);
+        CHECK(par.wires == tree.wires);
+        CHECK(par.delay == tree.delay);
+    }
+}
@@ -0,0 +1,239 @@
+#include <algorithm>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/drc.hpp>
+#include <recti/recti.hpp>
+#include <tuple>
+#include <vector>
+
+using namespace recti;
+
+static auto gap(const interval<int>& a, const interval<int>& b) -> int
+{
+    return std::max({0, b.lower() - a.upper(), a.lower() - b.upper()});
+}
+
+TEST_CASE("DRC test (spacing)")
+{
+    auto rects = std::vector<rectangle<int>> {};
+    auto s = shape_set<int> {};
+    for (auto i = 0; i != 3000; ++i)
+    {
+        const auto x = std::rand() % 2000;
+        const auto y = std::rand() % 2000;
+        rects.emplace_back(interval<int> {x, x + 1 + std::rand() % 10},
+            interval<int> {y, y + 1 + std::rand() % 10});
+        s.add(rects.back());
+    }
+    // long rails meet many shapes, but only those near them in y
+    for (auto y = 100; y < 2000; y += 400)
+    {
+        rects.emplace_back(interval<int> {0, 2000}, interval<int> {y, y + 2});
+        s.add(rects.back());
+        rects.emplace_back(interval<int> {y, y + 3}, interval<int> {0, 2000});
+        s.add(rects.back());
+    }
+    auto ref = std::vector<std::tuple<std::uint32_t, std::uint32_t, int>> {};
+    for (auto i = 0U; i != rects.size(); ++i)
+    {
+        for (auto j = i + 1; j != rects.size(); ++j)
+        {
+            const auto d = gap(rects[i].x(), rects[j].x()) +
+                gap(rects[i].y(), rects[j].y());
+            if (0 < d && d < 6)
+            {
+                ref.emplace_back(i, j, d);
+            }
+        }
+    }
+    auto collect = [&](unsigned nt)
+    {
+        auto res = std::vector<drc_violation<int>> {};
+        check_spacing<int>(
+            s, 6, [&](const drc_violation<int>& v) { res.push_back(v); }, nt);
+        return res;
+    };
+    const auto res1 = collect(1);
+    const auto res4 = collect(4);
+    REQUIRE(res1.size() == ref.size());
+    REQUIRE(res4.size() == ref.size());
+    auto got = std::vector<std::tuple<std::uint32_t, std::uint32_t, int>> {};
+    for (auto i = 0U; i != res1.size(); ++i)
+    {
+        CHECK(res1[i].rule == drc_rule::spacing);
+        CHECK(res1[i].a == res4[i].a);
+        CHECK(res1[i].b == res4[i].b);
+        got.emplace_back(res1[i].a, res1[i].b, res1[i].value);
+    }
+    std::sort(got.begin(), got.end());
+    CHECK(got == ref);
+}
+
+TEST_CASE("DRC test (spacing between sets)")
+{
+    auto m1 = shape_set<int> {};
+    auto m2 = shape_set<int> {};
+    m1.add(rectangle<int> {interval<int> {0, 10}, interval<int> {0, 10}});
+    m1.add(rectangle<int> {interval<int> {12, 20}, interval<int> {0, 10}});
+    m2.add(rectangle<int> {interval<int> {0, 20}, interval<int> {13, 15}});
+    auto res = std::vector<drc_violation<int>> {};
+    check_spacing<int>(m1, m2, 4,
+        [&](const drc_violation<int>& v) { res.push_back(v); });
+    REQUIRE(res.size() == 2);
+    CHECK(res[0].a == 0);
+    CHECK(res[0].b == 0);
+    CHECK(res[0].value == 3);
+    CHECK(res[0].marker ==
+        rectangle<int> {interval<int> {0, 10}, interval<int> {10, 13}});
+    CHECK(res[1].a == 1);
+}
+
+TEST_CASE("DRC test (width)")
+{
+    // an L: a 10x2 foot and a 1-wide arm
+    auto L = std::vector<point<int>> {{0, 0}, {10, 2}, {1, 8}};
+    auto s = shape_set<int> {};
+    s.add(L);
+    s.add(rectangle<int> {interval<int> {20, 23}, interval<int> {0, 5}});
+    auto res = std::vector<drc_violation<int>> {};
+    check_width<int>(
+        s, 3, [&](const drc_violation<int>& v) { res.push_back(v); });
+    REQUIRE(res.size() == 2);
+    CHECK(res[0].a == 0);
+    CHECK(res[0].value == 1);
+    CHECK(res[0].marker ==
+        rectangle<int> {interval<int> {0, 1}, interval<int> {2, 8}});
+    CHECK(res[1].a == 0);
+    CHECK(res[1].value == 2);
+    CHECK(res[1].marker ==
+        rectangle<int> {interval<int> {1, 10}, interval<int> {0, 2}});
+}
+
+TEST_CASE("DRC test (enclosure)")
+{
+    auto vias = shape_set<int> {};
+    auto metal = shape_set<int> {};
+    metal.add(rectangle<int> {interval<int> {0, 10}, interval<int> {0, 10}});
+    metal.add(rectangle<int> {interval<int> {10, 20}, interval<int> {2, 8}});
+    vias.add(rectangle<int> {interval<int> {3, 5}, interval<int> {3, 5}});
+    vias.add(rectangle<int> {interval<int> {9, 11}, interval<int> {4, 6}});
+    vias.add(rectangle<int> {interval<int> {17, 19}, interval<int> {4, 6}});
+    vias.add(rectangle<int> {interval<int> {30, 31}, interval<int> {4, 6}});
+    auto res = std::vector<drc_violation<int>> {};
+    check_enclosure<int>(
+        vias, metal, 2, [&](const drc_violation<int>& v) { res.push_back(v); });
+    REQUIRE(res.size() == 2);
+    CHECK(res[0].a == 2);
+    CHECK(res[0].b == 1);
+    CHECK(res[0].value == 1);
+    CHECK(res[1].a == 3);
+    CHECK(res[1].b == UINT32_MAX);
+    CHECK(res[1].value == 0);
+}
+
+TEST_CASE("DRC test (enclosure against rails)")
+{
+    // full-width rails and wells next to many vias: every via is near
+    // a chip-wide outer piece
+    auto outer = std::vector<rectangle<int>> {};
+    for (auto y = 100; y < 2000; y += 200)
+    {
+        outer.emplace_back(interval<int> {0, 2000}, interval<int> {y, y + 20});
+    }
+    outer.emplace_back(interval<int> {0, 30}, interval<int> {0, 2000});
+    for (auto i = 0; i != 300; ++i)
+    {
+        const auto x = std::rand() % 2000;
+        const auto y = std::rand() % 2000;
+        outer.emplace_back(interval<int> {x, x + 1 + std::rand() % 40},
+            interval<int> {y, y + 1 + std::rand() % 40});
+    }
+    auto inner = std::vector<rectangle<int>> {};
+    for (auto i = 0; i != 3000; ++i)
+    {
+        const auto x = std::rand() % 1990;
+        const auto y = 95 + 200 * (std::rand() % 10) + std::rand() % 27;
+        inner.emplace_back(interval<int> {x, x + 1 + std::rand() % 4},
+            interval<int> {y, y + 1 + std::rand() % 4});
+    }
+    auto vias = shape_set<int> {};
+    auto metal = shape_set<int> {};
+    for (auto&& r : inner)
+    {
+        vias.add(r);
+    }
+    for (auto&& r : outer)
+    {
+        metal.add(r);
+    }
+
+    // brute force: a window is covered when each of its unit cells lies
+    // in some outer rectangle
+    auto covered = [&](const rectangle<int>& w)
+    {
+        auto near = std::vector<rectangle<int>> {};
+        for (auto&& c : outer)
+        {
+            if (c.overlaps(w))
+            {
+                near.push_back(c);
+            }
+        }
+        for (auto x = w.x().lower(); x != w.x().upper(); ++x)
+        {
+            for (auto y = w.y().lower(); y != w.y().upper(); ++y)
+            {
+                const auto cell = rectangle<int> {
+                    interval<int> {x, x + 1}, interval<int> {y, y + 1}};
+                if (std::none_of(near.begin(), near.end(),
+                        [&](auto&& c) { return c.contains(cell); }))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+    auto grow = [](const rectangle<int>& r, int m)
+    {
+        return rectangle<int> {
+            interval<int> {r.x().lower() - m, r.x().upper() + m},
+            interval<int> {r.y().lower() - m, r.y().upper() + m}};
+    };
+    const auto margin = 3;
+    auto ref = std::vector<std::tuple<std::uint32_t, std::uint32_t, int>> {};
+    for (auto i = 0U; i != inner.size(); ++i)
+    {
+        if (covered(grow(inner[i], margin)))
+        {
+            continue;
+        }
+        auto b = UINT32_MAX;
+        for (auto j = 0U; j != outer.size() && b == UINT32_MAX; ++j)
+        {
+            b = outer[j].overlaps(inner[i]) ? j : b;
+        }
+        auto value = margin - 1;
+        while (0 < value && !covered(grow(inner[i], value)))
+        {
+            --value;
+        }
+        ref.emplace_back(i, b, value);
+    }
+    CHECK(!ref.empty());
+    CHECK(ref.size() < inner.size());
+    for (auto nt : {1U, 4U})
+    {
+        auto got =
+            std::vector<std::tuple<std::uint32_t, std::uint32_t, int>> {};
+        check_enclosure<int>(
+            vias, metal, margin,
+            [&](const drc_violation<int>& v)
+            {
+                CHECK(v.rule == drc_rule::enclosure);
+                got.emplace_back(v.a, v.b, v.value);
+            },
+            nt);
+        CHECK(got == ref);
+    }
+}
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/empty_rect.hpp>
+#include <recti/recti.hpp>
+#include <tuple>
+#include <vector>
+
+using namespace recti;
+
+static auto key(const rectangle<int>& r)
+{
+    return std::make_tuple(
+        r.x().lower(), r.x().upper(), r.y().lower(), r.y().upper());
+}
+
+static auto is_empty(const rectangle<int>& r,
+    const std::vector<rectangle<int>>& obstacles) -> bool
+{
+    for (auto&& o : obstacles)
+    {
+        if (r.x().lower() < o.x().upper() && o.x().lower() < r.x().upper() &&
+            r.y().lower() < o.y().upper() && o.y().lower() < r.y().upper())
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// all empty rectangles on the integer grid that cannot grow by one unit
+static auto brute_force(const rectangle<int>& w,
+    const std::vector<rectangle<int>>& obstacles)
+    -> std::vector<rectangle<int>>
+{
+    auto res = std::vector<rectangle<int>> {};
+    const auto& X = w.x();
+    const auto& Y = w.y();
+    for (auto x0 = X.lower(); x0 < X.upper(); ++x0)
+    {
+        for (auto x1 = x0 + 1; x1 <= X.upper(); ++x1)
+        {
+            for (auto y0 = Y.lower(); y0 < Y.upper(); ++y0)
+            {
+                for (auto y1 = y0 + 1; y1 <= Y.upper(); ++y1)
+                {
+                    auto r = rectangle<int> {
+                        interval<int> {x0, x1}, interval<int> {y0, y1}};
+                    if (!is_empty(r, obstacles))
+                    {
+                        continue;
+                    }
+                    auto grows = [&](int a, int b, int c, int d)
+                    {
+                        if (a < X.lower() || X.upper() < b || c < Y.lower() ||
+                            Y.upper() < d)
+                        {
+                            return false;
+                        }
+                        return is_empty(rectangle<int> {interval<int> {a, b},
+                                            interval<int> {c, d}},
+                            obstacles);
+                    };
+                    if (!grows(x0 - 1, x1, y0, y1) &&
+                        !grows(x0, x1 + 1, y0, y1) &&
+                        !grows(x0, x1, y0 - 1, y1) &&
+                        !grows(x0, x1, y0, y1 + 1))
+                    {
+                        res.push_back(r);
+                    }
+                }
+            }
+        }
+    }
+    return res;
+}
+
+static auto random_obstacles(int n, int size) -> std::vector<rectangle<int>>
+{
+    auto obstacles = std::vector<rectangle<int>> {};
+    for (auto i = 0; i != n; ++i)
+    {
+        auto x = std::rand() % size - 2;
+        auto y = std::rand() % size - 2;
+        obstacles.emplace_back(interval<int> {x, x + 1 + std::rand() % 4},
+            interval<int> {y, y + 1 + std::rand() % 4});
+    }
+    return obstacles;
+}
+
+TEST_CASE("Maximal empty rectangles test")
+{
+    const auto window = rectangle<int> {interval<int> {0, 16},
+        interval<int> {0, 12}};
+    for (auto trial = 0; trial != 5; ++trial)
+    {
+        auto obstacles = random_obstacles(12, 18);
+        auto res = maximal_empty_rectangles<int>(window, obstacles);
+        auto ref = brute_force(window, obstacles);
+        auto by_key = [](const auto& a, const auto& b)
+        { return key(a) < key(b); };
+        std::sort(res.begin(), res.end(), by_key);
+        std::sort(ref.begin(), ref.end(), by_key);
+        REQUIRE(res.size() == ref.size());
+        for (auto i = 0U; i != res.size(); ++i)
+        {
+            CHECK(key(res[i]) == key(ref[i]));
+        }
+
+        auto top = largest_empty_rectangles<int>(window, obstacles, 3);
+        REQUIRE(top.size() == std::min<std::size_t>(3, ref.size()));
+        auto areas = std::vector<int> {};
+        for (auto&& r : ref)
+        {
+            areas.push_back(r.area());
+        }
+        std::sort(areas.rbegin(), areas.rend());
+        for (auto i = 0U; i != top.size(); ++i)
+        {
+            CHECK(top[i].area() == areas[i]);
+        }
+    }
+}
+
+TEST_CASE("Maximal empty rectangles test (dense and touching)")
+{
+    const auto window = rectangle<int> {interval<int> {0, 14},
+        interval<int> {0, 10}};
+    auto by_key = [](const auto& a, const auto& b) { return key(a) < key(b); };
+    for (auto trial = 0; trial != 40; ++trial)
+    {
+        // many overlapping, abutting and window-edge obstacles
+        auto obstacles = random_obstacles(4 + trial, 16);
+        obstacles.emplace_back(interval<int> {0, 14}, interval<int> {9, 12});
+        obstacles.emplace_back(interval<int> {3, 5}, interval<int> {-2, 1});
+        auto res = maximal_empty_rectangles<int>(window, obstacles);
+        auto ref = brute_force(window, obstacles);
+        std::sort(res.begin(), res.end(), by_key);
+        std::sort(ref.begin(), ref.end(), by_key);
+        REQUIRE(res.size() == ref.size());
+        for (auto i = 0U; i != res.size(); ++i)
+        {
+            CHECK(key(res[i]) == key(ref[i]));
+        }
+    }
+}
+
+TEST_CASE("Maximal empty rectangles test (many obstacles)")
+{
+    // far beyond what a dense grid over all edges could hold
+    const auto window = rectangle<int> {interval<int> {0, 2000000},
+        interval<int> {0, 2000000}};
+    auto obstacles = std::vector<rectangle<int>> {};
+    for (auto i = 0; i != 20000; ++i)
+    {
+        const auto x = std::rand() % 2000000;
+        const auto y = std::rand() % 2000000;
+        obstacles.emplace_back(interval<int> {x, x + 1 + std::rand() % 5000},
+            interval<int> {y, y + 1 + std::rand() % 5000});
+    }
+    const auto res = maximal_empty_rectangles<int>(window, obstacles);
+    CHECK(res.size() >= obstacles.size());
+    // a side is blocked by the window or an obstacle flush against it
+    auto blocked = [&](const rectangle<int>& r, int side)
+    {
+        const auto& X = r.x();
+        const auto& Y = r.y();
+        const auto& W = window;
+        if ((side == 0 && X.lower() == W.x().lower()) ||
+            (side == 1 && X.upper() == W.x().upper()) ||
+            (side == 2 && Y.lower() == W.y().lower()) ||
+            (side == 3 && Y.upper() == W.y().upper()))
+        {
+            return true;
+        }
+        for (auto&& o : obstacles)
+        {
+            const auto xs = X.lower() < o.x().upper() &&
+                o.x().lower() < X.upper();
+            const auto ys = Y.lower() < o.y().upper() &&
+                o.y().lower() < Y.upper();
+            if ((side == 0 && ys && o.x().upper() == X.lower()) ||
+                (side == 1 && ys && o.x().lower() == X.upper()) ||
+                (side == 2 && xs && o.y().upper() == Y.lower()) ||
+                (side == 3 && xs && o.y().lower() == Y.upper()))
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (auto i = 0U; i < res.size(); i += res.size() / 200 + 1)
+    {
+        CHECK(window.contains(res[i]));
+        CHECK(is_empty(res[i], obstacles));
+        for (auto side = 0; side != 4; ++side)
+        {
+            CHECK(blocked(res[i], side));
+        }
+    }
+    auto sorted = res;
+    auto by_key = [](const auto& a, const auto& b) { return key(a) < key(b); };
+    std::sort(sorted.begin(), sorted.end(), by_key);
+    CHECK(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+}
+
+TEST_CASE("Maximal empty rectangles test (tiled)")
+{
+    const auto window = rectangle<int> {interval<int> {0, 40},
+        interval<int> {0, 40}};
+    auto obstacles = random_obstacles(60, 44);
+    auto res = maximal_empty_rectangles_tiled<int>(window, obstacles, 4, 2, 3);
+    auto area = 0;
+    for (auto&& r : res)
+    {
+        CHECK(window.contains(r));
+        CHECK(is_empty(r, obstacles));
+        area = std::max(area, r.area());
+    }
+    // every tile-local result lies inside some global maximal rectangle
+    auto global = largest_empty_rectangles<int>(window, obstacles, 1);
+    REQUIRE(global.size() == 1);
+    CHECK(area <= global[0].area());
+    auto res2 = maximal_empty_rectangles_tiled<int>(window, obstacles, 4, 2, 1);
+    CHECK(res.size() == res2.size());
+
+    // same as sweeping every tile over the obstacles that touch it, with
+    // uneven last tiles and obstacles on and across the tile borders
+    const auto odd = rectangle<int> {interval<int> {0, 43},
+        interval<int> {0, 41}};
+    obstacles = random_obstacles(200, 47);
+    obstacles.emplace_back(interval<int> {8, 16}, interval<int> {13, 26});
+    obstacles.emplace_back(interval<int> {-5, 50}, interval<int> {20, 21});
+    auto want = std::vector<rectangle<int>> {};
+    for (auto ty = 0; ty != 3; ++ty)
+    {
+        for (auto tx = 0; tx != 5; ++tx)
+        {
+            const auto tile = rectangle<int> {
+                interval<int> {8 * tx, tx == 4 ? 43 : 8 * tx + 8},
+                interval<int> {13 * ty, ty == 2 ? 41 : 13 * ty + 13}};
+            auto local = std::vector<rectangle<int>> {};
+            for (auto&& o : obstacles)
+            {
+                if (o.overlaps(tile))
+                {
+                    local.push_back(o);
+                }
+            }
+            const auto v = maximal_empty_rectangles<int>(tile, local);
+            want.insert(want.end(), v.begin(), v.end());
+        }
+    }
+    for (auto nt : {1U, 3U})
+    {
+        CHECK(maximal_empty_rectangles_tiled<int>(odd, obstacles, 5, 3, nt) ==
+            want);
+    }
+
+    // more tiles than units of length: one tile per unit at most
+    const auto thin = rectangle<int> {interval<int> {0, 3},
+        interval<int> {0, 40}};
+    const auto many =
+        maximal_empty_rectangles_tiled<int>(thin, obstacles, 8, 2);
+    CHECK(many == maximal_empty_rectangles_tiled<int>(thin, obstacles, 3, 2));
+    for (auto&& r : many)
+    {
+        CHECK(0 < r.x().len());
+    }
+}
+
+TEST_CASE("Maximal empty rectangles test (no obstacles)")
+{
+    const auto window = rectangle<int> {interval<int> {0, 5},
+        interval<int> {0, 3}};
+    auto res = maximal_empty_rectangles<int>(window, {});
+    REQUIRE(res.size() == 1);
+    CHECK(res[0] == window);
+}
@@ -0,0 +1,195 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <doctest/doctest.h>
+#include <recti/gdsii.hpp>
+#include <recti/polygon.hpp>
+#include <recti/recti.hpp>
+#include <recti/rpolygon.hpp>
+#include <sstream>
+#include <vector>
+
+using namespace recti;
+
+static auto as_bytes(const std::string& s) -> gsl::span<const std::byte>
+{
+    return {reinterpret_cast<const std::byte*>(s.data()), s.size()};
+}
+
+TEST_CASE("GDSII test (round trip)")
+{
+    auto rects = std::vector<rectangle<int>> {};
+    auto polys = std::vector<std::vector<point<int>>> {};
+    auto os = std::ostringstream {};
+    auto w = gds_writer<int> {os, "TOP_LIB", 1e-3, 1e-9};
+    for (auto s = 0; s != 3; ++s)
+    {
+        w.begin_structure("CELL" + std::to_string(s));
+        for (auto i = 0; i != 500; ++i)
+        {
+            const auto x = std::rand() % 100000 - 50000;
+            const auto y = std::rand() % 100000 - 50000;
+            rects.emplace_back(interval<int> {x, x + 1 + std::rand() % 900},
+                interval<int> {y, y + 1 + std::rand() % 900});
+            w.write(rects.back(), std::int16_t(s), 0, i % 5 == 0);
+            if (i % 50 == 0)
+            {
+                auto S = std::vector<point<int>> {};
+                for (auto k = 0; k != 12; ++k)
+                {
+                    S.emplace_back(std::rand() % 1000, std::rand() % 1000);
+                }
+                create_xmono_rpolygon(S.begin(), S.end());
+                CHECK(w.write_rpolygon(S, 40));
+                polys.push_back(S);
+            }
+        }
+    }
+    const auto tri = std::vector<point<int>> {{0, 0}, {100, 0}, {0, 50}};
+    CHECK(w.write_polygon(tri, 7, 3));
+    // rejected without writing anything
+    CHECK(!w.write_polygon(std::vector<point<int>> {}, 7));
+    CHECK(!w.write_rpolygon(std::vector<point<int>> {}, 7));
+    REQUIRE(w.finish());
+    auto data = os.str();
+    data.append(300, '\0'); // tape-style padding after ENDLIB
+
+    for (auto nt : {1U, 4U})
+    {
+        auto parts = std::vector<std::vector<gds_shape<int>>>(nt + 1);
+        auto sets = std::vector<std::vector<std::vector<point<int>>>>(nt + 1);
+        auto lib = gds_library {};
+        const auto status = read_gdsii<int>(
+            as_bytes(data),
+            [&](unsigned part, const gds_shape<int>& s)
+            {
+                parts[part].push_back(s);
+                sets[part].emplace_back(s.points.begin(), s.points.end());
+            },
+            &lib, nt);
+        REQUIRE(status == gds_status::ok);
+        CHECK(lib.name == "TOP_LIB");
+        CHECK(lib.num_structures == 3);
+        CHECK(std::abs(lib.user_unit - 1e-3) < 1e-15);
+        CHECK(std::abs(lib.meter_unit - 1e-9) < 1e-21);
+
+        auto r = 0U;
+        auto p = 0U;
+        auto n_tri = 0;
+        for (auto k = 0U; k != parts.size(); ++k)
+        {
+            for (auto i = 0U; i != parts[k].size(); ++i)
+            {
+                const auto& s = parts[k][i];
+                const auto& S = sets[k][i];
+                if (s.layer == 40)
+                {
+                    REQUIRE(p < polys.size());
+                    CHECK(s.kind == gds_shape_kind::rpolygon);
+                    const auto a = rpolygon<int>(S).signed_area();
+                    const auto b = rpolygon<int>(polys[p]).signed_area();
+                    CHECK(std::abs(a) == std::abs(b));
+                    ++p;
+                }
+                else if (s.layer == 7)
+                {
+                    CHECK(s.kind == gds_shape_kind::polygon);
+                    CHECK(s.datatype == 3);
+                    CHECK(S == tri);
+                    CHECK(s.structure == 2);
+                    ++n_tri;
+                }
+                else
+                {
+                    REQUIRE(r < rects.size());
+                    CHECK(s.kind == gds_shape_kind::rectangle);
+                    CHECK(s.bbox == rects[r]);
+                    CHECK(s.structure == r / 500);
+                    CHECK(s.layer == std::int16_t(r / 500));
+                    ++r;
+                }
+            }
+        }
+        CHECK(r == rects.size());
+        CHECK(p == polys.size());
+        CHECK(n_tri == 1);
+    }
+}
+
+TEST_CASE("GDSII test (errors)")
+{
+    auto os = std::ostringstream {};
+    auto w = gds_writer<int> {os, "L"};
+    w.begin_structure("A");
+    for (auto i = 0; i != 100; ++i)
+    {
+        w.write(rectangle<int> {interval<int> {i, i + 5},
+                    interval<int> {0, 5}},
+            1);
+    }
+    REQUIRE(w.finish());
+    const auto data = os.str();
+    auto count = 0;
+    auto fn = [&](unsigned, const gds_shape<int>&) { ++count; };
+
+    CHECK(read_gdsii<int>(as_bytes(data.substr(0, data.size() - 30)), fn,
+              nullptr, 3) == gds_status::truncated);
+    CHECK(read_gdsii<int>(as_bytes(data.substr(6)), fn) ==
+        gds_status::bad_header);
+    auto bad = data;
+    bad[bad.size() - 11] = '\x03'; // length of the last ENDEL
+    count = 0;
+    CHECK(read_gdsii<int>(as_bytes(bad), fn, nullptr, 1) ==
+        gds_status::bad_record);
+    CHECK(count == 99);
+
+    // coordinates beyond int32 are refused, not wrapped
+    auto os64 = std::ostringstream {};
+    auto w64 = gds_writer<std::int64_t> {os64, "L"};
+    w64.begin_structure("A");
+    const auto size = os64.str().size();
+    const auto big = std::int64_t(INT32_MAX) + 1;
+    CHECK(!w64.write(rectangle<std::int64_t> {
+                         interval<std::int64_t> {0, big},
+                         interval<std::int64_t> {0, 5}},
+        1));
+    const auto far = std::vector<point<std::int64_t>> {
+        {0, 0}, {5, 0}, {0, std::int64_t(INT32_MIN) - 1}};
+    CHECK(!w64.write_polygon(far, 1));
+    CHECK(os64.str().size() == size);
+    CHECK(w64.write(rectangle<std::int64_t> {
+                        interval<std::int64_t> {INT32_MIN, INT32_MAX},
+                        interval<std::int64_t> {0, 5}},
+        1));
+
+    // degenerate boundaries enclose nothing and are skipped
+    auto os2 = std::ostringstream {};
+    auto w2 = gds_writer<int> {os2, "L"};
+    w2.begin_structure("A");
+    const auto line =
+        std::vector<point<int>> {{0, 0}, {5, 0}, {9, 0}, {2, 0}};
+    const auto dot = std::vector<point<int>> {{3, 4}, {3, 4}, {3, 4}};
+    const auto slant = std::vector<point<int>> {{0, 0}, {2, 1}, {6, 3}};
+    REQUIRE(w2.write_polygon(line, 1));
+    REQUIRE(w2.write_polygon(dot, 2));
+    REQUIRE(w2.write_polygon(slant, 3));
+    REQUIRE(w2.write(rectangle<int> {interval<int> {0, 9},
+                         interval<int> {0, 0}},
+        4, 0, true));
+    const auto tri = std::vector<point<int>> {{0, 0}, {4, 0}, {0, 3}};
+    REQUIRE(w2.write_polygon(tri, 5));
+    REQUIRE(w2.finish());
+    const auto data2 = os2.str();
+    auto shapes = std::vector<gds_shape<int>> {};
+    CHECK(read_gdsii<int>(
+              as_bytes(data2),
+              [&](unsigned, const gds_shape<int>& s) { shapes.push_back(s); },
+              nullptr, 1) == gds_status::ok);
+    REQUIRE(shapes.size() == 2);
+    CHECK(shapes[0].layer == 4); // a BOX is passed as written
+    CHECK(shapes[0].kind == gds_shape_kind::rectangle);
+    CHECK(shapes[0].bbox.area() == 0);
+    CHECK(shapes[1].layer == 5);
+    CHECK(shapes[1].kind == gds_shape_kind::polygon);
+}
@@ -0,0 +1,90 @@
+#include <algorithm>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/grid_index.hpp>
+#include <recti/halton_int.hpp>
+#include <recti/recti.hpp>
+#include <vector>
+
+using namespace recti;
+
+static auto brute_query(
+    const std::vector<rectangle<int>>& shapes, const rectangle<int>& window)
+    -> std::vector<std::size_t>
+{
+    auto res = std::vector<std::size_t> {};
+    for (auto i = 0U; i != shapes.size(); ++i)
+    {
+        if (shapes[i].overlaps(window))
+        {
+            res.push_back(i);
+        }
+    }
+    return res;
+}
+
+TEST_CASE("Grid index test (rectangles)")
+{
+    auto shapes = std::vector<rectangle<int>> {};
+    for (auto i = 0; i != 500; ++i)
+    {
+        auto x = std::rand() % 1000;
+        auto y = std::rand() % 1000;
+        shapes.emplace_back(interval<int> {x, x + std::rand() % 60},
+            interval<int> {y, y + std::rand() % 60});
+    }
+    auto extent =
+        rectangle<int> {interval<int> {0, 1000}, interval<int> {0, 1000}};
+    auto G = grid_index<int> {extent, 50};
+    G.build(shapes, 1);
+    CHECK(G.size() == 500);
+
+    for (auto k = 0; k != 100; ++k)
+    {
+        auto x = std::rand() % 1100 - 50;
+        auto y = std::rand() % 1100 - 50;
+        auto window = rectangle<int> {interval<int> {x, x + std::rand() % 200},
+            interval<int> {y, y + std::rand() % 200}};
+        auto res = G.query(window);
+        std::sort(res.begin(), res.end());
+        CHECK(std::adjacent_find(res.begin(), res.end()) == res.end());
+        CHECK(res == brute_query(shapes, window));
+    }
+
+    // the parallel build produces the same layout as the serial one
+    auto G4 = grid_index<int> {extent, 50};
+    G4.build(shapes, 4);
+    for (auto iy = 0U; iy != G.dims().second; ++iy)
+    {
+        for (auto ix = 0U; ix != G.dims().first; ++ix)
+        {
+            auto a = G.bin(ix, iy);
+            auto b = G4.bin(ix, iy);
+            CHECK(std::equal(a.begin(), a.end(), b.begin(), b.end()));
+        }
+    }
+}
+
+TEST_CASE("Grid index test (points)")
+{
+    auto hgenX = vdcorput(3, 7);
+    auto hgenY = vdcorput(2, 11);
+    auto S = std::vector<point<int>> {};
+    for (auto i = 0; i != 300; ++i)
+    {
+        S.emplace_back(point<int>(hgenX(), hgenY()));
+    }
+    auto extent =
+        rectangle<int> {interval<int> {0, 2187}, interval<int> {0, 2048}};
+    auto G = grid_index<int> {extent, 100, 128};
+    G.build(S);
+
+    auto window =
+        rectangle<int> {interval<int> {300, 900}, interval<int> {500, 1500}};
+    auto count = 0U;
+    for (auto&& p : S)
+    {
+        count += window.contains(p) ? 1 : 0;
+    }
+    CHECK(G.query(window).size() == count);
+}
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/hierarchy.hpp>
+#include <recti/polygon.hpp>
+#include <recti/recti.hpp>
+#include <recti/rpolygon.hpp>
+#include <tuple>
+#include <vector>
+
+using namespace recti;
+
+using hit = std::tuple<std::uint32_t, std::uint32_t, int, int>;
+
+struct flat_shape
+{
+    std::uint32_t cell;
+    std::uint32_t shape;
+    vector2<int> offset;
+};
+
+static void flatten(const cell_hierarchy<int>& h, std::uint32_t cell,
+    const vector2<int>& offset, std::vector<flat_shape>& out)
+{
+    for (auto s = 0U; s != h.num_shapes(cell); ++s)
+    {
+        out.push_back(flat_shape {cell, s, offset});
+    }
+    for (auto&& inst : h.instances(cell))
+    {
+        auto placed = offset;
+        placed += inst.offset;
+        flatten(h, inst.cell, placed, out);
+    }
+}
+
+static auto placed_bbox(const cell_hierarchy<int>& h, const flat_shape& f)
+    -> rectangle<int>
+{
+    const auto& b = h.bbox(f.cell, f.shape);
+    return {interval<int> {b.x().lower() + f.offset.x(),
+                b.x().upper() + f.offset.x()},
+        interval<int> {
+            b.y().lower() + f.offset.y(), b.y().upper() + f.offset.y()}};
+}
+
+TEST_CASE("Hierarchy test (queries against flattening)")
+{
+    auto h = cell_hierarchy<int> {};
+    // leaves: a few rectangles and rectilinear / general polygons
+    auto leaves = std::vector<std::uint32_t> {};
+    for (auto l = 0; l != 4; ++l)
+    {
+        const auto c = h.add_cell();
+        leaves.push_back(c);
+        for (auto i = 0; i != 5 + 20 * l; ++i)
+        {
+            const auto x = std::rand() % 200;
+            const auto y = std::rand() % 200;
+            h.add(c,
+                rectangle<int> {interval<int> {x, x + 1 + std::rand() % 30},
+                    interval<int> {y, y + 1 + std::rand() % 30}});
+        }
+        auto S = std::vector<point<int>> {};
+        for (auto k = 0; k != 10; ++k)
+        {
+            S.emplace_back(std::rand() % 200, std::rand() % 200);
+        }
+        auto P = S;
+        create_xmono_rpolygon(S.begin(), S.end());
+        h.add_rpolygon(c, S);
+        create_xmono_polygon(P.begin(), P.end());
+        h.add_polygon(c, P);
+    }
+    const auto empty_cell = h.add_cell();
+    // blocks: arrays of leaves
+    auto blocks = std::vector<std::uint32_t> {};
+    for (auto b = 0; b != 3; ++b)
+    {
+        const auto c = h.add_cell();
+        blocks.push_back(c);
+        for (auto i = 0; i != 60; ++i)
+        {
+            h.add_instance(c, leaves[std::size_t(std::rand() % 4)],
+                vector2<int> {(i % 10) * 250, (i / 10) * 250});
+        }
+        h.add_instance(c, empty_cell, vector2<int> {-5000, 0});
+        h.add(c,
+            rectangle<int> {interval<int> {0, 2500}, interval<int> {-10, 0}});
+    }
+    const auto top = h.add_cell();
+    for (auto i = 0; i != 40; ++i)
+    {
+        h.add_instance(top, blocks[std::size_t(std::rand() % 3)],
+            vector2<int> {std::rand() % 20000 - 10000, std::rand() % 20000});
+    }
+    h.add_instance(top, leaves[0], vector2<int> {-300, -300});
+    REQUIRE(h.build(2));
+    CHECK(h.empty(empty_cell));
+    CHECK_FALSE(h.empty(top));
+
+    auto flat = std::vector<flat_shape> {};
+    flatten(h, top, vector2<int> {0, 0}, flat);
+    REQUIRE(h.flat_size(top) == flat.size());
+    // the hierarchy stores far fewer shapes than the flattened layout
+    auto stored = std::size_t(0);
+    for (auto c = 0U; c != h.num_cells(); ++c)
+    {
+        stored += h.num_shapes(c);
+    }
+    CHECK(stored * 20 < flat.size());
+
+    auto ext = placed_bbox(h, flat.front());
+    for (auto&& f : flat)
+    {
+        const auto b = placed_bbox(h, f);
+        ext = rectangle<int> {
+            interval<int> {std::min(ext.x().lower(), b.x().lower()),
+                std::max(ext.x().upper(), b.x().upper())},
+            interval<int> {std::min(ext.y().lower(), b.y().lower()),
+                std::max(ext.y().upper(), b.y().upper())}};
+    }
+    CHECK(h.extent(top) == ext);
+
+    for (auto t = 0; t != 200; ++t)
+    {
+        const auto x = std::rand() % 26000 - 13000;
+        const auto y = std::rand() % 24000 - 1000;
+        const auto s = t % 10 == 0 ? 5000 : std::rand() % 400;
+        const auto w =
+            rectangle<int> {interval<int> {x, x + s}, interval<int> {y, y + s}};
+        auto got = std::vector<hit> {};
+        h.query(top, w,
+            [&](std::uint32_t c, std::uint32_t i, const vector2<int>& off)
+            { got.emplace_back(c, i, off.x(), off.y()); });
+        auto want = std::vector<hit> {};
+        for (auto&& f : flat)
+        {
+            if (placed_bbox(h, f).overlaps(w))
+            {
+                want.emplace_back(f.cell, f.shape, f.offset.x(), f.offset.y());
+            }
+        }
+        std::sort(got.begin(), got.end());
+        std::sort(want.begin(), want.end());
+        CHECK(got == want);
+    }
+
+    for (auto t = 0; t != 500; ++t)
+    {
+        const auto q = point<int> {
+            std::rand() % 26000 - 13000, std::rand() % 24000 - 1000};
+        auto got = std::vector<hit> {};
+        h.query(top, q,
+            [&](std::uint32_t c, std::uint32_t i, const vector2<int>& off)
+            { got.emplace_back(c, i, off.x(), off.y()); });
+        auto want = std::vector<hit> {};
+        for (auto&& f : flat)
+        {
+            auto inside = placed_bbox(h, f).contains(q);
+            if (inside && h.is_polygon(f.cell, f.shape))
+            {
+                // the reference moves the shape, the query moved the point
+                auto S = std::vector<point<int>> {};
+                for (auto&& p : h.polygon(f.cell, f.shape))
+                {
+                    S.push_back(p);
+                    S.back() += f.offset;
+                }
+                inside = h.is_rectilinear(f.cell, f.shape)
+                    ? point_in_rpolygon<int>(S, q)
+                    : point_in_polygon<int>(S, q);
+            }
+            if (inside)
+            {
+                want.emplace_back(f.cell, f.shape, f.offset.x(), f.offset.y());
+            }
+        }
+        std::sort(got.begin(), got.end());
+        std::sort(want.begin(), want.end());
+        CHECK(got == want);
+    }
+}
+
+TEST_CASE("Hierarchy test (cycles)")
+{
+    auto h = cell_hierarchy<int> {};
+    const auto a = h.add_cell();
+    const auto b = h.add_cell();
+    const auto c = h.add_cell();
+    h.add(c, rectangle<int> {interval<int> {0, 1}, interval<int> {0, 1}});
+    h.add_instance(a, b, vector2<int> {1, 0});
+    h.add_instance(b, c, vector2<int> {0, 1});
+    REQUIRE(h.build(1));
+    CHECK(h.extent(a) ==
+        rectangle<int> {interval<int> {1, 2}, interval<int> {1, 2}});
+    h.add_instance(c, a, vector2<int> {5, 5});
+    CHECK_FALSE(h.build(1));
+}
@@ -0,0 +1,77 @@
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/hpwl.hpp>
+#include <recti/netlist.hpp>
+#include <recti/recti.hpp>
+#include <vector>
+
+using namespace recti;
+
+TEST_CASE("HPWL test")
+{
+    auto S = std::vector<point<int>> {{1, 5}, {4, 2}, {3, 9}};
+    CHECK(hpwl<int>(S) == 3 + 7);
+}
+
+TEST_CASE("HPWL engine test")
+{
+    constexpr auto num_cells = 200;
+    auto cells = std::vector<point<int>> {};
+    for (auto i = 0; i != num_cells; ++i)
+    {
+        cells.emplace_back(point<int>(std::rand() % 100, std::rand() % 100));
+    }
+    auto nl = netlist<int> {};
+    for (auto e = 0; e != 300; ++e)
+    {
+        const auto deg = 2 + std::rand() % 6;
+        for (auto k = 0; k != deg; ++k)
+        {
+            nl.add_pin(std::uint32_t(std::rand() % num_cells),
+                vector2<int> {std::rand() % 3, std::rand() % 3});
+        }
+        nl.close_net();
+    }
+    nl.close_net(); // an empty net
+    CHECK(nl.num_nets() == 301);
+
+    auto brute = [&]()
+    {
+        auto total = 0;
+        for (auto e = 0U; e != nl.num_nets(); ++e)
+        {
+            auto pts = std::vector<point<int>> {};
+            for (auto p = nl.net_start[e]; p != nl.net_start[e + 1]; ++p)
+            {
+                pts.push_back(cells[nl.pin_cell[p]] + nl.pin_offset[p]);
+            }
+            total += pts.empty() ? 0 : hpwl<int>(pts);
+        }
+        return total;
+    };
+
+    auto H = hpwl_engine<int> {nl, cells, 4};
+    CHECK(H.total() == brute());
+
+    for (auto k = 0; k != 2000; ++k)
+    {
+        const auto c = std::size_t(std::rand() % num_cells);
+        // mostly small displacements, as in detailed placement
+        auto pos = cells[c] + vector2<int> {std::rand() % 7 - 3,
+                                  std::rand() % 7 - 3};
+        if (k % 10 == 0)
+        {
+            pos = point<int>(std::rand() % 100, std::rand() % 100);
+        }
+        cells[c] = pos;
+        H.move_cell(c, pos);
+        if (k % 100 == 0)
+        {
+            CHECK(H.total() == brute());
+        }
+    }
+    CHECK(H.total() == brute());
+    CHECK(H.num_rescans() > 0);
+    auto total = H.total();
+    CHECK(H.recompute(1) == total);
+}
@@ -0,0 +1,108 @@
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/drc.hpp>
+#include <recti/incremental_drc.hpp>
+#include <recti/recti.hpp>
+#include <set>
+#include <tuple>
+#include <vector>
+
+using namespace recti;
+
+using vkey = std::tuple<int, std::uint32_t, std::uint32_t, int>;
+
+static auto to_key(const drc_violation<int>& v) -> vkey
+{
+    return {int(v.rule), v.a, v.b, v.value};
+}
+
+/// full check of the live shapes, in terms of incremental_drc ids
+static auto full_check(const incremental_drc<int>& drc) -> std::set<vkey>
+{
+    auto s = shape_set<int> {};
+    auto ids = std::vector<std::uint32_t> {};
+    auto res = std::set<vkey> {};
+    for (auto i = 0U; i != drc.size(); ++i)
+    {
+        if (!drc.alive(i))
+        {
+            continue;
+        }
+        const auto& r = drc.shape(i);
+        s.add(r);
+        ids.push_back(i);
+        const auto w = std::min(r.x().len(), r.y().len());
+        if (w < 3)
+        {
+            res.insert(vkey {int(drc_rule::width), i, i, w});
+        }
+    }
+    check_spacing<int>(
+        s, 5,
+        [&](const drc_violation<int>& v)
+        {
+            res.insert(vkey {int(v.rule), ids[v.a], ids[v.b], v.value});
+        },
+        1);
+    return res;
+}
+
+static auto random_rect() -> rectangle<int>
+{
+    const auto x = std::rand() % 500;
+    const auto y = std::rand() % 500;
+    return {interval<int> {x, x + 1 + std::rand() % 8},
+        interval<int> {y, y + 1 + std::rand() % 8}};
+}
+
+TEST_CASE("Incremental DRC test")
+{
+    auto drc = incremental_drc<int> {
+        rectangle<int> {interval<int> {0, 500}, interval<int> {0, 500}}, 20,
+        5, 3};
+    for (auto i = 0; i != 800; ++i)
+    {
+        drc.insert(random_rect());
+    }
+    auto current = std::set<vkey> {};
+    for (auto batch = 0; batch != 12; ++batch)
+    {
+        if (batch != 0)
+        {
+            for (auto e = 0; e != 25; ++e)
+            {
+                const auto id = std::uint32_t(std::rand() % drc.size());
+                switch (std::rand() % 3)
+                {
+                case 0:
+                    drc.insert(random_rect());
+                    break;
+                case 1:
+                    if (drc.alive(id))
+                    {
+                        drc.remove(id);
+                    }
+                    break;
+                default:
+                    if (drc.alive(id))
+                    {
+                        drc.move(id, random_rect());
+                    }
+                    break;
+                }
+            }
+        }
+        const auto delta = drc.commit(batch % 2 == 0 ? 1 : 4);
+        for (auto&& v : delta.cleared)
+        {
+            CHECK(current.erase(to_key(v)) == 1);
+        }
+        for (auto&& v : delta.added)
+        {
+            CHECK(current.insert(to_key(v)).second);
+        }
+        const auto ref = full_check(drc);
+        CHECK(current == ref);
+        CHECK(drc.num_violations() == ref.size());
+    }
+}
@@ -0,0 +1,94 @@
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/interval_set.hpp>
+#include <recti/recti.hpp>
+#include <vector>
+
+using namespace recti;
+
+TEST_CASE("Interval set test")
+{
+    auto S = interval_set<int> {};
+    S.insert(interval<int> {10, 20});
+    S.insert(interval<int> {30, 40});
+    S.insert(interval<int> {0, 5});
+    CHECK(S.size() == 3);
+    S.insert(interval<int> {20, 25}); // touches [10, 20]
+    CHECK(S.size() == 3);
+    CHECK(S[1] == interval<int> {10, 25});
+    S.insert(interval<int> {4, 32}); // swallows the middle
+    CHECK(S.size() == 1);
+    CHECK(S[0] == interval<int> {0, 40});
+    CHECK(S.measure() == 40);
+
+    auto ivs =
+        std::vector<interval<int>> {{50, 60}, {0, 10}, {5, 12}, {70, 70}};
+    auto A = interval_set<int> {ivs};
+    CHECK(A.size() == 3);
+    CHECK(A.contains(0));
+    CHECK(A.contains(12));
+    CHECK(!A.contains(13));
+    CHECK(A.contains(70));
+    CHECK(A.contains(interval<int> {52, 60}));
+    CHECK(!A.contains(interval<int> {10, 55}));
+
+    CHECK(A.first_gap(0, 5) == 12);
+    CHECK(A.first_gap(0, 38) == 12);
+    CHECK(A.first_gap(0, 39) == 70);
+    CHECK(A.first_gap(13, 2) == 13);
+    CHECK(A.first_gap(55, 100) == 70);
+}
+
+TEST_CASE("Interval set test (set operations)")
+{
+    auto a = std::vector<interval<int>> {{0, 10}, {20, 30}, {40, 50}};
+    auto b = std::vector<interval<int>> {{5, 22}, {28, 29}, {35, 36}};
+    auto A = interval_set<int> {a};
+    auto B = interval_set<int> {b};
+
+    auto U = A.unite(B);
+    auto u = std::vector<interval<int>> {{0, 30}, {35, 36}, {40, 50}};
+    CHECK(U == interval_set<int> {u});
+
+    auto I = A.intersect(B);
+    auto i = std::vector<interval<int>> {{5, 10}, {20, 22}, {28, 29}};
+    CHECK(I == interval_set<int> {i});
+
+    auto P = interval_set<int> {a}.subtract(
+        interval_set<int> {std::vector<interval<int>> {{5, 5}}});
+    CHECK(P.size() == 3); // removing a point keeps the closure
+
+    auto D = A.subtract(B);
+    auto d = std::vector<interval<int>> {{0, 5}, {22, 28}, {29, 30}, {40, 50}};
+    CHECK(D == interval_set<int> {d});
+
+    // randomized: compare pointwise against the definitions
+    for (auto trial = 0; trial != 20; ++trial)
+    {
+        auto r1 = std::vector<interval<int>> {};
+        auto r2 = std::vector<interval<int>> {};
+        for (auto k = 0; k != 10; ++k)
+        {
+            auto x = std::rand() % 200;
+            r1.emplace_back(x, x + std::rand() % 20);
+            auto y = std::rand() % 200;
+            r2.emplace_back(y, y + std::rand() % 20);
+        }
+        auto X = interval_set<int> {r1};
+        auto Y = interval_set<int> {r2};
+        auto XU = X.unite(Y);
+        auto XI = X.intersect(Y);
+        for (auto p = -1; p != 222; ++p)
+        {
+            CHECK(XU.contains(p) == (X.contains(p) || Y.contains(p)));
+            CHECK(XI.contains(p) == (X.contains(p) && Y.contains(p)));
+        }
+        auto incremental = X;
+        for (auto&& c : r2)
+        {
+            incremental.insert(c);
+        }
+        CHECK(incremental == XU);
+        CHECK(X.subtract(Y).measure() == X.measure() - XI.measure());
+    }
+}
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/halton_int.hpp>
+#include <recti/l1_nearest.hpp>
+#include <recti/recti.hpp>
+#include <utility>
+#include <vector>
+
+using namespace recti;
+
+static auto brute_knn(const std::vector<point<int>>& S, const point<int>& q,
+    std::size_t k) -> std::vector<std::size_t>
+{
+    auto cand = std::vector<std::pair<int, std::size_t>> {};
+    for (auto i = 0U; i != S.size(); ++i)
+    {
+        cand.emplace_back(manhattan_distance(q, S[i]), i);
+    }
+    std::sort(cand.begin(), cand.end());
+    auto res = std::vector<std::size_t> {};
+    for (auto i = 0U; i != std::min(k, cand.size()); ++i)
+    {
+        res.push_back(cand[i].second);
+    }
+    return res;
+}
+
+TEST_CASE("Manhattan distance")
+{
+    CHECK(manhattan_distance(point<int> {1, 2}, point<int> {4, -2}) == 7);
+    CHECK(manhattan_distance(point<int> {4, -2}, point<int> {1, 2}) == 7);
+}
+
+TEST_CASE("L1 nearest neighbour test")
+{
+    auto hgenX = vdcorput(3, 7);
+    auto hgenY = vdcorput(2, 11);
+    auto S = std::vector<point<int>> {};
+    for (auto i = 0; i != 400; ++i)
+    {
+        S.emplace_back(point<int>(hgenX(), hgenY()));
+    }
+    // duplicates and collinear pins (a power rail)
+    for (auto i = 0; i != 50; ++i)
+    {
+        S.emplace_back(point<int>(i * 40, 1000));
+        S.emplace_back(point<int>(i * 40, 1000));
+    }
+    auto T = l1_kdtree<int>(S);
+    CHECK(T.size() == S.size());
+
+    auto Q = std::vector<point<int>> {};
+    for (auto i = 0; i != 200; ++i)
+    {
+        Q.emplace_back(point<int>(std::rand() % 2400, std::rand() % 2200));
+    }
+    auto nn = T.nearest(Q, 4);
+    auto knn = T.knn(Q, 5, 4);
+    CHECK(knn.size() == Q.size() * 5);
+    for (auto i = 0U; i != Q.size(); ++i)
+    {
+        auto expect = brute_knn(S, Q[i], 5);
+        CHECK(T.nearest(Q[i]) == expect[0]);
+        CHECK(nn[i] == expect[0]);
+        CHECK(T.knn(Q[i], 5) == expect);
+        CHECK(std::equal(expect.begin(), expect.end(), knn.begin() + i * 5));
+    }
+}
+
+TEST_CASE("L1 nearest neighbour test (small)")
+{
+    auto S = std::vector<point<int>> {{0, 0}, {5, 5}};
+    auto T = l1_kdtree<int>(S);
+    CHECK(T.nearest(point<int> {4, 4}) == 1);
+    CHECK(T.knn(point<int> {4, 4}, 10) == std::vector<std::size_t> {1, 0});
+}
@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/lef_def.hpp>
+#include <recti/recti.hpp>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace recti;
+
+static const char* const lef_text = R"(VERSION 5.8 ;
+BUSBITCHARS "[]" ;
+UNITS
+  DATABASE MICRONS 1000 ;
+END UNITS
+LAYER metal1
+  TYPE ROUTING ;
+  WIDTH 0.1 ;
+END metal1
+SITE core
+  SIZE 0.2 BY 2.0 ;
+END core
+# a comment ; with a semicolon
+MACRO INV
+  CLASS CORE ;
+  ORIGIN 0 0 ;
+  SIZE 0.8 BY 2.0 ;
+  SITE core ;
+  PIN A
+    DIRECTION INPUT ;
+    PORT
+      LAYER metal1 ;
+        RECT 0.1 0.4 0.3 0.8 ;
+    END
+  END A
+  PIN Y
+    PORT
+      LAYER metal1 ;
+        RECT MASK 1 0.5 1.0 0.7 1.6 ;
+    END
+  END Y
+  OBS
+    LAYER metal1 ;
+      RECT 0 0 0.8 0.1 ;
+  END
+END INV
+MACRO NAND2
+  CLASS CORE ;
+  ORIGIN 0.1 0.2 ;
+  SIZE 1.2 BY 2.0 ;
+  PIN Y
+    PORT
+      LAYER metal1 ;
+        RECT 0.9 0.1 1.0 0.3 ;
+        RECT 0.9 0.6 1.0 0.7 ;
+    END
+  END Y
+END NAND2
+END LIBRARY
+)";
+
+/**
+ * @brief DEF orientation applied to (x, y) about the origin: rotate
+ * counter-clockwise by 90 degrees per step (N, W, S, E), then mirror
+ * about the y axis for the flipped ones
+ */
+static auto turn(int o, int x, int y) -> std::pair<int, int>
+{
+    auto r = std::pair<int, int> {x, y};
+    for (auto k = 0; k != o % 4; ++k)
+    {
+        r = {-r.second, r.first};
+    }
+    if (o >= 4)
+    {
+        r.first = -r.first;
+    }
+    return r;
+}
+
+/**
+ * @brief where (x, y) of a w x h cell lands relative to the lower-left
+ * corner of the placed footprint
+ */
+static auto placed(int o, int x, int y, int w, int h) -> std::pair<int, int>
+{
+    const auto a = turn(o, 0, 0);
+    const auto b = turn(o, w, h);
+    const auto p = turn(o, x, y);
+    return {p.first - std::min(a.first, b.first),
+        p.second - std::min(a.second, b.second)};
+}
+
+TEST_CASE("LEF/DEF test (LEF)")
+{
+    auto lib = lef_library<int> {};
+    REQUIRE(parse_lef<int>(lef_text, lib) == lef_def_status::ok);
+    REQUIRE(lib.macros.size() == 2);
+    const auto* inv = lib.find("INV");
+    REQUIRE(inv != nullptr);
+    CHECK(inv->cls == "CORE");
+    CHECK(inv->size == vector2<int> {800, 2000});
+    REQUIRE(inv->pins.size() == 2);
+    CHECK(inv->pins[1].name == "Y");
+    CHECK(inv->pins[1].shapes[0] ==
+        rectangle<int> {interval<int> {500, 700}, interval<int> {1000, 1600}});
+    REQUIRE(inv->obstructions.size() == 1);
+    CHECK(inv->obstructions[0] ==
+        rectangle<int> {interval<int> {0, 800}, interval<int> {0, 100}});
+    const auto* nand = lib.find("NAND2");
+    REQUIRE(nand != nullptr);
+    REQUIRE(nand->pins[0].shapes.size() == 2);
+    CHECK(nand->pins[0].shapes[1] ==
+        rectangle<int> {interval<int> {1000, 1100}, interval<int> {800, 900}});
+    CHECK(lib.find("BUF") == nullptr);
+
+    auto lib2 = lef_library<int> {};
+    CHECK(parse_lef<int>(lef_text, lib2, 2000) == lef_def_status::ok);
+    CHECK(lib2.find("INV")->size == vector2<int> {1600, 4000});
+
+    auto bad = std::string(lef_text);
+    bad.replace(bad.find("END INV"), 7, "END XYZ");
+    CHECK(parse_lef<int>(bad, lib2) == lef_def_status::syntax_error);
+}
+
+TEST_CASE("LEF/DEF test (DEF)")
+{
+    static const char* const orients[] = {
+        "N", "W", "S", "E", "FN", "FW", "FS", "FE"};
+    const auto num_cells = 3000;
+    const auto num_nets = 2000;
+    auto os = std::ostringstream {};
+    os << "VERSION 5.8 ;\nDESIGN top ;\n"
+       << "UNITS DISTANCE MICRONS 2000.000000000000000000000001 ;\n"
+       << "DIEAREA ( 0 0 ) ( 400000 0 ) ( 400000 300000 ) ( 0 300000 ) ;\n"
+       << "ROW row0 core 0 0 N DO 1000 BY 1 STEP 400 0 ;\n"
+       << "ROW row1 core 0 4000 FS DO 1000 BY 1 STEP 400 0 ;\n"
+       << "TRACKS X 0 DO 100 STEP 200 LAYER metal1 ;\n"
+       << "VIAS 1 ;\n- v1 + RECT metal1 ( 0 0 ) ( 1 1 ) ;\nEND VIAS\n";
+    auto cells = std::vector<std::tuple<int, int, int, int>> {};
+    os << "COMPONENTS " << num_cells << " ;\n";
+    for (auto i = 0; i != num_cells; ++i)
+    {
+        const auto x = std::rand() % 390000;
+        const auto y = std::rand() % 290000;
+        const auto o = std::rand() % 8;
+        const auto m = std::rand() % 2;
+        cells.emplace_back(x, y, o, m);
+        os << "- u" << i << (m == 0 ? " INV" : " NAND2");
+        if (i % 7 == 0)
+        {
+            os << " + SOURCE NETLIST";
+        }
+        os << " + " << (i % 3 == 0 ? "FIXED" : "PLACED") << " ( " << x
+           << ' ' << y << " ) " << orients[o] << " ;\n";
+    }
+    os << "- floating INV ;\nEND COMPONENTS\n";
+    os << "PINS 2 ;\n"
+       << "- in + NET n0 + DIRECTION INPUT + LAYER metal1 ( -100 0 ) "
+          "( 100 400 ) + FIXED ( 0 5000 ) E ;\n"
+       << "- out + NET n1 + PLACED ( 400000 7000 ) N ;\nEND PINS\n";
+    os << "BLOCKAGES 2 ;\n- LAYER metal1 RECT ( 10 20 ) ( 30 40 ) ;\n"
+       << "- PLACEMENT RECT ( 100 0 ) ( 0 100 ) RECT ( 5 5 ) ( 6 6 ) ;\n"
+       << "END BLOCKAGES\n";
+    os << "SPECIALNETS 1 ;\n- VDD ( * VDD ) + USE POWER ;\nEND SPECIALNETS\n";
+    auto nets = std::vector<std::vector<std::pair<int, int>>> {};
+    os << "NETS " << num_nets << " ;\n";
+    for (auto n = 0; n != num_nets; ++n)
+    {
+        os << "- n" << n;
+        auto& pins = nets.emplace_back();
+        if (n < 2)
+        {
+            os << " ( PIN " << (n == 0 ? "in" : "out") << " )";
+            pins.emplace_back(num_cells + 1 + n, -1);
+        }
+        const auto degree = 2 + std::rand() % 4;
+        for (auto k = 0; k != degree; ++k)
+        {
+            const auto c = std::rand() % num_cells;
+            const auto p = std::rand() % 2;
+            const auto m = std::get<3>(cells[std::size_t(c)]);
+            os << " ( u" << c << (p == 0 && m == 0 ? " A" : " Y")
+               << (k == 1 ? " + SYNTHESIZED" : "") << " )";
+            pins.emplace_back(c, p == 0 && m == 0 ? 0 : 1);
+        }
+        if (n % 5 == 0)
+        {
+            os << " + ROUTED metal1 ( 0 0 ) ( 100 * ) + USE SIGNAL";
+        }
+        if (n % 9 == 0)
+        {
+            // neither ends the section
+            os << " + PROPERTY note \"x END NETS y\" ;\n# END NETS\n";
+            continue;
+        }
+        os << " ;\n";
+    }
+    os << "END NETS\nEND DESIGN\n";
+    const auto def_text = os.str();
+
+    auto lib = lef_library<int> {};
+    REQUIRE(parse_lef<int>(lef_text, lib) == lef_def_status::ok);
+    for (auto nt : {1U, 4U})
+    {
+        auto d = def_design<int> {};
+        REQUIRE(parse_def<int>(def_text, d, &lib, nt) == lef_def_status::ok);
+        CHECK(d.name == "top");
+        CHECK(d.dbu == 2000);
+        CHECK(d.die_area ==
+            rectangle<int> {
+                interval<int> {0, 400000}, interval<int> {0, 300000}});
+        REQUIRE(d.rows.size() == 2);
+        CHECK(d.rows[1].orient == def_orient::FS);
+        CHECK(d.rows[1].origin == point<int> {0, 4000});
+        CHECK(d.rows[1].num_x == 1000);
+        CHECK(d.rows[1].step == vector2<int> {400, 0});
+
+        REQUIRE(d.components.size() == num_cells + 1);
+        for (auto i = 0U; i != std::size_t(num_cells); ++i)
+        {
+            const auto& c = d.components[i];
+            const auto [x, y, o, m] = cells[i];
+            CHECK(c.position == point<int> {x, y});
+            CHECK(c.orient == def_orient(o));
+            CHECK(c.macro == (m == 0 ? "INV" : "NAND2"));
+            CHECK(c.status ==
+                (i % 3 == 0 ? def_place::fixed : def_place::placed));
+            const auto w = m == 0 ? 1600 : 2400;
+            const auto fp = placed_footprint(d, i, lib);
+            CHECK(fp.x().len() == (o % 2 == 0 ? w : 4000));
+            CHECK(fp.y().len() == (o % 2 == 0 ? 4000 : w));
+        }
+        CHECK(d.components.back().status == def_place::unplaced);
+
+        REQUIRE(d.pins.size() == 2);
+        CHECK(d.pins[0].net == "n0");
+        CHECK(d.pins[0].layer == "metal1");
+        CHECK(d.pins[0].status == def_place::fixed);
+        // E rotates ( -100 0 ) ( 100 400 ) to ( 0 100 ) ( 400 -100 )
+        CHECK(d.pins[0].shape ==
+            rectangle<int> {
+                interval<int> {0, 400}, interval<int> {4900, 5100}});
+        CHECK(d.pins[1].layer.empty());
+        CHECK(d.pins[1].position == point<int> {400000, 7000});
+
+        REQUIRE(d.blockages.size() == 3);
+        CHECK(d.blockages[0].layer == "metal1");
+        CHECK(d.blockages[1].layer.empty());
+        CHECK(d.blockages[1].shape ==
+            rectangle<int> {interval<int> {0, 100}, interval<int> {0, 100}});
+
+        REQUIRE(d.nets.num_nets() == num_nets);
+        CHECK(d.net_names[17] == "n17");
+        for (auto n = 0U; n != nets.size(); ++n)
+        {
+            const auto first = d.nets.net_start[n];
+            REQUIRE(d.nets.net_start[n + 1] - first == nets[n].size());
+            for (auto k = 0U; k != nets[n].size(); ++k)
+            {
+                const auto [c, p] = nets[n][k];
+                CHECK(d.nets.pin_cell[first + k] == std::uint32_t(c));
+                auto off = std::pair<int, int> {0, 0};
+                if (p >= 0)
+                {
+                    // pin centres in DEF units: INV A, INV Y, NAND2 Y
+                    const auto [x, y, o, m] = cells[std::size_t(c)];
+                    const auto cx = m == 0 ? (p == 0 ? 400 : 1200) : 2100;
+                    const auto cy = m == 0 ? (p == 0 ? 1200 : 2600) : 1200;
+                    off = placed(o, cx, cy, m == 0 ? 1600 : 2400, 4000);
+                }
+                CHECK(d.nets.pin_offset[first + k] ==
+                    vector2<int> {off.first, off.second});
+            }
+        }
+        const auto pos = d.cell_positions();
+        CHECK(pos.size() == num_cells + 3);
+        CHECK(pos.back() == point<int> {400000, 7000});
+    }
+
+    auto d = def_design<int> {};
+    auto bad = def_text;
+    bad.replace(bad.find("( PIN in )"), 10, "( PIN zz )");
+    CHECK(parse_def<int>(bad, d, &lib, 3) ==
+        lef_def_status::unknown_reference);
+    // still reported first when a syntax error follows in the same run
+    bad.insert(bad.find("END NETS\nEND DESIGN"), "- nz ( u1 A ;\n");
+    CHECK(parse_def<int>(bad, d, &lib, 1) ==
+        lef_def_status::unknown_reference);
+    bad = def_text;
+    bad.insert(bad.find("END NETS\nEND DESIGN"), "- nz ( u1 A ) ( u2 Y ;\n");
+    CHECK(parse_def<int>(bad, d, &lib, 1) == lef_def_status::syntax_error);
+    bad = def_text;
+    bad.erase(bad.find("END COMPONENTS"), 14);
+    CHECK(parse_def<int>(bad, d, &lib) == lef_def_status::syntax_error);
+}
+
+TEST_CASE("LEF/DEF test (numbers)")
+{
+    auto close = [](double a, double b)
+    { return std::abs(a - b) <= 1e-15 * std::abs(b); };
+    auto v = 0.0;
+    CHECK(detail::parse_real("-12.5e2", v));
+    CHECK(v == -1250);
+    // more digits than fit in 64 bits
+    CHECK(detail::parse_real("123456789012345678901234", v));
+    CHECK(close(v, 1.23456789012345678e23));
+    CHECK(detail::parse_real("0.0000000000000000000000000125", v));
+    CHECK(close(v, 1.25e-26));
+    CHECK(detail::parse_real("3.14159265358979323846264338", v));
+    CHECK(close(v, 3.141592653589793));
+    CHECK(!detail::parse_real("-", v));
+    CHECK(!detail::parse_real("1.5x", v));
+
+    auto i = 0;
+    CHECK((detail::parse_integer("-123", i) && i == -123));
+    CHECK((detail::parse_integer("+5", i) && i == 5));
+    CHECK(!detail::parse_integer("12a", i));
+    CHECK(!detail::parse_integer("1.0", i));
+    CHECK(!detail::parse_integer("-", i));
+    CHECK(!detail::parse_integer("3000000000", i));
+    auto o = def_orient::N;
+    CHECK((detail::parse_orient("FW", o) && o == def_orient::FW));
+    CHECK((detail::parse_orient("E", o) && o == def_orient::E));
+    CHECK(!detail::parse_orient("F", o));
+    CHECK(!detail::parse_orient("NN", o));
+    auto st = def_place::unplaced;
+    CHECK((detail::parse_place("COVER", st) && st == def_place::cover));
+    CHECK(!detail::parse_place("CLASS", st));
+    CHECK(st == def_place::cover);
+
+    // long tokens, ';' glued to a token and a token at the very end
+    auto tok = detail::lef_def_tokens {
+        "( a_rather_long_token_name;b # c\n\"q r\";0123456789abcdefX"};
+    for (auto t : {"(", "a_rather_long_token_name", ";", "b", "\"q r\"", ";",
+             "0123456789abcdefX", ""})
+    {
+        CHECK(tok.next() == t);
+    }
+
+    // integer DEF coordinates skip parse_real(), others still take it
+    const auto def_text =
+        std::string_view {"DESIGN t ;\nCOMPONENTS 2 ;\n"
+                          "- a INV + PLACED ( -12 +7 ) FN ;\n"
+                          "- b INV + FIXED ( 1.5e3 2.4 ) FE;\n"
+                          "END COMPONENTS\nEND DESIGN\n"};
+    auto d = def_design<int> {};
+    REQUIRE(parse_def<int>(def_text, d, nullptr, 1) == lef_def_status::ok);
+    REQUIRE(d.components.size() == 2);
+    CHECK(d.components[0].position == point<int> {-12, 7});
+    CHECK(d.components[0].orient == def_orient::FN);
+    CHECK(d.components[1].position == point<int> {1500, 2});
+    CHECK(d.components[1].orient == def_orient::FE);
+    CHECK(d.components[1].status == def_place::fixed);
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/left_edge.hpp>
+#include <recti/recti.hpp>
+#include <utility>
+#include <vector>
+
+using namespace recti;
+
+static auto max_clique(const std::vector<interval<int>>& ivs) -> std::size_t
+{
+    // closed intervals: an opening at x comes before a closing at x
+    auto events = std::vector<std::pair<int, int>> {};
+    for (auto&& a : ivs)
+    {
+        events.emplace_back(a.lower(), 0);
+        events.emplace_back(a.upper(), 1);
+    }
+    std::sort(events.begin(), events.end());
+    auto depth = std::size_t(0);
+    auto best = std::size_t(0);
+    for (auto&& [x, kind] : events)
+    {
+        if (kind == 0)
+        {
+            best = std::max(best, ++depth);
+        }
+        else
+        {
+            --depth;
+        }
+    }
+    return best;
+}
+
+TEST_CASE("Left-edge test")
+{
+    auto ivs = std::vector<interval<int>> {};
+    for (auto i = 0; i != 500; ++i)
+    {
+        auto x = std::rand() % 1000;
+        ivs.emplace_back(x, x + std::rand() % 50);
+    }
+    auto res = left_edge<int>(ivs);
+    CHECK(res.num_tracks == max_clique(ivs));
+    for (auto i = 0U; i != ivs.size(); ++i)
+    {
+        CHECK(res.track[i] < res.num_tracks);
+        for (auto j = i + 1; j != ivs.size(); ++j)
+        {
+            if (res.track[i] == res.track[j])
+            {
+                CHECK((ivs[i] < ivs[j] || ivs[j] < ivs[i]));
+            }
+        }
+    }
+}
+
+TEST_CASE("Left-edge test (touching)")
+{
+    auto ivs = std::vector<interval<int>> {{0, 5}, {5, 9}, {6, 8}, {10, 12}};
+    auto res = left_edge<int>(ivs);
+    CHECK(res.num_tracks == 2);
+    CHECK(res.track == std::vector<std::uint32_t> {0, 1, 0, 0});
+}
+
+TEST_CASE("Left-edge test (hsegment)")
+{
+    auto segs = std::vector<hsegment<int>> {{interval<int> {0, 5}, 1},
+        {interval<int> {3, 8}, 2}, {interval<int> {2, 4}, 1},
+        {interval<int> {6, 9}, 1}, {interval<int> {1, 2}, 2}};
+    auto res = left_edge<int>(segs);
+    CHECK(res.num_tracks == 2);
+    CHECK(res.track == std::vector<std::uint32_t> {0, 0, 1, 0, 0});
+}
+
+TEST_CASE("Left-edge test (stream)")
+{
+    auto stream = left_edge_stream<int> {};
+    CHECK(stream.push(interval<int> {0, 10}) == 0);
+    CHECK(stream.push(interval<int> {2, 3}) == 1);
+    CHECK(stream.push(interval<int> {4, 6}) == 1);
+    CHECK(stream.push(interval<int> {5, 7}) == 2);
+    CHECK(stream.push(interval<int> {11, 12}) == 0);
+    CHECK(stream.num_tracks() == 3);
+}
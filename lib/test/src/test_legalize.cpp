@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/legalize.hpp>
+#include <recti/recti.hpp>
+#include <vector>
+
+using namespace recti;
+
+static void check_legal(const std::vector<rectangle<int>>& cells,
+    const std::vector<hsegment<int>>& rows, const legalization<int>& res)
+{
+    REQUIRE(res.cells.size() == cells.size());
+    auto placed = std::vector<rectangle<int>> {};
+    for (auto i = 0U; i != cells.size(); ++i)
+    {
+        const auto& r = res.cells[i];
+        CHECK(r.x().len() == cells[i].x().len());
+        CHECK(r.y().len() == cells[i].y().len());
+        const auto in_row = std::any_of(rows.begin(), rows.end(),
+            [&](const auto& row)
+            { return row.y() == r.y().lower() && row.x().contains(r.x()); });
+        CHECK(in_row);
+        placed.push_back(r);
+    }
+    // no two cells overlap (touching edges are fine)
+    std::sort(placed.begin(), placed.end(),
+        [](const auto& a, const auto& b)
+        {
+            return std::tie(a.y().lower(), a.x().lower()) <
+                std::tie(b.y().lower(), b.x().lower());
+        });
+    for (auto i = 1U; i < placed.size(); ++i)
+    {
+        const auto& a = placed[i - 1];
+        const auto& b = placed[i];
+        if (a.y().lower() == b.y().lower())
+        {
+            CHECK(a.x().upper() <= b.x().lower());
+        }
+    }
+}
+
+TEST_CASE("Abacus legalization test")
+{
+    auto rows = std::vector<hsegment<int>> {};
+    for (auto i = 0; i != 20; ++i)
+    {
+        rows.emplace_back(interval<int> {0, 1000}, i * 10);
+    }
+    auto cells = std::vector<rectangle<int>> {};
+    auto width = 0;
+    while (width < 14000) // 70% utilization
+    {
+        auto x = std::rand() % 1000;
+        auto y = std::rand() % 200;
+        auto w = 5 + std::rand() % 25;
+        width += w;
+        cells.emplace_back(interval<int> {x, x + w}, interval<int> {y, y + 10});
+    }
+
+    auto res = abacus_legalize<int>(cells, rows);
+    CHECK(res.unplaced.empty());
+    check_legal(cells, rows, res);
+
+    auto res4 = abacus_legalize<int>(cells, rows, 4, 4);
+    CHECK(res4.unplaced.empty());
+    check_legal(cells, rows, res4);
+
+    // a legal placement is left alone
+    auto again = abacus_legalize<int>(res.cells, rows);
+    CHECK(again.displacement == 0);
+}
+
+TEST_CASE("Abacus legalization test (overflow)")
+{
+    auto rows = std::vector<hsegment<int>> {{interval<int> {0, 100}, 0}};
+    auto cells = std::vector<rectangle<int>> {};
+    for (auto i = 0; i != 3; ++i)
+    {
+        cells.emplace_back(interval<int> {10, 50}, interval<int> {0, 10});
+    }
+    auto res = abacus_legalize<int>(cells, rows);
+    CHECK(res.unplaced == std::vector<std::size_t> {2});
+    CHECK(res.cells[0] ==
+        rectangle<int> {interval<int> {0, 40}, interval<int> {0, 10}});
+    CHECK(res.cells[1] ==
+        rectangle<int> {interval<int> {40, 80}, interval<int> {0, 10}});
+}
@@ -0,0 +1,187 @@
+#include <cstdint>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <queue>
+#include <recti/maze_router.hpp>
+#include <recti/recti.hpp>
+#include <utility>
+#include <vector>
+
+using namespace recti;
+
+/// Dijkstra over the whole grid
+static auto shortest(const occupancy_grid<int>& grid, std::uint32_t s,
+    std::uint32_t t, std::uint32_t via_cost) -> std::uint32_t
+{
+    auto dist = std::vector<std::uint32_t>(grid.num_nodes(), UINT32_MAX);
+    using entry = std::pair<std::uint32_t, std::uint32_t>;
+    auto pq = std::priority_queue<entry, std::vector<entry>,
+        std::greater<entry>> {};
+    dist[s] = 0;
+    pq.emplace(0, s);
+    while (!pq.empty())
+    {
+        const auto [d, n] = pq.top();
+        pq.pop();
+        if (d != dist[n])
+        {
+            continue;
+        }
+        const auto c = grid.coords(n);
+        auto relax = [&](long long x, long long y, long long l,
+                         std::uint32_t step)
+        {
+            if (x < 0 || y < 0 || l < 0 || x >= (long long)grid.nx() ||
+                y >= (long long)grid.ny() || l >= (long long)grid.num_layers())
+            {
+                return;
+            }
+            const auto m = grid.node(std::size_t(x), std::size_t(y),
+                std::size_t(l));
+            if (m != t && grid.blocked(m))
+            {
+                return;
+            }
+            if (d + step < dist[m])
+            {
+                dist[m] = d + step;
+                pq.emplace(dist[m], m);
+            }
+        };
+        relax(c[0] - 1LL, c[1], c[2], 1);
+        relax(c[0] + 1LL, c[1], c[2], 1);
+        relax(c[0], c[1] - 1LL, c[2], 1);
+        relax(c[0], c[1] + 1LL, c[2], 1);
+        relax(c[0], c[1], c[2] - 1LL, via_cost);
+        relax(c[0], c[1], c[2] + 1LL, via_cost);
+    }
+    return dist[t];
+}
+
+static auto wire_cost(const maze_route<int>& r, int pitch,
+    std::uint32_t via_cost) -> std::uint32_t
+{
+    auto len = 0;
+    for (auto&& s : r.hsegments)
+    {
+        len += s.x().len();
+    }
+    for (auto&& s : r.vsegments)
+    {
+        len += s.y().len();
+    }
+    return std::uint32_t(len / pitch) +
+        std::uint32_t(r.vias.size()) * via_cost;
+}
+
+TEST_CASE("Occupancy grid test")
+{
+    auto grid = occupancy_grid<int> {point<int> {0, 0}, 10, 100, 5, 2};
+    grid.block(1, rectangle<int> {interval<int> {15, 640}, interval<int> {
+                                                               -5, 20}});
+    for (auto ix = 0U; ix != 100; ++ix)
+    {
+        for (auto iy = 0U; iy != 5; ++iy)
+        {
+            CHECK(!grid.blocked(ix, iy, 0));
+            const auto inside = 2 <= ix && ix <= 64 && iy <= 2;
+            CHECK(grid.blocked(ix, iy, 1) == inside);
+        }
+    }
+    const auto n = grid.snap(layered_point<int> {point<int> {46, 14}, 1});
+    CHECK(n == grid.node(5, 1, 1));
+    grid.unblock(n);
+    CHECK(!grid.blocked(5, 1, 1));
+}
+
+TEST_CASE("Maze router test")
+{
+    const auto pitch = 2;
+    const auto via_cost = 3U;
+    auto grid = occupancy_grid<int> {point<int> {0, 0}, pitch, 40, 30, 2};
+    for (auto i = 0; i != 40; ++i)
+    {
+        const auto x = (std::rand() % 40) * pitch;
+        const auto y = (std::rand() % 30) * pitch;
+        grid.block(std::size_t(i % 2),
+            rectangle<int> {interval<int> {x, x + 8}, interval<int> {y, y}});
+    }
+    auto opts = maze_options {};
+    opts.via_cost = via_cost;
+    opts.margin = 100; // the whole grid
+    auto router = maze_router<int> {grid, opts};
+    for (auto trial = 0; trial != 20; ++trial)
+    {
+        auto random_point = [&]()
+        {
+            return point<int> {
+                (std::rand() % 40) * pitch, (std::rand() % 30) * pitch};
+        };
+        const auto pins = std::vector<layered_point<int>> {
+            {random_point(), 0}, {random_point(), 1}};
+        const auto s = grid.snap(pins[0]);
+        const auto t = grid.snap(pins[1]);
+        if (s == t || grid.blocked(s))
+        {
+            continue;
+        }
+        const auto ref = shortest(grid, s, t, via_cost);
+        const auto res = router.route(pins);
+        CHECK(res.routed == (ref != UINT32_MAX));
+        if (res.routed)
+        {
+            CHECK(res.cost == ref);
+            CHECK(wire_cost(res, pitch, via_cost) == ref);
+            CHECK(grid.blocked(s));
+            CHECK(grid.blocked(t));
+        }
+    }
+}
+
+TEST_CASE("Maze router test (multi-pin, parallel)")
+{
+    auto make_grid = []()
+    {
+        auto grid = occupancy_grid<int> {point<int> {0, 0}, 1, 300, 40, 3};
+        grid.block(0,
+            rectangle<int> {interval<int> {0, 299}, interval<int> {20, 20}});
+        return grid;
+    };
+    auto pins = std::vector<layered_point<int>> {};
+    auto net_start = std::vector<std::size_t> {0};
+    std::srand(7);
+    for (auto e = 0; e != 60; ++e)
+    {
+        const auto x = std::rand() % 280;
+        const auto k = 2 + std::rand() % 3;
+        for (auto i = 0; i != k; ++i)
+        {
+            pins.push_back(
+                {point<int> {x + std::rand() % 20, std::rand() % 40}, 0});
+        }
+        net_start.push_back(pins.size());
+    }
+    auto opts = maze_options {};
+    opts.margin = 4;
+    opts.region_width = 64;
+    auto grid1 = make_grid();
+    auto grid4 = make_grid();
+    const auto res1 =
+        maze_route_nets<int>(grid1, pins, net_start, opts, 1);
+    const auto res4 =
+        maze_route_nets<int>(grid4, pins, net_start, opts, 4);
+    REQUIRE(res1.size() == 60);
+    auto routed = 0;
+    for (auto e = 0U; e != res1.size(); ++e)
+    {
+        CHECK(res1[e].routed == res4[e].routed);
+        CHECK(res1[e].cost == res4[e].cost);
+        CHECK(res1[e].hsegments.size() == res4[e].hsegments.size());
+        if (res1[e].routed)
+        {
+            ++routed;
+            CHECK(wire_cost(res1[e], 1, opts.via_cost) == res1[e].cost);
+        }
+    }
+    CHECK(routed > 30);
+}
@@ -0,0 +1,157 @@
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/plot_writer.hpp>
+#include <recti/recti.hpp>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace recti;
+
+static auto count(const std::string& s, const std::string& what) -> std::size_t
+{
+    auto n = std::size_t(0);
+    for (auto i = s.find(what); i != std::string::npos; i = s.find(what, i + 1))
+    {
+        ++n;
+    }
+    return n;
+}
+
+TEST_CASE("Plot writer test (integers)")
+{
+    for (auto v : {0LL, 9LL, 10LL, 99LL, 100LL, -123LL, 1234567890123LL})
+    {
+        auto s = std::string {};
+        detail::append_int(s, v);
+        CHECK(s == std::to_string(v));
+    }
+}
+
+TEST_CASE("Plot writer test (SVG)")
+{
+    auto os = std::ostringstream {};
+    const auto view =
+        rectangle<int> {interval<int> {0, 100}, interval<int> {0, 50}};
+    auto w = plot_writer<int> {os, plot_format::svg, view, 100};
+    w.style("#88C0D0", "black");
+    w.add(rectangle<int> {interval<int> {10, 20}, interval<int> {5, 15}});
+    w.add(rectangle<int> {interval<int> {200, 220}, interval<int> {5, 15}});
+    const auto S = std::vector<point<int>> {{0, 0}, {4, 3}};
+    w.add_rpolygon(S);
+    const auto P = std::vector<point<int>> {{0, 0}, {10, 0}, {0, -5}};
+    w.add_polygon(P);
+    w.add(hsegment<int> {interval<int> {-10, 30}, 40});
+    w.add(vsegment<int> {60, interval<int> {-3, 7}});
+    REQUIRE(w.finish());
+    const auto out = os.str();
+    CHECK(out.rfind("<svg xmlns='http://www.w3.org/2000/svg' "
+                    "viewBox='0 -50 100 50' width='100' height='50'>",
+              0) == 0);
+    CHECK(out.find("<g fill='#88C0D0' stroke='black'>") !=
+        std::string::npos);
+    CHECK(out.find("<rect x='10' y='5' width='10' height='10'/>") !=
+        std::string::npos);
+    CHECK(out.find("<path d='M4 3H0V0H4V3Z'/>") != std::string::npos);
+    CHECK(out.find("<path d='M0 0L10 0L0 -5Z'/>") != std::string::npos);
+    CHECK(out.find("d='M-10 40H30'") != std::string::npos);
+    CHECK(out.find("d='M60 -3V7'") != std::string::npos);
+    CHECK(out.size() - out.rfind("</g>\n</g>\n</svg>\n") == 17);
+    CHECK(w.written() == 5);
+    CHECK(w.culled() == 1);
+    CHECK(w.merged() == 0);
+}
+
+TEST_CASE("Plot writer test (degenerate viewports)")
+{
+    // a thin, tall view: the height is bounded, not 10^7 pixels
+    auto os = std::ostringstream {};
+    const auto tall = rectangle<int> {
+        interval<int> {0, 1}, interval<int> {0, 10000000}};
+    auto w = plot_writer<int> {os, plot_format::svg, tall, 100};
+    w.add(rectangle<int> {interval<int> {0, 1}, interval<int> {5, 6}});
+    REQUIRE(w.finish());
+    CHECK(os.str().find("width='1' height='100'>") != std::string::npos);
+    CHECK(w.merged() == 0);
+
+    // zero width (and zero area) views must not divide by zero
+    for (auto h : {0, 50})
+    {
+        auto os2 = std::ostringstream {};
+        const auto line = rectangle<int> {
+            interval<int> {7, 7}, interval<int> {0, h}};
+        auto w2 = plot_writer<int> {os2, plot_format::svg, line, 100};
+        w2.add(rectangle<int> {interval<int> {6, 8}, interval<int> {-1, 1}});
+        REQUIRE(w2.finish());
+        CHECK(os2.str().find(h == 0 ? "width='1' height='1'>"
+                                    : "width='1' height='100'>") !=
+            std::string::npos);
+        CHECK(w2.written() == 1);
+    }
+}
+
+TEST_CASE("Plot writer test (TikZ)")
+{
+    auto os = std::ostringstream {};
+    const auto view =
+        rectangle<int> {interval<int> {0, 160}, interval<int> {0, 160}};
+    auto w = plot_writer<int> {os, plot_format::tikz, view, 16};
+    w.style("blue!30");
+    w.add(rectangle<int> {interval<int> {10, 20}, interval<int> {5, 15}});
+    const auto S = std::vector<point<int>> {{0, 0}, {40, 30}};
+    w.add_rpolygon(S);
+    w.add(hsegment<int> {interval<int> {0, 30}, 40});
+    REQUIRE(w.finish());
+    const auto out = os.str();
+    CHECK(out.rfind("\\begin{tikzpicture}[x=0.1cm,y=0.1cm]\n", 0) == 0);
+    CHECK(out.find("\\fill[fill=blue!30] (10,5) rectangle (20,15);\n") !=
+        std::string::npos);
+    CHECK(out.find("\\fill[fill=blue!30] (40,30) -| (0,0) -| (40,30) "
+                   "-- cycle;\n") != std::string::npos);
+    CHECK(out.find("\\draw (0,40) -- (30,40);\n") != std::string::npos);
+    CHECK(out.find("\\end{tikzpicture}\n") != std::string::npos);
+}
+
+TEST_CASE("Plot writer test (culling and merging)")
+{
+    auto os = std::ostringstream {};
+    const auto view =
+        rectangle<int> {interval<int> {0, 10000}, interval<int> {0, 10000}};
+    auto w = plot_writer<int> {os, plot_format::svg, view, 100};
+    auto pixels = std::set<std::pair<int, int>> {};
+    auto big = 0U;
+    auto outside = 0U;
+    const auto n = 100000U;
+    for (auto i = 0U; i != n; ++i)
+    {
+        const auto x = std::rand() % 12000 - 1000;
+        const auto y = std::rand() % 12000 - 1000;
+        const auto s = i % 100 == 0 ? 150 : std::rand() % 50;
+        const auto r = rectangle<int> {
+            interval<int> {x, x + s}, interval<int> {y, y + s}};
+        if (!view.overlaps(r))
+        {
+            ++outside;
+        }
+        else if (s >= 100)
+        {
+            ++big;
+        }
+        else
+        {
+            // the pixel of the centre, clamped to the view
+            const auto cx = std::min(std::max(2 * x + s, 0) / 200, 99);
+            const auto cy = std::min(std::max(2 * y + s, 0) / 200, 99);
+            pixels.emplace(cx, cy);
+        }
+        w.add(r);
+    }
+    REQUIRE(w.finish());
+    CHECK(w.culled() == outside);
+    CHECK(w.written() == big + pixels.size());
+    CHECK(w.merged() == n - outside - w.written());
+    CHECK(count(os.str(), "<rect") == w.written());
+    CHECK(pixels.size() <= 100 * 100);
+}
@@ -0,0 +1,99 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/range_count.hpp>
+#include <recti/recti.hpp>
+#include <vector>
+
+using namespace recti;
+
+TEST_CASE("Range count test (bit vector)")
+{
+    auto bv = detail::rank_bitvector {};
+    const auto n = std::size_t(5000);
+    bv.assign(n);
+    auto bits = std::vector<bool>(n);
+    for (auto i = std::size_t(0); i != n; ++i)
+    {
+        bits[i] = std::rand() % 3 == 0;
+        if (bits[i])
+        {
+            bv.words()[i / 64] |= std::uint64_t(1) << (i % 64);
+        }
+    }
+    bv.finish();
+    auto ones = std::size_t(0);
+    auto zeros = std::size_t(0);
+    for (auto i = std::size_t(0); i != n; ++i)
+    {
+        CHECK(bv.rank1(i) == ones);
+        if (bits[i])
+        {
+            CHECK(bv.select(true, ones++) == i);
+        }
+        else
+        {
+            CHECK(bv.select(false, zeros++) == i);
+        }
+    }
+    CHECK(bv.rank1(n) == ones);
+    CHECK(detail::popcount64(~std::uint64_t(0)) == 64);
+    CHECK(detail::select64(std::uint64_t(1) << 63, 0) == 63);
+}
+
+TEST_CASE("Range count test (against brute force)")
+{
+    for (auto spread : {50, 100000})
+    {
+        auto pts = std::vector<point<int>> {};
+        for (auto i = 0; i != 20000; ++i)
+        {
+            // small spreads give many repeated coordinates
+            pts.emplace_back(std::rand() % spread, std::rand() % spread);
+        }
+        auto windows = std::vector<rectangle<int>> {};
+        for (auto q = 0; q != 300; ++q)
+        {
+            const auto x = std::rand() % (spread + 20) - 10;
+            const auto y = std::rand() % (spread + 20) - 10;
+            const auto w = std::rand() % (spread / 2 + 1);
+            const auto h = std::rand() % (spread / 2 + 1);
+            windows.emplace_back(
+                interval<int> {x, x + w}, interval<int> {y, y + h});
+        }
+        const auto rc = range_counter<int> {pts, 3};
+        CHECK(rc.size() == pts.size());
+        const auto batch = rc.count_all(windows, 2);
+        const auto offline = count_points_offline<int>(pts, windows);
+        for (auto q = 0U; q != windows.size(); ++q)
+        {
+            const auto& w = windows[q];
+            auto want = std::vector<std::uint32_t> {};
+            for (auto i = 0U; i != pts.size(); ++i)
+            {
+                if (w.contains(pts[i]))
+                {
+                    want.push_back(i);
+                }
+            }
+            CHECK(rc.count(w) == want.size());
+            CHECK(batch[q] == want.size());
+            CHECK(offline[q] == want.size());
+            if (q % 10 == 0)
+            {
+                auto got = std::vector<std::uint32_t> {};
+                rc.report(w, [&got](std::uint32_t i) { got.push_back(i); });
+                std::sort(got.begin(), got.end());
+                CHECK(got == want);
+            }
+        }
+    }
+
+    const auto none = std::vector<point<int>> {};
+    const auto empty = range_counter<int> {none};
+    const auto w = rectangle<int> {interval<int> {0, 9}, interval<int> {0, 9}};
+    CHECK(empty.count(w) == 0);
+    const auto one = std::vector<point<int>> {{3, 4}};
+    CHECK(range_counter<int> {one}.count(w) == 1);
+}
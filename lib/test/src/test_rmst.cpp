@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/disjoint_set.hpp>
+#include <recti/halton_int.hpp>
+#include <recti/recti.hpp>
+#include <recti/rmst.hpp>
+#include <vector>
+
+using namespace recti;
+
+static auto prim_length(const std::vector<point<int>>& S) -> int
+{
+    const auto n = S.size();
+    auto dist = std::vector<int>(n, INT32_MAX);
+    auto done = std::vector<bool>(n, false);
+    auto total = 0;
+    dist[0] = 0;
+    for (auto k = 0U; k != n; ++k)
+    {
+        auto u = n;
+        for (auto i = 0U; i != n; ++i)
+        {
+            if (!done[i] && (u == n || dist[i] < dist[u]))
+            {
+                u = i;
+            }
+        }
+        done[u] = true;
+        total += dist[u];
+        for (auto i = 0U; i != n; ++i)
+        {
+            dist[i] = std::min(dist[i], manhattan_distance(S[u], S[i]));
+        }
+    }
+    return total;
+}
+
+static auto check_rmst(const std::vector<point<int>>& S) -> int
+{
+    auto E = rmst<int>(S);
+    CHECK(E.size() + 1 == S.size());
+    auto ds = disjoint_set {S.size()};
+    auto total = 0;
+    for (auto&& [u, v] : E)
+    {
+        CHECK(ds.unite(std::uint32_t(u), std::uint32_t(v)));
+        total += manhattan_distance(S[u], S[v]);
+    }
+    return total;
+}
+
+TEST_CASE("RMST test (random)")
+{
+    auto S = std::vector<point<int>> {};
+    for (auto i = 0; i != 300; ++i)
+    {
+        S.emplace_back(point<int>(std::rand() % 1000, std::rand() % 1000));
+    }
+    CHECK(check_rmst(S) == prim_length(S));
+}
+
+TEST_CASE("RMST test (grid with duplicates)")
+{
+    auto hgenX = vdcorput(3, 7);
+    auto hgenY = vdcorput(2, 11);
+    auto S = std::vector<point<int>> {};
+    for (auto i = 0; i != 100; ++i)
+    {
+        S.emplace_back(point<int>(hgenX(), hgenY()));
+        S.emplace_back(point<int>((i % 10) * 50, (i / 10) * 50));
+    }
+    S.emplace_back(point<int>(0, 0));
+    CHECK(check_rmst(S) == prim_length(S));
+}
+
+TEST_CASE("RMST test (trivial)")
+{
+    auto S = std::vector<point<int>> {{3, 4}};
+    CHECK(rmst<int>(S).empty());
+    S.emplace_back(point<int>(6, 0));
+    auto E = rmst<int>(S);
+    REQUIRE(E.size() == 1);
+    CHECK(E[0] == std::pair<std::size_t, std::size_t> {0, 1});
+}
@@ -69,3 +69,34 @@ TEST_CASE("Rectilinear Polygon test (y-mono 50)")
     CHECK(!point_in_rpolygon<int>(S, q));
     puts("Hello world1\n");
 }
+
+TEST_CASE("Rectilinear Polygon test (slabs)")
+{
+    auto S = std::vector<point<int>> {{-2, 2}, {0, -1}, {-5, 1}, {-2, 4},
+        {0, -4}, {-4, 3}, {-6, -2}, {5, 1}, {2, 2}, {3, -3}, {-3, -4}, {1, 4}};
+    create_xmono_rpolygon(S.begin(), S.end());
+    for (auto vertical : {false, true})
+    {
+        auto slabs = rpolygon_slabs<int>(S, vertical);
+        auto area = 0;
+        for (auto i = 0U; i != slabs.size(); ++i)
+        {
+            area += slabs[i].area();
+            for (auto j = i + 1; j != slabs.size(); ++j)
+            {
+                const auto& a = slabs[i];
+                const auto& b = slabs[j];
+                CHECK((!(a.x().lower() < b.x().upper() &&
+                          b.x().lower() < a.x().upper()) ||
+                    !(a.y().lower() < b.y().upper() &&
+                        b.y().lower() < a.y().upper())));
+            }
+        }
+        CHECK(area == 53);
+    }
+    auto R = std::vector<point<int>> {{0, 0}, {4, 3}};
+    auto slabs = rpolygon_slabs<int>(R);
+    REQUIRE(slabs.size() == 1);
+    CHECK(slabs[0] ==
+        rectangle<int> {interval<int> {0, 4}, interval<int> {0, 3}});
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/disjoint_set.hpp>
+#include <recti/recti.hpp>
+#include <recti/rmst.hpp>
+#include <recti/rsmt.hpp>
+#include <vector>
+
+using namespace recti;
+
+static auto mst_length(const std::vector<point<int>>& S) -> int
+{
+    auto total = 0;
+    for (auto&& [u, v] : rmst<int>(S))
+    {
+        total += manhattan_distance(S[u], S[v]);
+    }
+    return total;
+}
+
+/**
+ * @brief brute force: MST over the pins plus up to n - 2 Hanan points
+ */
+static auto brute_rsmt_length(const std::vector<point<int>>& pins) -> int
+{
+    auto hanan = std::vector<point<int>> {};
+    for (auto&& p : pins)
+    {
+        for (auto&& q : pins)
+        {
+            hanan.emplace_back(point<int> {p.x(), q.y()});
+        }
+    }
+    std::sort(hanan.begin(), hanan.end());
+    hanan.erase(std::unique(hanan.begin(), hanan.end()), hanan.end());
+    auto best = mst_length(pins);
+    const auto h = hanan.size();
+    for (auto a = 0U; a != h; ++a)
+    {
+        for (auto b = a; b != h; ++b)
+        {
+            for (auto c = b; c != h; ++c)
+            {
+                auto S = pins;
+                S.push_back(hanan[a]);
+                S.push_back(hanan[b]);
+                S.push_back(hanan[c]);
+                best = std::min(best, mst_length(S));
+            }
+        }
+    }
+    return best;
+}
+
+static void check_tree(
+    const std::vector<point<int>>& pins, const steiner_tree<int>& tree)
+{
+    const auto n = pins.size() + tree.steiner_points.size();
+    CHECK(tree.edges.size() + 1 == n);
+    auto ds = disjoint_set {n};
+    for (auto&& [u, v] : tree.edges)
+    {
+        CHECK(ds.unite(std::uint32_t(u), std::uint32_t(v)));
+    }
+    auto total = 0;
+    for (auto&& s : tree.hsegments)
+    {
+        total += s.x().len();
+    }
+    for (auto&& s : tree.vsegments)
+    {
+        total += s.y().len();
+    }
+    CHECK(total == tree.length);
+}
+
+TEST_CASE("RSMT test (exact vs brute force)")
+{
+    for (auto trial = 0; trial != 5; ++trial)
+    {
+        auto pins = std::vector<point<int>> {};
+        for (auto i = 0; i != 5; ++i)
+        {
+            pins.emplace_back(point<int>(std::rand() % 100, std::rand() % 100));
+        }
+        auto tree = rsmt_exact<int>(pins);
+        check_tree(pins, tree);
+        CHECK(tree.length == brute_rsmt_length(pins));
+    }
+}
+
+TEST_CASE("RSMT test (cross)")
+{
+    auto pins = std::vector<point<int>> {{0, 5}, {10, 5}, {5, 0}, {5, 10}};
+    auto tree = rsmt<int>(pins);
+    CHECK(tree.length == 20);
+    REQUIRE(tree.steiner_points.size() == 1);
+    CHECK(tree.steiner_points[0] == point<int> {5, 5});
+    check_tree(pins, tree);
+
+    auto htree = rsmt_heuristic<int>(pins);
+    CHECK(htree.length == 20);
+    check_tree(pins, htree);
+}
+
+TEST_CASE("RSMT test (heuristic)")
+{
+    auto pins = std::vector<point<int>> {};
+    for (auto i = 0; i != 9; ++i)
+    {
+        pins.emplace_back(point<int>(std::rand() % 1000, std::rand() % 1000));
+    }
+    auto exact = rsmt_exact<int>(pins);
+    auto heur = rsmt_heuristic<int>(pins);
+    check_tree(pins, exact);
+    check_tree(pins, heur);
+    CHECK(exact.length <= heur.length);
+    CHECK(heur.length <= mst_length(pins));
+
+    for (auto i = 0; i != 300; ++i)
+    {
+        pins.emplace_back(point<int>(std::rand() % 1000, std::rand() % 1000));
+    }
+    auto tree = rsmt<int>(pins);
+    check_tree(pins, tree);
+    CHECK(tree.length < mst_length(pins));
+}
+
+TEST_CASE("RSMT test (batch)")
+{
+    auto pins = std::vector<point<int>> {};
+    auto net_start = std::vector<std::size_t> {0};
+    for (auto k = 0; k != 40; ++k)
+    {
+        const auto deg = 1 + std::rand() % 15;
+        for (auto i = 0; i != deg; ++i)
+        {
+            pins.emplace_back(point<int>(std::rand() % 500, std::rand() % 500));
+        }
+        net_start.push_back(pins.size());
+    }
+    auto trees = rsmt_batch<int>(pins, net_start, 9, 4);
+    REQUIRE(trees.size() == 40);
+    for (auto k = 0U; k != 40; ++k)
+    {
+        auto net = std::vector<point<int>>(pins.begin() + net_start[k],
+            pins.begin() + net_start[k + 1]);
+        check_tree(net, trees[k]);
+        CHECK(trees[k].length == rsmt<int>(net).length);
+    }
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/recti.hpp>
+#include <recti/rstar_tree.hpp>
+#include <utility>
+#include <vector>
+
+using namespace recti;
+
+static auto random_cell(int extent) -> rectangle<int>
+{
+    const auto x = std::rand() % extent;
+    const auto y = std::rand() % extent;
+    return {interval<int> {x, x + 10 + std::rand() % 90},
+        interval<int> {y, y + 100}};
+}
+
+static auto shifted(const rectangle<int>& r, int dx, int dy) -> rectangle<int>
+{
+    return {interval<int> {r.x().lower() + dx, r.x().upper() + dx},
+        interval<int> {r.y().lower() + dy, r.y().upper() + dy}};
+}
+
+template <unsigned M>
+static void check_queries(const rstar_tree<int, M>& tree,
+    const std::vector<rectangle<int>>& shapes, const std::vector<bool>& alive,
+    int extent)
+{
+    for (auto q = 0; q != 100; ++q)
+    {
+        const auto x = std::rand() % extent - 200;
+        const auto y = std::rand() % extent - 200;
+        const auto s = q % 10 == 0 ? extent / 3 : std::rand() % 1000;
+        const auto w =
+            rectangle<int> {interval<int> {x, x + s}, interval<int> {y, y + s}};
+        auto got = tree.query(w);
+        std::sort(got.begin(), got.end());
+        auto want = std::vector<std::uint32_t> {};
+        for (auto i = 0U; i != shapes.size(); ++i)
+        {
+            if (alive[i] && shapes[i].overlaps(w))
+            {
+                want.push_back(i);
+            }
+        }
+        CHECK(got == want);
+    }
+}
+
+TEST_CASE("R*-tree test (insert, remove, move)")
+{
+    const auto extent = 50000;
+    auto tree = rstar_tree<int> {};
+    CHECK(tree.query(rectangle<int> {
+                         interval<int> {0, 10}, interval<int> {0, 10}})
+              .empty());
+    auto shapes = std::vector<rectangle<int>> {};
+    auto alive = std::vector<bool> {};
+    for (auto i = 0; i != 20000; ++i)
+    {
+        shapes.push_back(random_cell(extent));
+        alive.push_back(true);
+        CHECK(tree.insert(shapes.back()) == shapes.size() - 1);
+    }
+    CHECK(tree.size() == shapes.size());
+    CHECK(tree.height() >= 4);
+    REQUIRE(tree.valid());
+    check_queries(tree, shapes, alive, extent);
+
+    for (auto i = 0; i != 8000; ++i)
+    {
+        const auto id = std::uint32_t(std::rand()) % shapes.size();
+        if (!alive[id])
+        {
+            continue;
+        }
+        if (i % 2 == 0)
+        {
+            tree.remove(id);
+            alive[id] = false;
+            CHECK_FALSE(tree.contains(id));
+        }
+        else
+        {
+            shapes[id] = random_cell(extent);
+            tree.move(id, shapes[id]);
+        }
+    }
+    CHECK(tree.size() ==
+        std::size_t(std::count(alive.begin(), alive.end(), true)));
+    REQUIRE(tree.valid());
+    check_queries(tree, shapes, alive, extent);
+
+    // placement-like batches: mostly small steps, a few long jumps
+    auto in_place = std::size_t(0);
+    for (auto round = 0; round != 5; ++round)
+    {
+        auto moves = std::vector<std::pair<std::uint32_t, rectangle<int>>> {};
+        for (auto id = 0U; id != shapes.size(); ++id)
+        {
+            if (!alive[id] || std::rand() % 4 != 0)
+            {
+                continue;
+            }
+            shapes[id] = std::rand() % 20 == 0
+                ? random_cell(extent)
+                : shifted(shapes[id], std::rand() % 9 - 4, std::rand() % 9 - 4);
+            moves.emplace_back(id, shapes[id]);
+        }
+        in_place += tree.move_all(moves);
+        REQUIRE(tree.valid());
+        check_queries(tree, shapes, alive, extent);
+    }
+    CHECK(in_place > 0);
+
+    // empty it again; the root collapses to a leaf
+    for (auto id = 0U; id != shapes.size(); ++id)
+    {
+        if (alive[id])
+        {
+            tree.remove(id);
+        }
+    }
+    CHECK(tree.size() == 0);
+    CHECK(tree.height() == 1);
+    CHECK(tree.num_nodes() == 1);
+    CHECK(tree.valid());
+}
+
+TEST_CASE("R*-tree test (small nodes)")
+{
+    auto tree = rstar_tree<int, 4> {};
+    auto shapes = std::vector<rectangle<int>> {};
+    auto alive = std::vector<bool> {};
+    for (auto i = 0; i != 3000; ++i)
+    {
+        shapes.push_back(random_cell(5000));
+        alive.push_back(true);
+        tree.insert(shapes.back());
+        if (i % 3 == 0)
+        {
+            const auto id = std::uint32_t(std::rand()) % shapes.size();
+            if (alive[id])
+            {
+                tree.remove(id);
+                alive[id] = false;
+            }
+        }
+    }
+    REQUIRE(tree.valid());
+    check_queries(tree, shapes, alive, 5000);
+}
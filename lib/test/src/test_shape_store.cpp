@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <doctest/doctest.h>
+#include <recti/polygon.hpp>
+#include <recti/recti.hpp>
+#include <recti/rpolygon.hpp>
+#include <recti/shape_store.hpp>
+#include <vector>
+
+using namespace recti;
+
+static auto sorted_vertices(const rpolygon<int>& P) -> std::vector<point<int>>
+{
+    auto res = std::vector<point<int>> {P.origin()};
+    for (auto&& v : P.vecs())
+    {
+        res.push_back(P.origin());
+        res.back() += v;
+    }
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+TEST_CASE("Shape store test (rpolygon parts)")
+{
+    const auto S =
+        std::vector<point<int>> {{0, 0}, {4, 3}, {6, 1}, {8, 5}, {2, 7}};
+    auto P = rpolygon<int>(S);
+    P += vector2<int> {10, 20};
+    CHECK(P.origin() == point<int> {10, 20});
+    REQUIRE(P.vecs().size() == 4);
+    CHECK(P.vecs()[1] == vector2<int> {6, 1});
+    const auto vs =
+        std::vector<vector2<int>>(P.vecs().begin(), P.vecs().end());
+    const auto Q = rpolygon<int>(P.origin(), vs);
+    CHECK(Q.signed_area() == P.signed_area());
+}
+
+TEST_CASE("Shape store test (stream of repeated shapes)")
+{
+    // a small library of distinct shapes, placed many times with the
+    // vertex list starting at a random corner
+    const auto num_shapes = 40U;
+    auto library = std::vector<std::vector<point<int>>> {};
+    for (auto s = 0U; s != num_shapes; ++s)
+    {
+        auto S = std::vector<point<int>> {};
+        for (auto k = 0; k != 6 + int(s % 8); ++k)
+        {
+            S.emplace_back(std::rand() % 1000, std::rand() % 1000);
+        }
+        create_xmono_rpolygon(S.begin(), S.end());
+        library.push_back(S);
+    }
+    auto points = std::vector<point<int>> {};
+    auto start = std::vector<std::size_t> {0};
+    auto which = std::vector<std::uint32_t> {};
+    for (auto i = 0; i != 20000; ++i)
+    {
+        const auto s = std::uint32_t(std::rand()) % num_shapes;
+        const auto& S = library[s];
+        const auto dx = std::rand() % 100000;
+        const auto dy = std::rand() % 100000;
+        const auto r = std::size_t(std::rand()) % S.size();
+        for (auto k = std::size_t(0); k != S.size(); ++k)
+        {
+            points.push_back(S[(r + k) % S.size()]);
+            points.back() += vector2<int> {dx, dy};
+        }
+        start.push_back(points.size());
+        which.push_back(s);
+    }
+
+    for (auto nt : {1U, 3U})
+    {
+        auto store = shape_store<int> {};
+        const auto refs = store.intern_all(points, start, nt);
+        REQUIRE(refs.size() == which.size());
+        CHECK(store.size() == num_shapes);
+        CHECK(store.num_interned() == which.size());
+        CHECK(store.num_vecs() * 20 < points.size());
+
+        // one shape id per library shape, and every instance restored
+        auto id_of = std::vector<std::uint32_t>(num_shapes, UINT32_MAX);
+        for (auto i = 0U; i != refs.size(); ++i)
+        {
+            auto& id = id_of[which[i]];
+            if (id == UINT32_MAX)
+            {
+                id = refs[i].id;
+            }
+            CHECK(refs[i].id == id);
+            const auto P = store.to_rpolygon(refs[i]);
+            auto want = std::vector<point<int>>(
+                points.begin() + std::ptrdiff_t(start[i]),
+                points.begin() + std::ptrdiff_t(start[i + 1]));
+            CHECK(P.signed_area() == rpolygon<int>(want).signed_area());
+            std::sort(want.begin(), want.end());
+            CHECK(sorted_vertices(P) == want);
+            CHECK(refs[i].origin == want.front());
+        }
+
+        // single inserts agree with the batch
+        const auto& S = library[7];
+        CHECK(store.intern(S).id == id_of[7]);
+        auto P = rpolygon<int>(S);
+        P += vector2<int> {-5, 9};
+        const auto ref = store.intern(P);
+        CHECK(ref.id == id_of[7]);
+        CHECK(ref.origin == *std::min_element(S.begin(), S.end()) +
+                vector2<int> {-5, 9});
+        const auto tri = std::vector<point<int>> {{0, 0}, {3, 0}, {0, 2}};
+        CHECK(store.intern(polygon<int>(tri)).id == num_shapes);
+        CHECK(store.size() == num_shapes + 1);
+    }
+}
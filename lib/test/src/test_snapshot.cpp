@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <doctest/doctest.h>
+#include <fstream>
+#include <recti/recti.hpp>
+#include <recti/rpolygon.hpp>
+#include <recti/snapshot.hpp>
+#include <sstream>
+#include <vector>
+
+using namespace recti;
+
+/**
+ * @brief copy a serialized snapshot into a 64-bit aligned buffer
+ */
+static auto aligned_copy(const std::string& s) -> std::vector<std::uint64_t>
+{
+    auto buf = std::vector<std::uint64_t>((s.size() + 7) / 8);
+    std::memcpy(buf.data(), s.data(), s.size());
+    return buf;
+}
+
+static auto bytes(const std::vector<std::uint64_t>& buf, std::size_t n)
+    -> gsl::span<const std::byte>
+{
+    return {reinterpret_cast<const std::byte*>(buf.data()), n};
+}
+
+TEST_CASE("Snapshot test (round trip)")
+{
+    auto rects = std::vector<rectangle<int>> {};
+    for (auto i = 0; i != 2000; ++i)
+    {
+        const auto x = std::rand() % 5000 - 1000;
+        const auto y = std::rand() % 5000 - 1000;
+        rects.emplace_back(interval<int> {x, x + 1 + std::rand() % 200},
+            interval<int> {y, y + 1 + std::rand() % 200});
+    }
+    auto points = std::vector<point<int>> {};
+    auto start = std::vector<std::size_t> {0};
+    for (auto k = 0; k != 20; ++k)
+    {
+        for (auto i = 0; i != 10 + k; ++i)
+        {
+            points.emplace_back(std::rand() % 1000, std::rand() % 1000);
+        }
+        create_xmono_rpolygon(points.begin() + long(start.back()),
+            points.end());
+        start.push_back(points.size());
+    }
+
+    auto os = std::ostringstream {};
+    REQUIRE(write_snapshot<int>(os, rects, points, start, 256));
+    const auto str = os.str();
+    CHECK(str.size() % snapshot::alignment == 0);
+    const auto buf = aligned_copy(str);
+
+    auto v = snapshot_view<int> {};
+    REQUIRE(v.open(bytes(buf, str.size()), true) == snapshot_status::ok);
+    REQUIRE(v.num_rects() == rects.size());
+    REQUIRE(v.num_polygons() == 20);
+    for (auto i = 0U; i != rects.size(); ++i)
+    {
+        CHECK(v.rect(i) == rects[i]);
+    }
+    CHECK(v.rect_coords(3)[7] == rects[7].y().upper());
+    for (auto k = 0U; k != 20; ++k)
+    {
+        const auto P = v.polygon(k);
+        CHECK(std::equal(P.begin(), P.end(), points.begin() + long(start[k]),
+            points.begin() + long(start[k + 1])));
+        CHECK(rpolygon<int>(P).signed_area() ==
+            rpolygon<int>(gsl::span<const point<int>>(
+                              points.data() + start[k],
+                              start[k + 1] - start[k]))
+                .signed_area());
+    }
+
+    REQUIRE(v.has_index());
+    for (auto q = 0; q != 200; ++q)
+    {
+        const auto x = std::rand() % 6000 - 1500;
+        const auto y = std::rand() % 6000 - 1500;
+        const auto w = rectangle<int> {interval<int> {x, x + std::rand() % 800},
+            interval<int> {y, y + std::rand() % 800}};
+        auto got = std::vector<std::size_t> {};
+        v.query(w, [&](std::size_t id) { got.push_back(id); });
+        std::sort(got.begin(), got.end());
+        auto ref = std::vector<std::size_t> {};
+        for (auto i = 0U; i != rects.size(); ++i)
+        {
+            if (rects[i].overlaps(w))
+            {
+                ref.push_back(i);
+            }
+        }
+        CHECK(got == ref);
+    }
+
+    // without index, via a mapped file
+    auto os2 = std::ostringstream {};
+    REQUIRE(write_snapshot<int>(os2, rects, {}, {}));
+    const auto path = "test_snapshot.bin";
+    {
+        auto f = std::ofstream {path, std::ios::binary};
+        f << os2.str();
+    }
+    {
+        auto m = mapped_file {};
+        REQUIRE(m.open(path));
+        CHECK(m.data().size() == os2.str().size());
+        auto v2 = snapshot_view<int> {};
+        REQUIRE(v2.open(m.data(), true) == snapshot_status::ok);
+        CHECK(!v2.has_index());
+        CHECK(v2.num_polygons() == 0);
+        CHECK(v2.rect(1234) == rects[1234]);
+    }
+    std::remove(path);
+}
+
+TEST_CASE("Snapshot test (validation)")
+{
+    auto rects = std::vector<rectangle<int>> {
+        {interval<int> {0, 10}, interval<int> {0, 10}},
+        {interval<int> {20, 30}, interval<int> {5, 8}}};
+    auto points = std::vector<point<int>> {{0, 0}, {4, 3}};
+    auto start = std::vector<std::size_t> {0, 2};
+    auto os = std::ostringstream {};
+    REQUIRE(write_snapshot<int>(os, rects, points, start, 8));
+    const auto str = os.str();
+    auto v = snapshot_view<int> {};
+
+    auto buf = aligned_copy(str);
+    CHECK(v.open(bytes(buf, 20)) == snapshot_status::truncated);
+    CHECK(v.open(bytes(buf, str.size() - 64)) == snapshot_status::truncated);
+    CHECK(snapshot_view<unsigned> {}.open(bytes(buf, str.size())) ==
+        snapshot_status::bad_coord_type);
+    CHECK(snapshot_view<double> {}.open(bytes(buf, str.size())) ==
+        snapshot_status::bad_coord_type);
+
+    auto* raw = reinterpret_cast<unsigned char*>(buf.data());
+    raw[0] = 'X';
+    CHECK(v.open(bytes(buf, str.size())) == snapshot_status::bad_magic);
+    raw[0] = 'R';
+    raw[8] = 2;
+    CHECK(v.open(bytes(buf, str.size())) == snapshot_status::bad_version);
+    raw[8] = 1;
+    REQUIRE(v.open(bytes(buf, str.size()), true) == snapshot_status::ok);
+
+    // misaligned section offset (entry 0, offset field)
+    raw[snapshot::header_size + 8] += 1;
+    CHECK(v.open(bytes(buf, str.size())) == snapshot_status::bad_section);
+    raw[snapshot::header_size + 8] -= 1;
+
+    // a broken CSR offset passes the shallow check only
+    auto off = std::uint64_t(0);
+    const auto entry = snapshot::header_size + 4 * snapshot::entry_size;
+    std::memcpy(&off, raw + entry + 8, sizeof(off));
+    raw[off + 8] = 9; // poly_start[1] = 9 > num_points
+    CHECK(v.open(bytes(buf, str.size())) == snapshot_status::ok);
+    CHECK(v.open(bytes(buf, str.size()), true) ==
+        snapshot_status::bad_offsets);
+    CHECK(v.num_rects() == 0);
+}